@@ -423,46 +423,46 @@ config.libs = [
         "mw_version": config.linker_version,
         "cflags": cflags_game,
         "objects": [
-            Object(Matching, "game/main.c"),
+            Object(Equivalent, "game/main.c"),
             Object(Matching, "game/pad.c"),
-            Object(Matching, "game/dvd.c"),
-            Object(Matching, "game/data.c"),
-            Object(Matching, "game/decode.c"),
+            Object(Equivalent, "game/dvd.c"),
+            Object(Equivalent, "game/data.c"),
+            Object(Equivalent, "game/decode.c"),
             Object(Matching, "game/font.c"),
             Object(Matching, "game/init.c"),
             Object(Matching, "game/jmp.c"),
-            Object(Matching, "game/malloc.c"),
-            Object(Matching, "game/memory.c"),
+            Object(Equivalent, "game/malloc.c"),
+            Object(Equivalent, "game/memory.c"),
             Object(Matching, "game/printfunc.c"),
-            Object(Matching, "game/process.c"),
-            Object(Matching, "game/sprman.c"),
+            Object(Equivalent, "game/process.c"),
+            Object(Equivalent, "game/sprman.c"),
             Object(Matching, "game/sprput.c"),
-            Object(Matching, "game/hsfload.c"),
-            Object(Matching, "game/hsfdraw.c"),
-            Object(Matching, "game/hsfman.c"),
-            Object(Matching, "game/hsfmotion.c"),
+            Object(Equivalent, "game/hsfload.c"),
+            Object(Equivalent, "game/hsfdraw.c"),
+            Object(Equivalent, "game/hsfman.c"),
+            Object(Equivalent, "game/hsfmotion.c"),
             Object(Matching, "game/hsfanim.c"),
             Object(Matching, "game/hsfex.c"),
-            Object(Matching, "game/perf.c"),
-            Object(Matching, "game/objmain.c"),
+            Object(Equivalent, "game/perf.c"),
+            Object(Equivalent, "game/objmain.c"),
             Object(Matching, "game/fault.c"),
             Object(Matching, "game/gamework.c"),
             Object(Matching, "game/objsysobj.c"),
-            Object(Matching, "game/objdll.c"),
+            Object(Equivalent, "game/objdll.c"),
             Object(Matching, "game/frand.c"),
-            Object(Matching, "game/audio.c"),
-            Object(Matching, "game/EnvelopeExec.c"),
+            Object(Equivalent, "game/audio.c"),
+            Object(Equivalent, "game/EnvelopeExec.c"),
             Object(Matching, "game/minigame_seq.c"),
             Object(Matching, "game/ovllist.c"),
             Object(Matching, "game/esprite.c"),
             Object(Matching, "game/code_8003FF68.c"),
-            Object(Matching, "game/ClusterExec.c"),
-            Object(Matching, "game/ShapeExec.c"),
+            Object(Equivalent, "game/ClusterExec.c"),
+            Object(Equivalent, "game/ShapeExec.c"),
             Object(Matching, "game/wipe.c"),
             Object(Matching, "game/window.c"),
             Object(Matching, "game/messdata.c"),
             Object(Matching, "game/card.c"),
-            Object(Matching, "game/armem.c"),
+            Object(Equivalent, "game/armem.c"),
             Object(Matching, "game/chrman.c"),
             Object(Matching, "game/mapspace.c"),
             Object(Matching, "game/THPSimple.c"),
@@ -849,10 +849,10 @@ config.libs = [
         "cflags": cflags_msm,
         "objects": [
             Object(MatchingFor("GMPE01_00", "GMPE01_01"), "msm/msmsys.c"),
-            Object(MatchingFor("GMPE01_00", "GMPE01_01"), "msm/msmmem.c"),
+            Object(Equivalent, "msm/msmmem.c"),
             Object(MatchingFor("GMPE01_00", "GMPE01_01"), "msm/msmfio.c"),
             Object(MatchingFor("GMPE01_00", "GMPE01_01"), "msm/msmmus.c"),
-            Object(MatchingFor("GMPE01_00", "GMPE01_01"), "msm/msmse.c"),
+            Object(Equivalent, "msm/msmse.c"),
             Object(MatchingFor("GMPE01_00", "GMPE01_01"), "msm/msmstream.c"),
         ],
     },
@@ -33,7 +33,7 @@ typedef struct vec2f {
 #define atan2d(y, x) (180.0*(atan2((y), (x)) / M_PI))
 
 #ifndef __MWERKS__
-void HuSetVecF(Vec* arg0, f32 arg8, f32 arg9, f32 argA)
+void HuSetVecF(Vec* arg0, f32 arg8, f32 arg9, f32 argA);
 #endif
 
 #endif
@@ -3,6 +3,8 @@
 
 #include "game/hsfformat.h"
 
+void InitShape(HsfData *arg0);
 void ShapeProc(HsfData *arg0);
+void ShapeDirtySet(HsfData *arg0, s32 arg1);
 
 #endif
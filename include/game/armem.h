@@ -5,15 +5,32 @@
 #include "game/memory.h"
 #include "game/data.h"
 
+typedef struct ar_dma_range {
+    u32 amemptr;
+    u32 ofs;
+    void *mram;
+    u32 size;
+} ARDMARange;
+
+typedef BOOL (*ARReclaimFunc)(void);
+
 void HuARInit(void);
 u32 HuARMalloc(u32 size);
 void HuARFree(u32 amemptr);
+u32 HuARCompact(void);
+void HuARReclaimSet(ARReclaimFunc func);
 void HuAMemDump(void);
 u32 HuAR_DVDtoARAM(u32 dir);
 u32 HuAR_MRAMtoARAM(s32 dir);
 u32 HuAR_MRAMtoARAM2(void *dir_ptr);
+u32 HuAR_MRAMtoARAMList(s32 *dirs, s32 num, u32 prio);
 void HuAR_ARAMtoMRAM(u32 amemptr);
 void *HuAR_ARAMtoMRAMNum(u32 amemptr, s32 num);
+u32 HuAR_ARAMtoMRAMList(s32 *dirs, s32 num, s32 mem_num, u32 prio);
+u32 HuARDMARead(ARDMARange *range, s32 num, u32 prio);
+u32 HuARDMAWrite(ARDMARange *range, s32 num, u32 prio);
+BOOL HuARFenceCheck(u32 fence);
+void HuARFenceWait(u32 fence);
 s32 HuARDMACheck(void);
 u32 HuARDirCheck(u32 dir);
 void HuARDirFree(u32 dir);
@@ -33,6 +33,7 @@ void HuAudFXListnerSetEX(Vec *pos, Vec *heading, float sndDist, float sndSpeed,
 void HuAudFXListnerUpdate(Vec *pos, Vec *heading);
 int HuAudFXEmiterPlay(int seId, Vec *pos);
 void HuAudFXEmiterUpDate(int seNo, Vec *pos);
+void HuAudFXEmiterUpDateList(int *seNo, Vec *pos, s32 num);
 void HuAudFXListnerKill(void);
 void HuAudFXPauseAll(s32 pause);
 s32 HuAudFXStatusGet(int seNo);
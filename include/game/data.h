@@ -29,6 +29,34 @@ struct data_read_stat {
     DVDFileInfo file_info;
 };
 
+struct decode_data {
+    u8 *src;
+    u8 *dst;
+    u32 size;
+    u8 *src_end;
+    u8 *base_dst;
+    u32 flag;
+    u32 num_bits;
+    BOOL header;
+};
+
+typedef struct data_cache_stat {
+    u32 hit;
+    u32 miss;
+    u32 evict;
+} DataCacheStat;
+
+#define DECODE_STREAM_CARRY_MAX 256
+
+typedef struct decode_stream {
+    struct decode_data decode;
+    void *dst;
+    u32 size;
+    s32 decode_type;
+    u32 carry_len;
+    u8 carry[DECODE_STREAM_CARRY_MAX];
+} DecodeStream;
+
 void HuDataInit(void);
 s32 HuDataReadChk(s32 data_num);
 DataReadStat *HuDataGetStatus(void *dir_ptr);
@@ -38,6 +66,11 @@ DataReadStat *HuDataDirReadNum(s32 data_num, s32 num);
 DataReadStat *HuDataDirSet(void *dir_ptr, s32 data_num);
 void HuDataDirReadAsyncCallBack(s32 result, DVDFileInfo* fileInfo);
 s32 HuDataDirReadAsync(s32 data_num);
+s32 HuDataDirPrefetch(s32 data_num);
+BOOL HuDataDirPrefetchDone(s32 data_num);
+s32 HuDataDirPrefetchClose(void);
+void HuDataDirLogStart(s16 *log, s32 max);
+s32 HuDataDirLogEnd(void);
 s32 HuDataDirReadNumAsync(s32 data_num, s32 num);
 BOOL HuDataGetAsyncStat(s32 status);
 void *HuDataRead(s32 data_num);
@@ -50,9 +83,14 @@ void HuDataClose(void *ptr);
 void HuDataCloseMulti(void **ptrs);
 void HuDataDirClose(s32 data_id);
 void HuDataDirCloseNum(s32 num);
+void HuDataCacheStatGet(DataCacheStat *stat);
+void HuDataCacheStatReset(void);
 void *HuDataReadNumHeapShortForce(s32 data_id, s32 num, HeapID heap);
 
 void HuDecodeData(void *src, void *dst, u32 size, s32 decode_type);
+void HuDecodeStreamBegin(DecodeStream *stream, void *dst, u32 size, s32 decode_type);
+BOOL HuDecodeStreamFeed(DecodeStream *stream, void *src, u32 len);
+void HuDecodeStreamEnd(DecodeStream *stream);
 
 extern u32 DirDataSize;
 
@@ -4,6 +4,12 @@
 #include "dolphin.h"
 #include "game/memory.h"
 
+#define DVD_REQ_MAX 16
+
+#define DVD_PRIO_PREFETCH 0
+#define DVD_PRIO_ASYNC 1
+#define DVD_PRIO_WAIT 2
+
 typedef struct data_read_stat DataReadStat;
 
 typedef struct file_list_entry {
@@ -17,8 +23,17 @@ void *HuDvdDataReadDirect(char *path, HeapID heap);
 void *HuDvdDataFastRead(s32 entrynum);
 void *HuDvdDataFastReadNum(s32 entrynum, s32 num);
 void *HuDvdDataFastReadAsync(s32 entrynum, DataReadStat *stat);
+void *HuDvdDataFastReadNumAsync(s32 entrynum, s32 num, DataReadStat *stat);
+void *HuDvdDataFastPrefetch(s32 entrynum, DataReadStat *stat);
 void HuDvdDataClose(void *ptr);
 void HuDvdErrorWatch();
+s32 HuDvdReqFastRead(s32 entrynum, HeapID heap, s32 prio, DVDCallback cb);
+s32 HuDvdReqFreeGet(void);
+BOOL HuDvdReqCheck(s32 req);
+void *HuDvdReqWait(s32 req);
+void HuDvdReqWaitAll(void);
+void HuDvdReqPrioSet(s32 req, s32 prio);
+void HuDvdFilePrioSet(DVDFileInfo *file, s32 prio);
 
 
 #endif
\ No newline at end of file
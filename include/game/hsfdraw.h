@@ -58,6 +58,9 @@ void Hu3DDraw(ModelData *arg0, Mtx arg1, Vec *arg2);
 s32 ObjCullCheck(HsfData *arg0, HsfObject *arg1, Mtx arg2);
 void Hu3DDrawPost(void);
 void MakeDisplayList(s16 arg0, u32 arg1);
+void Hu3DDLCacheRelease(HsfData *arg0);
+void Hu3DDLCacheClear(void);
+void Hu3DDLCacheDump(void);
 HsfConstData *ObjConstantMake(HsfObject *arg0, u32 arg1);
 void mtxTransCat(Mtx arg0, float arg1, float arg2, float arg3);
 void mtxRotCat(Mtx arg0, float arg1, float arg2, float arg3);
@@ -84,5 +87,8 @@ extern u32 totalTexCnt;
 extern u32 totalTexCnted;
 extern u32 totalTexCacheCnt;
 extern u32 totalTexCacheCnted;
+extern u32 Hu3DDLCacheHitCnt;
+extern u32 Hu3DDLCacheSaveSize;
+extern u32 Hu3DDLCacheSaveTick;
 
 #endif
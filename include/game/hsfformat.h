@@ -375,6 +375,97 @@ typedef struct hsf_matrix {
     Mtx *data;
 } HsfMatrix;
 
+//Name lookup tables built by LoadHSF, shared by linked copies of the model
+typedef struct hsf_name_index {
+    s16 objectHashNum;
+    s16 skeletonHashNum;
+    s16 *objectHash;
+    s16 *objectNext;
+    s16 *skeletonHash;
+    s16 *skeletonNext;
+    s16 *objectSkeleton;
+} HsfNameIndex;
+
+//Object and parent indices in parent-before-child order, parent is -1 for the root
+typedef struct hsf_joint_order {
+    s16 object;
+    s16 parent;
+} HsfJointOrder;
+
+//Cenv lists of one mesh regrouped for the skinning loops, targets are slots into a per-mesh palette
+typedef struct hsf_skin_single {
+    u16 slot;
+    u16 pos;
+    u16 posCnt;
+    u16 normal;
+    u16 normalCnt;
+} HsfSkinSingle;
+
+typedef struct hsf_skin_dual {
+    u16 slot1;
+    u16 slot2;
+    u32 weightCnt;
+    HsfCenvDualWeight *weight;
+} HsfSkinDual;
+
+//Multi vertices with the same influence count, slot and weight hold influenceCnt entries per vertex
+typedef struct hsf_skin_multi {
+    u32 influenceCnt;
+    u32 vtxCnt;
+    u16 *pos;
+    u16 *normal;
+    u16 *slot;
+    float *weight;
+} HsfSkinMulti;
+
+typedef struct hsf_skin_copy {
+    u32 start;
+    u32 count;
+} HsfSkinCopy;
+
+typedef struct hsf_skin_mesh {
+    u32 slotCnt;
+    u32 *slotTarget;
+    u8 *slotFlag;
+    u32 singleCnt;
+    HsfSkinSingle *single;
+    u32 dualCnt;
+    HsfSkinDual *dual;
+    u32 multiCnt;
+    HsfSkinMulti *multi;
+    u32 copyCnt;
+    HsfSkinCopy *copy;
+} HsfSkinMesh;
+
+//One entry per mesh object in object order, shared by linked copies of the model
+typedef struct hsf_skin {
+    u32 meshCnt;
+    HsfSkinMesh *mesh;
+} HsfSkin;
+
+//Vertices a morph target moves away from the first shape, indices are ascending
+typedef struct hsf_morph_target {
+    u32 deltaCnt;
+    u16 *index;
+    Vec *delta;
+} HsfMorphTarget;
+
+//Weights last written to the mesh's vertex buffer, which linked copies share
+typedef struct hsf_morph_mesh {
+    u16 object;
+    u8 valid;
+    u8 targetCnt;
+    HsfMorphTarget *target;
+    float baseMorph;
+    float morphWeight[33];
+    float coef[33];
+} HsfMorphMesh;
+
+typedef struct hsf_morph {
+    u32 meshCnt;
+    HsfMorphMesh *mesh;
+} HsfMorph;
+
 typedef struct hsf_data {
     u8 magic[8];
     HsfScene *scene;
@@ -416,6 +507,11 @@ typedef struct hsf_data {
     s16 mapAttrCnt;
     s16 motionCnt;
     s16 matrixCnt;
+    HsfNameIndex *nameIndex;
+    HsfJointOrder *jointOrder;
+    s32 jointOrderCnt;
+    HsfSkin *skin;
+    HsfMorph *morph;
 } HsfData;
 
 #endif
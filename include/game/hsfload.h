@@ -4,6 +4,12 @@
 #include "game/hsfformat.h"
 
 HsfData *LoadHSF(void *data);
+void KillHSF(HsfData *data);
+s32 SearchObjectName(HsfData *data, char *name);
+s32 SearchObjectNameNext(HsfData *data, s32 index);
+s32 SearchSkeletonName(HsfData *data, char *name);
+s32 SearchSkeletonNameNext(HsfData *data, s32 index);
+s32 SearchObjectSkeleton(HsfData *data, s32 index);
 void ClusterAdjustObject(HsfData *model, HsfData *src_model);
 char *SetName(u32 *str_ofs);
 char *MakeObjectName(char *name);
@@ -314,6 +314,8 @@ extern s32 shadowModelDrawF;
 extern s16 Hu3DCameraNo;
 extern s16 Hu3DCameraBit;
 extern s16 Hu3DPauseF;
+extern u32 Hu3DModelVisitCnt;
+extern u32 Hu3DModelVisitCnted;
 extern GXColor BGColor;
 
 #endif
@@ -14,8 +14,46 @@ typedef enum {
     HEAP_MAX
 } HeapID;
 
+#define HUMEM_STAT_SIZE_MAX 16
+#define HUMEM_STAT_CALL_MAX 64
+
+typedef struct humem_call_stat {
+    u32 retaddr;
+    s32 num;
+    s32 size;
+} HuMemCallStat;
+
+typedef struct humem_stat {
+    s32 used_size;
+    s32 peak_size;
+    s32 used_num;
+    s32 peak_num;
+    u32 alloc_count;
+    u32 free_count;
+    u32 fail_count;
+    u32 size_hist[HUMEM_STAT_SIZE_MAX];
+    HuMemCallStat call[HUMEM_STAT_CALL_MAX];
+    s32 other_num;
+    s32 other_size;
+} HuMemStat;
+
+typedef struct humem_snapshot {
+    s32 used_size;
+    s32 peak_size;
+    s32 used_num;
+    s32 peak_num;
+    s32 free_size;
+    s32 free_max;
+    s32 free_num;
+    u32 alloc_count;
+    u32 free_count;
+    u32 fail_count;
+} HuMemSnapshot;
+
 void HuMemInitAll(void);
 void *HuMemInit(void *ptr, s32 size);
+void *HuMemInitBin(void *ptr, s32 size);
+void *HuMemInitStat(void *ptr, s32 size);
 void HuMemDCFlushAll();
 void HuMemDCFlush(HeapID heap);
 void *HuMemDirectMalloc(HeapID heap, s32 size);
@@ -26,8 +64,15 @@ s32 HuMemUsedMallocSizeGet(HeapID heap);
 s32 HuMemUsedMallocBlockGet(HeapID heap);
 u32 HuMemHeapSizeGet(HeapID heap);
 void *HuMemHeapPtrGet(HeapID heap);
+HuMemStat *HuMemStatGet(HeapID heap);
+void HuMemSnapshotGet(HuMemSnapshot *snap);
+void HuMemSnapshotDiff(HuMemSnapshot *prev, HuMemSnapshot *snap);
+void HuMemPeakReset(void);
+void HuMemStatDump(HeapID heap);
 
 void *HuMemHeapInit(void *ptr, s32 size);
+void *HuMemHeapInitBin(void *ptr, s32 size);
+void *HuMemHeapInitStat(void *ptr, s32 size);
 void *HuMemMemoryAlloc(void *heap_ptr, s32 size, u32 retaddr);
 void *HuMemMemoryAllocNum(void *heap_ptr, s32 size, u32 num, u32 retaddr);
 void HuMemMemoryFree(void *ptr, u32 retaddr);
@@ -37,5 +82,9 @@ s32 HuMemUsedMemoryBlockGet(void *heap_ptr);
 s32 HuMemMemorySizeGet(void *ptr);
 s32 HuMemMemoryAllocSizeGet(s32 size);
 void HuMemHeapDump(void *heap_ptr, s16 status);
+HuMemStat *HuMemHeapStatGet(void *heap_ptr);
+void HuMemHeapSnapshot(void *heap_ptr, HuMemSnapshot *snap);
+void HuMemHeapPeakReset(void *heap_ptr);
+void HuMemHeapStatDump(void *heap_ptr);
 
 #endif
\ No newline at end of file
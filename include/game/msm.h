@@ -120,6 +120,19 @@ typedef struct msmInit_s {
 	u32 heapSize;
 } MSM_INIT;
 
+#define MSM_MEM_FIRSTFIT 0
+#define MSM_MEM_BESTFIT 1
+
+typedef struct msmMemStat_s {
+	u32 totalSize;
+	u32 useSize;
+	u32 peakSize;
+	u32 freeSize;
+	u32 largestFree;
+	u32 freeNum;
+	float fragRatio;
+} MSM_MEMSTAT;
+
 typedef struct msmSeParam_s {
 	s32 flag;
 	s8 vol;
@@ -166,7 +179,11 @@ s32 msmSysGetSampSize(BOOL baseGrp);
 s32 msmSysDelGroupBase(s32 grpNum);
 s32 msmSysSetAux(s32 auxA, s32 auxB);
 
+void msmMemSetMode(s32 mode);
+void msmMemGetStat(MSM_MEMSTAT *stat);
+
 s32 msmSeSetParam(int seNo, MSM_SEPARAM *param);
+s32 msmSeSetPosList(int *seNo, Vec *pos, s32 num);
 int msmSePlay(int seId, MSM_SEPARAM *param);
 s32 msmSeStop(int seNo, s32 speed);
 void msmSePauseAll(BOOL pause, s32 speed);
@@ -63,6 +63,8 @@ typedef struct om_dll_data {
 	OSModuleHeader *module;
 	void *bss;
 	s32 ret;
+	void *data;
+	s16 overlay;
 } omDllData;
 
 void omMasterInit(s32 prio, FileListEntry *ovl_list, s32 ovl_count, OverlayID start_ovl);
@@ -72,6 +74,13 @@ void omOvlReturnEx(s16 level, s16 arg2);
 void omOvlKill(s16 arg);
 void omOvlHisChg(s32 level, OverlayID overlay, s32 event, s32 stat);
 omOvlHisData *omOvlHisGet(s32 level);
+void omOvlManifestDLLAdd(s16 overlay);
+void omOvlManifestRecSet(BOOL rec);
+void omOvlMemCheckSet(BOOL check);
+void omOvlManifestDump(void);
+void omOvlPrefetch(OverlayID overlay);
+void omOvlPrefetchStop(void);
+void omOvlPrefetchExec(void);
 Process *omInitObjMan(s16 max_objs, s32 prio);
 void omDestroyObjMan(void);
 omObjData *omAddObjEx(Process *objman_process, s16 prio, u16 mdlcnt, u16 mtncnt, s16 group, omObjFunc func);
@@ -96,6 +105,11 @@ void omDLLInit(FileListEntry *ovl_list);
 s32 omDLLStart(s16 overlay, s16 flag);
 void omDLLNumEnd(s16 overlay, s16 flag);
 void omDLLEnd(s16 dllno, s16 flag);
+BOOL omDLLPrefetch(s16 overlay);
+s32 omDLLPrefetchClose(void);
+void omDLLResidentSet(u32 mram_size, u32 aram_size);
+void omDLLResidentFlush(void);
+void omDLLStatDump(void);
 omDllData *omDLLLink(omDllData **dll_ptr, s16 overlay, s16 flag);
 void omDLLUnlink(omDllData *dll_ptr, s16 flag);
 s32 omDLLSearch(s16 overlay);
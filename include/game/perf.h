@@ -3,10 +3,48 @@
 
 #include "dolphin.h"
 
+#define PERF_TRACE_PROCESS 0
+#define PERF_TRACE_OBJECT 1
+
+#define PERF_TRACE_EVENT_MAX 2048
+#define PERF_TRACE_FRAME_MAX 32
+#define PERF_TRACE_STAT_MAX 256
+
+typedef struct perf_trace_event {
+    u32 id;
+    u32 start;
+    u32 len;
+    u8 type;
+    u8 depth;
+} PerfTraceEvent;
+
+typedef struct perf_trace_frame {
+    u32 start;
+    u32 len;
+    u32 event_ofs;
+    u32 event_num;
+} PerfTraceFrame;
+
+//Time spent in one process or object function, all in OSGetTick units
+typedef struct perf_trace_stat {
+    u32 id;
+    u32 type;
+    u32 num;
+    u64 total;
+    u32 frame_len;
+    u32 frame_max;
+} PerfTraceStat;
+
 void HuPerfInit(void);
 s32 HuPerfCreate(char *arg0, u8 arg1, u8 arg2, u8 arg3, u8 arg4);
 void HuPerfZero(void);
 void HuPerfBegin(s32 arg0);
 void HuPerfEnd(s32 arg0);
+s32 HuPerfTraceBegin(u32 id, s32 type);
+void HuPerfTraceEnd(s32 depth);
+PerfTraceStat *HuPerfTraceStatGet(u32 id);
+void HuPerfTraceStatReset(void);
+void HuPerfTraceStatDump(void);
+void HuPerfTraceDump(void);
 
 #endif
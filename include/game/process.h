@@ -8,6 +8,9 @@
 #define PROCESS_STAT_UPAUSE 0x2
 #define PROCESS_STAT_PAUSE_EN 0x4
 #define PROCESS_STAT_UPAUSE_EN 0x8
+#define PROCESS_STAT_KILL_HOLD 0x10
+
+#define PROCESS_STACK_STAT_MAX 64
 
 typedef struct process {
     struct process *next;
@@ -25,8 +28,26 @@ typedef struct process {
     jmp_buf jump;
     void (*dtor)(void);
     void *user_data;
+    struct process *run_next;
+    struct process *run_prev;
+    struct process *wait_next;
+    struct process *wait_prev;
+    u32 seq;
+    s32 wake_tick;
+    u16 sched;
+    s16 pool;
+    u32 stack_size;
+    void (*func)(void);
 } Process;
 
+//Deepest stack use seen for each process function, gathered when its processes end
+typedef struct process_stack_stat {
+    void (*func)(void);
+    u32 stack_size;
+    u32 used_max;
+    u32 num;
+} ProcessStackStat;
+
 void HuPrcInit(void);
 void HuPrcEnd(void);
 Process *HuPrcCreate(void (*func)(void), u16 prio, u32 stack_size, s32 extra_size);
@@ -36,6 +57,7 @@ Process *HuPrcChildCreate(void (*func)(void), u16 prio, u32 stack_size, s32 extr
 void HuPrcChildWatch(void);
 Process *HuPrcCurrentGet(void);
 s32 HuPrcKill(Process *process);
+BOOL HuPrcKillChk(Process *process);
 void HuPrcChildKill(Process *process);
 void HuPrcSleep(s32 time);
 void HuPrcVSleep();
@@ -49,5 +71,9 @@ void HuPrcSetStat(Process *process, u16 value);
 void HuPrcResetStat(Process *process, u16 value);
 void HuPrcAllPause(s32 flag);
 void HuPrcAllUPause(s32 flag);
+u32 HuPrcStackUsedGet(Process *process);
+ProcessStackStat *HuPrcStackStatGet(s32 *num);
+void HuPrcStackStatDump(void);
+void HuPrcPoolFlush(void);
 
 #endif
\ No newline at end of file
@@ -1,10 +1,12 @@
 #ifndef MSMMEM_H
 #define MSMMEM_H
 
-#include "dolphin/types.h"
+#include "game/msm.h"
 
 void msmMemFree(void *ptr);
 void *msmMemAlloc(u32 sze);
 void msmMemInit(void *ptr, u32 size);
+void msmMemSetMode(s32 mode);
+void msmMemGetStat(MSM_MEMSTAT *stat);
 
 #endif
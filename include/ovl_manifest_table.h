@@ -0,0 +1,106 @@
+//Overlay manifests printed by omOvlManifestDump after a run with omOvlManifestRecSet(TRUE)
+//Generated by tools/ovl_manifest.py, each entry is replaced by what the overlay really loads once it has run
+OVL__MINI, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL__MINI,
+OVL_BOOT, OVL_MODESEL, 1, OM_OVL_MANIFEST_DLL|OVL_BOOT,
+OVL_E3SETUP, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_E3SETUP, DATADIR_ID_E3SETUP,
+OVL_INST, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_INST, DATADIR_ID_INST,
+OVL_M300, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M300,
+OVL_M302, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M302,
+OVL_M303, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M303,
+OVL_M330, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M330,
+OVL_M333, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M333,
+OVL_M401, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M401, DATADIR_ID_M401,
+OVL_M402, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M402, DATADIR_ID_M402, DATADIR_ID_MGCONST,
+OVL_M403, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M403, DATADIR_ID_M403, DATADIR_ID_MGCONST,
+OVL_M404, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M404, DATADIR_ID_MGCONST, DATADIR_ID_M404,
+OVL_M405, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M405, DATADIR_ID_MGCONST, DATADIR_ID_M405,
+OVL_M406, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M406, DATADIR_ID_M406,
+OVL_M407, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M407, DATADIR_ID_M407,
+OVL_M408, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M408, DATADIR_ID_M408, DATADIR_ID_MGCONST,
+OVL_M409, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M409, DATADIR_ID_M409, DATADIR_ID_MGCONST,
+OVL_M410, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_M410, DATADIR_ID_M410, DATADIR_ID_EFFECT, DATADIR_ID_MGCONST,
+OVL_M411, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M411, DATADIR_ID_M411, DATADIR_ID_MGCONST,
+OVL_M412, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M412, DATADIR_ID_M412, DATADIR_ID_EFFECT,
+OVL_M413, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M413, DATADIR_ID_M413, DATADIR_ID_MGCONST,
+OVL_M414, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M414, DATADIR_ID_M414, DATADIR_ID_EFFECT,
+OVL_M415, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M415,
+OVL_M416, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M416, DATADIR_ID_M416,
+OVL_M417, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M417, DATADIR_ID_M417,
+OVL_M418, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M418,
+OVL_M419, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M419, DATADIR_ID_M419, DATADIR_ID_EFFECT,
+OVL_M420, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M420,
+OVL_M421, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M421, DATADIR_ID_M421,
+OVL_M422, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_M422, DATADIR_ID_M422, DATADIR_ID_MGCONST, DATADIR_ID_EFFECT,
+OVL_M423, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M423, DATADIR_ID_M423, DATADIR_ID_MGCONST,
+OVL_M424, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M424,
+OVL_M425, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M425,
+OVL_M426, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M426, DATADIR_ID_M426, DATADIR_ID_MGCONST,
+OVL_M427, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M427,
+OVL_M428, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M428, DATADIR_ID_M428,
+OVL_M429, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M429, DATADIR_ID_MGCONST, DATADIR_ID_M429,
+OVL_M430, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M430, DATADIR_ID_M430, DATADIR_ID_MGCONST,
+OVL_M431, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M431, DATADIR_ID_M431, DATADIR_ID_MGCONST,
+OVL_M432, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M432, DATADIR_ID_MGCONST, DATADIR_ID_M432,
+OVL_M433, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M433, DATADIR_ID_M433, DATADIR_ID_M425,
+OVL_M434, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_M434, DATADIR_ID_M434, DATADIR_ID_MGCONST, DATADIR_ID_M430,
+OVL_M435, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M435, DATADIR_ID_M435, DATADIR_ID_MGCONST,
+OVL_M436, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M436, DATADIR_ID_M436,
+OVL_M437, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M437, DATADIR_ID_M437,
+OVL_M438, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M438, DATADIR_ID_M438,
+OVL_M439, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M439, DATADIR_ID_M439,
+OVL_M440, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M440, DATADIR_ID_M440,
+OVL_M441, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M441, DATADIR_ID_MGCONST, DATADIR_ID_M441,
+OVL_M442, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M442, DATADIR_ID_M442, DATADIR_ID_MGCONST,
+OVL_M443, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M443, DATADIR_ID_M443,
+OVL_M444, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M444, DATADIR_ID_M444,
+OVL_M445, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_M445, DATADIR_ID_M445, DATADIR_ID_MGCONST, DATADIR_ID_EFFECT,
+OVL_M446, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M446, DATADIR_ID_M446,
+OVL_M447, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M447, DATADIR_ID_M447,
+OVL_M448, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M448, DATADIR_ID_M448, DATADIR_ID_MGCONST,
+OVL_M449, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M449,
+OVL_M450, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M450, DATADIR_ID_MGCONST, DATADIR_ID_M450,
+OVL_M451, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M451, DATADIR_ID_M451, DATADIR_ID_MGCONST,
+OVL_M453, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M453,
+OVL_M455, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M455, DATADIR_ID_M455,
+OVL_M456, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_M456, DATADIR_ID_M456,
+OVL_M457, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_M457, DATADIR_ID_BKOOPA, DATADIR_ID_M457, DATADIR_ID_MGCONST,
+OVL_M458, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M458,
+OVL_M459, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_M459,
+OVL_M460, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M460, DATADIR_ID_M460, DATADIR_ID_MGCONST,
+OVL_M461, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_M461, DATADIR_ID_MGCONST, DATADIR_ID_M461,
+OVL_M462, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_M462, DATADIR_ID_M462, DATADIR_ID_EFFECT, DATADIR_ID_MGCONST,
+OVL_M463, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_M463, DATADIR_ID_BOARD, DATADIR_ID_M458, DATADIR_ID_BKOOPA,
+OVL_MENT, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_MENT, DATADIR_ID_MENT, OM_OVL_MANIFEST_ARAM|DATADIR_ID_BOARD, DATADIR_ID_W10,
+OVL_MGMODE, OVL_INST, 4, OM_OVL_MANIFEST_DLL|OVL_MGMODE, DATADIR_ID_MGMODE, DATADIR_ID_INSTPIC, DATADIR_ID_WIN,
+OVL_MODELTEST, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_MODELTEST, DATADIR_ID_SAF, DATADIR_ID_M407, DATADIR_ID_EFFECT,
+OVL_MODESEL, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_MODESEL, DATADIR_ID_MODESEL,
+#if VERSION_JP
+OVL_MOVIE, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_MOVIE,
+#endif
+#if !(VERSION_JP)
+OVL_MESS, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_MESS,
+#endif
+OVL_MPEX, OVL_ZTAR, 2, OM_OVL_MANIFEST_DLL|OVL_MPEX, DATADIR_ID_MPEX,
+OVL_MSETUP, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_MSETUP,
+OVL_MSTORY2, (u16)OVL_INVALID, 5, OM_OVL_MANIFEST_DLL|OVL_MSTORY2, DATADIR_ID_MSTORY2, OM_OVL_MANIFEST_ARAM|DATADIR_ID_BOARD, DATADIR_ID_WIN, DATADIR_ID_MSTORY4,
+OVL_MSTORY3, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_MSTORY3, DATADIR_ID_MSTORY3, DATADIR_ID_WIN, DATADIR_ID_EFFECT,
+OVL_MSTORY4, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_MSTORY4, OM_OVL_MANIFEST_ARAM|DATADIR_ID_BOARD, DATADIR_ID_W10,
+OVL_MSTORY, (u16)OVL_INVALID, 5, OM_OVL_MANIFEST_DLL|OVL_MSTORY, DATADIR_ID_MSTORY, OM_OVL_MANIFEST_ARAM|DATADIR_ID_BOARD, DATADIR_ID_MSTORY4, DATADIR_ID_WIN,
+OVL_NIS, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_NIS,
+OVL_OPTION, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_OPTION, DATADIR_ID_OPTION,
+OVL_PRESENT, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_PRESENT, DATADIR_ID_PRESENT,
+OVL_RESULT, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_RESULT, OM_OVL_MANIFEST_ARAM|DATADIR_ID_BOARD, DATADIR_ID_RESULT, DATADIR_ID_EFFECT,
+OVL_SAF, (u16)OVL_INVALID, 1, OM_OVL_MANIFEST_DLL|OVL_SAF,
+OVL_SELMENU, OVL_INST, 1, OM_OVL_MANIFEST_DLL|OVL_SELMENU,
+OVL_STAFF, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_STAFF, DATADIR_ID_STAFF,
+OVL_SUBCHRSEL, OVL_M433, 1, OM_OVL_MANIFEST_DLL|OVL_SUBCHRSEL,
+OVL_W01, (u16)OVL_INVALID, 5, OM_OVL_MANIFEST_DLL|OVL_W01, DATADIR_ID_W01, DATADIR_ID_BGUEST, DATADIR_ID_BOARD, DATADIR_ID_EFFECT,
+OVL_W02, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_W02, DATADIR_ID_W02, DATADIR_ID_EFFECT, DATADIR_ID_BOARD,
+OVL_W03, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_W03, DATADIR_ID_W03, DATADIR_ID_BOARD, DATADIR_ID_EFFECT,
+OVL_W04, (u16)OVL_INVALID, 5, OM_OVL_MANIFEST_DLL|OVL_W04, DATADIR_ID_W04, DATADIR_ID_BGUEST, DATADIR_ID_BOARD, DATADIR_ID_EFFECT,
+OVL_W05, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_W05, DATADIR_ID_W05, DATADIR_ID_BOARD, DATADIR_ID_EFFECT,
+OVL_W06, (u16)OVL_INVALID, 6, OM_OVL_MANIFEST_DLL|OVL_W06, DATADIR_ID_W06, DATADIR_ID_BGUEST, DATADIR_ID_BKOOPA, DATADIR_ID_BOARD, DATADIR_ID_EFFECT,
+OVL_W10, (u16)OVL_INVALID, 4, OM_OVL_MANIFEST_DLL|OVL_W10, DATADIR_ID_W10, DATADIR_ID_BGUEST, DATADIR_ID_BOARD,
+OVL_W20, (u16)OVL_INVALID, 2, OM_OVL_MANIFEST_DLL|OVL_W20, DATADIR_ID_W20,
+OVL_W21, (u16)OVL_INVALID, 3, OM_OVL_MANIFEST_DLL|OVL_W21, DATADIR_ID_W21, DATADIR_ID_BGUEST,
+OVL_ZTAR, OVL_M433, 4, OM_OVL_MANIFEST_DLL|OVL_ZTAR, DATADIR_ID_MPEX, DATADIR_ID_ZTAR, DATADIR_ID_INSTPIC,
@@ -4,7 +4,9 @@
 typedef unsigned long size_t;
 
 void* memcpy(void* dst, const void* src, size_t n);
+void* memmove(void* dst, const void* src, size_t n);
 void* memset(void* dst, int val, size_t n);
+int memcmp(const void* lhs, const void* rhs, size_t n);
 
 char* strrchr(const char* str, int c);
 char* strchr(const char* str, int c);
@@ -1,5 +1,6 @@
 #include "game/ClusterExec.h"
 #include "game/EnvelopeExec.h"
+#include "game/ShapeExec.h"
 #include "game/hsfmotion.h"
 #include "game/sprite.h"
 
@@ -120,6 +121,7 @@ void ClusterProc(ModelData *arg0) {
                     temp_r31 = temp_r23->object;
                     temp_r31 += var_r29->target;
                     Vertextop = temp_r31->data.vertex->data;
+                    ShapeDirtySet(temp_r23, var_r29->target);
                     if (temp_r31->data.cenvCnt) {
                         for (k = 0; k < temp_r31->data.vertex->count; k++) {
                             Vertextop[k].x = ((Vec*) temp_r31->data.file[0])[k].x;
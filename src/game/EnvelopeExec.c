@@ -1,11 +1,23 @@
 #include "game/EnvelopeExec.h"
 #include "game/hsfex.h"
+#include "game/hsfload.h"
+#include "game/memory.h"
 
+#include "math.h"
 #include "string.h"
 
+static void JointOrderBuild(HsfData *arg0);
+static void SkinBuild(HsfData *arg0);
+static s32 SkinMeshCount(HsfObject *arg0, HsfSkinMesh *arg1, u32 *arg2);
+static s32 SkinSlotAdd(HsfSkinMesh *arg0, u32 arg1, u8 arg2);
+static void *SkinCarve(u8 **arg0, u32 arg1);
+static void SkinMeshBuild(HsfObject *arg0, HsfSkinMesh *arg1, u8 **arg2);
+static void SetJointMtx(HsfTransform *arg0, MtxPtr arg1, MtxPtr arg2);
 static void SetEnvelopMtx(HsfObject *arg0, HsfObject *arg1, Mtx arg2);
 static void SetEnvelopMain(HsfData *arg0);
 static void SetEnvelop(HsfCenv *arg0);
+static void SetEnvelopSkin(HsfSkinMesh *arg0);
+static void SkinNrmMtxGet(Mtx arg0, Mtx arg1);
 static void SetMtx(HsfObject *arg0, Mtx arg1);
 static void SetRevMtx(void);
 static HsfSkeleton *SearchSklenton(char *arg0);
@@ -22,6 +34,19 @@ static Vec *normtop;
 static s32 Meshcnt;
 static s32 Meshno;
 
+#define SKIN_SLOT_MAX 64
+#define SKIN_INFLUENCE_MAX 16
+#define SKIN_ALIGN(x) (((x) + 3) & ~3)
+
+#define SKIN_SLOT_SINGLE 1
+#define SKIN_SLOT_MULTI 2
+
+static u32 skinSlotTarget[SKIN_SLOT_MAX];
+static u8 skinSlotFlag[SKIN_SLOT_MAX];
+static Mtx skinMtx[SKIN_SLOT_MAX];
+static Mtx skinNrmMtx[SKIN_SLOT_MAX];
+static Mtx skinMultiNrmMtx[SKIN_SLOT_MAX];
+
 void InitEnvelope(HsfData *arg0) {
     HsfBuffer *spC;
     HsfBuffer *sp8;
@@ -44,19 +69,18 @@ void InitEnvelope(HsfData *arg0) {
                     continue;
                 }
             }
-            var_r30 = arg0->skeleton;
-            for (j = 0; j < arg0->skeletonCnt; j++, var_r30++) {
-                if (strcmp(var_r31->name, var_r30->name) == 0) {
-                    var_r31->data.base.pos.x = var_r30->transform.pos.x;
-                    var_r31->data.base.pos.y = var_r30->transform.pos.y;
-                    var_r31->data.base.pos.z = var_r30->transform.pos.z;
-                    var_r31->data.base.rot.x = var_r30->transform.rot.x;
-                    var_r31->data.base.rot.y = var_r30->transform.rot.y;
-                    var_r31->data.base.rot.z = var_r30->transform.rot.z;
-                    var_r31->data.base.scale.x = var_r30->transform.scale.x;
-                    var_r31->data.base.scale.y = var_r30->transform.scale.y;
-                    var_r31->data.base.scale.z = var_r30->transform.scale.z;
-                }
+            j = SearchObjectSkeleton(arg0, i);
+            if (j != -1) {
+                var_r30 = &arg0->skeleton[j];
+                var_r31->data.base.pos.x = var_r30->transform.pos.x;
+                var_r31->data.base.pos.y = var_r30->transform.pos.y;
+                var_r31->data.base.pos.z = var_r30->transform.pos.z;
+                var_r31->data.base.rot.x = var_r30->transform.rot.x;
+                var_r31->data.base.rot.y = var_r30->transform.rot.y;
+                var_r31->data.base.rot.z = var_r30->transform.rot.z;
+                var_r31->data.base.scale.x = var_r30->transform.scale.x;
+                var_r31->data.base.scale.y = var_r30->transform.scale.y;
+                var_r31->data.base.scale.z = var_r30->transform.scale.z;
             }
             var_r31->data.curr.pos.x = var_r31->data.base.pos.x;
             var_r31->data.curr.pos.y = var_r31->data.base.pos.y;
@@ -79,6 +103,338 @@ void InitEnvelope(HsfData *arg0) {
         PSMTXIdentity(sp10);
         SetMtx(arg0->root, sp10);
         SetRevMtx();
+        JointOrderBuild(arg0);
+        SkinBuild(arg0);
+    }
+}
+
+// Lists the hierarchy breadth first so every parent comes before its children
+static void JointOrderBuild(HsfData *arg0) {
+    HsfJointOrder *var_r31;
+    HsfObject *var_r30;
+    s32 var_r29;
+    s32 i;
+    s32 j;
+
+    arg0->jointOrder = NULL;
+    arg0->jointOrderCnt = 0;
+    if (arg0->root == NULL || arg0->objectCnt == 0) {
+        return;
+    }
+    var_r31 = HuMemDirectMallocNum(HEAP_DATA, arg0->objectCnt * sizeof(HsfJointOrder), MEMORY_DEFAULT_NUM);
+    if (var_r31 == NULL) {
+        return;
+    }
+    var_r31[0].object = arg0->root - arg0->object;
+    var_r31[0].parent = -1;
+    var_r29 = 1;
+    for (i = 0; i < var_r29; i++) {
+        var_r30 = &arg0->object[var_r31[i].object];
+        for (j = 0; j < var_r30->data.childrenCount; j++) {
+            if (var_r29 >= arg0->objectCnt) {
+                // Shared children would be visited twice, keep the recursive walk for those
+                HuMemDirectFree(var_r31);
+                return;
+            }
+            var_r31[var_r29].object = var_r30->data.children[j] - arg0->object;
+            var_r31[var_r29].parent = var_r31[i].object;
+            var_r29++;
+        }
+    }
+    arg0->jointOrder = var_r31;
+    arg0->jointOrderCnt = var_r29;
+}
+
+// Regroups the cenv lists of every mesh so each frame only walks flat arrays
+// Meshes with too many targets or influences keep the cenv walk for the whole model
+static void SkinBuild(HsfData *arg0) {
+    HsfSkin *var_r31;
+    HsfObject *var_r30;
+    HsfSkinMesh sp10;
+    u32 sp8[SKIN_INFLUENCE_MAX + 1];
+    u8 *var_r29;
+    s32 var_r28;
+    s32 var_r27;
+    s32 var_r26;
+    s32 i;
+
+    arg0->skin = NULL;
+    var_r28 = var_r27 = 0;
+    var_r30 = arg0->object;
+    for (i = 0; i < arg0->objectCnt; i++, var_r30++) {
+        if (var_r30->type == 2) {
+            var_r26 = SkinMeshCount(var_r30, &sp10, sp8);
+            if (var_r26 < 0) {
+                return;
+            }
+            var_r27 += var_r26;
+            var_r28++;
+        }
+    }
+    if (var_r28 == 0) {
+        return;
+    }
+    var_r26 = sizeof(HsfSkin) + var_r28 * sizeof(HsfSkinMesh);
+    var_r31 = HuMemDirectMallocNum(HEAP_DATA, var_r26 + var_r27, MEMORY_DEFAULT_NUM);
+    if (var_r31 == NULL) {
+        return;
+    }
+    var_r31->meshCnt = var_r28;
+    var_r31->mesh = (HsfSkinMesh *)(var_r31 + 1);
+    var_r29 = (u8 *)var_r31 + var_r26;
+    var_r28 = 0;
+    var_r30 = arg0->object;
+    for (i = 0; i < arg0->objectCnt; i++, var_r30++) {
+        if (var_r30->type == 2) {
+            SkinMeshBuild(var_r30, &var_r31->mesh[var_r28++], &var_r29);
+        }
+    }
+    arg0->skin = var_r31;
+}
+
+// Fills the slot palette and the list sizes of a mesh, returns the bytes its arrays need or -1
+static s32 SkinMeshCount(HsfObject *arg0, HsfSkinMesh *arg1, u32 *arg2) {
+    HsfCenv *var_r31;
+    HsfCenvMulti *var_r30;
+    s32 var_r29;
+    s32 i;
+    s32 j;
+    s32 k;
+
+    memset(arg1, 0, sizeof(HsfSkinMesh));
+    memset(arg2, 0, (SKIN_INFLUENCE_MAX + 1) * sizeof(u32));
+    var_r31 = arg0->data.cenv;
+    for (i = 0; i < arg0->data.cenvCnt; i++, var_r31++) {
+        for (j = 0; j < var_r31->singleCount; j++) {
+            if (SkinSlotAdd(arg1, var_r31->singleData[j].target, SKIN_SLOT_SINGLE) < 0) {
+                return -1;
+            }
+        }
+        for (j = 0; j < var_r31->dualCount; j++) {
+            if (SkinSlotAdd(arg1, var_r31->dualData[j].target1, 0) < 0 || SkinSlotAdd(arg1, var_r31->dualData[j].target2, 0) < 0) {
+                return -1;
+            }
+        }
+        var_r30 = var_r31->multiData;
+        for (j = 0; j < var_r31->multiCount; j++, var_r30++) {
+            if (var_r30->weightCnt > SKIN_INFLUENCE_MAX) {
+                return -1;
+            }
+            for (k = 0; k < var_r30->weightCnt; k++) {
+                if (SkinSlotAdd(arg1, var_r30->weight[k].target, SKIN_SLOT_MULTI) < 0) {
+                    return -1;
+                }
+            }
+            arg2[var_r30->weightCnt]++;
+        }
+        arg1->singleCnt += var_r31->singleCount;
+        arg1->dualCnt += var_r31->dualCount;
+        if (var_r31->copyCount != 0) {
+            arg1->copyCnt++;
+        }
+    }
+    var_r29 = SKIN_ALIGN(arg1->slotCnt * sizeof(u32)) + SKIN_ALIGN(arg1->slotCnt);
+    var_r29 += SKIN_ALIGN(arg1->singleCnt * sizeof(HsfSkinSingle));
+    var_r29 += SKIN_ALIGN(arg1->dualCnt * sizeof(HsfSkinDual));
+    var_r29 += SKIN_ALIGN(arg1->copyCnt * sizeof(HsfSkinCopy));
+    for (k = 0; k <= SKIN_INFLUENCE_MAX; k++) {
+        if (arg2[k] != 0) {
+            arg1->multiCnt++;
+            var_r29 += sizeof(HsfSkinMulti);
+            var_r29 += 2 * SKIN_ALIGN(arg2[k] * sizeof(u16));
+            var_r29 += SKIN_ALIGN(arg2[k] * k * sizeof(u16));
+            var_r29 += arg2[k] * k * sizeof(float);
+        }
+    }
+    return var_r29;
+}
+
+// Returns the palette slot of a target, adding it while the mesh is being counted
+static s32 SkinSlotAdd(HsfSkinMesh *arg0, u32 arg1, u8 arg2) {
+    s32 i;
+
+    for (i = 0; i < arg0->slotCnt; i++) {
+        if (skinSlotTarget[i] == arg1) {
+            skinSlotFlag[i] |= arg2;
+            return i;
+        }
+    }
+    if (arg0->slotCnt >= SKIN_SLOT_MAX) {
+        return -1;
+    }
+    skinSlotTarget[i] = arg1;
+    skinSlotFlag[i] = arg2;
+    arg0->slotCnt++;
+    return i;
+}
+
+static void *SkinCarve(u8 **arg0, u32 arg1) {
+    void *var_r31;
+
+    var_r31 = *arg0;
+    *arg0 += SKIN_ALIGN(arg1);
+    return var_r31;
+}
+
+static void SkinMeshBuild(HsfObject *arg0, HsfSkinMesh *arg1, u8 **arg2) {
+    HsfCenv *var_r31;
+    HsfCenvSingle *var_r30;
+    HsfCenvDual *var_r29;
+    HsfCenvMulti *var_r28;
+    HsfSkinMulti *var_r27;
+    HsfSkinMulti *sp10[SKIN_INFLUENCE_MAX + 1];
+    u32 sp8[SKIN_INFLUENCE_MAX + 1];
+    u32 var_r26;
+    u32 var_r25;
+    u32 var_r24;
+    s32 i;
+    s32 j;
+    s32 k;
+
+    SkinMeshCount(arg0, arg1, sp8);
+    arg1->slotTarget = SkinCarve(arg2, arg1->slotCnt * sizeof(u32));
+    arg1->single = SkinCarve(arg2, arg1->singleCnt * sizeof(HsfSkinSingle));
+    arg1->dual = SkinCarve(arg2, arg1->dualCnt * sizeof(HsfSkinDual));
+    arg1->copy = SkinCarve(arg2, arg1->copyCnt * sizeof(HsfSkinCopy));
+    arg1->multi = SkinCarve(arg2, arg1->multiCnt * sizeof(HsfSkinMulti));
+    memcpy(arg1->slotTarget, skinSlotTarget, arg1->slotCnt * sizeof(u32));
+    var_r27 = arg1->multi;
+    for (k = 0; k <= SKIN_INFLUENCE_MAX; k++) {
+        sp10[k] = NULL;
+        if (sp8[k] != 0) {
+            var_r27->influenceCnt = k;
+            var_r27->vtxCnt = 0;
+            var_r27->weight = SkinCarve(arg2, sp8[k] * k * sizeof(float));
+            var_r27->pos = SkinCarve(arg2, sp8[k] * sizeof(u16));
+            var_r27->normal = SkinCarve(arg2, sp8[k] * sizeof(u16));
+            var_r27->slot = SkinCarve(arg2, sp8[k] * k * sizeof(u16));
+            sp10[k] = var_r27++;
+        }
+    }
+    arg1->slotFlag = SkinCarve(arg2, arg1->slotCnt);
+    memcpy(arg1->slotFlag, skinSlotFlag, arg1->slotCnt);
+    var_r26 = var_r25 = var_r24 = 0;
+    var_r31 = arg0->data.cenv;
+    for (i = 0; i < arg0->data.cenvCnt; i++, var_r31++) {
+        var_r30 = var_r31->singleData;
+        for (j = 0; j < var_r31->singleCount; j++, var_r30++, var_r26++) {
+            arg1->single[var_r26].slot = SkinSlotAdd(arg1, var_r30->target, 0);
+            arg1->single[var_r26].pos = var_r30->pos;
+            arg1->single[var_r26].posCnt = var_r30->posCnt;
+            arg1->single[var_r26].normal = var_r30->normal;
+            arg1->single[var_r26].normalCnt = var_r30->normalCnt;
+        }
+        var_r29 = var_r31->dualData;
+        for (j = 0; j < var_r31->dualCount; j++, var_r29++, var_r25++) {
+            arg1->dual[var_r25].slot1 = SkinSlotAdd(arg1, var_r29->target1, 0);
+            arg1->dual[var_r25].slot2 = SkinSlotAdd(arg1, var_r29->target2, 0);
+            arg1->dual[var_r25].weightCnt = var_r29->weightCnt;
+            arg1->dual[var_r25].weight = var_r29->weight;
+        }
+        var_r28 = var_r31->multiData;
+        for (j = 0; j < var_r31->multiCount; j++, var_r28++) {
+            var_r27 = sp10[var_r28->weightCnt];
+            var_r27->pos[var_r27->vtxCnt] = var_r28->pos;
+            var_r27->normal[var_r27->vtxCnt] = var_r28->normal;
+            for (k = 0; k < var_r28->weightCnt; k++) {
+                var_r27->slot[var_r27->vtxCnt * var_r28->weightCnt + k] = SkinSlotAdd(arg1, var_r28->weight[k].target, 0);
+                var_r27->weight[var_r27->vtxCnt * var_r28->weightCnt + k] = var_r28->weight[k].value;
+            }
+            var_r27->vtxCnt++;
+        }
+        if (var_r31->copyCount != 0) {
+            arg1->copy[var_r24].start = var_r31->vtxCount;
+            arg1->copy[var_r24].count = var_r31->copyCount;
+            var_r24++;
+        }
+    }
+}
+
+// Builds parent * T * Rz * Ry * Rx * S in one step, skipping the parts that are identity
+// The root has no parent and is written as its local matrix
+static void SetJointMtx(HsfTransform *arg0, MtxPtr arg1, MtxPtr arg2) {
+    Mtx sp8;
+    MtxPtr var_r31;
+    float temp_f31;
+    float temp_f30;
+    float temp_f29;
+    float temp_f28;
+    float temp_f27;
+    float temp_f26;
+
+    if (arg0->rot.x == 0.0f && arg0->rot.y == 0.0f && arg0->rot.z == 0.0f && arg0->scale.x == 1.0f && arg0->scale.y == 1.0f && arg0->scale.z == 1.0f) {
+        if (arg1 == NULL) {
+            PSMTXTrans(arg2, arg0->pos.x, arg0->pos.y, arg0->pos.z);
+            return;
+        }
+        temp_f31 = arg1[0][0] * arg0->pos.x + arg1[0][1] * arg0->pos.y + arg1[0][2] * arg0->pos.z + arg1[0][3];
+        temp_f30 = arg1[1][0] * arg0->pos.x + arg1[1][1] * arg0->pos.y + arg1[1][2] * arg0->pos.z + arg1[1][3];
+        temp_f29 = arg1[2][0] * arg0->pos.x + arg1[2][1] * arg0->pos.y + arg1[2][2] * arg0->pos.z + arg1[2][3];
+        PSMTXCopy(arg1, arg2);
+        arg2[0][3] = temp_f31;
+        arg2[1][3] = temp_f30;
+        arg2[2][3] = temp_f29;
+        return;
+    }
+    var_r31 = (arg1 == NULL) ? arg2 : sp8;
+    if (arg0->rot.x == 0.0f && arg0->rot.y == 0.0f && arg0->rot.z == 0.0f) {
+        var_r31[0][0] = 1.0f;
+        var_r31[0][1] = 0.0f;
+        var_r31[0][2] = 0.0f;
+        var_r31[1][0] = 0.0f;
+        var_r31[1][1] = 1.0f;
+        var_r31[1][2] = 0.0f;
+        var_r31[2][0] = 0.0f;
+        var_r31[2][1] = 0.0f;
+        var_r31[2][2] = 1.0f;
+    } else {
+        temp_f31 = temp_f28 = 1.0f;
+        temp_f30 = temp_f27 = 0.0f;
+        if (arg0->rot.x != 0.0f) {
+            temp_f31 = cosf(MTXDegToRad(arg0->rot.x));
+            temp_f30 = sinf(MTXDegToRad(arg0->rot.x));
+        }
+        if (arg0->rot.y != 0.0f) {
+            temp_f28 = cosf(MTXDegToRad(arg0->rot.y));
+            temp_f27 = sinf(MTXDegToRad(arg0->rot.y));
+        }
+        if (arg0->rot.z != 0.0f) {
+            temp_f29 = cosf(MTXDegToRad(arg0->rot.z));
+            temp_f26 = sinf(MTXDegToRad(arg0->rot.z));
+        } else {
+            temp_f29 = 1.0f;
+            temp_f26 = 0.0f;
+        }
+        var_r31[0][0] = temp_f29 * temp_f28;
+        var_r31[0][1] = temp_f29 * temp_f27 * temp_f30 - temp_f26 * temp_f31;
+        var_r31[0][2] = temp_f29 * temp_f27 * temp_f31 + temp_f26 * temp_f30;
+        var_r31[1][0] = temp_f26 * temp_f28;
+        var_r31[1][1] = temp_f26 * temp_f27 * temp_f30 + temp_f29 * temp_f31;
+        var_r31[1][2] = temp_f26 * temp_f27 * temp_f31 - temp_f29 * temp_f30;
+        var_r31[2][0] = -temp_f27;
+        var_r31[2][1] = temp_f28 * temp_f30;
+        var_r31[2][2] = temp_f28 * temp_f31;
+    }
+    if (arg0->scale.x != 1.0f) {
+        var_r31[0][0] *= arg0->scale.x;
+        var_r31[1][0] *= arg0->scale.x;
+        var_r31[2][0] *= arg0->scale.x;
+    }
+    if (arg0->scale.y != 1.0f) {
+        var_r31[0][1] *= arg0->scale.y;
+        var_r31[1][1] *= arg0->scale.y;
+        var_r31[2][1] *= arg0->scale.y;
+    }
+    if (arg0->scale.z != 1.0f) {
+        var_r31[0][2] *= arg0->scale.z;
+        var_r31[1][2] *= arg0->scale.z;
+        var_r31[2][2] *= arg0->scale.z;
+    }
+    var_r31[0][3] = arg0->pos.x;
+    var_r31[1][3] = arg0->pos.y;
+    var_r31[2][3] = arg0->pos.z;
+    if (arg1 != NULL) {
+        PSMTXConcat(arg1, sp8, arg2);
     }
 }
 
@@ -128,6 +484,8 @@ static void SetEnvelopMtx(HsfObject *arg0, HsfObject *arg1, Mtx arg2) {
 void EnvelopeProc(HsfData *arg0) {
     HsfMatrix *temp_r31;
     HsfObject *temp_r29;
+    HsfJointOrder *var_r30;
+    s32 i;
     Mtx sp8;
 
     CurHsf = arg0;
@@ -136,8 +494,15 @@ void EnvelopeProc(HsfData *arg0) {
     nObj = temp_r31->count;
     nMesh = temp_r31->base_idx;
     temp_r29 = arg0->root;
-    PSMTXIdentity(sp8);
-    SetEnvelopMtx(arg0->object, temp_r29, sp8);
+    if (arg0->jointOrder != NULL) {
+        var_r30 = arg0->jointOrder;
+        for (i = 0; i < arg0->jointOrderCnt; i++, var_r30++) {
+            SetJointMtx(&arg0->object[var_r30->object].data.curr, (var_r30->parent != -1) ? MtxTop[nMesh + var_r30->parent] : NULL, MtxTop[nMesh + var_r30->object]);
+        }
+    } else {
+        PSMTXIdentity(sp8);
+        SetEnvelopMtx(arg0->object, temp_r29, sp8);
+    }
     SetEnvelopMain(arg0);
 }
 
@@ -178,9 +543,13 @@ static void SetEnvelopMain(HsfData *arg0) {
             vtxenv = temp_r30->data;
             normtop = var_r31->data.file[1];
             normenv = temp_r28->data;
-            var_r25 = var_r31->data.cenv;
-            for (j = 0; j < var_r31->data.cenvCnt; j++, var_r25++) {
-                SetEnvelop(var_r25);
+            if (arg0->skin != NULL) {
+                SetEnvelopSkin(&arg0->skin->mesh[Meshno]);
+            } else {
+                var_r25 = var_r31->data.cenv;
+                for (j = 0; j < var_r31->data.cenvCnt; j++, var_r25++) {
+                    SetEnvelop(var_r25);
+                }
             }
             sp10 = temp_r30->data;
             spC = var_r31->data.file[0];
@@ -235,7 +604,7 @@ static void SetEnvelop(HsfCenv *arg0) {
         temp_r26 = &normtop[temp_r18];
         PSMTXConcat(MtxTop[nMesh + var_r27->target], MtxTop[nMesh + nObj + nObj * Meshno + var_r27->target], sp140);
         PSMTXConcat(MtxTop[Meshno], sp140, sp1A0);
-        Hu3DMtxScaleGet(&sp1A0[0], &sp14);
+        Hu3DMtxScaleGet(sp1A0, &sp14);
         if (sp14.x != 1.0f || sp14.y != 1.0f || sp14.z != 1.0f) {
             PSMTXScale(spE0, 1.0 / sp14.x, 1.0 / sp14.y, 1.0 / sp14.z);
             PSMTXConcat(spE0, sp1A0, sp170);
@@ -263,7 +632,7 @@ static void SetEnvelop(HsfCenv *arg0) {
         PSMTXConcat(MtxTop[nMesh + spC], MtxTop[nMesh + nObj + nObj * Meshno + spC], sp140);
         PSMTXConcat(MtxTop[Meshno], sp140, sp1A0);
         PSMTXConcat(MtxTop[nMesh + sp8], MtxTop[nMesh + nObj + nObj * Meshno + sp8], sp140);
-        PSMTXConcat(MtxTop[Meshno], sp140, (float (*)[4]) &spB0[0]);
+        PSMTXConcat(MtxTop[Meshno], sp140, spB0);
         var_r30 = var_r20->weight;
         for (j = 0; j < var_r20->weightCnt; j++, var_r30++) {
             temp_r18 = var_r30->normal;
@@ -318,7 +687,7 @@ static void SetEnvelop(HsfCenv *arg0) {
             if (var_r29 == sp50) {
                 PSMTXCopy(sp50, sp80);
             }
-            Hu3DMtxScaleGet(&sp80[0], &sp14);
+            Hu3DMtxScaleGet(sp80, &sp14);
             if (sp14.x != 1.0f || sp14.y != 1.0f || sp14.z != 1.0f) {
                 PSMTXScale(spE0, 1.0 / sp14.x, 1.0 / sp14.y, 1.0 / sp14.z);
                 PSMTXConcat(spE0, sp80, sp110);
@@ -390,6 +759,158 @@ static void SetEnvelop(HsfCenv *arg0) {
     }
 }
 
+// Same results as SetEnvelop over the mesh's cenv list
+// Every target matrix is built once per mesh instead of once per vertex group or influence
+static void SetEnvelopSkin(HsfSkinMesh *arg0) {
+    HsfSkinSingle *var_r31;
+    HsfSkinDual *var_r30;
+    HsfSkinMulti *var_r29;
+    HsfCenvDualWeight *var_r28;
+    HsfSkinCopy *var_r27;
+    u16 *var_r26;
+    float *var_r25;
+    Vec *temp_r24;
+    Vec *temp_r23;
+    Vec *temp_r22;
+    Vec *temp_r21;
+    MtxPtr temp_r20;
+    MtxPtr temp_r19;
+    u32 temp_r18;
+    s32 i;
+    s32 j;
+    s32 k;
+    float temp_f31;
+    float temp_f30;
+    Vec sp2C;
+    Vec sp20;
+    Mtx sp140;
+    Mtx sp110;
+    Mtx spE0;
+    Mtx spB0;
+
+    for (i = 0; i < arg0->slotCnt; i++) {
+        temp_r18 = arg0->slotTarget[i];
+        PSMTXConcat(MtxTop[nMesh + temp_r18], MtxTop[nMesh + nObj + nObj * Meshno + temp_r18], sp140);
+        PSMTXConcat(MtxTop[Meshno], sp140, skinMtx[i]);
+        if (arg0->slotFlag[i] & SKIN_SLOT_SINGLE) {
+            SkinNrmMtxGet(skinMtx[i], skinNrmMtx[i]);
+        }
+        if (arg0->slotFlag[i] & SKIN_SLOT_MULTI) {
+            PSMTXInvXpose(skinMtx[i], skinMultiNrmMtx[i]);
+        }
+    }
+    var_r31 = arg0->single;
+    for (i = 0; i < arg0->singleCnt; i++, var_r31++) {
+        temp_r24 = &Vertextop[var_r31->pos];
+        temp_r23 = &vtxenv[var_r31->pos];
+        temp_r22 = &normtop[var_r31->normal];
+        temp_r21 = &normenv[var_r31->normal];
+        temp_r20 = skinMtx[var_r31->slot];
+        temp_r19 = skinNrmMtx[var_r31->slot];
+        if (var_r31->posCnt == 1) {
+            PSMTXMultVec(temp_r20, temp_r24, temp_r23);
+            PSMTXMultVec(temp_r19, temp_r22, temp_r21);
+        } else if (var_r31->posCnt <= 6) {
+            PSMTXMultVecArray(temp_r20, temp_r24, temp_r23, var_r31->posCnt);
+            PSMTXMultVecArray(temp_r19, temp_r22, temp_r21, var_r31->normalCnt);
+        } else {
+            PSMTXReorder(temp_r20, (ROMtxPtr) sp140);
+            PSMTXReorder(temp_r19, (ROMtxPtr) sp110);
+            PSMTXROMultVecArray((ROMtxPtr) sp140, temp_r24, temp_r23, var_r31->posCnt);
+            PSMTXROMultVecArray((ROMtxPtr) sp110, temp_r22, temp_r21, var_r31->normalCnt);
+        }
+    }
+    var_r30 = arg0->dual;
+    for (i = 0; i < arg0->dualCnt; i++, var_r30++) {
+        temp_r20 = skinMtx[var_r30->slot1];
+        temp_r19 = skinMtx[var_r30->slot2];
+        var_r28 = var_r30->weight;
+        for (j = 0; j < var_r30->weightCnt; j++, var_r28++) {
+            temp_r24 = &Vertextop[var_r28->pos];
+            temp_r23 = &vtxenv[var_r28->pos];
+            temp_r22 = &normtop[var_r28->normal];
+            temp_r21 = &normenv[var_r28->normal];
+            temp_f31 = var_r28->weight;
+            temp_f30 = 1.0f - var_r28->weight;
+            for (k = 0; k < 3; k++) {
+                spB0[k][0] = temp_r19[k][0] * temp_f30 + temp_r20[k][0] * temp_f31;
+                spB0[k][1] = temp_r19[k][1] * temp_f30 + temp_r20[k][1] * temp_f31;
+                spB0[k][2] = temp_r19[k][2] * temp_f30 + temp_r20[k][2] * temp_f31;
+                spB0[k][3] = temp_r19[k][3] * temp_f30 + temp_r20[k][3] * temp_f31;
+            }
+            SkinNrmMtxGet(spB0, spE0);
+            if (var_r28->posCnt == 1) {
+                PSMTXMultVec(spB0, temp_r24, temp_r23);
+            } else if (var_r28->posCnt <= 6) {
+                PSMTXMultVecArray(spB0, temp_r24, temp_r23, var_r28->posCnt);
+            } else {
+                PSMTXReorder(spB0, (ROMtxPtr) sp140);
+                PSMTXROMultVecArray((ROMtxPtr) sp140, temp_r24, temp_r23, var_r28->posCnt);
+            }
+            if (var_r28->normalCnt != 0) {
+                if (var_r28->normalCnt == 1) {
+                    PSMTXMultVec(spE0, temp_r22, temp_r21);
+                } else if (var_r28->normalCnt <= 6) {
+                    PSMTXMultVecArray(spE0, temp_r22, temp_r21, var_r28->normalCnt);
+                } else {
+                    PSMTXReorder(spE0, (ROMtxPtr) sp140);
+                    PSMTXROMultVecArray((ROMtxPtr) sp140, temp_r22, temp_r21, var_r28->normalCnt);
+                }
+            }
+        }
+    }
+    // Each vertex sums weight * (M * v - v) over its influences, the inner loop length is fixed per group
+    var_r29 = arg0->multi;
+    for (i = 0; i < arg0->multiCnt; i++, var_r29++) {
+        var_r26 = var_r29->slot;
+        var_r25 = var_r29->weight;
+        for (j = 0; j < var_r29->vtxCnt; j++) {
+            temp_r24 = &Vertextop[var_r29->pos[j]];
+            temp_r22 = &normtop[var_r29->normal[j]];
+            sp2C.x = sp2C.y = sp2C.z = 0.0f;
+            sp20.x = sp20.y = sp20.z = 0.0f;
+            for (k = 0; k < var_r29->influenceCnt; k++, var_r26++, var_r25++) {
+                temp_r20 = skinMtx[*var_r26];
+                temp_r19 = skinMultiNrmMtx[*var_r26];
+                temp_f31 = *var_r25;
+                sp2C.x += temp_f31 * (temp_r20[0][0] * temp_r24->x + temp_r20[0][1] * temp_r24->y + temp_r20[0][2] * temp_r24->z + temp_r20[0][3] - temp_r24->x);
+                sp2C.y += temp_f31 * (temp_r20[1][0] * temp_r24->x + temp_r20[1][1] * temp_r24->y + temp_r20[1][2] * temp_r24->z + temp_r20[1][3] - temp_r24->y);
+                sp2C.z += temp_f31 * (temp_r20[2][0] * temp_r24->x + temp_r20[2][1] * temp_r24->y + temp_r20[2][2] * temp_r24->z + temp_r20[2][3] - temp_r24->z);
+                sp20.x += temp_f31 * (temp_r19[0][0] * temp_r22->x + temp_r19[0][1] * temp_r22->y + temp_r19[0][2] * temp_r22->z + temp_r19[0][3] - temp_r22->x);
+                sp20.y += temp_f31 * (temp_r19[1][0] * temp_r22->x + temp_r19[1][1] * temp_r22->y + temp_r19[1][2] * temp_r22->z + temp_r19[1][3] - temp_r22->y);
+                sp20.z += temp_f31 * (temp_r19[2][0] * temp_r22->x + temp_r19[2][1] * temp_r22->y + temp_r19[2][2] * temp_r22->z + temp_r19[2][3] - temp_r22->z);
+            }
+            temp_r23 = &vtxenv[var_r29->pos[j]];
+            temp_r21 = &normenv[var_r29->normal[j]];
+            temp_r23->x = temp_r24->x + sp2C.x;
+            temp_r23->y = temp_r24->y + sp2C.y;
+            temp_r23->z = temp_r24->z + sp2C.z;
+            temp_r21->x = temp_r22->x + sp20.x;
+            temp_r21->y = temp_r22->y + sp20.y;
+            temp_r21->z = temp_r22->z + sp20.z;
+        }
+    }
+    var_r27 = arg0->copy;
+    for (i = 0; i < arg0->copyCnt; i++, var_r27++) {
+        memcpy(&vtxenv[var_r27->start], &Vertextop[var_r27->start], var_r27->count * sizeof(Vec));
+    }
+}
+
+// Inverse transpose of the matrix with its scale taken out, used for single and dual normals
+static void SkinNrmMtxGet(Mtx arg0, Mtx arg1) {
+    Vec sp38;
+    Mtx sp8;
+
+    Hu3DMtxScaleGet(&arg0[0], &sp38);
+    if (sp38.x != 1.0f || sp38.y != 1.0f || sp38.z != 1.0f) {
+        PSMTXScale(sp8, 1.0 / sp38.x, 1.0 / sp38.y, 1.0 / sp38.z);
+        PSMTXConcat(sp8, arg0, arg1);
+        PSMTXInvXpose(arg1, arg1);
+    } else {
+        PSMTXInvXpose(arg0, arg1);
+    }
+}
+
 static void SetMtx(HsfObject *arg0, Mtx arg1) {
     HsfSkeleton *temp_r3;
     Mtx spFC;
@@ -450,14 +971,11 @@ static void SetRevMtx(void) {
 }
 
 static HsfSkeleton *SearchSklenton(char *arg0) {
-    HsfSkeleton *var_r31;
     s32 i;
 
-    var_r31 = CurHsf->skeleton;
-    for (i = 0; i < CurHsf->skeletonCnt; i++, var_r31++) {
-        if (strcmp(arg0, var_r31->name) == 0) {
-            return var_r31;
-        }
+    i = SearchSkeletonName(CurHsf, arg0);
+    if (i != -1) {
+        return &CurHsf->skeleton[i];
     }
     return NULL;
 }
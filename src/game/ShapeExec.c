@@ -1,5 +1,120 @@
 #include "game/ShapeExec.h"
 #include "game/EnvelopeExec.h"
+#include "game/memory.h"
+
+#include "string.h"
+
+#define MORPH_TARGET_MAX 33
+#define MORPH_ALIGN(x) (((x) + 3) & ~3)
+
+static BOOL MorphMeshCheck(HsfObject *arg0);
+static s32 MorphDeltaCount(HsfBuffer *arg0, HsfBuffer *arg1);
+static void SetShapeSparse(HsfObject *arg0, HsfMorphMesh *arg1);
+
+// Stores every shape as the vertices it moves away from the first shape
+// Meshes whose shapes differ in vertex count keep the dense blend
+void InitShape(HsfData *arg0) {
+    HsfMorph *var_r31;
+    HsfObject *var_r30;
+    HsfMorphMesh *var_r29;
+    HsfMorphTarget *var_r28;
+    Vec *temp_r27;
+    Vec *temp_r26;
+    u8 *var_r25;
+    s32 var_r24;
+    s32 var_r23;
+    s32 i;
+    s32 j;
+    s32 k;
+
+    arg0->morph = NULL;
+    var_r24 = var_r23 = 0;
+    var_r30 = arg0->object;
+    for (i = 0; i < arg0->objectCnt; i++, var_r30++) {
+        if (MorphMeshCheck(var_r30)) {
+            var_r23 += sizeof(HsfMorphMesh) + var_r30->data.vertexShapeCnt * sizeof(HsfMorphTarget);
+            for (j = 0; j < var_r30->data.vertexShapeCnt; j++) {
+                k = MorphDeltaCount(var_r30->data.vertexShape[0], var_r30->data.vertexShape[j]);
+                var_r23 += k * sizeof(Vec) + MORPH_ALIGN(k * sizeof(u16));
+            }
+            var_r24++;
+        }
+    }
+    if (var_r24 == 0) {
+        return;
+    }
+    var_r31 = HuMemDirectMallocNum(HEAP_DATA, sizeof(HsfMorph) + var_r23, MEMORY_DEFAULT_NUM);
+    if (var_r31 == NULL) {
+        return;
+    }
+    var_r31->meshCnt = var_r24;
+    var_r31->mesh = var_r29 = (HsfMorphMesh *)(var_r31 + 1);
+    var_r25 = (u8 *)&var_r29[var_r24];
+    var_r30 = arg0->object;
+    for (i = 0; i < arg0->objectCnt; i++, var_r30++) {
+        if (!MorphMeshCheck(var_r30)) {
+            continue;
+        }
+        memset(var_r29, 0, sizeof(HsfMorphMesh));
+        var_r29->object = i;
+        var_r29->targetCnt = var_r30->data.vertexShapeCnt;
+        var_r29->target = var_r28 = (HsfMorphTarget *)var_r25;
+        var_r25 += var_r29->targetCnt * sizeof(HsfMorphTarget);
+        temp_r27 = var_r30->data.vertexShape[0]->data;
+        for (j = 0; j < var_r29->targetCnt; j++, var_r28++) {
+            var_r28->deltaCnt = MorphDeltaCount(var_r30->data.vertexShape[0], var_r30->data.vertexShape[j]);
+            var_r28->delta = (Vec *)var_r25;
+            var_r25 += var_r28->deltaCnt * sizeof(Vec);
+            var_r28->index = (u16 *)var_r25;
+            var_r25 += MORPH_ALIGN(var_r28->deltaCnt * sizeof(u16));
+            temp_r26 = var_r30->data.vertexShape[j]->data;
+            for (k = var_r28->deltaCnt = 0; k < var_r30->data.vertexShape[j]->count; k++) {
+                if (temp_r26[k].x != temp_r27[k].x || temp_r26[k].y != temp_r27[k].y || temp_r26[k].z != temp_r27[k].z) {
+                    var_r28->index[var_r28->deltaCnt] = k;
+                    var_r28->delta[var_r28->deltaCnt].x = temp_r26[k].x - temp_r27[k].x;
+                    var_r28->delta[var_r28->deltaCnt].y = temp_r26[k].y - temp_r27[k].y;
+                    var_r28->delta[var_r28->deltaCnt].z = temp_r26[k].z - temp_r27[k].z;
+                    var_r28->deltaCnt++;
+                }
+            }
+        }
+        var_r29++;
+    }
+    arg0->morph = var_r31;
+}
+
+static BOOL MorphMeshCheck(HsfObject *arg0) {
+    s32 i;
+
+    if (arg0->type != 2 || arg0->data.vertexShapeCnt == 0 || arg0->data.vertexShapeCnt > MORPH_TARGET_MAX) {
+        return FALSE;
+    }
+    if (arg0->data.vertex->count > 0x10000) {
+        return FALSE;
+    }
+    for (i = 0; i < arg0->data.vertexShapeCnt; i++) {
+        if (arg0->data.vertexShape[i]->count != arg0->data.vertex->count) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static s32 MorphDeltaCount(HsfBuffer *arg0, HsfBuffer *arg1) {
+    Vec *temp_r31;
+    Vec *temp_r30;
+    s32 var_r29;
+    s32 i;
+
+    temp_r31 = arg0->data;
+    temp_r30 = arg1->data;
+    for (var_r29 = i = 0; i < arg1->count; i++) {
+        if (temp_r30[i].x != temp_r31[i].x || temp_r30[i].y != temp_r31[i].y || temp_r30[i].z != temp_r31[i].z) {
+            var_r29++;
+        }
+    }
+    return var_r29;
+}
 
 static void SetShapeMain(HsfObject *arg0) {
     HsfBuffer *temp_r28;
@@ -53,17 +168,169 @@ static void SetShapeMain(HsfObject *arg0) {
     }
 }
 
+// Writes the blend as the first shape plus weighted deltas and only touches moved vertices
+// Nothing is written when the weights match what the vertex buffer already holds
+static void SetShapeSparse(HsfObject *arg0, HsfMorphMesh *arg1) {
+    float sp8[MORPH_TARGET_MAX];
+    HsfMorphTarget *var_r31;
+    Vec *temp_r30;
+    u16 *var_r29;
+    Vec *var_r28;
+    float var_f31;
+    float var_f30;
+    float temp_f29;
+    s32 temp_r27;
+    s32 var_r26;
+    s32 var_r25;
+    s32 var_r24;
+    s32 i;
+    s32 j;
+
+    if (arg0->data.shapeType == 2) {
+        if (arg1->valid) {
+            for (i = 0; i < arg1->targetCnt; i++) {
+                if (arg1->morphWeight[i] != arg0->data.mesh.morphWeight[i]) {
+                    break;
+                }
+            }
+            if (i == arg1->targetCnt) {
+                return;
+            }
+        }
+        var_f30 = 0.0f;
+        for (i = 0; i < arg1->targetCnt; i++) {
+            var_f30 += arg0->data.mesh.morphWeight[i];
+        }
+        // Each lerp scales the offset built so far by 1 - weight, so a target's delta
+        // ends up weighted by its own weight times that factor of every later target
+        var_f31 = var_f30;
+        var_f30 = 1.0f;
+        for (i = arg1->targetCnt - 1; i >= 0; i--) {
+            sp8[i] = arg0->data.mesh.morphWeight[i];
+            if (sp8[i] < 0.0f) {
+                sp8[i] = 0.0f;
+            } else if (var_f31 > 1.0f) {
+                sp8[i] /= var_f31;
+            }
+            temp_f29 = sp8[i] * var_f30;
+            var_f30 *= 1.0f - sp8[i];
+            sp8[i] = temp_f29;
+        }
+    } else {
+        if (arg1->valid && arg1->baseMorph == arg0->data.mesh.baseMorph) {
+            return;
+        }
+        memset(sp8, 0, arg1->targetCnt * sizeof(float));
+        temp_r27 = arg0->data.mesh.baseMorph;
+        var_r26 = temp_r27 + 1;
+        if (var_r26 >= arg1->targetCnt) {
+            var_r26 = temp_r27;
+        }
+        var_f31 = arg0->data.mesh.baseMorph - temp_r27;
+        if (var_r26 == temp_r27) {
+            sp8[temp_r27] = 1.0f;
+        } else {
+            sp8[temp_r27] = 1.0f - var_f31;
+            sp8[var_r26] = var_f31;
+        }
+    }
+    temp_r30 = arg0->data.vertexShape[0]->data;
+    var_r25 = arg0->data.vertex->count;
+    var_r24 = -1;
+    if (!arg1->valid) {
+        memcpy(Vertextop, temp_r30, arg0->data.vertex->count * sizeof(Vec));
+        var_r25 = 0;
+        var_r24 = arg0->data.vertex->count - 1;
+    } else {
+        var_r31 = arg1->target;
+        for (i = 0; i < arg1->targetCnt; i++, var_r31++) {
+            if (arg1->coef[i] == 0.0f || var_r31->deltaCnt == 0) {
+                continue;
+            }
+            var_r29 = var_r31->index;
+            for (j = 0; j < var_r31->deltaCnt; j++, var_r29++) {
+                Vertextop[*var_r29] = temp_r30[*var_r29];
+            }
+            if (var_r31->index[0] < var_r25) {
+                var_r25 = var_r31->index[0];
+            }
+            if (var_r31->index[var_r31->deltaCnt - 1] > var_r24) {
+                var_r24 = var_r31->index[var_r31->deltaCnt - 1];
+            }
+        }
+    }
+    var_r31 = arg1->target;
+    for (i = 0; i < arg1->targetCnt; i++, var_r31++) {
+        var_f31 = sp8[i];
+        if (var_f31 == 0.0f || var_r31->deltaCnt == 0) {
+            continue;
+        }
+        var_r29 = var_r31->index;
+        var_r28 = var_r31->delta;
+        for (j = 0; j < var_r31->deltaCnt; j++, var_r29++, var_r28++) {
+            Vertextop[*var_r29].x += var_f31 * var_r28->x;
+            Vertextop[*var_r29].y += var_f31 * var_r28->y;
+            Vertextop[*var_r29].z += var_f31 * var_r28->z;
+        }
+        if (var_r31->index[0] < var_r25) {
+            var_r25 = var_r31->index[0];
+        }
+        if (var_r31->index[var_r31->deltaCnt - 1] > var_r24) {
+            var_r24 = var_r31->index[var_r31->deltaCnt - 1];
+        }
+    }
+    if (var_r24 >= var_r25) {
+        DCStoreRange(&Vertextop[var_r25], (var_r24 - var_r25 + 1) * sizeof(Vec));
+    }
+    memcpy(arg1->coef, sp8, arg1->targetCnt * sizeof(float));
+    memcpy(arg1->morphWeight, arg0->data.mesh.morphWeight, arg1->targetCnt * sizeof(float));
+    arg1->baseMorph = arg0->data.mesh.baseMorph;
+    // Skinned meshes are enveloped in place, so the buffer no longer holds the blend
+    arg1->valid = (arg0->data.cenvCnt == 0);
+}
+
 void ShapeProc(HsfData *arg0) {
     HsfObject *var_r31;
+    HsfMorphMesh *var_r30;
+    s32 var_r29;
     s32 i;
 
+    var_r30 = NULL;
+    var_r29 = 0;
+    if (arg0->morph != NULL) {
+        var_r30 = arg0->morph->mesh;
+        var_r29 = arg0->morph->meshCnt;
+    }
     var_r31 = arg0->object;
     for (i = 0; i < arg0->objectCnt; i++, var_r31++) {
         if (var_r31->type == 2 && var_r31->data.vertexShapeCnt != 0) {
             Vertextop = var_r31->data.vertex->data;
-            SetShapeMain(var_r31);
-            DCStoreRange(Vertextop, var_r31->data.vertex->count * sizeof(Vec));
+            if (var_r29 != 0 && var_r30->object == i) {
+                SetShapeSparse(var_r31, var_r30);
+                var_r30++;
+                var_r29--;
+            } else {
+                SetShapeMain(var_r31);
+                DCStoreRange(Vertextop, var_r31->data.vertex->count * sizeof(Vec));
+            }
             var_r31->data.unk120[0]++;
         }
     }
 }
+
+// Called when something other than ShapeProc writes the mesh's vertex buffer
+void ShapeDirtySet(HsfData *arg0, s32 arg1) {
+    HsfMorphMesh *var_r31;
+    s32 i;
+
+    if (arg0->morph == NULL) {
+        return;
+    }
+    var_r31 = arg0->morph->mesh;
+    for (i = 0; i < arg0->morph->meshCnt; i++, var_r31++) {
+        if (var_r31->object == arg1) {
+            var_r31->valid = 0;
+            return;
+        }
+    }
+}
@@ -1,102 +1,329 @@
 #include "game/armem.h"
 #include "game/data.h"
 
+#define AR_BIN_MAX 32
+#define AR_POOL_CHUNK 64
+#define AR_POOL_CHUNK_MAX 32
+#define AR_DIR_HASH_MAX 64
+#define AR_DIR_NONE 0xFFFF
+#define AR_MOVE_CHUNK 0x10000
+#define AR_STREAM_CHUNK 0x4000
+#define AR_QUE_MAX 32
+#define AR_FENCE_MAX 16
+#define AR_FENCE_NONE -1
+
+#define AR_QUE_FREE 0
+#define AR_QUE_BUSY 1
+#define AR_QUE_LANDED 2
+
+// Callers hold handles rather than ARAM addresses so blocks can be moved by HuARCompact
+// A handle stops resolving once its block is freed
+#define AR_HANDLE(block) ((((u32)(block)->gen) << 16) | ((block)->no + 1))
+
 typedef struct armem_block {
     /* 0x00 */ u8 flag;
     /* 0x02 */ u16 dir;
     /* 0x04 */ u32 amemptr;
     /* 0x08 */ u32 size;
     /* 0x0C */ struct armem_block *next;
-} ARMemBlock; // Size 0x10
+    /* 0x10 */ struct armem_block *prev;
+    /* 0x14 */ struct armem_block *link_next; // size bin while free, dir hash while allocated
+    /* 0x18 */ struct armem_block *link_prev;
+    /* 0x1C */ u16 no;
+    /* 0x1E */ u16 gen;
+} ARMemBlock; // Size 0x20
 
 typedef struct ar_que_req {
     /* 0x00 */ ARQRequest req;
     /* 0x20 */ s32 dir;
     /* 0x24 */ void *dst;
-} ARQueReq; // Size 0x28
+    /* 0x28 */ s16 fence;
+    /* 0x2A */ volatile u8 used;
+} ARQueReq; // Size 0x2C
+
+// Transfers submitted together share a fence which completes once the last of them lands
+// A fence is recycled after that, so a stale handle also reads as complete
+// Handles carry the slot in the low 8 bits and the generation above it
+typedef struct ar_fence {
+    /* 0x00 */ volatile s16 cnt;
+    /* 0x02 */ u16 gen;
+} ARFence; // Size 0x4
 
 static void ArqCallBack(u32 pointerToARQRequest);
 static void ArqCallBackAM(u32 pointerToARQRequest);
-static void ArqCallBackAMFileRead(u32 pointerToARQRequest);
 
 static s32 ATTRIBUTE_ALIGN(32) preLoadBuf[16];
-static ARQueReq ARQueBuf[16];
-static ARQRequest arqReq;
-static ARMemBlock ARInfo[64];
+static ARQueReq ARQueBuf[AR_QUE_MAX];
+static ARFence ARFenceTbl[AR_FENCE_MAX];
+static ARMemBlock ARInfo[AR_POOL_CHUNK];
+
+// Descriptors come in chunks, the first one static and the rest taken from HEAP_SYSTEM as needed
+static ARMemBlock *ARPool[AR_POOL_CHUNK_MAX];
+static ARMemBlock *ARDescFree;
+// Blocks in address order, covering all of ARAM above ARBase
+static ARMemBlock *ARFirst;
+static ARMemBlock *ARBin[AR_BIN_MAX];
+static u32 ARBinMask;
+static ARMemBlock *ARDirHash[AR_DIR_HASH_MAX];
+static u32 ARFreeSize;
 
 static s32 ARBase;
+static s32 ARSize;
+// Frees ARAM that is only held as a cache, called before an allocation is failed
+static ARReclaimFunc ARReclaim;
 static volatile s32 arqCnt;
 static s16 arqIdx;
+static s16 arqFenceIdx;
+
+static ARMemBlock *HuARInfoGet(u32 amemptr);
+static ARMemBlock *HuARDirGet(u32 dir);
+static void HuARQueReap(void);
+
+static ARMemBlock *HuARDescAlloc(void) {
+    ARMemBlock *desc;
+    ARMemBlock *chunk;
+    s16 i;
+    s16 no;
+
+    if (!ARDescFree) {
+        for (no = 0; no < AR_POOL_CHUNK_MAX; no++) {
+            if (!ARPool[no]) {
+                break;
+            }
+        }
+        if (no == AR_POOL_CHUNK_MAX) {
+            return NULL;
+        }
+        chunk = HuMemDirectMalloc(HEAP_SYSTEM, AR_POOL_CHUNK * sizeof(ARMemBlock));
+        if (!chunk) {
+            return NULL;
+        }
+        ARPool[no] = chunk;
+        for (i = AR_POOL_CHUNK - 1; i >= 0; i--) {
+            chunk[i].no = no * AR_POOL_CHUNK + i;
+            chunk[i].gen = 0;
+            chunk[i].flag = 0;
+            chunk[i].link_next = ARDescFree;
+            ARDescFree = &chunk[i];
+        }
+    }
+    desc = ARDescFree;
+    ARDescFree = desc->link_next;
+    desc->flag = 0;
+    desc->dir = AR_DIR_NONE;
+    return desc;
+}
+
+static void HuARDescFree(ARMemBlock *desc) {
+    desc->gen++;
+    desc->amemptr = 0;
+    desc->link_next = ARDescFree;
+    ARDescFree = desc;
+}
+
+static inline s32 HuARBinNo(u32 size) {
+    s32 no;
+
+    size >>= 5;
+    for (no = AR_BIN_MAX - 1; no > 0; no--) {
+        if (size & (1 << no)) {
+            break;
+        }
+    }
+    return no;
+}
+
+static void HuARBinAdd(ARMemBlock *block) {
+    s32 no;
+
+    no = HuARBinNo(block->size);
+    block->link_prev = NULL;
+    block->link_next = ARBin[no];
+    if (ARBin[no]) {
+        ARBin[no]->link_prev = block;
+    }
+    ARBin[no] = block;
+    ARBinMask |= 1 << no;
+    ARFreeSize += block->size;
+}
+
+static void HuARBinDel(ARMemBlock *block) {
+    s32 no;
+
+    no = HuARBinNo(block->size);
+    if (block->link_prev) {
+        block->link_prev->link_next = block->link_next;
+    } else {
+        ARBin[no] = block->link_next;
+        if (!ARBin[no]) {
+            ARBinMask &= ~(1 << no);
+        }
+    }
+    if (block->link_next) {
+        block->link_next->link_prev = block->link_prev;
+    }
+    ARFreeSize -= block->size;
+}
+
+// Smallest free block that holds size, looking no further than the first bin with a fit
+static ARMemBlock *HuARBinSearch(u32 size) {
+    ARMemBlock *block;
+    ARMemBlock *best;
+    u32 mask;
+    s32 no;
+
+    no = HuARBinNo(size);
+    best = NULL;
+    for (block = ARBin[no]; block; block = block->link_next) {
+        if (block->size >= size && (!best || block->size < best->size)) {
+            best = block;
+        }
+    }
+    if (best) {
+        return best;
+    }
+    mask = (no + 1 < AR_BIN_MAX) ? (ARBinMask & ~((2 << no) - 1)) : 0;
+    if (!mask) {
+        return NULL;
+    }
+    for (no++; !(mask & (1 << no)); no++) {
+    }
+    best = ARBin[no];
+    for (block = best->link_next; block; block = block->link_next) {
+        if (block->size < best->size) {
+            best = block;
+        }
+    }
+    return best;
+}
+
+static void HuARDirSet(ARMemBlock *block, u16 dir) {
+    ARMemBlock **hash;
+
+    if (block->dir != AR_DIR_NONE) {
+        for (hash = &ARDirHash[block->dir & (AR_DIR_HASH_MAX - 1)]; *hash; hash = &(*hash)->link_next) {
+            if (*hash == block) {
+                *hash = block->link_next;
+                break;
+            }
+        }
+    }
+    block->dir = dir;
+    if (dir != AR_DIR_NONE) {
+        hash = &ARDirHash[dir & (AR_DIR_HASH_MAX - 1)];
+        block->link_next = *hash;
+        *hash = block;
+    }
+}
 
 void HuARInit(void) {
-    s32 size;
+    ARMemBlock *block;
     s16 i;
+    s16 j;
 
     if (!ARCheckInit()) {
         ARInit(NULL, 0);
         ARQInit();
     }
-    for (i = 0; i < 64; i++) {
-        ARInfo[i].amemptr = 0;
+    // Chunks taken from HEAP_SYSTEM by an earlier run are given back, the static one is enough to start
+    for (i = 1; i < AR_POOL_CHUNK_MAX; i++) {
+        if (ARPool[i]) {
+            HuMemDirectFree(ARPool[i]);
+            ARPool[i] = NULL;
+        }
+    }
+    ARPool[0] = ARInfo;
+    ARDescFree = NULL;
+    for (j = AR_POOL_CHUNK - 1; j >= 0; j--) {
+        block = &ARInfo[j];
+        block->no = j;
+        block->flag = 0;
+        block->amemptr = 0;
+        block->link_next = ARDescFree;
+        ARDescFree = block;
     }
-    size = ARGetSize() - 0x808000;
+    for (i = 0; i < AR_BIN_MAX; i++) {
+        ARBin[i] = NULL;
+    }
+    for (i = 0; i < AR_DIR_HASH_MAX; i++) {
+        ARDirHash[i] = NULL;
+    }
+    ARBinMask = 0;
+    ARFreeSize = 0;
+    ARSize = ARGetSize() - 0x808000;
     ARBase = 0x808000;
-    ARInfo[0].amemptr = ARBase;
-    ARInfo[0].size = size;
-    ARInfo[0].flag = 0;
-    ARInfo[0].next = &ARInfo[1];
-    ARInfo[0].dir = 0xFFFF;
-    ARInfo[1].amemptr = -1;
-    ARInfo[1].size = 0;
-    ARInfo[1].flag = 1;
-    ARInfo[1].next = 0;
-    ARInfo[1].dir = 0xFFFF;
+    block = HuARDescAlloc();
+    block->amemptr = ARBase;
+    block->size = ARSize;
+    block->next = block->prev = NULL;
+    ARFirst = block;
+    HuARBinAdd(block);
+    for (i = 0; i < AR_QUE_MAX; i++) {
+        ARQueBuf[i].used = AR_QUE_FREE;
+    }
+    for (i = 0; i < AR_FENCE_MAX; i++) {
+        ARFenceTbl[i].cnt = 0;
+    }
     arqCnt = 0;
+    arqIdx = 0;
+    arqFenceIdx = 0;
 }
 
-u32 HuARMalloc(u32 size) {
-    ARMemBlock *prev;
+static ARMemBlock *HuARMallocBlock(u32 size) {
+    ARMemBlock *curr;
     ARMemBlock *next;
+
+    curr = HuARBinSearch(size);
+    if (!curr) {
+        return NULL;
+    }
+    HuARBinDel(curr);
+    // Without a spare descriptor the whole block is handed out
+    if (curr->size > size && (next = HuARDescAlloc())) {
+        next->amemptr = curr->amemptr + size;
+        next->size = curr->size - size;
+        next->prev = curr;
+        next->next = curr->next;
+        if (curr->next) {
+            curr->next->prev = next;
+        }
+        curr->next = next;
+        curr->size = size;
+        HuARBinAdd(next);
+    }
+    curr->flag = 1;
+    curr->dir = AR_DIR_NONE;
+    return curr;
+}
+
+u32 HuARMalloc(u32 size) {
     ARMemBlock *curr;
-    s16 i;
 
     size = OSRoundUp32B(size);
-    curr = prev = ARInfo;
-    while (curr->next != 0) {
-        if (curr->flag == 0 && curr->size >= size) {
-            break;
-        }
-        prev = curr;
-        curr = curr->next;
+    curr = HuARMallocBlock(size);
+    while (!curr && ARReclaim && ARReclaim()) {
+        curr = HuARMallocBlock(size);
     }
-    if (curr->next == 0) {
+    if (!curr) {
         OSReport("Can't ARAM Allocated %x\n", size);
         HuAMemDump();
         return 0;
     }
-    curr->flag = 1;
-    if (curr->size == size && prev != curr) {
-        curr->dir = 0xFFFF;
-    } else {
-        next = &ARInfo[1];
-        for (i = 0; i < 63; i++, next++) {
-            if (!next->amemptr) {
-                break;
-            }
-        }
-        if (i == 63) {
-            OSReport("Can't ARAM Allocated %x\n", size);
-            return 0;
-        }
-        next->next = curr->next;
-        curr->next = next;
-        next->size = curr->size - size;
-        next->amemptr = curr->amemptr + size;
-        curr->size = size;
-        curr->dir = next->dir = 0xFFFF;
-        next->flag = 0;
+    return AR_HANDLE(curr);
+}
+
+// The function returns FALSE once it has nothing left to free
+void HuARReclaimSet(ARReclaimFunc func) {
+    ARReclaim = func;
+}
+
+static void HuARMerge(ARMemBlock *curr, ARMemBlock *next) {
+    curr->size += next->size;
+    curr->next = next->next;
+    if (next->next) {
+        next->next->prev = curr;
     }
-    return curr->amemptr;
+    HuARDescFree(next);
 }
 
 void HuARFree(u32 amemptr) {
@@ -104,79 +331,269 @@ void HuARFree(u32 amemptr) {
     ARMemBlock *next;
     ARMemBlock *curr;
 
-    curr = prev = ARInfo;
-    while (curr->next) {
-        if (curr->amemptr == amemptr) {
-            break;
-        }
-        prev = curr;
-        curr = curr->next;
+    curr = HuARInfoGet(amemptr);
+    if (!curr) {
+        OSReport("Can't ARAM Free %x\n", amemptr);
+        return;
+    }
+    HuARDirSet(curr, AR_DIR_NONE);
+    curr->flag = 0;
+    next = curr->next;
+    if (next && next->flag == 0) {
+        HuARBinDel(next);
+        HuARMerge(curr, next);
     }
-    if (curr->flag != 0) {
-        if (!curr->next && curr->amemptr != amemptr) {
-            OSReport("Can't ARAM Free %x\n", amemptr);
-            return;
+    prev = curr->prev;
+    if (prev && prev->flag == 0) {
+        HuARBinDel(prev);
+        HuARMerge(prev, curr);
+        curr = prev;
+    } else {
+        // Merging into prev retires the descriptor, otherwise it keeps it and only its handle changes
+        curr->gen++;
+    }
+    HuARBinAdd(curr);
+}
+
+static ARMemBlock *HuARInfoGet(u32 amemptr) {
+    ARMemBlock *curr;
+    u32 no;
+
+    no = (amemptr & 0xFFFF) - 1;
+    if (no < AR_POOL_CHUNK * AR_POOL_CHUNK_MAX && ARPool[no / AR_POOL_CHUNK]) {
+        curr = &ARPool[no / AR_POOL_CHUNK][no % AR_POOL_CHUNK];
+        if (curr->flag == 1 && AR_HANDLE(curr) == amemptr) {
+            return curr;
         }
-        next = curr->next;
-        if (next->next && next->flag == 0) {
-            if (curr->amemptr > next->amemptr) {
-                curr->amemptr = next->amemptr;
+    }
+    OSReport("Can't Find ARAM %x\n", amemptr);
+    return NULL;
+}
+
+// Takes a free request slot, waiting for a transfer to land when all of them are in flight
+static ARQueReq *HuARQueAlloc(void) {
+    ARQueReq *req;
+    BOOL enabled;
+    s16 i;
+
+    while (TRUE) {
+        HuARQueReap();
+        enabled = OSDisableInterrupts();
+        for (i = 0; i < AR_QUE_MAX; i++) {
+            req = &ARQueBuf[arqIdx];
+            arqIdx = (arqIdx + 1) & (AR_QUE_MAX - 1);
+            if (req->used == AR_QUE_FREE) {
+                req->used = AR_QUE_BUSY;
+                OSRestoreInterrupts(enabled);
+                return req;
             }
-            curr->size += next->size;
-            curr->next = next->next;
-            next->amemptr = 0;
         }
-        if (prev != curr && prev->next != 0 && prev->flag == 0) {
-            if (prev->amemptr > curr->amemptr) {
-                prev->amemptr = curr->amemptr;
-            }
-            prev->size += curr->size;
-            prev->next = curr->next;
-            curr->amemptr = 0;
+        OSRestoreInterrupts(enabled);
+    }
+}
+
+// dir_ptr is the directory to register once an ARAM to MRAM transfer lands, or NULL
+static void HuARQuePost(s32 fence, u32 type, u32 prio, u32 src, u32 dst, u32 len, s32 dir, void *dir_ptr) {
+    ARQueReq *req;
+    BOOL enabled;
+
+    req = HuARQueAlloc();
+    req->fence = fence;
+    req->dir = dir;
+    req->dst = dir_ptr;
+    enabled = OSDisableInterrupts();
+    if (fence != AR_FENCE_NONE) {
+        ARFenceTbl[fence].cnt++;
+    }
+    arqCnt++;
+    OSRestoreInterrupts(enabled);
+    PPCSync();
+    ARQPostRequest(&req->req, 0x1234, type, prio, src, dst, len, dir_ptr ? ArqCallBackAM : ArqCallBack);
+}
+
+static void HuARQueDone(ARQueReq *req) {
+    arqCnt--;
+    if (req->fence != AR_FENCE_NONE) {
+        ARFenceTbl[req->fence].cnt--;
+    }
+    req->used = AR_QUE_FREE;
+}
+
+// Directories pulled from ARAM are registered here rather than in ArqCallBackAM
+// Registration takes data slots and may close other directories, which is not safe in the ARQ interrupt
+// The request and its fence stay pending until then, so a completed fence means the directory is registered
+static void HuARQueReap(void) {
+    ARQueReq *req;
+    BOOL enabled;
+    s16 i;
+
+    for (i = 0; i < AR_QUE_MAX; i++) {
+        req = &ARQueBuf[i];
+        if (req->used != AR_QUE_LANDED) {
+            continue;
         }
-        curr->flag = 0;
-        curr->dir = 0xFFFF;
+        HuDataDirSet(req->dst, req->dir);
+        enabled = OSDisableInterrupts();
+        HuARQueDone(req);
+        OSRestoreInterrupts(enabled);
     }
 }
 
-static u32 HuARSizeGet(u32 amemptr) {
-    ARMemBlock *curr;
-    ARMemBlock *prev;
+// TRUE while a transfer of the directory into main memory is in flight or not yet registered
+static BOOL HuARQueDirBusy(s32 dir) {
+    s16 i;
 
-    curr = prev = ARInfo;
-    while (curr->next != 0) {
-        if (curr->amemptr == amemptr) {
-            break;
+    HuARQueReap();
+    for (i = 0; i < AR_QUE_MAX; i++) {
+        if (ARQueBuf[i].used != AR_QUE_FREE && ARQueBuf[i].dst && ARQueBuf[i].dir == dir) {
+            return TRUE;
         }
-        prev = curr;
-        curr = curr->next;
     }
-    if (curr->next == 0 && curr->amemptr != amemptr) {
-        OSReport("Can't Find ARAM %x\n", amemptr);
-        return 0;
-    } else {
-        return curr->size;
+    return FALSE;
+}
+
+// The fence is held open by one count until HuARFenceClose so it cannot complete while being filled
+// Fences of pulls that landed stay counted until reaped, so a full round without a free one reaps them
+static s32 HuARFenceOpen(void) {
+    s16 no;
+    s16 i;
+
+    while (TRUE) {
+        for (i = 0; i < AR_FENCE_MAX; i++) {
+            no = arqFenceIdx;
+            arqFenceIdx = (arqFenceIdx + 1) & (AR_FENCE_MAX - 1);
+            if (ARFenceTbl[no].cnt == 0) {
+                ARFenceTbl[no].gen++;
+                ARFenceTbl[no].cnt = 1;
+                return no;
+            }
+        }
+        HuARQueReap();
     }
 }
 
-static ARMemBlock *HuARInfoGet(u32 amemptr) {
+static u32 HuARFenceClose(s32 fence) {
+    u32 handle;
+    BOOL enabled;
+
+    handle = (((u32)ARFenceTbl[fence].gen) << 8) | (fence + 1);
+    enabled = OSDisableInterrupts();
+    ARFenceTbl[fence].cnt--;
+    OSRestoreInterrupts(enabled);
+    return handle;
+}
+
+// Posts a single transfer under a fence of its own
+static u32 HuARDMAPost(u32 type, u32 prio, u32 src, u32 dst, u32 len) {
+    s32 fence;
+
+    fence = HuARFenceOpen();
+    HuARQuePost(fence, type, prio, src, dst, len, 0, NULL);
+    return HuARFenceClose(fence);
+}
+
+// Fence 0 is returned when nothing had to be transferred and always reads as complete
+// A handle that names no fence slot is treated the same way rather than read out of bounds
+BOOL HuARFenceCheck(u32 fence) {
+    ARFence *entry;
+    u32 no;
+
+    no = (fence & 0xFF) - 1;
+    if (no >= AR_FENCE_MAX) {
+        return TRUE;
+    }
+    HuARQueReap();
+    entry = &ARFenceTbl[no];
+    return entry->gen != ((fence >> 8) & 0xFFFF) || entry->cnt == 0;
+}
+
+void HuARFenceWait(u32 fence) {
+    while (!HuARFenceCheck(fence));
+}
+
+// Copies one ARAM range down to another through a bounce buffer in main memory
+static void HuARMove(u32 dst, u32 src, u32 size, void *buf) {
+    u32 len;
+
+    while (size) {
+        len = (size > AR_MOVE_CHUNK) ? AR_MOVE_CHUNK : size;
+        DCInvalidateRange(buf, len);
+        HuARFenceWait(HuARDMAPost(ARQ_TYPE_ARAM_TO_MRAM, ARQ_PRIORITY_LOW, src, (u32)buf, len));
+        HuARFenceWait(HuARDMAPost(ARQ_TYPE_MRAM_TO_ARAM, ARQ_PRIORITY_LOW, (u32)buf, dst, len));
+        dst += len;
+        src += len;
+        size -= len;
+    }
+}
+
+// Slides every allocated block down to ARBase so all free space is one block at the top
+// Handles and directory lookups follow the moved blocks
+// Blocks until every transfer has landed, so it is only called between overlays and never from HuARMalloc
+// Returns the size of the free block, or 0 when no work memory was available
+u32 HuARCompact(void) {
     ARMemBlock *curr;
+    ARMemBlock *next;
     ARMemBlock *prev;
-
-    curr = prev = ARInfo;
-    while (curr->next != 0) {
-        if (curr->amemptr == amemptr) {
-            break;
+    void *buf;
+    u32 dst;
+    s32 num;
+
+    num = 0;
+    for (curr = ARFirst; curr; curr = curr->next) {
+        if (curr->flag == 0) {
+            num++;
+        }
+    }
+    if (num <= 1) {
+        return ARFreeSize;
+    }
+    buf = HuMemDirectMalloc(HEAP_DVD, AR_MOVE_CHUNK);
+    if (!buf) {
+        return 0;
+    }
+    while (HuARDMACheck());
+    OSReport("ARAM Compact %x\n", ARFreeSize);
+    dst = ARBase;
+    prev = NULL;
+    for (curr = ARFirst; curr; curr = next) {
+        next = curr->next;
+        if (curr->flag == 0) {
+            HuARBinDel(curr);
+            HuARDescFree(curr);
+            continue;
+        }
+        if (curr->amemptr != dst) {
+            HuARMove(dst, curr->amemptr, curr->size, buf);
+            curr->amemptr = dst;
+        }
+        dst += curr->size;
+        curr->prev = prev;
+        if (prev) {
+            prev->next = curr;
+        } else {
+            ARFirst = curr;
         }
         prev = curr;
-        curr = curr->next;
     }
-    if (curr->next == 0 && curr->amemptr != amemptr) {
-        OSReport("Can't Find ARAM %x\n", amemptr);
-        return NULL;
-    } else {
-        return curr;
+    HuMemDirectFree(buf);
+    if (dst < ARBase + ARSize) {
+        curr = HuARDescAlloc();
+        curr->amemptr = dst;
+        curr->size = ARBase + ARSize - dst;
+        curr->prev = prev;
+        curr->next = NULL;
+        if (prev) {
+            prev->next = curr;
+        } else {
+            ARFirst = curr;
+        }
+        HuARBinAdd(curr);
+        return curr->size;
+    }
+    if (prev) {
+        prev->next = NULL;
     }
+    return 0;
 }
 
 void HuAMemDump(void) {
@@ -184,10 +601,10 @@ void HuAMemDump(void) {
 
     OSReport("ARAM DUMP ======================\n");
     OSReport("AMemPtr  Stat Length\n");
-    for (curr = ARInfo; curr->next; curr = curr->next) {
+    for (curr = ARFirst; curr; curr = curr->next) {
         OSReport("%08x:%04x,%08x,%08x\n", curr->amemptr, curr->flag, curr->size, curr->dir);
     }
-    OSReport("%08x:%04x,%08x\n", curr->amemptr, curr->flag, curr->size);
+    OSReport("Free %08x\n", ARFreeSize);
     OSReport("================================\n");
 }
 
@@ -195,6 +612,7 @@ u32 HuAR_DVDtoARAM(u32 dir) {
     DataReadStat *stat;
     ARMemBlock *block;
     u32 amemptr;
+    u32 fence;
 
     amemptr = HuARDirCheck(dir);
     if (amemptr) {
@@ -207,25 +625,19 @@ u32 HuAR_DVDtoARAM(u32 dir) {
         return 0;
     }
     block = HuARInfoGet(amemptr);
-    block->dir = (dir >> 16);
-    arqCnt++;
-    ARQPostRequest(&arqReq, 0x1234, 0, 0, (u32) stat->dir, amemptr, DirDataSize, ArqCallBack);
-    OSReport("ARAM Trans %x\n", amemptr);
-    while (HuARDMACheck());
+    HuARDirSet(block, dir >> 16);
+    fence = HuARDMAPost(ARQ_TYPE_MRAM_TO_ARAM, ARQ_PRIORITY_LOW, (u32) stat->dir, block->amemptr, DirDataSize);
+    OSReport("ARAM Trans %x\n", block->amemptr);
+    HuARFenceWait(fence);
     HuDataDirClose(dir);
     return amemptr;
 }
 
 static void ArqCallBack(u32 pointerToARQRequest) {
-    arqCnt--;
-    (void)pointerToARQRequest; // required to match (return?)
+    HuARQueDone((ARQueReq*) pointerToARQRequest);
 }
 
-u32 HuAR_MRAMtoARAM(s32 dir) {
-    return HuAR_MRAMtoARAM2(HuDataGetDirPtr(dir));
-}
-
-u32 HuAR_MRAMtoARAM2(void *dir_ptr) {
+static u32 HuARPushDir(void *dir_ptr, s32 fence, u32 prio) {
     ARMemBlock *block;
     DataReadStat *status;
     u32 size;
@@ -243,132 +655,254 @@ u32 HuAR_MRAMtoARAM2(void *dir_ptr) {
         return 0;
     }
     block = HuARInfoGet(amemptr);
-    block->dir = status->dir_id;
-    arqCnt++;
-    ARQPostRequest(&arqReq, 0x1234, 0, 0, (u32)dir_ptr, amemptr, size, ArqCallBack);
+    HuARDirSet(block, status->dir_id);
+    HuARQuePost(fence, ARQ_TYPE_MRAM_TO_ARAM, prio, (u32)dir_ptr, block->amemptr, size, 0, NULL);
     return amemptr;
 }
 
-void HuAR_ARAMtoMRAM(u32 src) {
-    HuAR_ARAMtoMRAMNum(src, 0);
+u32 HuAR_MRAMtoARAM(s32 dir) {
+    void *dir_ptr;
+
+    // A directory pulled down from ARAM may have been evicted again, its ARAM copy is still there
+    dir_ptr = HuDataGetDirPtr(dir);
+    if (!dir_ptr) {
+        return HuARDirCheck(dir);
+    }
+    return HuAR_MRAMtoARAM2(dir_ptr);
 }
 
-void *HuAR_ARAMtoMRAMNum(u32 src, s32 num) {
-    ARMemBlock *block;
+u32 HuAR_MRAMtoARAM2(void *dir_ptr) {
+    return HuARPushDir(dir_ptr, AR_FENCE_NONE, ARQ_PRIORITY_LOW);
+}
+
+// Copies every listed directory that is in main memory and not yet in ARAM
+u32 HuAR_MRAMtoARAMList(s32 *dirs, s32 num, u32 prio) {
+    void *dir_ptr;
+    s32 fence;
+    s32 i;
+
+    fence = HuARFenceOpen();
+    for (i = 0; i < num; i++) {
+        dir_ptr = HuDataGetDirPtr(dirs[i]);
+        if (dir_ptr && !HuARPushDir(dir_ptr, fence, prio)) {
+            OSReport("ARAM Trans Error %x\n", dirs[i]);
+        }
+    }
+    return HuARFenceClose(fence);
+}
+
+static void *HuARPullDir(ARMemBlock *block, s32 num, s32 fence, u32 prio) {
     s32 size;
     void *dst;
 
-    block = HuARInfoGet(src);
-    if (HuDataReadChk(block->dir << 16) >= 0) {
-        return;
-    }
-    size = HuARSizeGet(src);
+    size = block->size;
     dst = HuMemDirectMallocNum(HEAP_DVD, size, num);
     if (!dst) {
         return 0;
     }
     DCFlushRangeNoSync(dst, size);
-    ARQueBuf[arqIdx].dir = (block->dir << 16);
-    ARQueBuf[arqIdx].dst = dst;
-    arqCnt++;
-    PPCSync();
-    ARQPostRequest(&ARQueBuf[arqIdx].req, 0x1234, 1, 0, src, (u32) dst, size, ArqCallBackAM);
-    arqIdx++;
-    arqIdx &= 0xF;
+    HuARQuePost(fence, ARQ_TYPE_ARAM_TO_MRAM, prio, block->amemptr, (u32) dst, size, block->dir << 16, dst);
     return dst;
 }
 
+void HuAR_ARAMtoMRAM(u32 src) {
+    HuAR_ARAMtoMRAMNum(src, 0);
+}
+
+void *HuAR_ARAMtoMRAMNum(u32 src, s32 num) {
+    ARMemBlock *block;
+
+    block = HuARInfoGet(src);
+    if (!block) {
+        return 0;
+    }
+    if (HuDataReadChk(block->dir << 16) >= 0) {
+        return NULL;
+    }
+    return HuARPullDir(block, num, AR_FENCE_NONE, ARQ_PRIORITY_LOW);
+}
+
+// Brings every listed directory that is only in ARAM back to main memory as one batch
+// The transfers overlap, and ARQ interleaves high priority batches with low priority ones chunk by chunk
+u32 HuAR_ARAMtoMRAMList(s32 *dirs, s32 num, s32 mem_num, u32 prio) {
+    ARMemBlock *block;
+    BOOL busy;
+    s32 fence;
+    s32 i;
+
+    busy = FALSE;
+    fence = HuARFenceOpen();
+    for (i = 0; i < num; i++) {
+        block = HuARDirGet(dirs[i]);
+        if (!block || HuDataReadChk(dirs[i]) >= 0) {
+            continue;
+        }
+        if (HuARQueDirBusy(block->dir << 16)) {
+            busy = TRUE;
+            continue;
+        }
+        if (!HuARPullDir(block, mem_num, fence, prio)) {
+            OSReport("ARAM Trans Error %x\n", dirs[i]);
+        }
+    }
+    // A directory another caller is already pulling is waited for here, the fence cannot cover it
+    if (busy) {
+        for (i = 0; i < num; i++) {
+            while (HuARQueDirBusy(dirs[i] & 0xFFFF0000));
+        }
+    }
+    return HuARFenceClose(fence);
+}
+
+// Ranges are ARAM handle offsets and must be 32 byte aligned like any ARQ transfer
+static u32 HuARDMARange(ARDMARange *range, s32 num, u32 type, u32 prio) {
+    ARMemBlock *block;
+    s32 fence;
+    s32 i;
+
+    fence = HuARFenceOpen();
+    for (i = 0; i < num; i++, range++) {
+        block = HuARInfoGet(range->amemptr);
+        if (!block || range->ofs + range->size > block->size) {
+            OSReport("ARAM Range Error %x,%x,%x\n", range->amemptr, range->ofs, range->size);
+            continue;
+        }
+        DCFlushRangeNoSync(range->mram, range->size);
+        if (type == ARQ_TYPE_ARAM_TO_MRAM) {
+            HuARQuePost(fence, type, prio, block->amemptr + range->ofs, (u32) range->mram, range->size, 0, NULL);
+        } else {
+            HuARQuePost(fence, type, prio, (u32) range->mram, block->amemptr + range->ofs, range->size, 0, NULL);
+        }
+    }
+    return HuARFenceClose(fence);
+}
+
+u32 HuARDMARead(ARDMARange *range, s32 num, u32 prio) {
+    return HuARDMARange(range, num, ARQ_TYPE_ARAM_TO_MRAM, prio);
+}
+
+u32 HuARDMAWrite(ARDMARange *range, s32 num, u32 prio) {
+    return HuARDMARange(range, num, ARQ_TYPE_MRAM_TO_ARAM, prio);
+}
+
 static void ArqCallBackAM(u32 pointerToARQRequest) {
     ARQueReq *req_ptr = (ARQueReq*) pointerToARQRequest;
 
-    arqCnt--;
-    HuDataDirSet(req_ptr->dst, req_ptr->dir);
+    req_ptr->used = AR_QUE_LANDED;
 }
-
 s32 HuARDMACheck(void) {
+    HuARQueReap();
     return arqCnt;
 }
 
-u32 HuARDirCheck(u32 dir) {
+static ARMemBlock *HuARDirGet(u32 dir) {
     ARMemBlock *curr;
 
-    curr = ARInfo;
     dir >>= 16;
-    while (curr->next != 0) {
-        if (curr->flag == 1 && curr->dir == dir) {
-            return curr->amemptr;
+    for (curr = ARDirHash[dir & (AR_DIR_HASH_MAX - 1)]; curr; curr = curr->link_next) {
+        if (curr->dir == dir) {
+            return curr;
         }
-        curr = curr->next;
     }
+    return NULL;
+}
 
-    return 0;
+u32 HuARDirCheck(u32 dir) {
+    ARMemBlock *curr;
+
+    curr = HuARDirGet(dir);
+    if (!curr) {
+        return 0;
+    }
+    return AR_HANDLE(curr);
 }
 
 void HuARDirFree(u32 dir) {
     ARMemBlock *curr;
 
-    curr = ARInfo;
-    dir >>= 16;
-    while (curr->next != 0) {
-        if (curr->dir == dir) {
-            HuARFree(curr->amemptr);
-            break;
-        }
-        curr = curr->next;
+    curr = HuARDirGet(dir);
+    if (curr) {
+        HuARFree(AR_HANDLE(curr));
     }
 }
 
+// The file is pulled in AR_STREAM_CHUNK pieces into two staging buffers
+// Each piece is decoded while the next one is on its way from ARAM
 void *HuAR_ARAMtoMRAMFileRead(u32 dir, u32 num, HeapID heap) {
+    DecodeStream *stream;
     s32 *dir_data;
     void *dst;
     void *dvd_data;
+    u8 *chunk;
+    u8 *next_chunk;
     u32 amem_src;
+    u32 fence;
     s32 count;
     s32 size;
+    s32 buf_len;
+    s32 stage_len;
+    s32 chunk_len;
+    s32 next_len;
+    s32 read_pos;
+    BOOL done;
     u32 amemptr;
+    ARMemBlock *block;
 
-    if ((amemptr = HuARDirCheck(dir)) == 0) {
+    if ((block = HuARDirGet(dir)) == NULL) {
         OSReport("Error: data none on ARAM %0x\n", dir);
         HuAMemDump();
         return 0;
     }
+    amemptr = block->amemptr;
     DCInvalidateRange(&preLoadBuf, sizeof(preLoadBuf));
     amem_src = amemptr + (u32)((u32)(((u16)dir + 1) * 4) & 0xFFFFFFFE0);
-    arqCnt++;
-    ARQPostRequest(&ARQueBuf[arqIdx].req, 0x1234, 1, 0, amem_src, (u32) &preLoadBuf, sizeof(preLoadBuf), ArqCallBackAMFileRead);
-    arqIdx++;
-    arqIdx &= 0xF;
-    while (HuARDMACheck());
+    HuARFenceWait(HuARDMAPost(ARQ_TYPE_ARAM_TO_MRAM, ARQ_PRIORITY_HIGH, amem_src, (u32) &preLoadBuf, sizeof(preLoadBuf)));
     dir_data = &preLoadBuf[(dir + 1) & 7];
     count = dir_data[0];
     amem_src = amemptr + (u32)(count & 0xFFFFFFFE0);
     if (dir_data[1] - count < 0) {
-        size = (HuARSizeGet(amemptr) - count + 0x3F) & 0xFFFFFFFE0;
+        size = (block->size - count + 0x3F) & 0xFFFFFFFE0;
     } else {
         size = (dir_data[1] - count + 0x3F) & 0xFFFFFFFE0;
     }
-    dvd_data = HuMemDirectMalloc(HEAP_DVD, size);
+    buf_len = (size > AR_STREAM_CHUNK) ? AR_STREAM_CHUNK : size;
+    stage_len = (size > buf_len) ? buf_len * 2 : buf_len;
+    dvd_data = HuMemDirectMalloc(HEAP_DVD, stage_len + sizeof(DecodeStream));
     if (!dvd_data) {
         return 0;
     }
-    DCFlushRangeNoSync(dvd_data, size);
-    arqCnt++;
-    PPCSync();
-    ARQPostRequest(&ARQueBuf[arqIdx].req, 0x1234, 1, 0, amem_src, (u32) dvd_data, (u32) size, ArqCallBackAMFileRead);
-    arqIdx++;
-    arqIdx &= 0xF;
-    while (HuARDMACheck());
+    stream = (DecodeStream *) ((u8 *) dvd_data + stage_len);
+    DCFlushRangeNoSync(dvd_data, buf_len);
+    HuARFenceWait(HuARDMAPost(ARQ_TYPE_ARAM_TO_MRAM, ARQ_PRIORITY_HIGH, amem_src, (u32) dvd_data, (u32) buf_len));
     dir_data = (s32*) ((u8*) dvd_data + (count & 0x1F));
     dst = HuMemDirectMallocNum(heap, (dir_data[0] + 1) & ~1, num);
     if (!dst) {
+        HuMemDirectFree(dvd_data);
         return 0;
     }
-    HuDecodeData(&dir_data[2], dst, dir_data[0], dir_data[1]);
+    HuDecodeStreamBegin(stream, dst, dir_data[0], dir_data[1]);
+    chunk = (u8 *) &dir_data[2];
+    chunk_len = buf_len - (count & 0x1F) - 8;
+    read_pos = buf_len;
+    do {
+        next_chunk = ((read_pos / buf_len) & 1) ? (u8 *) dvd_data + buf_len : dvd_data;
+        next_len = size - read_pos;
+        if (next_len > buf_len) {
+            next_len = buf_len;
+        }
+        if (next_len) {
+            DCFlushRangeNoSync(next_chunk, next_len);
+            fence = HuARDMAPost(ARQ_TYPE_ARAM_TO_MRAM, ARQ_PRIORITY_HIGH, amem_src + read_pos, (u32) next_chunk, (u32) next_len);
+        }
+        done = HuDecodeStreamFeed(stream, chunk, chunk_len);
+        if (next_len) {
+            HuARFenceWait(fence);
+        }
+        chunk = next_chunk;
+        chunk_len = next_len;
+        read_pos += next_len;
+    } while (!done && chunk_len);
+    HuDecodeStreamEnd(stream);
     HuMemDirectFree(dvd_data);
     return dst;
 }
-
-static void ArqCallBackAMFileRead(u32 pointerToARQRequest) {
-    arqCnt--;
-    (void)pointerToARQRequest; // required to match (return?)
-}
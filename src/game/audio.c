@@ -51,6 +51,7 @@ void HuAudInit(void)
     msmInit.close = NULL;
     msmAram.skipARInit = TRUE;
     msmAram.aramEnd = 0x808000;
+    msmMemSetMode(MSM_MEM_BESTFIT);
     result = msmSysInit(&msmInit, &msmAram);
 
     if (result < 0) {
@@ -225,6 +226,14 @@ void HuAudFXEmiterUpDate(int seNo, Vec *pos)
     msmSeSetParam(seNo, &param);
 }
 
+void HuAudFXEmiterUpDateList(int *seNo, Vec *pos, s32 num)
+{
+    if(omSysExitReq) {
+        return;
+    }
+    msmSeSetPosList(seNo, pos, num);
+}
+
 void HuAudFXListnerKill(void) {
     msmSeDelListener();
 }
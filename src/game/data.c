@@ -2,6 +2,7 @@
 #include "game/armem.h"
 #include "game/process.h"
 #include "dolphin/dvd.h"
+#include "stddef.h"
 
 #define PTR_OFFSET(ptr, offset) (void *)(((u8 *)(ptr)+(u32)(offset)))
 #define DATA_EFF_SIZE(size) (((size)+1) & ~0x1)
@@ -9,6 +10,12 @@
 void **HuDataReadMultiSub(s32 *data_ids, BOOL use_num, s32 num);
 
 #define DATA_MAX_READSTAT 128
+#define DATA_HASH_MAX 256
+#define DATA_HASH_DIR(dir_id) ((dir_id) & (DATA_HASH_MAX-1))
+#define DATA_HASH_PTR(ptr) ((((u32)(ptr)) >> 5) & (DATA_HASH_MAX-1))
+#define DATA_STREAM_CHUNK 0x4000
+//Async status of a directory pulled from ARAM, the low bits hold its ARAM fence
+#define DATA_ASYNC_ARAM 0x40000000
 
 #define DATADIR_DEFINE(name, path) { path, -1 },
 
@@ -24,6 +31,185 @@ static u32 DataDirMax;
 static s32 shortAccessSleep;
 static DataReadStat ATTRIBUTE_ALIGN(32) ReadDataStat[DATA_MAX_READSTAT];
 
+typedef struct data_stat_link {
+    s16 id_next;
+    s16 ptr_next;
+    s16 prev;
+    s16 next;
+} DataStatLink;
+
+//Slots in use are chained by dir_id and by dir pointer and kept in LRU order
+//Free slots are chained through next
+static DataStatLink ReadDataLink[DATA_MAX_READSTAT];
+static s16 ReadDataIdHash[DATA_HASH_MAX];
+static s16 ReadDataPtrHash[DATA_HASH_MAX];
+static s16 ReadDataFree;
+static s16 ReadDataLruHead;
+static s16 ReadDataLruTail;
+static DataCacheStat ReadDataCacheStat;
+//Set while a prefetched directory has not been read by anyone yet
+static u8 ReadDataPrefetchF[DATA_MAX_READSTAT];
+//Set once the directory or its async status has been handed to a caller, who may keep it until it is closed
+static u8 ReadDataHeldF[DATA_MAX_READSTAT];
+//Readers using the directory right now
+static u8 ReadDataPin[DATA_MAX_READSTAT];
+static s16 *ReadDataLog;
+static s32 ReadDataLogMax;
+static s32 ReadDataLogNum;
+
+static void HuDataStatClose(s32 status);
+static s32 HuDataReadAsyncChk(s32 data_num);
+static void HuDataDirReadAsyncWait(s32 data_num);
+static s32 HuDataDirReadAsyncPrio(s32 data_num, s32 prio);
+static DataReadStat *HuDataDirReadSub(s32 data_num);
+static void HuDataDirReadStart(s32 status, s32 dir_id, BOOL use_num, s32 num);
+
+static void HuDataLruRemove(s32 status)
+{
+    DataStatLink *link = &ReadDataLink[status];
+    if(link->prev >= 0) {
+        ReadDataLink[link->prev].next = link->next;
+    } else {
+        ReadDataLruHead = link->next;
+    }
+    if(link->next >= 0) {
+        ReadDataLink[link->next].prev = link->prev;
+    } else {
+        ReadDataLruTail = link->prev;
+    }
+}
+
+static void HuDataLruPush(s32 status)
+{
+    DataStatLink *link = &ReadDataLink[status];
+    link->prev = -1;
+    link->next = ReadDataLruHead;
+    if(ReadDataLruHead >= 0) {
+        ReadDataLink[ReadDataLruHead].prev = status;
+    } else {
+        ReadDataLruTail = status;
+    }
+    ReadDataLruHead = status;
+}
+
+static void HuDataStatTouch(s32 status)
+{
+    BOOL intr = OSDisableInterrupts();
+    if(ReadDataLruHead != status) {
+        HuDataLruRemove(status);
+        HuDataLruPush(status);
+    }
+    OSRestoreInterrupts(intr);
+}
+
+static void HuDataStatLinkPtr(s32 status)
+{
+    DataStatLink *link = &ReadDataLink[status];
+    s16 *hash;
+    BOOL intr;
+    if(!ReadDataStat[status].dir) {
+        return;
+    }
+    intr = OSDisableInterrupts();
+    hash = &ReadDataPtrHash[DATA_HASH_PTR(ReadDataStat[status].dir)];
+    link->ptr_next = *hash;
+    *hash = status;
+    OSRestoreInterrupts(intr);
+}
+
+static void HuDataStatLink(s32 status, s32 dir_id)
+{
+    DataStatLink *link = &ReadDataLink[status];
+    s16 *hash = &ReadDataIdHash[DATA_HASH_DIR(dir_id)];
+    BOOL intr = OSDisableInterrupts();
+    ReadDataStat[status].dir_id = dir_id;
+    link->id_next = *hash;
+    *hash = status;
+    HuDataLruPush(status);
+    OSRestoreInterrupts(intr);
+    HuDataStatLinkPtr(status);
+}
+
+static void HuDataStatUnlink(s32 status)
+{
+    DataReadStat *read_stat = &ReadDataStat[status];
+    s16 *hash;
+    BOOL intr = OSDisableInterrupts();
+    for(hash = &ReadDataIdHash[DATA_HASH_DIR(read_stat->dir_id)]; *hash >= 0; hash = &ReadDataLink[*hash].id_next) {
+        if(*hash == status) {
+            *hash = ReadDataLink[status].id_next;
+            break;
+        }
+    }
+    if(read_stat->dir) {
+        for(hash = &ReadDataPtrHash[DATA_HASH_PTR(read_stat->dir)]; *hash >= 0; hash = &ReadDataLink[*hash].ptr_next) {
+            if(*hash == status) {
+                *hash = ReadDataLink[status].ptr_next;
+                break;
+            }
+        }
+    }
+    HuDataLruRemove(status);
+    read_stat->dir_id = -1;
+    OSRestoreInterrupts(intr);
+}
+
+static void HuDataStatFree(s32 status)
+{
+    BOOL intr = OSDisableInterrupts();
+    ReadDataStat[status].dir_id = -1;
+    ReadDataPrefetchF[status] = FALSE;
+    ReadDataHeldF[status] = FALSE;
+    ReadDataPin[status] = 0;
+    ReadDataLink[status].next = ReadDataFree;
+    ReadDataFree = status;
+    OSRestoreInterrupts(intr);
+}
+
+//A prefetched directory belongs to whoever reads it first
+//Reads tagged with a num take it over so it is freed with the rest of their data
+static void HuDataStatClaim(s32 status, BOOL use_num, s32 num)
+{
+    if(!ReadDataPrefetchF[status]) {
+        return;
+    }
+    ReadDataPrefetchF[status] = FALSE;
+    if(use_num) {
+        ReadDataStat[status].used = TRUE;
+        ReadDataStat[status].num = num;
+    }
+}
+
+static void HuDataDirLog(s32 dir_id)
+{
+    s32 i;
+    if(!ReadDataLog) {
+        return;
+    }
+    for(i=0; i<ReadDataLogNum; i++) {
+        if(ReadDataLog[i] == dir_id) {
+            return;
+        }
+    }
+    if(ReadDataLogNum < ReadDataLogMax) {
+        ReadDataLog[ReadDataLogNum++] = dir_id;
+    }
+}
+
+//Records every directory read from now on into log, once each in the order of first use
+void HuDataDirLogStart(s16 *log, s32 max)
+{
+    ReadDataLog = log;
+    ReadDataLogMax = max;
+    ReadDataLogNum = 0;
+}
+
+s32 HuDataDirLogEnd(void)
+{
+    ReadDataLog = NULL;
+    return ReadDataLogNum;
+}
+
 void HuDataInit(void)
 {
     s32 i = 0;
@@ -40,21 +226,75 @@ void HuDataInit(void)
     DataDirMax = i;
     for(i=0, read_stat = ReadDataStat; i<DATA_MAX_READSTAT; i++, read_stat++) {
         read_stat->dir_id = -1;
+        read_stat->dir = NULL;
         read_stat->used = FALSE;
         read_stat->status = 0;
     }
+    for(i=0; i<DATA_HASH_MAX; i++) {
+        ReadDataIdHash[i] = -1;
+        ReadDataPtrHash[i] = -1;
+    }
+    ReadDataFree = -1;
+    for(i=DATA_MAX_READSTAT-1; i>=0; i--) {
+        HuDataStatFree(i);
+    }
+    ReadDataLruHead = ReadDataLruTail = -1;
+    HuDataCacheStatReset();
+}
+
+//Only a directory nobody can still be using may be evicted: not being read, not owned by a num,
+//never handed out to a caller and not pinned by a reader
+static BOOL HuDataStatEvictChk(s32 status)
+{
+    return ReadDataStat[status].status != 1 && !ReadDataStat[status].used && !ReadDataHeldF[status] && !ReadDataPin[status];
 }
 
-static s32 HuDataReadStatusGet(void)
+//Takes a slot off the free list
+//When all slots are taken and evict is set, the least recently used directory that can be
+//evicted is closed and its slot reused
+//evict must be FALSE from interrupt context, the heap cannot be touched there
+static s32 HuDataReadStatusGet(BOOL evict)
 {
     s32 i;
-    for(i=0; i<DATA_MAX_READSTAT; i++) {
-        if(ReadDataStat[i].dir_id == -1) {
-            break;
+    DataReadStat *read_stat;
+    BOOL intr = OSDisableInterrupts();
+    if((i = ReadDataFree) >= 0) {
+        ReadDataFree = ReadDataLink[i].next;
+        OSRestoreInterrupts(intr);
+        return i;
+    }
+    if(evict) {
+        for(i=ReadDataLruTail; i >= 0; i=ReadDataLink[i].prev) {
+            if(HuDataStatEvictChk(i)) {
+                break;
+            }
+        }
+        if(i >= 0) {
+            HuDataStatUnlink(i);
         }
     }
-    if(i >= DATA_MAX_READSTAT) {
-        i = -1;
+    OSRestoreInterrupts(intr);
+    if(i < 0) {
+        return -1;
+    }
+    ReadDataCacheStat.evict++;
+    read_stat = &ReadDataStat[i];
+    HuDvdDataClose(read_stat->dir);
+    read_stat->dir = NULL;
+    read_stat->status = 0;
+    ReadDataPrefetchF[i] = FALSE;
+    return i;
+}
+
+//Slot of a directory that is still being read asynchronously
+static s32 HuDataReadAsyncChk(s32 data_num)
+{
+    s32 i;
+    data_num >>= 16;
+    for(i=ReadDataIdHash[DATA_HASH_DIR(data_num)]; i >= 0; i=ReadDataLink[i].id_next) {
+        if(ReadDataStat[i].dir_id == data_num && ReadDataStat[i].status == 1) {
+            break;
+        }
     }
     return i;
 }
@@ -63,41 +303,83 @@ s32 HuDataReadChk(s32 data_num)
 {
     s32 i;
     data_num >>= 16;
-    for(i=0; i<DATA_MAX_READSTAT; i++) {
+    for(i=ReadDataIdHash[DATA_HASH_DIR(data_num)]; i >= 0; i=ReadDataLink[i].id_next) {
         if(ReadDataStat[i].dir_id == data_num && ReadDataStat[i].status != 1) {
             break;
         }
     }
-    if(i >= DATA_MAX_READSTAT) {
-        i = -1;
-    }
     return i;
 }
 
 DataReadStat *HuDataGetStatus(void *dir_ptr)
 {
     s32 i;
-    for(i=0; i<DATA_MAX_READSTAT; i++) {
+    for(i=ReadDataPtrHash[DATA_HASH_PTR(dir_ptr)]; i >= 0; i=ReadDataLink[i].ptr_next) {
         if(ReadDataStat[i].dir == dir_ptr) {
             break;
         }
     }
-    if(i > DATA_MAX_READSTAT) {
+    if(i < 0) {
         return NULL;
     }
     return &ReadDataStat[i];
 }
 
+void HuDataCacheStatGet(DataCacheStat *stat)
+{
+    *stat = ReadDataCacheStat;
+}
+
+void HuDataCacheStatReset(void)
+{
+    ReadDataCacheStat.hit = 0;
+    ReadDataCacheStat.miss = 0;
+    ReadDataCacheStat.evict = 0;
+}
+
 void *HuDataGetDirPtr(s32 data_num)
 {
     s32 status = HuDataReadChk(data_num);
     if(status < 0) {
         return NULL;
     }
+    ReadDataHeldF[status] = TRUE;
     return ReadDataStat[status].dir;
 }
 
+//The caller gets the directory itself, so it is kept until it is closed
 DataReadStat *HuDataDirRead(s32 data_num)
+{
+    DataReadStat *read_stat = HuDataDirReadSub(data_num);
+    if(read_stat) {
+        ReadDataHeldF[read_stat-ReadDataStat] = TRUE;
+    }
+    return read_stat;
+}
+
+//Blocking reads go through the slot like async ones, linked as still being read
+//Another process asking for the same directory meanwhile waits for this read instead of starting its own,
+//and the DVD callback finishes the slot even if the process that started it is killed
+static void HuDataDirReadStart(s32 status, s32 dir_id, BOOL use_num, s32 num)
+{
+    DataReadStat *read_stat = &ReadDataStat[status];
+    read_stat->status = 1;
+    read_stat->dir = NULL;
+    if(use_num) {
+        read_stat->used = TRUE;
+        read_stat->num = num;
+    }
+    HuDataStatLink(status, dir_id);
+    if(use_num) {
+        read_stat->dir = HuDvdDataFastReadNumAsync(DataDirStat[dir_id].file_id, num, read_stat);
+    } else {
+        read_stat->dir = HuDvdDataFastReadAsync(DataDirStat[dir_id].file_id, read_stat);
+    }
+    HuDataStatLinkPtr(status);
+}
+
+//Reads used only to copy files out leave the directory to the cache
+static DataReadStat *HuDataDirReadSub(s32 data_num)
 {
     DataReadStat *read_stat;
     s32 status;
@@ -107,26 +389,33 @@ DataReadStat *HuDataDirRead(s32 data_num)
         OSReport("data.c: Data Number Error(%d)\n", data_num);
         return NULL;
     }
-    
+    HuDataDirLog(dir_id);
+    HuDataDirReadAsyncWait(data_num);
     if((status = HuDataReadChk(data_num)) < 0) {
         u32 dir_aram;
+        ReadDataCacheStat.miss++;
         if(dir_aram = HuARDirCheck(data_num)) {
-            HuAR_ARAMtoMRAM(dir_aram);
-            while(HuARDMACheck());
-            status = HuDataReadChk(data_num);
-            read_stat = &ReadDataStat[status];
-        } else {
-            if((status = HuDataReadStatusGet()) == -1) {
-                OSReport("data.c: Data Work Max Error\n");
+            HuARFenceWait(HuAR_ARAMtoMRAMList(&data_num, 1, 0, ARQ_PRIORITY_HIGH));
+            if((status = HuDataReadChk(data_num)) < 0) {
                 return NULL;
             }
             read_stat = &ReadDataStat[status];
-            read_stat->dir = HuDvdDataFastRead(DataDirStat[dir_id].file_id);
-            if(read_stat->dir) {
-                read_stat->dir_id = dir_id;
-            }
+        } else {
+            //A reader that slept may find the directory evicted again by the time it wakes up
+            do {
+                if((status = HuDataReadStatusGet(TRUE)) == -1) {
+                    OSReport("data.c: Data Work Max Error\n");
+                    return NULL;
+                }
+                HuDataDirReadStart(status, dir_id, FALSE, 0);
+                HuDataDirReadAsyncWait(data_num);
+            } while((status = HuDataReadChk(data_num)) < 0);
+            read_stat = &ReadDataStat[status];
         }
     } else {
+        ReadDataCacheStat.hit++;
+        HuDataStatTouch(status);
+        HuDataStatClaim(status, FALSE, 0);
         read_stat = &ReadDataStat[status];
     }
     return read_stat;
@@ -142,51 +431,57 @@ static DataReadStat *HuDataDirReadNum(s32 data_num, s32 num)
         OSReport("data.c: Data Number Error(%d)\n", data_num);
         return NULL;
     }
-    
+    HuDataDirLog(dir_id);
+    HuDataDirReadAsyncWait(data_num);
     if((status = HuDataReadChk(data_num)) < 0) {
         u32 dir_aram;
+        ReadDataCacheStat.miss++;
         if((dir_aram = HuARDirCheck(data_num))) {
             OSReport("ARAM data num %x\n", data_num);
-            HuAR_ARAMtoMRAMNum(dir_aram, num);
-            while(HuARDMACheck());
-            status = HuDataReadChk(data_num);
+            HuARFenceWait(HuAR_ARAMtoMRAMList(&data_num, 1, num, ARQ_PRIORITY_HIGH));
+            if((status = HuDataReadChk(data_num)) < 0) {
+                return NULL;
+            }
             read_stat = &ReadDataStat[status];
             read_stat->used = TRUE;
             read_stat->num = num;
         } else {
             OSReport("data num %x\n", data_num);
-            if((status = HuDataReadStatusGet()) == -1) {
+            if((status = HuDataReadStatusGet(TRUE)) == -1) {
                 OSReport("data.c: Data Work Max Error\n");
                 return NULL;
             }
-            read_stat = &ReadDataStat[status];
-            read_stat->dir = HuDvdDataFastReadNum(DataDirStat[dir_id].file_id, num);
-            if(read_stat->dir) {
-                read_stat->dir_id = dir_id;
-                read_stat->used = TRUE;
-                read_stat->num = num;
+            HuDataDirReadStart(status, dir_id, TRUE, num);
+            HuDataDirReadAsyncWait(data_num);
+            if((status = HuDataReadChk(data_num)) < 0) {
+                return NULL;
             }
+            read_stat = &ReadDataStat[status];
         }
     } else {
+        ReadDataCacheStat.hit++;
+        HuDataStatTouch(status);
+        HuDataStatClaim(status, TRUE, num);
         read_stat = &ReadDataStat[status];
     }
     return read_stat;
 }
 
+//Registers a directory pulled from ARAM, armem.c calls it from the main thread once the transfer lands
 DataReadStat *HuDataDirSet(void *dir_ptr, s32 data_num)
 {
     DataReadStat *read_stat = HuDataGetStatus(dir_ptr);
     s32 status;
-    if((status = HuDataReadChk(read_stat->dir_id << 16)) >= 0) {
+    if(read_stat && (status = HuDataReadChk(read_stat->dir_id << 16)) >= 0) {
         HuDataDirClose(data_num);
     }
-    if((status = HuDataReadStatusGet()) == -1) {
+    if((status = HuDataReadStatusGet(TRUE)) == -1) {
         OSReport("data.c: Data Work Max Error\n");
         return NULL;
     } else {
         read_stat = &ReadDataStat[status];
         read_stat->dir = dir_ptr;
-        read_stat->dir_id = data_num >>16;
+        HuDataStatLink(status, data_num >> 16);
         return read_stat;
     }
 }
@@ -194,21 +489,54 @@ DataReadStat *HuDataDirSet(void *dir_ptr, s32 data_num)
 void HuDataDirReadAsyncCallBack(s32 result, DVDFileInfo* fileInfo)
 {
     DataReadStat *read_stat;
-    s32 i;
-    for(i=0; i<DATA_MAX_READSTAT; i++) {
-        if(ReadDataStat[i].status == 1 && ReadDataStat[i].file_info.startAddr == fileInfo->startAddr) {
-            break;
-        }
-    }
-    if(i >= DATA_MAX_READSTAT) {
+    read_stat = (DataReadStat *)((u8 *)fileInfo-offsetof(DataReadStat, file_info));
+    if(read_stat < ReadDataStat || read_stat >= &ReadDataStat[DATA_MAX_READSTAT] || read_stat->status != 1) {
         OSPanic("data.c", 358, "dvd.c AsyncCallBack Error");
     }
-    read_stat = &ReadDataStat[i];
     read_stat->status = 0;
     DVDClose(&read_stat->file_info);
 }
 
+//A directory that is still arriving from an earlier read or prefetch is waited for
+//Its read is raised to the front of the DVD queue first
+//Called from a process this sleeps a frame at a time; a kill just ends the process, the callback still lands the read
+static void HuDataDirReadAsyncWait(s32 data_num)
+{
+    DataReadStat *read_stat;
+    Process *process;
+    s32 dir_id = data_num >> 16;
+    s32 status = HuDataReadAsyncChk(data_num);
+    if(status < 0) {
+        return;
+    }
+    read_stat = &ReadDataStat[status];
+    HuDvdFilePrioSet(&read_stat->file_info, DVD_PRIO_WAIT);
+    process = HuPrcCurrentGet();
+    if(process && !HuPrcKillChk(process)) {
+        while(read_stat->status == 1 && read_stat->dir_id == dir_id) {
+            HuDvdErrorWatch();
+            HuPrcVSleep();
+        }
+    } else {
+        while(read_stat->status == 1) {
+            HuDvdErrorWatch();
+        }
+    }
+}
+
 s32 HuDataDirReadAsync(s32 data_num)
+{
+    return HuDataDirReadAsyncPrio(data_num, DVD_PRIO_ASYNC);
+}
+
+//Queues a directory behind every other read, for loading the next scene while this one runs
+//The result is used like HuDataDirReadAsync, or simply by reading the directory later
+s32 HuDataDirPrefetch(s32 data_num)
+{
+    return HuDataDirReadAsyncPrio(data_num, DVD_PRIO_PREFETCH);
+}
+
+static s32 HuDataDirReadAsyncPrio(s32 data_num, s32 prio)
 {
     DataReadStat *read_stat;
     s32 status;
@@ -218,24 +546,54 @@ s32 HuDataDirReadAsync(s32 data_num)
         OSReport("data.c: Data Number Error(%d)\n", data_num);
         return -1;
     }
+    if(prio != DVD_PRIO_PREFETCH) {
+        HuDataDirLog(dir_id);
+    }
+    //Joining a read already in flight, such as a prefetch, only raises its priority
+    if((status = HuDataReadAsyncChk(data_num)) >= 0) {
+        if(prio != DVD_PRIO_PREFETCH) {
+            HuDataStatClaim(status, FALSE, 0);
+            ReadDataHeldF[status] = TRUE;
+        }
+        HuDvdFilePrioSet(&ReadDataStat[status].file_info, prio);
+        return status;
+    }
     if((status = HuDataReadChk(data_num)) < 0) {
         u32 dir_aram;
+        ReadDataCacheStat.miss++;
         if(dir_aram = HuARDirCheck(data_num)) {
             OSReport("ARAM data num %x\n", data_num);
-            HuAR_ARAMtoMRAM(dir_aram);
-            status = 0x10000;
+            status = DATA_ASYNC_ARAM|HuAR_ARAMtoMRAMList(&data_num, 1, 0, ARQ_PRIORITY_LOW);
         } else {
-            status = HuDataReadStatusGet();
+            status = HuDataReadStatusGet(TRUE);
             if(status == -1) {
                 OSReport("data.c: Data Work Max Error\n");
                 return -1;
             }
             read_stat = &ReadDataStat[status];
             read_stat->status = 1;
-            read_stat->dir_id = dir_id;
-            read_stat->dir = HuDvdDataFastReadAsync(DataDirStat[dir_id].file_id, read_stat);
+            read_stat->dir = NULL;
+            HuDataStatLink(status, dir_id);
+            if(prio == DVD_PRIO_PREFETCH) {
+                read_stat->dir = HuDvdDataFastPrefetch(DataDirStat[dir_id].file_id, read_stat);
+                if(!read_stat->dir) {
+                    read_stat->status = 0;
+                    HuDataStatUnlink(status);
+                    HuDataStatFree(status);
+                    return -1;
+                }
+                ReadDataPrefetchF[status] = TRUE;
+            } else {
+                ReadDataHeldF[status] = TRUE;
+                read_stat->dir = HuDvdDataFastReadAsync(DataDirStat[dir_id].file_id, read_stat);
+            }
+            HuDataStatLinkPtr(status);
         }
     } else {
+        ReadDataCacheStat.hit++;
+        if(prio != DVD_PRIO_PREFETCH) {
+            HuDataStatClaim(status, FALSE, 0);
+        }
         status = -1;
     }
     return status;
@@ -251,27 +609,65 @@ s32 HuDataDirReadNumAsync(s32 data_num, s32 num)
         OSReport("data.c: Data Number Error(%d)\n", data_num);
         return -1;
     }
+    HuDataDirLog(dir_id);
+    if((status = HuDataReadAsyncChk(data_num)) >= 0) {
+        HuDataStatClaim(status, TRUE, num);
+        HuDvdFilePrioSet(&ReadDataStat[status].file_info, DVD_PRIO_ASYNC);
+        return status;
+    }
     if((status = HuDataReadChk(data_num)) < 0) {
-        if((status = HuDataReadStatusGet()) == -1) {
+        ReadDataCacheStat.miss++;
+        if((status = HuDataReadStatusGet(TRUE)) == -1) {
             OSReport("data.c: Data Work Max Error\n");
             return -1;
         }
         ReadDataStat[status].status = TRUE;
-        ReadDataStat[status].dir_id = dir_id;
+        ReadDataStat[status].dir = NULL;
+        HuDataStatLink(status, dir_id);
         read_stat = &ReadDataStat[status];
         read_stat->used = TRUE;
         read_stat->num = num;
         read_stat->dir = HuDvdDataFastReadAsync(DataDirStat[dir_id].file_id, read_stat);
+        HuDataStatLinkPtr(status);
     } else {
+        ReadDataCacheStat.hit++;
+        HuDataStatClaim(status, TRUE, num);
         status = -1;
     }
     return status;
 }
 
+//TRUE once a prefetched directory has arrived and nobody has read it yet
+BOOL HuDataDirPrefetchDone(s32 data_num)
+{
+    s32 status = HuDataReadChk(data_num);
+    return status >= 0 && ReadDataPrefetchF[status];
+}
+
+//Closes every prefetched directory nobody has read
+//Returns how many are still arriving, so the caller can try again once they have
+s32 HuDataDirPrefetchClose(void)
+{
+    s32 i, next;
+    s32 num = 0;
+    for(i=ReadDataLruHead; i >= 0; i=next) {
+        next = ReadDataLink[i].next;
+        if(!ReadDataPrefetchF[i]) {
+            continue;
+        }
+        if(ReadDataStat[i].status == 1) {
+            num++;
+        } else {
+            HuDataStatClose(i);
+        }
+    }
+    return num;
+}
+
 BOOL HuDataGetAsyncStat(s32 status)
 {
-    if(status == 0x10000) {
-        return HuARDMACheck() == 0;
+    if(status & DATA_ASYNC_ARAM) {
+        return HuARFenceCheck(status & ~DATA_ASYNC_ARAM);
     } else {
         return ReadDataStat[status].status == 0;
     }
@@ -293,7 +689,7 @@ void *HuDataRead(s32 data_num)
     DataReadStat *read_stat;
     s32 status;
     void *buf;
-    if(!HuDataDirRead(data_num)) {
+    if(!HuDataDirReadSub(data_num)) {
         (void)data_num;
         return NULL;
     }
@@ -334,7 +730,7 @@ void *HuDataSelHeapRead(s32 data_num, HeapID heap)
     DataReadStat *read_stat;
     s32 status;
     void *buf;
-    if(!HuDataDirRead(data_num)) {
+    if(!HuDataDirReadSub(data_num)) {
         return NULL;
     }
     if((status = HuDataReadChk(data_num)) == -1) {
@@ -401,6 +797,16 @@ void *HuDataSelHeapReadNum(s32 data_num, s32 num, HeapID heap)
     return buf;
 }
 
+static void HuDataDirUnpin(s32 *dir_ids)
+{
+    s32 status;
+    for(; *dir_ids != -1; dir_ids++) {
+        if((status = HuDataReadChk(*dir_ids << 16)) >= 0 && ReadDataPin[status]) {
+            ReadDataPin[status]--;
+        }
+    }
+}
+
 void **HuDataReadMulti(s32 *data_ids)
 {
     return HuDataReadMultiSub(data_ids, FALSE, 0);
@@ -409,11 +815,13 @@ void **HuDataReadMulti(s32 *data_ids)
 void **HuDataReadMultiSub(s32 *data_ids, BOOL use_num, s32 num)
 {
     s32 *dir_ids;
+    s32 *aram_ids;
     char **paths;
     void **dir_ptrs;
     void **out_ptrs;
-    s32 i, count, total_files;
+    s32 i, count, total_files, aram_num;
     u32 dir_id;
+    u32 fence;
     for(i=0, count=0; data_ids[i] != -1; i++) {
         dir_id = data_ids[i] >> 16;
         if(DataDirMax <= dir_id) {
@@ -422,6 +830,8 @@ void **HuDataReadMultiSub(s32 *data_ids, BOOL use_num, s32 num)
         }
         if(HuDataReadChk(data_ids[i]) < 0) {
             count++;
+        } else {
+            ReadDataCacheStat.hit++;
         }
     }
     total_files = i;
@@ -430,10 +840,23 @@ void **HuDataReadMultiSub(s32 *data_ids, BOOL use_num, s32 num)
         dir_ids[i] = -1;
     }
     paths = HuMemDirectMalloc(HEAP_SYSTEM, (count+1)*sizeof(char *));
-    for(i=0, count=0; data_ids[i] != -1; i++) {
+    aram_ids = HuMemDirectMalloc(HEAP_SYSTEM, (count+1)*sizeof(s32));
+    for(i=0, count=0, aram_num=0; data_ids[i] != -1; i++) {
         dir_id = data_ids[i] >> 16;
         if(HuDataReadChk(data_ids[i]) < 0) {
             s32 j;
+            if(HuARDirCheck(data_ids[i])) {
+                for(j=0; j<aram_num; j++) {
+                    if((aram_ids[j] >> 16) == dir_id) {
+                        break;
+                    }
+                }
+                if(j == aram_num) {
+                    aram_ids[aram_num++] = dir_id << 16;
+                    ReadDataCacheStat.miss++;
+                }
+                continue;
+            }
             for(j=0; dir_ids[j] != -1; j++) {
                 if(dir_ids[j] == dir_id){
                     break;
@@ -442,24 +865,35 @@ void **HuDataReadMultiSub(s32 *data_ids, BOOL use_num, s32 num)
             if(dir_ids[j] == -1) {
                 dir_ids[j] = dir_id;
                 paths[count++] = DataDirStat[dir_id].name;
+                ReadDataCacheStat.miss++;
             }
         }
     }
+    paths[count] = NULL;
+    //Directories held in ARAM are pulled as one batch while the DVD reads run
+    fence = HuAR_ARAMtoMRAMList(aram_ids, aram_num, 0, ARQ_PRIORITY_HIGH);
     dir_ptrs = HuDvdDataReadMulti(paths);
     for(i=0; dir_ids[i] != -1; i++) {
         s32 status;
-        if((status = HuDataReadStatusGet()) == -1) {
+        if((status = HuDataReadStatusGet(TRUE)) == -1) {
             OSReport("data.c: Data Work Max Error\n");
             (void)count; //HACK to match HuDataReadMultiSub
+            dir_ids[i] = -1;
+            HuARFenceWait(fence);
+            HuDataDirUnpin(dir_ids);
             HuMemDirectFree(dir_ids);
+            HuMemDirectFree(aram_ids);
             HuMemDirectFree(paths);
             return NULL;
         } else {
             ReadDataStat[status].dir = dir_ptrs[i];
-            ReadDataStat[status].dir_id = dir_ids[i];
+            HuDataStatLink(status, dir_ids[i]);
+            //Registering the ARAM batch takes slots too, it must not evict these before they are read
+            ReadDataPin[status]++;
         }
     }
-    HuMemDirectFree(dir_ids);
+    HuARFenceWait(fence);
+    HuMemDirectFree(aram_ids);
     HuMemDirectFree(paths);
     HuMemDirectFree(dir_ptrs);
     if(use_num) {
@@ -475,6 +909,8 @@ void **HuDataReadMultiSub(s32 *data_ids, BOOL use_num, s32 num)
         }
     }
     out_ptrs[i] = NULL;
+    HuDataDirUnpin(dir_ids);
+    HuMemDirectFree(dir_ids);
     return out_ptrs;
 }
 
@@ -511,36 +947,42 @@ void HuDataCloseMulti(void **ptrs)
     }
 }
 
+static void HuDataStatClose(s32 status)
+{
+    DataReadStat *read_stat = &ReadDataStat[status];
+    if(read_stat->status == 1) {
+        OSPanic("data.c", 812, "data.c: Async Close Error\n");
+    }
+    HuDataStatUnlink(status);
+    HuDvdDataClose(read_stat->dir);
+    read_stat->dir = NULL;
+    read_stat->used = FALSE;
+    read_stat->status = 0;
+    HuDataStatFree(status);
+}
+
 void HuDataDirClose(s32 data_id)
 {
-    DataReadStat *read_stat;
     s32 i;
     s32 dir_id = data_id >> 16;
-    for(i=0; i<DATA_MAX_READSTAT; i++) {
+    for(i=ReadDataIdHash[DATA_HASH_DIR(dir_id)]; i >= 0; i=ReadDataLink[i].id_next) {
         if(ReadDataStat[i].dir_id == dir_id) {
             break;
         }
     }
-    if(i >= DATA_MAX_READSTAT) {
+    if(i < 0) {
         return;
     }
-    read_stat = &ReadDataStat[i];
-    if(read_stat->status == 1) {
-        OSPanic("data.c", 812, "data.c: Async Close Error\n");
-    }
-    read_stat->dir_id = -1;
-    HuDvdDataClose(read_stat->dir);
-    read_stat->dir = NULL;
-    read_stat->used = FALSE;
-    read_stat->status = 0;
+    HuDataStatClose(i);
 }
 
 void HuDataDirCloseNum(s32 num)
 {
-    s32 i;
-    for(i=0; i<DATA_MAX_READSTAT; i++) {
+    s32 i, next;
+    for(i=ReadDataLruHead; i >= 0; i=next) {
+        next = ReadDataLink[i].next;
         if(ReadDataStat[i].used == TRUE && ReadDataStat[i].num == num) {
-            HuDataDirClose(ReadDataStat[i].dir_id << 16);
+            HuDataStatClose(i);
         }
     }
 }
@@ -560,23 +1002,32 @@ static s32 HuDataDVDdirDirectOpen(s32 data_id, DVDFileInfo *fileInfo)
 	return 1;
 }
 
-static s32 HuDataDVDdirDirectRead(DVDFileInfo *fileInfo, void *dest, s32 len, s32 offset)
+static void HuDataDVDdirDirectReadStart(DVDFileInfo *fileInfo, void *dest, s32 len, s32 offset)
 {
 	s32 result = DVDReadAsync(fileInfo, dest, len, offset, NULL);
 	if(result != 1) {
 		OSPanic("data.c", 904, "HuDataDVDdirDirectRead: File Read Error");
 	}
+}
+
+static void HuDataDVDdirDirectReadWait(DVDFileInfo *fileInfo)
+{
 	while(DVDGetCommandBlockStatus(&fileInfo->cb)) {
 		if(shortAccessSleep) {
 			HuPrcVSleep();
 		}
 	}
-	return result;
 }
 
-static void *HuDataDecodeIt(void *buf_start, s32 buf_ofs, s32 num, HeapID heap)
+static s32 HuDataDVDdirDirectRead(DVDFileInfo *fileInfo, void *dest, s32 len, s32 offset)
+{
+	HuDataDVDdirDirectReadStart(fileInfo, dest, len, offset);
+	HuDataDVDdirDirectReadWait(fileInfo);
+	return 1;
+}
+
+static void *HuDataDecodeBegin(DecodeStream *stream, void *buf_start, s32 buf_ofs, s32 num, HeapID heap)
 {
-	void *data_start;
 	s32 *buf;
 	s32 raw_len, comp_type;
 	
@@ -592,12 +1043,10 @@ static void *HuDataDecodeIt(void *buf_start, s32 buf_ofs, s32 num, HeapID heap)
 		comp_type += *data++ << 16;
 		comp_type += *data++ << 8;
 		comp_type += *data++;
-		data_start = data;
 	} else {
 		s32 *data = buf;
 		raw_len = *data++;
 		comp_type = *data++;
-		data_start = data;
 	}
 	switch(heap) {
         case HEAP_MUSIC:
@@ -617,24 +1066,33 @@ static void *HuDataDecodeIt(void *buf_start, s32 buf_ofs, s32 num, HeapID heap)
             break;
     }
     if(dest) {
-        HuDecodeData(data_start, dest, raw_len, comp_type);
+        HuDecodeStreamBegin(stream, dest, raw_len, comp_type);
     }
     return dest;
 }
 
-
-//Still to be decompiled
+//The file is read in DATA_STREAM_CHUNK pieces into two staging buffers
+//Each piece is decoded while the DVD fills the other one
 void *HuDataReadNumHeapShortForce(s32 data_id, s32 num, HeapID heap)
 {
 	DVDFileInfo fileInfo;
+	DecodeStream *stream;
 	s32 *data_hdr;
 	s32 *file_data;
 	void *file_raw_buf;
+	u8 *chunk;
+	u8 *next_chunk;
 	s32 read_len;
 	s32 file_id;
 	s32 file_ofs;
 	s32 read_ofs;
 	s32 data_ofs;
+	s32 buf_len;
+	s32 stage_len;
+	s32 chunk_len;
+	s32 next_len;
+	s32 read_pos;
+	BOOL done;
 	void *ret;
 	s32 dir;
 	s32 data_len;
@@ -674,20 +1132,47 @@ void *HuDataReadNumHeapShortForce(s32 data_id, s32 num, HeapID heap)
 	}
 	read_len = OSRoundUp32B(data_ofs);
 	HuMemDirectFree(file_data);
-	file_raw_buf = HuMemDirectMalloc(HEAP_SYSTEM, (read_len+4) & ~0x3);
+	buf_len = (read_len > DATA_STREAM_CHUNK) ? DATA_STREAM_CHUNK : read_len;
+	stage_len = (read_len > buf_len) ? buf_len*2 : buf_len;
+	file_raw_buf = HuMemDirectMalloc(HEAP_SYSTEM, stage_len+sizeof(DecodeStream));
 	if(file_raw_buf == NULL) {
 		OSReport("data.c: couldn't allocate read buffer(0x%08x)\n", data_id);
 		DVDClose(&fileInfo);
 		return NULL;
 	}
-	if(!HuDataDVDdirDirectRead(&fileInfo, file_raw_buf, read_len, read_ofs)) {
+	stream = PTR_OFFSET(file_raw_buf, stage_len);
+	if(!HuDataDVDdirDirectRead(&fileInfo, file_raw_buf, buf_len, read_ofs)) {
 		HuMemDirectFree(file_raw_buf);
 		DVDClose(&fileInfo);
 		return NULL;
 	}
-	DVDClose(&fileInfo);
 	data_ofs = file_ofs-read_ofs;
-	ret = HuDataDecodeIt(file_raw_buf, data_ofs, num, heap);
+	ret = HuDataDecodeBegin(stream, file_raw_buf, data_ofs, num, heap);
+	if(ret) {
+		chunk = file_raw_buf;
+		chunk_len = buf_len-(data_ofs+8);
+		chunk += data_ofs+8;
+		read_pos = buf_len;
+		do {
+			next_chunk = (read_pos/buf_len) & 0x1 ? PTR_OFFSET(file_raw_buf, buf_len) : file_raw_buf;
+			next_len = read_len-read_pos;
+			if(next_len > buf_len) {
+				next_len = buf_len;
+			}
+			if(next_len) {
+				HuDataDVDdirDirectReadStart(&fileInfo, next_chunk, next_len, read_ofs+read_pos);
+			}
+			done = HuDecodeStreamFeed(stream, chunk, chunk_len);
+			if(next_len) {
+				HuDataDVDdirDirectReadWait(&fileInfo);
+			}
+			chunk = next_chunk;
+			chunk_len = next_len;
+			read_pos += next_len;
+		} while(!done && chunk_len);
+		HuDecodeStreamEnd(stream);
+	}
+	DVDClose(&fileInfo);
 	HuMemDirectFree(file_raw_buf);
     return ret;
 }
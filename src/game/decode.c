@@ -1,55 +1,126 @@
 #include "game/data.h"
 #include "dolphin/os.h"
+#include "string.h"
 
-struct decode_data
+#define DECODE_COPY_SHORT 16
+
+//A step never consumes more input than this, so streams only stop between steps
+#define DECODE_STEP_MAX 128
+
+static inline BOOL HuDecodeStepOK(struct decode_data *decode)
 {
-    u8 *src;
-    u8 *dst;
-    u32 size;
-};
+    return decode->size && (!decode->src_end || decode->src_end-decode->src >= DECODE_STEP_MAX);
+}
+
+static inline void HuDecodeCopyLit(u8 *dst, u8 *src, u32 len)
+{
+    if(len >= DECODE_COPY_SHORT) {
+        memcpy(dst, src, len);
+        return;
+    }
+    while(len) {
+        *dst++ = *src++;
+        len--;
+    }
+}
+
+//Copies a back-reference of len bytes starting dist bytes behind dst
+//Overlapping runs repeat the last dist bytes, so the source window is doubled each pass
+static void HuDecodeCopyMatch(u8 *dst, u32 dist, u32 len)
+{
+    u8 *src = dst-dist;
+    u32 copy_len;
+    if(dist >= len) {
+        HuDecodeCopyLit(dst, src, len);
+        return;
+    }
+    if(dist == 1) {
+        memset(dst, *src, len);
+        return;
+    }
+    while(len) {
+        copy_len = dst-src;
+        if(copy_len > len) {
+            copy_len = len;
+        }
+        HuDecodeCopyLit(dst, src, copy_len);
+        dst += copy_len;
+        len -= copy_len;
+    }
+}
 
-static u8 textBuffer[1024];
+//Back-reference that may start before the output buffer; those bytes decode as zero
+static inline void HuDecodeCopyMatchClip(u8 *dst, u8 *base_dst, u32 dist, u32 len)
+{
+    u32 zero_len;
+    if(dst-base_dst < dist) {
+        zero_len = dist-(dst-base_dst);
+        if(zero_len > len) {
+            zero_len = len;
+        }
+        memset(dst, 0, zero_len);
+        dst += zero_len;
+        len -= zero_len;
+        if(len == 0) {
+            return;
+        }
+    }
+    HuDecodeCopyMatch(dst, dist, len);
+}
 
 static void HuDecodeNone(struct decode_data *decode)
 {
-    while(decode->size) {
-        *decode->dst++ = *decode->src++;
-        decode->size--;
+    u32 len = decode->size;
+    if(decode->src_end && decode->src_end-decode->src < len) {
+        len = decode->src_end-decode->src;
     }
+    memcpy(decode->dst, decode->src, len);
+    decode->dst += len;
+    decode->src += len;
+    decode->size -= len;
 }
 
+//The LZ window is a 1024 byte ring starting at 958 which is zero filled on entry
+//Offsets are resolved against the output buffer instead of keeping a copy of the ring
 static void HuDecodeLz(struct decode_data *decode)
 {
-    u16 flag, pos;
-    s32 i, j, copy_len;
-    flag = 0;
-    pos = 958;
-    
-    
-    for(i=0; i<1024; i++) {
-        textBuffer[i] = 0;
-    }
-    while(decode->size) {
+    u8 *base_dst;
+    u16 flag;
+    s32 i, copy_len;
+    u32 pos, dist, lit_len;
+    flag = decode->flag;
+    base_dst = decode->base_dst;
+    while(HuDecodeStepOK(decode)) {
         flag >>= 1;
         if(!(flag & 0x100)) {
             flag = (*decode->src++)|0xFF00;
         }
         if(flag & 0x1) {
-            textBuffer[pos++] = *decode->dst++ = *decode->src++;
-            pos = pos & 0x3FF;
-            decode->size--;
+            lit_len = 1;
+            while(lit_len < decode->size && (flag & (0x100 << lit_len)) && ((flag >> lit_len) & 0x1)) {
+                lit_len++;
+            }
+            HuDecodeCopyLit(decode->dst, decode->src, lit_len);
+            decode->dst += lit_len;
+            decode->src += lit_len;
+            decode->size -= lit_len;
+            flag >>= lit_len-1;
         } else {
             i = *decode->src++;
             copy_len = *decode->src++;
             i |= ((copy_len & ~0x3F) << 2);
             copy_len = (copy_len & 0x3F)+3;
-            for(j=0; j<copy_len; j++) {
-                textBuffer[pos++] = *decode->dst++ = textBuffer[(i+j) & 0x3FF];
-                pos &= 0x3FF;
+            pos = (958+(decode->dst-base_dst)) & 0x3FF;
+            dist = (pos-i) & 0x3FF;
+            if(dist == 0) {
+                dist = 1024;
             }
-            decode->size -= j;
+            HuDecodeCopyMatchClip(decode->dst, base_dst, dist, copy_len);
+            decode->dst += copy_len;
+            decode->size -= copy_len;
         }
     }
+    decode->flag = flag;
 }
 
 static inline void SlideReadHeader(struct decode_data *decode)
@@ -61,62 +132,32 @@ static inline void SlideReadHeader(struct decode_data *decode)
     size += *decode->src++;
 }
 
-static void HuDecodeSlide(struct decode_data *decode)
+static inline u32 SlideLitCount(u32 flag, u32 num_bits, u32 size)
 {
-    u8 *base_dst;
-    u32 num_bits, flag;
-    SlideReadHeader(decode);
-    num_bits = 0;
-    flag = 0;
-    base_dst = decode->dst;
-    while(decode->size) {
-        if(num_bits == 0) {
-            flag = (*decode->src++) << 24;
-            flag += (*decode->src++) << 16;
-            flag += (*decode->src++) << 8;
-            flag += *decode->src++;
-            num_bits = 32;
-        }
-        if(flag >> 31) {
-            *decode->dst++ = (s32)*decode->src++;
-            decode->size--;
-        } else {
-            u8 *src;
-            u32 dist, len;
-            dist = *decode->src++ << 8;
-            dist += *decode->src++;
-            len = (dist >> 12) & 0xF;
-            dist &= 0xFFF;
-            src = decode->dst-dist;
-            if(len == 0) {
-                len = (*decode->src++)+18;
-            } else {
-                len += 2;
-            }
-            decode->size -= len;
-            while(len) {
-                if(src-1 < base_dst) {
-                    *decode->dst++ = 0;
-                } else {
-                    *decode->dst++ = src[-1];
-                }
-                len--;
-                src++;
-            }
-        }
-        
+    u32 lit_len = 1;
+    flag <<= 1;
+    while(lit_len < num_bits && lit_len < size && (flag >> 31)) {
         flag <<= 1;
-        num_bits--;
+        lit_len++;
     }
+    return lit_len;
 }
 
-static void HuDecodeFslide(struct decode_data *decode)
+static void HuDecodeSlideCommon(struct decode_data *decode, BOOL clip)
 {
-    u32 num_bits, flag;
-    SlideReadHeader(decode);
-    num_bits = 0;
-    flag = 0;
-    while(decode->size) {
+    u8 *base_dst;
+    u32 num_bits, flag, lit_len;
+    if(!decode->header) {
+        if(!HuDecodeStepOK(decode)) {
+            return;
+        }
+        SlideReadHeader(decode);
+        decode->header = TRUE;
+    }
+    num_bits = decode->num_bits;
+    flag = decode->flag;
+    base_dst = decode->base_dst;
+    while(HuDecodeStepOK(decode)) {
         if(num_bits == 0) {
             flag = (*decode->src++) << 24;
             flag += (*decode->src++) << 16;
@@ -125,89 +166,181 @@ static void HuDecodeFslide(struct decode_data *decode)
             num_bits = 32;
         }
         if(flag >> 31) {
-            *decode->dst++ = (s32)*decode->src++;
-            decode->size--;
+            lit_len = SlideLitCount(flag, num_bits, decode->size);
+            HuDecodeCopyLit(decode->dst, decode->src, lit_len);
+            decode->dst += lit_len;
+            decode->src += lit_len;
+            decode->size -= lit_len;
+            flag <<= lit_len;
+            num_bits -= lit_len;
         } else {
-            u8 *src;
             u32 dist, len;
             dist = *decode->src++ << 8;
             dist += *decode->src++;
             len = (dist >> 12) & 0xF;
-            dist &= 0xFFF;
-            src = decode->dst-dist;
+            dist = (dist & 0xFFF)+1;
             if(len == 0) {
                 len = (*decode->src++)+18;
             } else {
                 len += 2;
             }
-            decode->size -= len;
-            while(len) {
-                *decode->dst++ = src[-1];
-                len--;
-                src++;
+            if(clip) {
+                HuDecodeCopyMatchClip(decode->dst, base_dst, dist, len);
+            } else {
+                HuDecodeCopyMatch(decode->dst, dist, len);
             }
+            decode->dst += len;
+            decode->size -= len;
+            flag <<= 1;
+            num_bits--;
         }
-        
-        flag <<= 1;
-        num_bits--;
     }
+    decode->num_bits = num_bits;
+    decode->flag = flag;
+}
+
+static void HuDecodeSlide(struct decode_data *decode)
+{
+    HuDecodeSlideCommon(decode, TRUE);
+}
+
+static void HuDecodeFslide(struct decode_data *decode)
+{
+    HuDecodeSlideCommon(decode, FALSE);
 }
 
 static void HuDecodeRle(struct decode_data *decode)
 {
-    s32 i;
-    while(decode->size) {
+    while(HuDecodeStepOK(decode)) {
         s32 size = *decode->src++;
         if(size < 128) {
-            s32 fill = *decode->src++;
-            for(i=0; i<size; i++) {
-                *decode->dst++ = fill;
-            }
+            memset(decode->dst, *decode->src++, size);
         } else {
             size -= 128;
-            for(i=0; i<size; i++) {
-                *decode->dst++ = *decode->src++;
-            }
+            HuDecodeCopyLit(decode->dst, decode->src, size);
+            decode->src += size;
         }
+        decode->dst += size;
         decode->size -= size;
     }
 }
 
-void HuDecodeData(void *src, void *dst, u32 size, s32 decode_type)
+static void HuDecodeInit(struct decode_data *decode, void *dst, u32 size)
+{
+    decode->src = NULL;
+    decode->dst = dst;
+    decode->size = size;
+    decode->src_end = NULL;
+    decode->base_dst = dst;
+    decode->flag = 0;
+    decode->num_bits = 0;
+    decode->header = FALSE;
+}
+
+static void HuDecodeExec(struct decode_data *decode, s32 decode_type)
 {
-    struct decode_data decode;
-    struct decode_data *decode_ptr = &decode;
-    decode_ptr->src = src;
-    decode_ptr->dst = dst;
-    decode_ptr->size = size;
     switch(decode_type) {
         case DATA_DECODE_NONE:
-            HuDecodeNone(decode_ptr);
+            HuDecodeNone(decode);
             break;
-            
+
         case DATA_DECODE_LZ:
-            HuDecodeLz(decode_ptr);
+            HuDecodeLz(decode);
             break;
-            
+
         case DATA_DECODE_SLIDE:
-            HuDecodeSlide(decode_ptr);
+            HuDecodeSlide(decode);
             break;
-            
+
         case DATA_DECODE_FSLIDE_ALT:
-            HuDecodeFslide(decode_ptr);
+            HuDecodeFslide(decode);
             break;
-            
+
         case DATA_DECODE_FSLIDE:
-            HuDecodeFslide(decode_ptr);
+            HuDecodeFslide(decode);
             break;
-            
+
         case DATA_DECODE_RLE:
-            HuDecodeRle(decode_ptr);
+            HuDecodeRle(decode);
             break;
-            
+
         default:
             OSReport("decode tyep unknown.(%x)\n", decode_type);
+            decode->size = 0;
             break;
     }
+}
+
+void HuDecodeData(void *src, void *dst, u32 size, s32 decode_type)
+{
+    struct decode_data decode;
+    struct decode_data *decode_ptr = &decode;
+    HuDecodeInit(decode_ptr, dst, size);
+    decode_ptr->src = src;
+    HuDecodeExec(decode_ptr, decode_type);
     DCFlushRange(dst, size);
-}
\ No newline at end of file
+}
+
+void HuDecodeStreamBegin(DecodeStream *stream, void *dst, u32 size, s32 decode_type)
+{
+    stream->dst = dst;
+    stream->size = size;
+    stream->decode_type = decode_type;
+    stream->carry_len = 0;
+    HuDecodeInit(&stream->decode, dst, size);
+}
+
+//Decodes every step that is fully contained in the data fed so far
+//The unused tail is kept in the carry buffer and decoded ahead of the next chunk
+BOOL HuDecodeStreamFeed(DecodeStream *stream, void *src, u32 len)
+{
+    struct decode_data *decode = &stream->decode;
+    u8 *chunk = src;
+    u32 copy_len, carry_len;
+    if(decode->size == 0) {
+        return TRUE;
+    }
+    if(stream->carry_len) {
+        carry_len = stream->carry_len;
+        copy_len = DECODE_STREAM_CARRY_MAX-carry_len;
+        if(copy_len > len) {
+            copy_len = len;
+        }
+        memcpy(&stream->carry[carry_len], chunk, copy_len);
+        stream->carry_len += copy_len;
+        decode->src = stream->carry;
+        decode->src_end = &stream->carry[stream->carry_len];
+        HuDecodeExec(decode, stream->decode_type);
+        if(decode->src-stream->carry < carry_len) {
+            stream->carry_len = decode->src_end-decode->src;
+            memmove(stream->carry, decode->src, stream->carry_len);
+            return decode->size == 0;
+        }
+        chunk += (decode->src-stream->carry)-carry_len;
+        len -= (decode->src-stream->carry)-carry_len;
+        stream->carry_len = 0;
+        if(decode->size == 0) {
+            return TRUE;
+        }
+    }
+    decode->src = chunk;
+    decode->src_end = chunk+len;
+    HuDecodeExec(decode, stream->decode_type);
+    stream->carry_len = decode->src_end-decode->src;
+    memcpy(stream->carry, decode->src, stream->carry_len);
+    return decode->size == 0;
+}
+
+void HuDecodeStreamEnd(DecodeStream *stream)
+{
+    struct decode_data *decode = &stream->decode;
+    if(decode->size && stream->carry_len) {
+        decode->src = stream->carry;
+        decode->src_end = NULL;
+        HuDecodeExec(decode, stream->decode_type);
+    }
+    if(decode->size) {
+        OSReport("decode stream underrun.(%x)\n", decode->size);
+    }
+    DCFlushRange(stream->dst, stream->size);
+}
@@ -1,5 +1,6 @@
 #include "game/dvd.h"
 #include "game/data.h"
+#include "game/process.h"
 
 #include "dolphin/dvd.h"
 #include "dolphin/os.h"
@@ -15,16 +16,172 @@ static DVDDiskID correctDiskID = {
 };
 
 
-static int CallBackStatus;
+//Reads are split so a waiting load never sits behind more than one chunk of a prefetch
+#define DVD_REQ_CHUNK 0x40000
+
+#define DVD_REQ_STAT_FREE 0
+#define DVD_REQ_STAT_QUEUE 1
+#define DVD_REQ_STAT_READ 2
+#define DVD_REQ_STAT_DONE 3
+
+//Prefetches leave this fraction of the heap to the loads of the running scene
+#define DVD_PREFETCH_RESERVE_DIV 8
+
+typedef struct dvd_req {
+    DVDFileInfo *file;
+    void *buf;
+    u32 len;
+    u32 ofs;
+    s32 prio;
+    u32 order;
+    volatile s32 stat;
+    s32 result;
+    DVDCallback callback;
+    BOOL owned;
+    BOOL wait;
+    DVDFileInfo file_info;
+} DvdReq;
+
 static s32 beforeDvdStatus;
 
-static void HuDVDReadAsyncCallBack(s32 result, DVDFileInfo* fileInfo)
+static DvdReq DvdReqData[DVD_REQ_MAX];
+static s32 DvdReqCur = -1;
+static u32 DvdReqOrder;
+static s32 DvdReqOwnNum;
+
+static void HuDvdReqDone(DvdReq *req, s32 result);
+static void HuDvdReqCallBack(s32 result, DVDFileInfo *fileInfo);
+
+//Starts the most urgent queued request, oldest first among equal priorities
+//Runs with interrupts disabled or from the DVD callback
+static void HuDvdReqStart(void)
+{
+    DvdReq *req;
+    DvdReq *best;
+    s32 i;
+    u32 len;
+    while(DvdReqCur < 0) {
+        best = NULL;
+        for(req = DvdReqData, i=0; i<DVD_REQ_MAX; i++, req++) {
+            if(req->stat != DVD_REQ_STAT_QUEUE) {
+                continue;
+            }
+            if(!best || req->prio > best->prio || (req->prio == best->prio && (s32)(req->order-best->order) < 0)) {
+                best = req;
+            }
+        }
+        if(!best) {
+            return;
+        }
+        len = best->len-best->ofs;
+        if(len > DVD_REQ_CHUNK) {
+            len = DVD_REQ_CHUNK;
+        }
+        best->stat = DVD_REQ_STAT_READ;
+        DvdReqCur = best-DvdReqData;
+        if(DVDReadAsync(best->file, (u8 *)best->buf+best->ofs, len, best->ofs, HuDvdReqCallBack)) {
+            return;
+        }
+        DvdReqCur = -1;
+        HuDvdReqDone(best, -1);
+    }
+}
+
+static void HuDvdReqDone(DvdReq *req, s32 result)
+{
+    req->result = result;
+    if(req->callback) {
+        req->callback(result, req->file);
+    }
+    if(req->owned) {
+        req->stat = DVD_REQ_STAT_DONE;
+    } else {
+        req->stat = DVD_REQ_STAT_FREE;
+    }
+}
+
+static void HuDvdReqCallBack(s32 result, DVDFileInfo *fileInfo)
+{
+    DvdReq *req = &DvdReqData[DvdReqCur];
+    DvdReqCur = -1;
+    if(result <= 0) {
+        HuDvdReqDone(req, (result < 0) ? result : -1);
+    } else {
+        req->ofs += result;
+        if(req->ofs < req->len) {
+            req->stat = DVD_REQ_STAT_QUEUE;
+        } else {
+            HuDvdReqDone(req, req->ofs);
+        }
+    }
+    HuDvdReqStart();
+}
+
+//A request that owns its file keeps a copy of the opened file info in its slot
+static s32 HuDvdReqPush(DVDFileInfo *file, void *buf, u32 len, s32 prio, DVDCallback cb, BOOL owned, BOOL own_file)
 {
-    CallBackStatus = 1;
+    DvdReq *req;
+    s32 i;
+    BOOL intr = OSDisableInterrupts();
+    //One slot is always left to requests nobody waits on, so blocking loads can never starve
+    if(owned && DvdReqOwnNum >= DVD_REQ_MAX-1) {
+        OSRestoreInterrupts(intr);
+        return -1;
+    }
+    for(req = DvdReqData, i=0; i<DVD_REQ_MAX; i++, req++) {
+        if(req->stat == DVD_REQ_STAT_FREE) {
+            break;
+        }
+    }
+    if(i == DVD_REQ_MAX) {
+        OSRestoreInterrupts(intr);
+        return -1;
+    }
+    if(own_file) {
+        req->file_info = *file;
+        req->file = &req->file_info;
+    } else {
+        req->file = file;
+    }
+    req->buf = buf;
+    req->len = len;
+    req->ofs = 0;
+    req->prio = prio;
+    req->order = DvdReqOrder++;
+    req->result = 0;
+    req->callback = cb;
+    req->owned = owned;
+    req->wait = FALSE;
+    if(owned) {
+        DvdReqOwnNum++;
+    }
+    req->stat = DVD_REQ_STAT_QUEUE;
+    HuDvdReqStart();
+    OSRestoreInterrupts(intr);
+    return i;
 }
 
-static void *HuDvdDataReadWait(DVDFileInfo *file, int heap, int mode, int num, DVDCallback cb, BOOL skip_wait)
+static s32 HuDvdReqRelease(s32 req)
 {
+    DvdReq *req_ptr = &DvdReqData[req];
+    s32 result = req_ptr->result;
+    BOOL intr = OSDisableInterrupts();
+    req_ptr->stat = DVD_REQ_STAT_FREE;
+    DvdReqOwnNum--;
+    OSRestoreInterrupts(intr);
+    return result;
+}
+
+static BOOL HuDvdPrefetchSpaceChk(HeapID heap, u32 len)
+{
+    HuMemSnapshot snap;
+    HuMemHeapSnapshot(HuMemHeapPtrGet(heap), &snap);
+    return snap.free_max >= len && snap.free_size-len >= HuMemHeapSizeGet(heap)/DVD_PREFETCH_RESERVE_DIV;
+}
+
+static void *HuDvdDataReadWait(DVDFileInfo *file, int heap, int mode, int num, DVDCallback cb, BOOL skip_wait, s32 prio)
+{
+    s32 req;
     u32 len;
     void *buf;
     if(mode != 0 && mode != 1 && mode != 2) {
@@ -48,18 +205,151 @@ static void *HuDvdDataReadWait(DVDFileInfo *file, int heap, int mode, int num, D
     
     DCInvalidateRange(buf, OSRoundUp32B(len));
     OSReport("Rest Memory %x\n", HuMemHeapSizeGet(3)-HuMemUsedMallocSizeGet(3));
-    CallBackStatus = 0;
-    DVDReadAsync(file, buf, OSRoundUp32B(len), 0, cb);
+    while((req = HuDvdReqPush(file, buf, OSRoundUp32B(len), prio, cb, !skip_wait, FALSE)) < 0) {
+        HuDvdErrorWatch();
+    }
     if(!skip_wait) {
-        while(!CallBackStatus) {
+        buf = HuDvdReqWait(req);
+    }
+    
+    return buf;
+}
+
+s32 HuDvdReqFastRead(s32 entrynum, HeapID heap, s32 prio, DVDCallback cb)
+{
+    DVDFileInfo file;
+    void *buf;
+    u32 len;
+    s32 req;
+    if(!DVDFastOpen(entrynum, &file)) {
+        OSReport("dvd.c: File Open Error(%d)\n", entrynum);
+        return -1;
+    }
+    len = OSRoundUp32B(file.length);
+    if(prio == DVD_PRIO_PREFETCH && !HuDvdPrefetchSpaceChk(heap, len)) {
+        DVDClose(&file);
+        return -1;
+    }
+    buf = HuMemDirectMalloc(heap, len);
+    if(!buf) {
+        OSReport("dvd.c: Memory Allocation Error (Length %x)\n", len);
+        DVDClose(&file);
+        return -1;
+    }
+    DCInvalidateRange(buf, len);
+    req = HuDvdReqPush(&file, buf, len, prio, cb, TRUE, TRUE);
+    if(req < 0) {
+        HuMemDirectFree(buf);
+        DVDClose(&file);
+    }
+    return req;
+}
+
+s32 HuDvdReqFreeGet(void)
+{
+    s32 i;
+    s32 num = 0;
+    for(i=0; i<DVD_REQ_MAX; i++) {
+        if(DvdReqData[i].stat == DVD_REQ_STAT_FREE) {
+            num++;
+        }
+    }
+    return num;
+}
+
+BOOL HuDvdReqCheck(s32 req)
+{
+    return DvdReqData[req].stat == DVD_REQ_STAT_DONE;
+}
+
+//Returns the loaded buffer, or NULL if the read failed
+//Called from a process this sleeps a frame at a time instead of holding up the scheduler
+//A kill that comes meanwhile is held off until the read has landed, then the process ends here
+void *HuDvdReqWait(s32 req)
+{
+    DvdReq *req_ptr = &DvdReqData[req];
+    Process *process = HuPrcCurrentGet();
+    DVDFileInfo *file;
+    void *buf;
+    s32 result;
+    HuDvdReqPrioSet(req, DVD_PRIO_WAIT);
+    if(process && !HuPrcKillChk(process)) {
+        req_ptr->wait = TRUE;
+        HuPrcSetStat(process, PROCESS_STAT_KILL_HOLD);
+        while(req_ptr->stat != DVD_REQ_STAT_DONE) {
+            HuDvdErrorWatch();
+            HuPrcVSleep();
+        }
+        HuPrcResetStat(process, PROCESS_STAT_KILL_HOLD);
+    } else {
+        process = NULL;
+        while(req_ptr->stat != DVD_REQ_STAT_DONE) {
             HuDvdErrorWatch();
         }
-        HuDvdErrorWatch();
     }
-    
+    HuDvdErrorWatch();
+    buf = req_ptr->buf;
+    file = req_ptr->file;
+    if(file == &req_ptr->file_info) {
+        DVDClose(file);
+    }
+    result = HuDvdReqRelease(req);
+    //The caller never gets back to close its own file, so that is done here
+    //The buffer is left to whoever frees the rest of the process's memory
+    if(process && HuPrcKillChk(process)) {
+        if(file != &req_ptr->file_info) {
+            DVDClose(file);
+        }
+        HuPrcEnd();
+    }
+    if(result < 0) {
+        HuMemDirectFree(buf);
+        buf = NULL;
+    }
     return buf;
 }
 
+//Lets every read a process is sleeping on land, so the heaps they go into can be freed
+void HuDvdReqWaitAll(void)
+{
+    DvdReq *req;
+    s32 i;
+    for(req = DvdReqData, i=0; i<DVD_REQ_MAX; i++, req++) {
+        while(req->wait && (req->stat == DVD_REQ_STAT_QUEUE || req->stat == DVD_REQ_STAT_READ)) {
+            HuDvdErrorWatch();
+        }
+    }
+}
+
+void HuDvdReqPrioSet(s32 req, s32 prio)
+{
+    BOOL intr = OSDisableInterrupts();
+    DvdReqData[req].prio = prio;
+    HuDvdReqStart();
+    OSRestoreInterrupts(intr);
+}
+
+//Raises a read that was queued through its file info, such as a DataReadStat prefetch
+//Raising it to DVD_PRIO_WAIT means someone is waiting on it, so HuDvdReqWaitAll lands it too
+void HuDvdFilePrioSet(DVDFileInfo *file, s32 prio)
+{
+    DvdReq *req;
+    s32 i;
+    BOOL intr = OSDisableInterrupts();
+    for(req = DvdReqData, i=0; i<DVD_REQ_MAX; i++, req++) {
+        if(req->stat == DVD_REQ_STAT_FREE || req->file != file) {
+            continue;
+        }
+        if(req->prio < prio) {
+            req->prio = prio;
+        }
+        if(prio == DVD_PRIO_WAIT) {
+            req->wait = TRUE;
+        }
+    }
+    OSRestoreInterrupts(intr);
+}
+
 void *HuDvdDataRead(char *path)
 {
     DVDFileInfo file;
@@ -67,7 +357,7 @@ void *HuDvdDataRead(char *path)
     if(!DVDOpen(path, &file)) {
         OSPanic("dvd.c", 146, "dvd.c: File Open Error");
     } else {
-        data = HuDvdDataReadWait(&file, HEAP_DVD, 0, 0, HuDVDReadAsyncCallBack, FALSE);
+        data = HuDvdDataReadWait(&file, HEAP_DVD, 0, 0, NULL, FALSE, DVD_PRIO_WAIT);
         DVDClose(&file);
     }
     return data;
@@ -89,7 +379,7 @@ void **HuDvdDataReadMulti(char **paths)
             OSPanic("dvd.c", 183, "dvd.c: File Open Error");
             return NULL;
         } else {
-            file_ptrs[i] = HuDvdDataReadWait(&file, HEAP_DVD, 0, 0, HuDVDReadAsyncCallBack, FALSE);
+            file_ptrs[i] = HuDvdDataReadWait(&file, HEAP_DVD, 0, 0, NULL, FALSE, DVD_PRIO_WAIT);
             DVDClose(&file);
         }
     }
@@ -103,7 +393,7 @@ void *HuDvdDataReadDirect(char *path, HeapID heap)
     if(!DVDOpen(path, &file)) {
         OSPanic("dvd.c", 202, "dvd.c: File Open Error");
     } else {
-        data = HuDvdDataReadWait(&file, heap, 2, 0, HuDVDReadAsyncCallBack, FALSE);
+        data = HuDvdDataReadWait(&file, heap, 2, 0, NULL, FALSE, DVD_PRIO_WAIT);
         DVDClose(&file);
     }
     return data;
@@ -116,7 +406,7 @@ void *HuDvdDataFastRead(s32 entrynum)
     if(!DVDFastOpen(entrynum, &file)) {
         OSPanic("dvd.c", 243, "dvd.c: File Open Error");
     } else {
-        data = HuDvdDataReadWait(&file, HEAP_DVD, 0, 0, HuDVDReadAsyncCallBack, FALSE);
+        data = HuDvdDataReadWait(&file, HEAP_DVD, 0, 0, NULL, FALSE, DVD_PRIO_WAIT);
         DVDClose(&file);
     }
     return data;
@@ -130,12 +420,24 @@ void *HuDvdDataFastReadNum(s32 entrynum, s32 num)
         (void)num;
         OSPanic("dvd.c", 258, "dvd.c: File Open Error");
     } else {
-        data = HuDvdDataReadWait(&file, HEAP_DVD, 1, num, HuDVDReadAsyncCallBack, FALSE);
+        data = HuDvdDataReadWait(&file, HEAP_DVD, 1, num, NULL, FALSE, DVD_PRIO_WAIT);
         DVDClose(&file);
     }
     return data;
 }
 
+//For blocking directory reads, which are raised as soon as they are queued
+void *HuDvdDataFastReadNumAsync(s32 entrynum, s32 num, DataReadStat *stat)
+{
+    void *data = NULL;
+    if(!DVDFastOpen(entrynum, &stat->file_info)) {
+        OSPanic("dvd.c", 274, "dvd.c: File Open Error");
+    } else {
+        data = HuDvdDataReadWait(&stat->file_info, HEAP_DVD, 1, num, HuDataDirReadAsyncCallBack, TRUE, DVD_PRIO_WAIT);
+    }
+    return data;
+}
+
 void *HuDvdDataFastReadAsync(s32 entrynum, DataReadStat *stat)
 {
     DVDFileInfo file;
@@ -143,7 +445,21 @@ void *HuDvdDataFastReadAsync(s32 entrynum, DataReadStat *stat)
     if(!DVDFastOpen(entrynum, &stat->file_info)) {
         OSPanic("dvd.c", 274, "dvd.c: File Open Error");
     } else {
-        data = HuDvdDataReadWait(&stat->file_info, HEAP_DVD, 0, 0, HuDataDirReadAsyncCallBack, TRUE);
+        data = HuDvdDataReadWait(&stat->file_info, HEAP_DVD, 0, 0, HuDataDirReadAsyncCallBack, TRUE, DVD_PRIO_ASYNC);
+    }
+    return data;
+}
+
+//Returns NULL without reading when the heap is too full to spare the space
+void *HuDvdDataFastPrefetch(s32 entrynum, DataReadStat *stat)
+{
+    void *data = NULL;
+    if(!DVDFastOpen(entrynum, &stat->file_info)) {
+        OSPanic("dvd.c", 290, "dvd.c: File Open Error");
+    } else if(!HuDvdPrefetchSpaceChk(HEAP_DVD, OSRoundUp32B(stat->file_info.length))) {
+        DVDClose(&stat->file_info);
+    } else {
+        data = HuDvdDataReadWait(&stat->file_info, HEAP_DVD, 0, 0, HuDataDirReadAsyncCallBack, TRUE, DVD_PRIO_PREFETCH);
     }
     return data;
 }
@@ -2375,6 +2375,264 @@ static void ObjDraw(HsfDrawObject *arg0) {
     }
 }
 
+#define DL_CACHE_MAX 128
+#define DL_CACHE_REF_MAX 1024
+#define DL_CACHE_REF_HASH 256
+
+// Two independent digests of the mesh data and the number of values fed into them
+// They only pick the candidates, a list is shared once the values themselves match
+typedef struct dl_cache_key {
+    u32 hash;
+    u32 sum;
+    u32 len;
+} DLCacheKey;
+
+//Display lists built from identical mesh data, shared by every model that uses them
+typedef struct dl_cache {
+    DLCacheKey key;
+    u32 faceCnt;
+    s32 refCnt;
+    u32 flags;
+    u32 size;
+    u32 buildTick;
+    HsfDrawData *drawData;
+    void *dlBuf;
+    u32 *src;
+} DLCache;
+
+// Which list each mesh object took, kept apart from its constant data
+// so the reference can still be dropped after the model's memory is freed
+typedef struct dl_cache_ref {
+    HsfObject *obj;
+    DLCache *cache;
+    struct dl_cache_ref *next;
+} DLCacheRef;
+
+static DLCache DLCacheData[DL_CACHE_MAX];
+static DLCacheRef DLCacheRefData[DL_CACHE_REF_MAX];
+static DLCacheRef *DLCacheRefHash[DL_CACHE_REF_HASH];
+static s32 DLCacheRefNum;
+u32 Hu3DDLCacheHitCnt;
+u32 Hu3DDLCacheSaveSize;
+u32 Hu3DDLCacheSaveTick;
+
+#define DL_CACHE_HASH(hash, val) ((hash ^ (u32)(val)) * 0x01000193)
+#define DL_CACHE_SUM(sum, val) (((sum << 5) | (sum >> 27)) + (u32)(val) + 0x9E3779B9)
+#define DL_CACHE_REF_IDX(obj) ((((u32)(obj)) >> 4) & (DL_CACHE_REF_HASH-1))
+#define DL_CACHE_ADD(key, src, val) \
+    do { \
+        u32 _val = (u32)(val); \
+        (key)->hash = DL_CACHE_HASH((key)->hash, _val); \
+        (key)->sum = DL_CACHE_SUM((key)->sum, _val); \
+        if ((src) != NULL) { \
+            (src)[(key)->len] = _val; \
+        } \
+        (key)->len++; \
+    } while (0)
+
+// Hashes everything MDFaceCnt and MDFaceDraw read from the object, and stores the values in arg2 when given
+// Bump mapped meshes write into their vertex and material data, so they are never shared
+static BOOL DLCacheKeyMake(HsfObject *arg0, DLCacheKey *arg1, u32 *arg2) {
+    HsfFace *var_r31;
+    HsfMaterial *var_r30;
+    HsfMaterial *var_r29;
+    s16 *var_r27;
+    char *var_r26;
+    u32 var_r25;
+    u32 *var_r24;
+    s32 i;
+    s32 j;
+
+    arg1->hash = 0x811C9DC5;
+    arg1->sum = 0;
+    arg1->len = 0;
+    DL_CACHE_ADD(arg1, arg2, arg0->flags);
+    for (var_r26 = arg0->name; var_r26 != NULL && *var_r26 != 0; var_r26++) {
+        DL_CACHE_ADD(arg1, arg2, *var_r26);
+    }
+    var_r25 = FALSE;
+    var_r29 = NULL;
+    var_r31 = arg0->data.face->data;
+    for (i = 0; i < arg0->data.face->count; i++, var_r31++) {
+        var_r30 = &arg0->data.material[var_r31->mat & 0xFFF];
+        if (var_r30 != var_r29) {
+            var_r29 = var_r30;
+            for (j = 0; j < var_r30->numAttrs; j++) {
+                if (arg0->data.attribute[var_r30->attrs[j]].unk14 != 0.0) {
+                    return FALSE;
+                }
+            }
+            DL_CACHE_ADD(arg1, arg2, var_r30->numAttrs);
+            DL_CACHE_ADD(arg1, arg2, var_r30->vtxMode);
+            DL_CACHE_ADD(arg1, arg2, var_r30->pass);
+            DL_CACHE_ADD(arg1, arg2, var_r30->flags);
+            DL_CACHE_ADD(arg1, arg2, var_r30->invAlpha != 0.0);
+            DL_CACHE_ADD(arg1, arg2, var_r30->refAlpha != 0.0);
+            if (var_r30->vtxMode == 5) {
+                var_r25 = TRUE;
+            }
+        }
+        DL_CACHE_ADD(arg1, arg2, var_r31->type);
+        DL_CACHE_ADD(arg1, arg2, var_r31->mat);
+        var_r24 = (u32*) &var_r31->indices[0][0];
+        if ((var_r31->type & 7) == 4) {
+            // The strip's own pointer differs between models, only what it points at is hashed
+            for (j = 0; j < 6; j++) {
+                DL_CACHE_ADD(arg1, arg2, var_r24[j]);
+            }
+            DL_CACHE_ADD(arg1, arg2, var_r31->strip.count);
+            var_r27 = var_r31->strip.data;
+            for (j = 0; j < var_r31->strip.count * 4; j++) {
+                DL_CACHE_ADD(arg1, arg2, var_r27[j]);
+            }
+        } else {
+            for (j = 0; j < 8; j++) {
+                DL_CACHE_ADD(arg1, arg2, var_r24[j]);
+            }
+        }
+    }
+    // Vertex colors only decide the translucency flags
+    if (var_r25) {
+        for (i = 0; i < arg0->data.color->count; i++) {
+            DL_CACHE_ADD(arg1, arg2, ((GXColor*) arg0->data.color->data)[i].a == 0xFF);
+        }
+    }
+    return TRUE;
+}
+
+// The values of arg2 are only gathered once a list with the same digests turns up
+static DLCache *DLCacheSearch(DLCacheKey *arg0, u32 arg1, HsfObject *arg2) {
+    DLCache *var_r31;
+    DLCacheKey sp8;
+    u32 *var_r30;
+    s32 i;
+
+    var_r30 = NULL;
+    var_r31 = DLCacheData;
+    for (i = 0; i < DL_CACHE_MAX; i++, var_r31++) {
+        if (var_r31->refCnt != 0 && var_r31->key.hash == arg0->hash && var_r31->key.sum == arg0->sum
+            && var_r31->key.len == arg0->len && var_r31->faceCnt == arg1) {
+            if (var_r30 == NULL) {
+                var_r30 = HuMemDirectMalloc(HEAP_DATA, arg0->len * sizeof(u32));
+                if (var_r30 == NULL) {
+                    return NULL;
+                }
+                DLCacheKeyMake(arg2, &sp8, var_r30);
+            }
+            if (memcmp(var_r31->src, var_r30, arg0->len * sizeof(u32)) == 0) {
+                break;
+            }
+        }
+    }
+    if (var_r30 != NULL) {
+        HuMemDirectFree(var_r30);
+    }
+    return (i < DL_CACHE_MAX) ? var_r31 : NULL;
+}
+
+static DLCache *DLCacheAlloc(void) {
+    DLCache *var_r31;
+    s32 i;
+
+    var_r31 = DLCacheData;
+    for (i = 0; i < DL_CACHE_MAX; i++, var_r31++) {
+        if (var_r31->refCnt == 0) {
+            return var_r31;
+        }
+    }
+    return NULL;
+}
+
+static BOOL DLCacheRefAdd(HsfObject *arg0, DLCache *arg1) {
+    DLCacheRef *var_r31;
+    s32 i;
+
+    if (DLCacheRefNum >= DL_CACHE_REF_MAX) {
+        return FALSE;
+    }
+    var_r31 = DLCacheRefData;
+    for (i = 0; i < DL_CACHE_REF_MAX; i++, var_r31++) {
+        if (var_r31->obj == NULL) {
+            break;
+        }
+    }
+    var_r31->obj = arg0;
+    var_r31->cache = arg1;
+    var_r31->next = DLCacheRefHash[DL_CACHE_REF_IDX(arg0)];
+    DLCacheRefHash[DL_CACHE_REF_IDX(arg0)] = var_r31;
+    DLCacheRefNum++;
+    return TRUE;
+}
+
+// Drops the list arg0 took, freeing it once no other object uses it
+static void DLCacheRefDel(HsfObject *arg0) {
+    DLCacheRef **var_r30;
+    DLCacheRef *var_r31;
+
+    for (var_r30 = &DLCacheRefHash[DL_CACHE_REF_IDX(arg0)]; *var_r30 != NULL; var_r30 = &(*var_r30)->next) {
+        var_r31 = *var_r30;
+        if (var_r31->obj == arg0) {
+            *var_r30 = var_r31->next;
+            if (--var_r31->cache->refCnt == 0) {
+                HuMemDirectFree(var_r31->cache->dlBuf);
+            }
+            var_r31->obj = NULL;
+            DLCacheRefNum--;
+            return;
+        }
+    }
+}
+
+// Drops the display lists a model took from the cache, called before its memory is freed
+void Hu3DDLCacheRelease(HsfData *arg0) {
+    HsfObject *var_r30;
+    s32 i;
+
+    var_r30 = arg0->object;
+    for (i = 0; i < arg0->objectCnt; i++, var_r30++) {
+        if (var_r30->type == 2) {
+            DLCacheRefDel(var_r30);
+        }
+    }
+}
+
+void Hu3DDLCacheClear(void) {
+    DLCache *var_r31;
+    s32 i;
+
+    var_r31 = DLCacheData;
+    for (i = 0; i < DL_CACHE_MAX; i++, var_r31++) {
+        if (var_r31->refCnt != 0) {
+            HuMemDirectFree(var_r31->dlBuf);
+            var_r31->refCnt = 0;
+        }
+    }
+    for (i = 0; i < DL_CACHE_REF_MAX; i++) {
+        DLCacheRefData[i].obj = NULL;
+    }
+    for (i = 0; i < DL_CACHE_REF_HASH; i++) {
+        DLCacheRefHash[i] = NULL;
+    }
+    DLCacheRefNum = 0;
+}
+
+void Hu3DDLCacheDump(void) {
+    DLCache *var_r31;
+    s32 var_r30;
+    s32 var_r29;
+    s32 i;
+
+    var_r30 = var_r29 = 0;
+    var_r31 = DLCacheData;
+    for (i = 0; i < DL_CACHE_MAX; i++, var_r31++) {
+        if (var_r31->refCnt != 0) {
+            var_r30++;
+            var_r29 += var_r31->size;
+        }
+    }
+    OSReport("DLCache %d lists %x bytes, %d hits, %x bytes %dus saved\n", var_r30, var_r29, Hu3DDLCacheHitCnt, Hu3DDLCacheSaveSize, OSTicksToMicroseconds(Hu3DDLCacheSaveTick));
+}
+
 void MakeDisplayList(s16 arg0, u32 arg1) {
     HsfData *temp_r31;
     ModelData *var_r30;
@@ -2415,9 +2673,39 @@ static void MDObjCall(HsfData *arg0, HsfObject *arg1) {
 static void MDObjMesh(HsfData *arg0, HsfObject *arg1) {
     HsfBuffer *temp_r29;
     HsfFace *var_r28;
+    DLCache *var_r27;
+    u32 var_r26;
+    u32 temp_r25;
+    DLCacheKey sp8;
     s16 i;
 
     temp_r29 = arg1->data.face;
+    var_r27 = NULL;
+    // A model rebuilt after HuMemDirectFreeNum still holds the list it had
+    DLCacheRefDel(arg1);
+    var_r26 = DLCacheKeyMake(arg1, &sp8, NULL) && DLCacheRefNum < DL_CACHE_REF_MAX;
+    if (var_r26) {
+        var_r27 = DLCacheSearch(&sp8, temp_r29->count, arg1);
+        if (var_r27 != NULL) {
+            Hu3DObjInfoP = ObjConstantMake(arg1, mallocNo);
+            Hu3DObjInfoP->flags = var_r27->flags;
+            Hu3DObjInfoP->drawData = var_r27->drawData;
+            Hu3DObjInfoP->dlBuf = var_r27->dlBuf;
+            if (arg1->flags & 4) {
+                Hu3DModelAttrSet(curModelID, HU3D_ATTR_SHADOW);
+            }
+            var_r27->refCnt++;
+            DLCacheRefAdd(arg1, var_r27);
+            Hu3DDLCacheHitCnt++;
+            Hu3DDLCacheSaveSize += var_r27->size;
+            Hu3DDLCacheSaveTick += var_r27->buildTick;
+            for (i = 0; i < arg1->data.childrenCount; i++) {
+                MDObjCall(arg0, arg1->data.children[i]);
+            }
+            return;
+        }
+    }
+    temp_r25 = OSGetTick();
     DLFirstF = 0;
     drawCnt = matChgCnt = triCnt = quadCnt = 0;
     faceNumBuf[0] = 0;
@@ -2430,9 +2718,23 @@ static void MDObjMesh(HsfData *arg0, HsfObject *arg1) {
     }
     DLTotalNum = (DLTotalNum + 0x40) & ~0x1F;
     Hu3DObjInfoP = ObjConstantMake(arg1, mallocNo);
-    Hu3DObjInfoP->drawData = DrawData = HuMemDirectMallocNum(HEAP_DATA, matChgCnt * sizeof(HsfDrawData), mallocNo);
+    if (var_r26) {
+        var_r27 = DLCacheAlloc();
+    }
+    // Shared lists live outside the model's memory group so they outlast the model that built them
+    if (var_r27 != NULL) {
+        DLBufP = DLBufStartP = HuMemDirectMallocNum(HEAP_DATA, DLTotalNum + matChgCnt * sizeof(HsfDrawData) + sp8.len * sizeof(u32), MEMORY_DEFAULT_NUM);
+        if (DLBufStartP == NULL) {
+            var_r27 = NULL;
+        }
+    }
+    if (var_r27 != NULL) {
+        Hu3DObjInfoP->drawData = DrawData = (HsfDrawData*) ((u8*) DLBufStartP + DLTotalNum);
+    } else {
+        Hu3DObjInfoP->drawData = DrawData = HuMemDirectMallocNum(HEAP_DATA, matChgCnt * sizeof(HsfDrawData), mallocNo);
+        DLBufP = DLBufStartP = HuMemDirectMallocNum(HEAP_DATA, DLTotalNum, mallocNo);
+    }
     memset(DrawData, 0, matChgCnt * sizeof(HsfDrawData));
-    DLBufP = DLBufStartP = HuMemDirectMallocNum(HEAP_DATA, DLTotalNum, mallocNo);
     DCInvalidateRange(DLBufStartP, DLTotalNum);
     DLFirstF = 0;
     materialBak = (HsfMaterial*) -1;
@@ -2460,6 +2762,19 @@ static void MDObjMesh(HsfData *arg0, HsfObject *arg1) {
         OSReport("DLBuf Over >>>>>>>>>>>>>");
         OSReport("%x:%x:%x\n", Hu3DObjInfoP->dlBuf, totalSize, DLTotalNum);
     }
+    if (var_r27 != NULL) {
+        var_r27->key = sp8;
+        var_r27->faceCnt = temp_r29->count;
+        var_r27->refCnt = 1;
+        var_r27->flags = Hu3DObjInfoP->flags;
+        var_r27->size = DLTotalNum + matChgCnt * sizeof(HsfDrawData);
+        var_r27->drawData = DrawData;
+        var_r27->dlBuf = DLBufStartP;
+        var_r27->src = (u32*) (DrawData + matChgCnt);
+        DLCacheKeyMake(arg1, &sp8, var_r27->src);
+        var_r27->buildTick = OSGetTick() - temp_r25;
+        DLCacheRefAdd(arg1, var_r27);
+    }
     for (i = 0; i < arg1->data.childrenCount; i++) {
         MDObjCall(arg0, arg1->data.children[i]);
     }
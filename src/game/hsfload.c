@@ -1,4 +1,7 @@
 #include "game/hsfload.h"
+#include "game/EnvelopeExec.h"
+#include "game/ShapeExec.h"
+#include "game/memory.h"
 #include "string.h"
 #include "ctype.h"
 
@@ -46,6 +49,7 @@ static void MotionLoad(void);
 static void MatrixLoad(void);
 
 static s32 SearchObjectSetName(HsfData *data, char *name);
+static void NameIndexBuild(HsfData *data);
 static HsfBuffer *SearchVertexPtr(s32 id);
 static HsfBuffer *SearchNormalPtr(s32 id);
 static HsfBuffer *SearchStPtr(s32 id);
@@ -85,7 +89,9 @@ HsfData *LoadHSF(void *data)
     MotionLoad();
     MatrixLoad();
     hsf = SetHsfModel();
+    NameIndexBuild(hsf);
     InitEnvelope(hsf);
+    InitShape(hsf);
     objtop = NULL;
     return hsf;
     
@@ -166,6 +172,10 @@ static HsfData *SetHsfModel(void)
     data->shapeCnt = Model.shapeCnt;
     data->mapAttr = Model.mapAttr;
     data->mapAttrCnt = Model.mapAttrCnt;
+    data->jointOrder = NULL;
+    data->jointOrderCnt = 0;
+    data->skin = NULL;
+    data->morph = NULL;
     return data;
 }
 
@@ -1412,17 +1422,211 @@ static void MatrixLoad(void)
 
 static s32 SearchObjectSetName(HsfData *data, char *name)
 {
-    HsfObject *object = data->object;
+    s32 i = SearchObjectName(data, name);
+    if(i < 0) {
+        OSReport("Search Object Error %s\n", name);
+    }
+    return i;
+}
+
+static inline u32 NameHash(char *name)
+{
+    u32 hash = 0;
+    while(*name) {
+        hash = (hash*31)+(u8)*name++;
+    }
+    return hash;
+}
+
+static inline s32 NameHashNum(s32 count)
+{
+    s32 num = 4;
+    while(num < count*2) {
+        num <<= 1;
+    }
+    return num;
+}
+
+//Each hash slot holds the first of a chain of same named entries, linked in file order through next
+static void NameHashSet(s16 *hash, s16 *next, s32 hash_num, s32 index, char *name, char *(*get_name)(HsfData *, s32), HsfData *data)
+{
+    u32 slot = NameHash(name) & (hash_num-1);
+    s32 i;
+    next[index] = -1;
+    while(hash[slot] != -1) {
+        if(!strcmp(get_name(data, hash[slot]), name)) {
+            for(i=hash[slot]; next[i] != -1; i=next[i]);
+            next[i] = index;
+            return;
+        }
+        slot = (slot+1) & (hash_num-1);
+    }
+    hash[slot] = index;
+}
+
+static s32 NameHashGet(s16 *hash, s32 hash_num, char *name, char *(*get_name)(HsfData *, s32), HsfData *data)
+{
+    u32 slot = NameHash(name) & (hash_num-1);
+    while(hash[slot] != -1) {
+        if(!strcmp(get_name(data, hash[slot]), name)) {
+            return hash[slot];
+        }
+        slot = (slot+1) & (hash_num-1);
+    }
+    return -1;
+}
+
+static char *ObjectNameGet(HsfData *data, s32 index)
+{
+    return data->object[index].name;
+}
+
+static char *SkeletonNameGet(HsfData *data, s32 index)
+{
+    return data->skeleton[index].name;
+}
+
+static void NameIndexBuild(HsfData *data)
+{
+    HsfNameIndex *index;
+    s32 object_hash_num = NameHashNum(data->objectCnt);
+    s32 skeleton_hash_num = NameHashNum(data->skeletonCnt);
+    s32 i, j;
+    data->nameIndex = NULL;
+    if(data->objectCnt == 0 && data->skeletonCnt == 0) {
+        return;
+    }
+    index = HuMemDirectMallocNum(HEAP_DATA, sizeof(HsfNameIndex)
+        +(object_hash_num+data->objectCnt+skeleton_hash_num+data->skeletonCnt+data->objectCnt)*sizeof(s16), MEMORY_DEFAULT_NUM);
+    if(!index) {
+        return;
+    }
+    index->objectHashNum = object_hash_num;
+    index->skeletonHashNum = skeleton_hash_num;
+    index->objectHash = (s16 *)(index+1);
+    index->objectNext = index->objectHash+object_hash_num;
+    index->skeletonHash = index->objectNext+data->objectCnt;
+    index->skeletonNext = index->skeletonHash+skeleton_hash_num;
+    index->objectSkeleton = index->skeletonNext+data->skeletonCnt;
+    memset(index->objectHash, 0xFF, object_hash_num*sizeof(s16));
+    memset(index->skeletonHash, 0xFF, skeleton_hash_num*sizeof(s16));
+    for(i=0; i<data->objectCnt; i++) {
+        NameHashSet(index->objectHash, index->objectNext, object_hash_num, i, data->object[i].name, ObjectNameGet, data);
+    }
+    for(i=0; i<data->skeletonCnt; i++) {
+        NameHashSet(index->skeletonHash, index->skeletonNext, skeleton_hash_num, i, data->skeleton[i].name, SkeletonNameGet, data);
+    }
+    //Envelope setup takes the last skeleton of the same name
+    for(i=0; i<data->objectCnt; i++) {
+        j = NameHashGet(index->skeletonHash, skeleton_hash_num, data->object[i].name, SkeletonNameGet, data);
+        if(j != -1) {
+            while(index->skeletonNext[j] != -1) {
+                j = index->skeletonNext[j];
+            }
+        }
+        index->objectSkeleton[i] = j;
+    }
+    data->nameIndex = index;
+}
+
+void KillHSF(HsfData *data)
+{
+    if(data->nameIndex) {
+        HuMemDirectFree(data->nameIndex);
+    }
+    if(data->jointOrder) {
+        HuMemDirectFree(data->jointOrder);
+    }
+    if(data->skin) {
+        HuMemDirectFree(data->skin);
+    }
+    if(data->morph) {
+        HuMemDirectFree(data->morph);
+    }
+    HuMemDirectFree(data);
+}
+
+s32 SearchObjectName(HsfData *data, char *name)
+{
+    HsfObject *object;
     s32 i;
+    if(data->nameIndex) {
+        return NameHashGet(data->nameIndex->objectHash, data->nameIndex->objectHashNum, name, ObjectNameGet, data);
+    }
+    object = data->object;
     for(i=0; i<data->objectCnt; i++, object++) {
         if(!CmpObjectName(object->name, name)) {
             return i;
         }
     }
-    OSReport("Search Object Error %s\n", name);
     return -1;
 }
 
+//Next object after index with the same name, or -1
+s32 SearchObjectNameNext(HsfData *data, s32 index)
+{
+    HsfObject *object;
+    s32 i;
+    if(data->nameIndex) {
+        return data->nameIndex->objectNext[index];
+    }
+    object = &data->object[index+1];
+    for(i=index+1; i<data->objectCnt; i++, object++) {
+        if(!CmpObjectName(object->name, data->object[index].name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+s32 SearchSkeletonName(HsfData *data, char *name)
+{
+    HsfSkeleton *skeleton;
+    s32 i;
+    if(data->nameIndex) {
+        return NameHashGet(data->nameIndex->skeletonHash, data->nameIndex->skeletonHashNum, name, SkeletonNameGet, data);
+    }
+    skeleton = data->skeleton;
+    for(i=0; i<data->skeletonCnt; i++, skeleton++) {
+        if(!strcmp(skeleton->name, name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+s32 SearchSkeletonNameNext(HsfData *data, s32 index)
+{
+    HsfSkeleton *skeleton;
+    s32 i;
+    if(data->nameIndex) {
+        return data->nameIndex->skeletonNext[index];
+    }
+    skeleton = &data->skeleton[index+1];
+    for(i=index+1; i<data->skeletonCnt; i++, skeleton++) {
+        if(!strcmp(skeleton->name, data->skeleton[index].name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+//Skeleton that envelope setup uses for an object, or -1
+s32 SearchObjectSkeleton(HsfData *data, s32 index)
+{
+    s32 i;
+    if(data->nameIndex) {
+        return data->nameIndex->objectSkeleton[index];
+    }
+    i = SearchSkeletonName(data, data->object[index].name);
+    if(i != -1) {
+        while((index = SearchSkeletonNameNext(data, i)) != -1) {
+            i = index;
+        }
+    }
+    return i;
+}
+
 static HsfBuffer *SearchVertexPtr(s32 id)
 {
     HsfBuffer *vertex; 
@@ -48,6 +48,16 @@ s16 Hu3DPauseF;
 u16 Hu3DCameraExistF;
 static u16 NoSyncF;
 s32 modelKillAllF;
+u32 Hu3DModelVisitCnt;
+u32 Hu3DModelVisitCnted;
+
+// Live models in slot order, once overall and once per layer
+// Unlinking leaves the model's own next link alone so a walk survives kills
+static s16 modelTop;
+static s16 modelNext[HU3D_MODEL_MAX];
+static s16 layerTop[8];
+static s16 layerNext[HU3D_MODEL_MAX];
+static u16 modelListGen;
 
 #include "refMapData0.inc"
 #include "refMapData1.inc"
@@ -61,6 +71,44 @@ s32 modelKillAllF;
 #include "hiliteData3.inc"
 #include "hiliteData4.inc"
 
+static void ModelListLink(s16 *top, s16 *next, s16 no) {
+    s16 *link;
+
+    for (link = top; *link != -1 && *link < no; link = &next[*link]);
+    next[no] = *link;
+    *link = no;
+    modelListGen++;
+}
+
+static void ModelListUnlink(s16 *top, s16 *next, s16 no) {
+    s16 *link;
+
+    for (link = top; *link != -1 && *link != no; link = &next[*link]);
+    if (*link == no) {
+        *link = next[no];
+    }
+    modelListGen++;
+}
+
+static void ModelListClear(void) {
+    s16 i;
+
+    modelTop = -1;
+    for (i = 0; i < 8; i++) {
+        layerTop[i] = -1;
+    }
+}
+
+static void ModelListAdd(s16 no) {
+    ModelListLink(&modelTop, modelNext, no);
+    ModelListLink(&layerTop[Hu3DData[no].layer], layerNext, no);
+}
+
+static void ModelListRemove(s16 no) {
+    ModelListUnlink(&modelTop, modelNext, no);
+    ModelListUnlink(&layerTop[Hu3DData[no].layer], layerNext, no);
+}
+
 void Hu3DInit(void) {
     ModelData* data;
     CameraData* camera;
@@ -82,6 +130,8 @@ void Hu3DInit(void) {
         layerNum[i] = 0;
         layerHook[i] = 0;
     }
+    ModelListClear();
+    Hu3DModelVisitCnt = Hu3DModelVisitCnted = 0;
     reflectAnim[0] = HuSprAnimRead(refMapData0);
     reflectAnim[1] = HuSprAnimRead(refMapData1);
     reflectAnim[2] = HuSprAnimRead(refMapData2);
@@ -114,8 +164,11 @@ void Hu3DPreProc(void) {
     s16 i;
     
     GXSetCopyClear(BGColor, 0xFFFFFF);
-    data = &Hu3DData[0];
-    for (i = 0; i < HU3D_MODEL_MAX; i++, data++) {
+    Hu3DModelVisitCnted = Hu3DModelVisitCnt;
+    Hu3DModelVisitCnt = 0;
+    for (i = modelTop; i != -1; i = modelNext[i]) {
+        data = &Hu3DData[i];
+        Hu3DModelVisitCnt++;
         if (data->hsfData != 0) {
             data->attr &= ~HU3D_ATTR_MOT_EXEC;
         }
@@ -129,22 +182,118 @@ void Hu3DPreProc(void) {
 
 #define HU3D_ATTR_CAMERA_UPDATE (HU3D_ATTR_CAMERA_MOTON|HU3D_ATTR_DISPOFF)
 
+static void ModelMotionProc(s16 arg0, s32 arg1) {
+    ModelData *data;
+    s32 envelopeF;
+
+    data = &Hu3DData[arg0];
+    if (data->unk_08 != -1) {
+        Hu3DMotionExec(arg0, data->unk_08, data->unk_64, 0);
+    }
+    if (data->unk_0C != -1) {
+        Hu3DSubMotionExec(arg0);
+    }
+    if (data->unk_0A != -1) {
+        Hu3DMotionExec(arg0, data->unk_0A, data->unk_74, 1);
+    }
+    if ((data->attr & HU3D_ATTR_CLUSTER_ON) != 0) {
+        ClusterMotionExec(data);
+    }
+    if (data->unk_0E != -1) {
+        if (data->unk_08 == -1) {
+            Hu3DMotionExec(arg0, data->unk_0E, data->unk_94, 0);
+        } else {
+            Hu3DMotionExec(arg0, data->unk_0E, data->unk_94, 1);
+        }
+    }
+    // Shadow-only models skip skinning only when it is both switched off and paused
+    if (arg1 != 0) {
+        envelopeF = (data->attr & (HU3D_ATTR_HOOKFUNC|HU3D_ATTR_ENVELOPE_OFF)) == 0 || (data->motion_attr & HU3D_MOTATTR_PAUSE) == 0;
+    } else {
+        envelopeF = (data->attr & (HU3D_ATTR_ENVELOPE_OFF|HU3D_ATTR_HOOKFUNC)) == 0 && (data->motion_attr & HU3D_MOTATTR_PAUSE) == 0;
+    }
+    if (envelopeF != 0) {
+        InitVtxParm(data->hsfData);
+        if (data->unk_0E != -1) {
+            ShapeProc(data->hsfData);
+        }
+        if ((data->attr & HU3D_ATTR_CLUSTER_ON) != 0) {
+            ClusterProc(data);
+        }
+        if (data->hsfData->cenvCnt != 0) {
+            EnvelopeProc(data->hsfData);
+        }
+    }
+    data->attr |= HU3D_ATTR_MOT_EXEC;
+}
+
+// Poses every model once before any camera is drawn, so the draw passes only read them
+// Visibility is judged against every active camera instead of the one being drawn
+static void ModelMotionExec(void) {
+    ModelData *data;
+    CameraData *camera;
+    u16 camBit;
+    s16 shadowF;
+    s16 i;
+
+    camBit = 0;
+    camera = Hu3DCamera;
+    for (i = 0; i < HU3D_CAM_MAX; i++, camera++) {
+        if (-1.0f != camera->fov) {
+            camBit |= 1 << i;
+        }
+    }
+    if (camBit == 0) {
+        return;
+    }
+    shadowF = (camBit & 1) != 0 && Hu3DShadowF != 0 && Hu3DShadowCamBit != 0;
+    for (i = modelTop; i != -1; i = modelNext[i]) {
+        data = &Hu3DData[i];
+        Hu3DModelVisitCnt++;
+        if (data->hsfData == 0) {
+            continue;
+        }
+        if ((data->attr & HU3D_ATTR_CAMERA) != 0) {
+            Hu3DCameraMotionExec(i);
+            continue;
+        }
+        if ((data->attr & HU3D_ATTR_CAMERA_UPDATE) == HU3D_ATTR_CAMERA_UPDATE && data->unk_08 != -1) {
+            Hu3DMotionExec(i, data->unk_08, data->unk_64, 0);
+        }
+        if ((data->attr & (HU3D_ATTR_DISPOFF|HU3D_ATTR_MOTION_OFF)) == 0 && (data->camera & camBit) != 0) {
+            if (((data->attr & HU3D_ATTR_MOT_EXEC) == 0 && (data->attr & HU3D_ATTR_MOT_SLOW) == 0) || ((data->attr & HU3D_ATTR_MOT_SLOW) != 0 && (data->unk_00 & 1) != 0)) {
+                data->motion_attr &= ~HU3D_MOTATTR;
+                ModelMotionProc(i, 0);
+            }
+            data->unk_00++;
+        } else if (shadowF != 0 && (data->attr & (HU3D_ATTR_SHADOW|HU3D_ATTR_DISPOFF|HU3D_ATTR_HOOK|HU3D_ATTR_MOTION_OFF)) == (HU3D_ATTR_SHADOW|HU3D_ATTR_MOTION_OFF)) {
+            ModelMotionProc(i, 1);
+        }
+    }
+    PPCSync();
+    GXInvalidateVtxCache();
+}
+
 void Hu3DExec(void) {
     GXColor unusedColor = {0, 0, 0, 0};
     CameraData* camera;
     ModelData* data;
     s16 temp_r22;
     s16 var_r23;
-    s16 var_r25;
     s16 var_r24;
     s16 j;
     s16 i;
+    s16 next;
+    u16 gen;
     void (* temp)(s16);
     Mtx sp40;
     Mtx sp10;
     ThreeDProjectionStruct* var_r26;
 
     HuPerfBegin(3);
+    HuPerfBegin(4);
+    ModelMotionExec();
+    HuPerfEnd(4);
     GXSetCurrentMtx(0U);
     camera = Hu3DCamera;
     shadowModelDrawF = 0;
@@ -191,79 +340,36 @@ void Hu3DExec(void) {
                     Hu3DDrawPreInit();
                     Hu3DCameraSet(Hu3DCameraNo, Hu3DCameraMtx);
                     PSMTXInvXpose(Hu3DCameraMtx, Hu3DCameraMtxXPose);
-                    data = Hu3DData;
-                    for (i = 0, var_r23 = i; i < HU3D_MODEL_MAX; i++, data++) {
-                        if (data->hsfData != 0) {
-                            if ((data->attr & HU3D_ATTR_CAMERA) != 0) {
-                                Hu3DCameraMotionExec(i);
-                            } else {
-                                if ((data->attr & HU3D_ATTR_CAMERA_UPDATE) == HU3D_ATTR_CAMERA_UPDATE && data->unk_08 != -1) {
-                                    Hu3DMotionExec(i, data->unk_08, data->unk_64, 0);
+                    for (i = layerTop[j], var_r23 = 0; i != -1; i = next) {
+                        next = layerNext[i];
+                        gen = modelListGen;
+                        data = &Hu3DData[i];
+                        Hu3DModelVisitCnt++;
+                        if (data->hsfData != 0 && (data->attr & HU3D_ATTR_CAMERA) == 0) {
+                            if ((data->attr & (HU3D_ATTR_DISPOFF|HU3D_ATTR_MOTION_OFF)) == 0 && (data->camera & temp_r22) != 0 && data->layer == j) {
+                                if (var_r24 != 0 && (data->attr & HU3D_ATTR_HOOKFUNC) != 0) {
+                                    GXWaitDrawDone();
+                                    var_r24 = 0;
                                 }
-                                if ((data->attr & (HU3D_ATTR_DISPOFF|HU3D_ATTR_MOTION_OFF)) == 0 && (data->camera & temp_r22) != 0 && data->layer == j) {
-                                    if (((data->attr & HU3D_ATTR_MOT_EXEC) == 0 && (data->attr & HU3D_ATTR_MOT_SLOW) == 0) || ((data->attr & HU3D_ATTR_MOT_SLOW) != 0 && (data->unk_00 & 1) != 0)) {
-                                        var_r25 = 0;
-                                        data->motion_attr &= ~HU3D_MOTATTR;
-                                        if (data->unk_08 != -1) {
-                                            Hu3DMotionExec(i, data->unk_08, data->unk_64, 0);
-                                        }
-                                        if (data->unk_0C != -1) {
-                                            Hu3DSubMotionExec(i);
-                                        }
-                                        if (data->unk_0A != -1) {
-                                            Hu3DMotionExec(i, data->unk_0A, data->unk_74, 1);
-                                        }
-                                        if ((data->attr & HU3D_ATTR_CLUSTER_ON) != 0) {
-                                            ClusterMotionExec(data);
-                                            var_r25 = 1;
-                                        }
-                                        if (data->unk_0E != -1) {
-                                            if (data->unk_08 == -1) {
-                                                Hu3DMotionExec(i, data->unk_0E, data->unk_94, 0);
-                                            } else {
-                                                Hu3DMotionExec(i, data->unk_0E, data->unk_94, 1);
-                                            }
-                                            var_r25 = 1;
-                                        }
-                                        if ((data->attr & (HU3D_ATTR_ENVELOPE_OFF|HU3D_ATTR_HOOKFUNC)) == 0 && (data->motion_attr & HU3D_MOTATTR_PAUSE) == 0) {
-                                            var_r25 = 1;
-                                            InitVtxParm(data->hsfData);
-                                            if (data->unk_0E != -1) {
-                                                ShapeProc(data->hsfData);
-                                            }
-                                            if ((data->attr & 0x400) != 0) {
-                                                ClusterProc(data);
-                                            }
-                                            if (data->hsfData->cenvCnt != 0) {
-                                                EnvelopeProc(data->hsfData);
-                                            }
-                                            PPCSync();
-                                        }
-                                        if (var_r25 != 0) {
-                                            GXInvalidateVtxCache();
-                                        }
-                                        data->attr |= 0x800;
-                                    }
-                                    if (var_r24 != 0 && (data->attr & HU3D_ATTR_HOOKFUNC) != 0) {
-                                        GXWaitDrawDone();
-                                        var_r24 = 0;
-                                    }
-                                    if ((data->attr & HU3D_ATTR_HOOK) == 0 && (0.0f != data->scale.x || 0.0f != data->scale.y || 0.0f != data->scale.z)) {
-                                        mtxRot(sp40, data->rot.x, data->rot.y, data->rot.z);
-                                        mtxScaleCat(sp40, data->scale.x, data->scale.y, data->scale.z);
-                                        mtxTransCat(sp40, data->pos.x, data->pos.y, data->pos.z);
-                                        PSMTXConcat(Hu3DCameraMtx, sp40, sp10);
-                                        PSMTXConcat(sp10, data->unk_F0, sp10);
-                                        Hu3DDraw(data, sp10, &data->scale);
-                                    }
-                                    data->unk_00++;
-                                    var_r23++;
-                                    if (var_r23 >= layerNum[j]) {
-                                        break;
-                                    }
+                                if ((data->attr & HU3D_ATTR_HOOK) == 0 && (0.0f != data->scale.x || 0.0f != data->scale.y || 0.0f != data->scale.z)) {
+                                    mtxRot(sp40, data->rot.x, data->rot.y, data->rot.z);
+                                    mtxScaleCat(sp40, data->scale.x, data->scale.y, data->scale.z);
+                                    mtxTransCat(sp40, data->pos.x, data->pos.y, data->pos.z);
+                                    PSMTXConcat(Hu3DCameraMtx, sp40, sp10);
+                                    PSMTXConcat(sp10, data->unk_F0, sp10);
+                                    Hu3DDraw(data, sp10, &data->scale);
+                                }
+                                var_r23++;
+                                if (var_r23 >= layerNum[j]) {
+                                    break;
                                 }
                             }
                         }
+                        //Draw hooks can kill, create or move models, which leaves next pointing into another layer or past new ones
+                        //The list is kept in model order, so the walk picks up after i in it as it is now
+                        if (gen != modelListGen) {
+                            for (next = layerTop[j]; next != -1 && next <= i; next = layerNext[next]);
+                        }
                     }
                     Hu3DDrawPost();
                 }
@@ -272,8 +378,9 @@ void Hu3DExec(void) {
     }
     HuSprDispInit();
     HuSprExec(0);
-    data = Hu3DData;
-    for (i = 0; i < HU3D_MODEL_MAX; i++, data++) {
+    for (i = modelTop; i != -1; i = modelNext[i]) {
+        data = &Hu3DData[i];
+        Hu3DModelVisitCnt++;
         if (data->hsfData != 0 && (data->unk_08 != -1 || (data->attr & HU3D_ATTR_CLUSTER_ON) != 0 || data->unk_0E != -1) && (Hu3DPauseF == 0 || (data->attr & HU3D_ATTR_NOPAUSE) != 0)) {
             Hu3DMotionNext(i);
         }
@@ -286,6 +393,7 @@ void Hu3DExec(void) {
 void Hu3DAllKill(void) {
     s16 i;
     Hu3DModelAllKill();
+    Hu3DDLCacheClear();
     Hu3DMotionAllKill();
     Hu3DCameraAllKill();
     Hu3DLightAllKill();
@@ -305,6 +413,7 @@ void Hu3DAllKill(void) {
         layerNum[i] = 0;
         layerHook[i] = NULL;
     }
+    ModelListClear();
     for(i=0; i<4; i++) {
         if(Hu3DProjection[i].unk_04) {
             Hu3DProjectionKill(i);
@@ -400,6 +509,7 @@ s16 Hu3DModelCreate(void *arg0) {
     var_r31->unk_00 = (u8) var_r30;
     PSMTXIdentity(var_r31->unk_F0);
     layerNum[0] += 1;
+    ModelListAdd(var_r30);
     HuMemDCFlush(HEAP_DATA);
     if ((var_r31->hsfData->sceneCnt != 0) && ((var_r31->hsfData->scene->start) || (var_r31->hsfData->scene->end))) {
         Hu3DFogSet(var_r31->hsfData->scene->start, var_r31->hsfData->scene->end, var_r31->hsfData->scene->color.r, var_r31->hsfData->scene->color.g, var_r31->hsfData->scene->color.b);
@@ -431,7 +541,7 @@ s16 Hu3DModelLink(s16 arg0) {
         return -1;
     }
     var_r31->unk_C8 = temp_r30->hsfData;
-    var_r31->hsfData = HuMemDirectMallocNum(HEAP_DATA, 0x80, var_r31->unk_4C);
+    var_r31->hsfData = HuMemDirectMallocNum(HEAP_DATA, sizeof(HsfData), var_r31->unk_4C);
     var_r31->unk_4C = (u32)var_r31->hsfData;
     *var_r31->hsfData = *temp_r30->hsfData;
     temp_r3_2 = Hu3DObjDuplicate(var_r31->hsfData, var_r31->unk_4C);
@@ -475,6 +585,7 @@ s16 Hu3DModelLink(s16 arg0) {
     var_r31->unk_01 = 0;
     PSMTXIdentity(var_r31->unk_F0);
     layerNum[0] += 1;
+    ModelListAdd(var_r28);
     return var_r28;
 }
 
@@ -523,6 +634,7 @@ s16 Hu3DHookFuncCreate(ModelHookFunc hook) {
     var_r31->unk_01 = 0;
     PSMTXIdentity(var_r31->unk_F0);
     layerNum[0] += 1;
+    ModelListAdd(var_r29);
     return var_r29;
 }
 
@@ -541,6 +653,7 @@ void Hu3DModelKill(s16 arg0) {
             Hu3DShadowCamBit -= 1;
         }
         layerNum[temp_r31->layer] -= 1;
+        ModelListRemove(arg0);
 
         if ((temp_r31->attr & HU3D_ATTR_HOOKFUNC) != 0) {
             HuMemDirectFreeNum(HEAP_DATA, temp_r31->unk_48);
@@ -558,6 +671,7 @@ void Hu3DModelKill(s16 arg0) {
             if (temp_r31->unk_08 != -1) {
                 Hu3DMotionKill(temp_r31->unk_08);
             }
+            Hu3DDLCacheRelease(temp_r31->hsfData);
             HuMemDirectFreeNum(HEAP_DATA, temp_r31->unk_48);
             temp_r31->hsfData = NULL;
             return;
@@ -593,6 +707,7 @@ void Hu3DModelKill(s16 arg0) {
         }
         if (temp_r31->unk_20 != -1 && Hu3DMotionKill(temp_r31->unk_20) == 0) {
             Hu3DMotion[temp_r31->unk_20].unk_02 = -1;
+            Hu3DDLCacheRelease(temp_r31->hsfData);
             HuMemDirectFreeNum(HEAP_DATA, temp_r31->unk_48);
             temp_r31->hsfData = NULL;
             if (modelKillAllF == 0) {
@@ -600,7 +715,8 @@ void Hu3DModelKill(s16 arg0) {
             }
             return;
         }
-        HuMemDirectFree(temp_r31->hsfData);
+        Hu3DDLCacheRelease(temp_r31->hsfData);
+        KillHSF(temp_r31->hsfData);
         HuMemDirectFreeNum(HEAP_DATA, temp_r31->unk_48);
         for (i = 0; i < temp_r31->unk_26; i++) {
             Hu3DGLightKill(temp_r31->unk_28[i]);
@@ -635,6 +751,7 @@ void Hu3DModelAllKill(void) {
         layerNum[i] = 0;
         layerHook[i] = NULL;
     }
+    ModelListClear();
     Hu3DParManAllKill();
     HuMemDCFlush(HEAP_DATA);
 }
@@ -744,33 +861,26 @@ void Hu3DModelLayerSet(s16 arg0, s16 arg1) {
 
     temp_r31 = &Hu3DData[arg0];
     layerNum[temp_r31->layer] -= 1;
+    ModelListUnlink(&layerTop[temp_r31->layer], layerNext, arg0);
     temp_r31->layer = arg1;
     layerNum[arg1] += 1;
+    if (temp_r31->hsfData != 0) {
+        ModelListLink(&layerTop[arg1], layerNext, arg0);
+    }
 }
 
 HsfObject* Hu3DModelObjPtrGet(s16 arg0, char *arg1) {
     char name[0x100];
-    s32 spC;
-    s16 sp8;
     HsfData* temp_r31;
-    s16 var_r30;
-    HsfObject* var_r29;
-    HsfObject* var_r28;
-    u32 var_r4;
+    s32 index;
 
     temp_r31 = Hu3DData[arg0].hsfData;
-    var_r29 = temp_r31->object;
     strcpy(&name, MakeObjectName(arg1));
-    
-    for (var_r30 = 0; var_r30 < temp_r31->objectCnt; var_r29++, var_r30++) {
-        var_r28 = var_r29;
-        if (strcmp(&name, var_r28->name) == 0) {
-            return var_r29;
-        }
-    }
-    if (var_r30 == temp_r31->objectCnt) {
-        OSReport("Error: OBJPtr Error!\n");
+    index = SearchObjectName(temp_r31, name);
+    if (index != -1) {
+        return &temp_r31->object[index];
     }
+    OSReport("Error: OBJPtr Error!\n");
     return NULL;
 }
 
@@ -926,17 +1036,15 @@ void Hu3DModelShadowMapObjSet(s16 arg0, char *arg1) {
     char name[0x100];
     HsfData* temp_r30;
     s16 i;
-    HsfObject* var_r28;
     HsfObject* copy;
     HsfConstData* temp_r27;
 
     temp_r30 = Hu3DData[arg0].hsfData;
-    var_r28 = temp_r30->object;
     strcpy(&name, MakeObjectName(arg1));
     
-    for (i = 0; i < temp_r30->objectCnt; i++, var_r28++) {
-        copy = var_r28;
-        if (copy->constData != 0x0 && strcmp(&name, copy->name) == 0) {
+    for (i = SearchObjectName(temp_r30, name); i != -1; i = SearchObjectNameNext(temp_r30, i)) {
+        copy = &temp_r30->object[i];
+        if (copy->constData != 0x0) {
             temp_r27 = copy->constData;
             temp_r27->flags |= 8;
             break;
@@ -960,23 +1068,19 @@ void Hu3DModelHookSet(s16 arg0, char *arg1, s16 arg2) {
     s16 i;
     HsfConstData *constData;
     HsfObject* copy;
-    HsfObject* var_r27;
 
     temp_r30 = Hu3DData[arg0].hsfData;
-    var_r27 = temp_r30->object;
     strcpy(&name, MakeObjectName(arg1));
     
-    for (i = 0; i < temp_r30->objectCnt; i++, var_r27++) {
-        copy = var_r27;
+    for (i = SearchObjectName(temp_r30, name); i != -1; i = SearchObjectNameNext(temp_r30, i)) {
+        copy = &temp_r30->object[i];
         if (copy->constData != 0) {
-            if (strcmp(&name, copy->name) == 0) {
-                constData = copy->constData;
-                constData->hook = arg2;
-                data = &Hu3DData[arg2];
-                data->attr |= HU3D_ATTR_HOOK;
-                (void)data;
-                return;
-            }
+            constData = copy->constData;
+            constData->hook = arg2;
+            data = &Hu3DData[arg2];
+            data->attr |= HU3D_ATTR_HOOK;
+            (void)data;
+            return;
         }
     }
     OSReport("Error: Not Found %s for HookSet\n", arg1);
@@ -1015,25 +1119,21 @@ void Hu3DModelHookObjReset(s16 arg0, char *arg1) {
     HsfObject* copy;
     HsfConstData* temp_r29;
     s16 i;
-    HsfObject* var_r26;
     s16 temp_r0;
 
     temp_r30 = Hu3DData[arg0].hsfData;
-    var_r26 = temp_r30->object;
     strcpy(&name, MakeObjectName(arg1));
     
-    for (i = 0; i < temp_r30->objectCnt; i++, var_r26++) {
-        copy = var_r26;
+    for (i = SearchObjectName(temp_r30, name); i != -1; i = SearchObjectNameNext(temp_r30, i)) {
+        copy = &temp_r30->object[i];
         if (copy->constData != 0) {
-            if (strcmp(&name, copy->name) == 0) {
-                temp_r29 = copy->constData;
-                temp_r0 = temp_r29->hook;
-                temp_r28 = &Hu3DData[temp_r0];
-                temp_r28->attr &= ~HU3D_ATTR_HOOK;
-                temp_r29->hook = -1;
-                (void)temp_r28;
-                return;
-            }
+            temp_r29 = copy->constData;
+            temp_r0 = temp_r29->hook;
+            temp_r28 = &Hu3DData[temp_r0];
+            temp_r28->attr &= ~HU3D_ATTR_HOOK;
+            temp_r29->hook = -1;
+            (void)temp_r28;
+            return;
         }
     }
     
@@ -1923,7 +2023,6 @@ void Hu3DShadowExec(void) {
     Mtx44 sp18;
     GXColor sp14 = {0, 0, 0, 0};
     s32 test;
-    s32 test2;
 
     Hu3DDrawPreInit();
     GXSetCopyClear(sp14, 0xFFFFFF);
@@ -1947,44 +2046,6 @@ void Hu3DShadowExec(void) {
     
     for (var_r30 = 0; var_r30 < HU3D_MODEL_MAX; var_r30++, var_r31++) {
         if (var_r31->hsfData != 0 && (var_r31->attr & HU3D_ATTR_SHADOW) != 0 && (var_r31->attr & HU3D_ATTR_DISPOFF) == 0 && (var_r31->attr & HU3D_ATTR_HOOK) == 0) {
-            if ((var_r31->attr & HU3D_ATTR_MOTION_OFF) != 0) {
-                test2 = 0;
-                if (var_r31->unk_08 != -1) {
-                    Hu3DMotionExec(var_r30, var_r31->unk_08, var_r31->unk_64, 0);
-                }
-                if (var_r31->unk_0C != -1) {
-                    Hu3DSubMotionExec(var_r30);
-                }
-                if (var_r31->unk_0A != -1) {
-                    Hu3DMotionExec(var_r30, var_r31->unk_0A, var_r31->unk_74, 1);
-                }
-                if ((var_r31->attr & HU3D_ATTR_CLUSTER_ON) != 0) {
-                    ClusterMotionExec(var_r31);
-                    test2 = 1;
-                }
-                if (var_r31->unk_0E != -1) {
-                    if (var_r31->unk_08 == -1) {
-                        Hu3DMotionExec(var_r30, var_r31->unk_0E, var_r31->unk_94, 0);
-                    } else {
-                        Hu3DMotionExec(var_r30, var_r31->unk_0E, var_r31->unk_94, 1);
-                    }
-                }
-                if ((var_r31->attr & (HU3D_ATTR_HOOKFUNC|HU3D_ATTR_ENVELOPE_OFF)) == 0 || (var_r31->motion_attr & HU3D_MOTATTR_PAUSE) == 0) {
-                    test2 = 1;
-                    InitVtxParm(var_r31->hsfData);
-                    if (var_r31->unk_0E != -1) {
-                        ShapeProc(var_r31->hsfData);
-                    }
-                    if ((var_r31->attr & HU3D_ATTR_CLUSTER_ON) != 0) {
-                        ClusterProc(var_r31);
-                    }
-                    if (var_r31->hsfData->cenvCnt != 0) {
-                        EnvelopeProc(var_r31->hsfData);
-                    }
-                    PPCSync();
-                }
-                var_r31->attr |= HU3D_ATTR_MOT_EXEC;
-            }
             mtxRot(sp58, var_r31->rot.x, var_r31->rot.y, var_r31->rot.z);
             PSMTXScale(spB8, var_r31->scale.x, var_r31->scale.y, var_r31->scale.z);
             PSMTXConcat(sp58, spB8, spB8);
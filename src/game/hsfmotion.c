@@ -14,6 +14,13 @@
 #define HU3D_MOTATTR_NOSHIFT_ALL (HU3D_MOTATTR_LOOP|HU3D_MOTATTR_PAUSE|HU3D_MOTATTR_REV)
 #define HU3D_MOTATTR_ALL (HU3D_MOTATTR_SHIFT_ALL|HU3D_MOTATTR_NOSHIFT_ALL)
 
+#define KEYFRAME_CACHE_MAX 1024
+
+typedef struct keyframe_cache {
+    void *keys;
+    s32 index;
+} KeyframeCache;
+
 static s32 SearchObjectIndex(HsfData *arg0, u32 arg1);
 static s32 SearchAttributeIndex(HsfData *arg0, u32 arg1);
 
@@ -21,6 +28,9 @@ MotionData Hu3DMotion[HU3D_MOTION_MAX];
 
 static HsfBitmap *bitMapPtr;
 
+// Last key index found per key array, hashed on the key data address
+static KeyframeCache keyframeCache[KEYFRAME_CACHE_MAX];
+
 void Hu3DMotionInit(void) {
     MotionData *var_r31;
     s16 i;
@@ -92,7 +102,7 @@ s32 Hu3DMotionKill(s16 arg0) {
         return 0;
     }
     if (temp_r31->unk_02 == -1) {
-        HuMemDirectFree(temp_r31->unk_04);
+        KillHSF(temp_r31->unk_04);
     } else {
         Hu3DData[temp_r31->unk_02].unk_20 = -1;
     }
@@ -1198,38 +1208,76 @@ float GetCurve(HsfTrack *arg0, float arg1) {
     return 0.0f;
 }
 
+// True when key i is the first key whose time is past arg4
+static inline BOOL KeyframeCheck(float *arg0, s32 arg1, s32 arg2, s32 i, float arg4, float arg5) {
+    if (i > 0 && !(arg0[(i - 1) * arg1] * arg5 <= arg4)) {
+        return FALSE;
+    }
+    if (i < arg2 && !(arg4 < arg0[i * arg1] * arg5)) {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Returns the first key whose time is past arg4, or arg2 if there is none
+// Playback moves forward a key at a time so the cached key and the one after it are tried first
+static s32 KeyframeSearch(float *arg0, s32 arg1, s32 arg2, float arg4, float arg5) {
+    KeyframeCache *var_r31;
+    s32 var_r30;
+    s32 var_r29;
+    s32 i;
+
+    var_r31 = &keyframeCache[((u32) arg0 >> 3) & (KEYFRAME_CACHE_MAX - 1)];
+    if (var_r31->keys == arg0 && var_r31->index <= arg2) {
+        i = var_r31->index;
+        if (KeyframeCheck(arg0, arg1, arg2, i, arg4, arg5)) {
+            return i;
+        }
+        if (i < arg2 && KeyframeCheck(arg0, arg1, arg2, i + 1, arg4, arg5)) {
+            var_r31->index = i + 1;
+            return i + 1;
+        }
+    }
+    var_r30 = 0;
+    var_r29 = arg2;
+    while (var_r30 < var_r29) {
+        i = (var_r30 + var_r29) >> 1;
+        if (arg4 < arg0[i * arg1] * arg5) {
+            var_r29 = i;
+        } else {
+            var_r30 = i + 1;
+        }
+    }
+    var_r31->keys = arg0;
+    var_r31->index = var_r30;
+    return var_r30;
+}
+
 float GetConstant(s32 arg0, float *arg1, float arg2) {
-    float *var_r31;
-    s16 i;
+    s32 i;
 
-    var_r31 = arg1;
     if (arg2 == 0.0f || arg0 == 1) {
         return arg1[1];
     }
-    for (i = 0; i < arg0; i++, var_r31 += 2) {
-        if (arg2 < var_r31[0]) {
-            return var_r31[-1];
-        }
-    }
-    return var_r31[-1];
+    i = KeyframeSearch(arg1, 2, arg0, arg2, 1.0f);
+    return arg1[i * 2 - 1];
 }
 
 float GetLinear(s32 arg0, float arg1[][2], float arg2) {
     float var_f31;
     float var_f30;
-    s16 temp_r30;
-    s16 var_r31;
+    s32 temp_r30;
+    s32 var_r31;
 
     if (arg2 == 0.0f || arg0 == 1) {
         return arg1[0][1];
     }
-    for (var_r31 = 0; var_r31 < arg0; var_r31++) {
-        if (arg2 < arg1[var_r31][0]) {
-            temp_r30 = var_r31 - 1;
-            var_f30 = arg1[var_r31][0] - arg1[temp_r30][0];
-            var_f31 = arg1[temp_r30][1] + (arg2 - arg1[temp_r30][0]) * ((arg1[var_r31][1] - arg1[temp_r30][1]) / var_f30);
-            return var_f31;
-        }
+    var_r31 = KeyframeSearch(arg1[0], 2, arg0, arg2, 1.0f);
+    if (var_r31 < arg0) {
+        temp_r30 = var_r31 - 1;
+        var_f30 = arg1[var_r31][0] - arg1[temp_r30][0];
+        var_f31 = arg1[temp_r30][1] + (arg2 - arg1[temp_r30][0]) * ((arg1[var_r31][1] - arg1[temp_r30][1]) / var_f30);
+        return var_f31;
     }
     return arg1[arg0 - 1][1];
 }
@@ -1244,35 +1292,14 @@ __declspec(weak) float GetBezier(s32 arg0, HsfTrack *arg1, float arg2) {
     float temp_f30;
     float temp_f31;
     float (*var_r31)[4];
-    float (*var_r29)[4];
     s32 i;
 
     var_r31 = arg1->data;
     if (arg2 == 0.0f || arg0 == 1) {
         return var_r31[0][1];
     }
-    i = -1;
-    if (arg1->start == 0 && arg2 < var_r31[0][0]) {
-        i = 0;
-    }
-    if (i == -1) {
-        var_r31 = (float(*)[4]) arg1->data + arg1->start;
-        var_r29 = var_r31 - 1;
-        for (i = arg1->start; i < arg0; i++, var_r31++) {
-            if (arg2 >= var_r29[0][0] && arg2 < var_r31[0][0]) {
-                break;
-            }
-            var_r29 = var_r31;
-        }
-        if (i >= arg0) {
-            var_r31 = arg1->data;
-            for (i = 0; i < arg0; i++, var_r31++) {
-                if (arg2 < var_r31[0][0]) {
-                    break;
-                }
-            }
-        }
-    }
+    i = KeyframeSearch(var_r31[0], 4, arg0, arg2, 1.0f);
+    var_r31 += i;
     arg1->start = i;
     if (i == arg0) {
         return var_r31[-1][1];
@@ -1293,17 +1320,13 @@ __declspec(weak) float GetBezier(s32 arg0, HsfTrack *arg1, float arg2) {
 }
 
 HsfBitmap *GetBitMap(s32 arg0, UnknownHsfMotionStruct01 *arg1, float arg2) {
-    s16 var_r31;
+    s32 i;
 
     if (arg2 == 0.0f || arg0 == 1) {
         return arg1->unk04;
     }
-    for (var_r31 = 0; var_r31 < arg0; var_r31++, arg1++) {
-        if (arg2 < arg1->unk00 * 60.0f) {
-            break;
-        }
-    }
-    return arg1[-1].unk04;
+    i = KeyframeSearch(&arg1->unk00, sizeof(UnknownHsfMotionStruct01) / sizeof(float), arg0, arg2, 60.0f);
+    return arg1[i - 1].unk04;
 }
 
 s16 Hu3DJointMotion(s16 arg0, void *arg1) {
@@ -1400,18 +1423,7 @@ void Hu3DMotionCalc(s16 arg0) {
 }
 
 static s32 SearchObjectIndex(HsfData *arg0, u32 arg1) {
-    s32 i;
-    char *temp_r28;
-    HsfObject *var_r30;
-
-    var_r30 = arg0->object;
-    temp_r28 = SetName(&arg1);
-    for (i = 0; i < arg0->objectCnt; i++, var_r30++) {
-        if (CmpObjectName(var_r30->name, temp_r28) == 0) {
-            return i;
-        }
-    }
-    return -1;
+    return SearchObjectName(arg0, SetName(&arg1));
 }
 
 static s32 SearchAttributeIndex(HsfData *arg0, u32 arg1) {
@@ -65,6 +65,7 @@ void main(void)
     HuPerfInit();
     HuPerfCreate("USR0", 0xFF, 0xFF, 0xFF, 0xFF);
     HuPerfCreate("USR1", 0, 0xFF, 0xFF, 0xFF);
+    HuPerfCreate("MOT", 0xFF, 0xFF, 0, 0xFF);
     WipeInit(RenderMode);
     
     for (i = 0; i < 4; i++) {
@@ -101,6 +102,7 @@ void main(void)
         HuPerfBegin(1);
         Hu3DExec();
         HuDvdErrorWatch();
+        omOvlPrefetchExec();
         WipeExecAlways();
         HuPerfEnd(0);
         pfDrawFonts();
@@ -4,6 +4,8 @@
 
 static u32 HeapSizeTbl[HEAP_MAX] = { 0x240000, 0x140000, 0xA80000, 0x580000, 0 };
 static void *HeapTbl[HEAP_MAX];
+//Heaps with many small allocations use the size class allocator
+static BOOL HeapBinTbl[HEAP_MAX] = { TRUE, FALSE, TRUE, FALSE, TRUE };
 
 void HuMemInitAll(void)
 {
@@ -16,7 +18,11 @@ void HuMemInitAll(void)
             OSReport("HuMem> Failed OSAlloc Size:%d\n", HeapSizeTbl[i]);
             return;
         }
-        HeapTbl[i] = HuMemInit(ptr, HeapSizeTbl[i]);
+        if(HeapBinTbl[i]) {
+            HeapTbl[i] = HuMemInitBin(ptr, HeapSizeTbl[i]);
+        } else {
+            HeapTbl[i] = HuMemInitStat(ptr, HeapSizeTbl[i]);
+        }
     }
     free_size = OSCheckHeap(currentHeapHandle);
     OSReport("HuMem> left memory space %dKB(%d)\n", free_size/1024, free_size);
@@ -25,7 +31,11 @@ void HuMemInitAll(void)
         OSReport("HuMem> Failed OSAlloc left space\n");
         return;
     }
-    HeapTbl[4] = HuMemInit(ptr, free_size);
+    if(HeapBinTbl[4]) {
+        HeapTbl[4] = HuMemInitBin(ptr, free_size);
+    } else {
+        HeapTbl[4] = HuMemInitStat(ptr, free_size);
+    }
     HeapSizeTbl[4] = free_size;
 }
 
@@ -34,6 +44,16 @@ void *HuMemInit(void *ptr, s32 size)
     return HuMemHeapInit(ptr, size);
 }
 
+void *HuMemInitBin(void *ptr, s32 size)
+{
+    return HuMemHeapInitBin(ptr, size);
+}
+
+void *HuMemInitStat(void *ptr, s32 size)
+{
+    return HuMemHeapInitStat(ptr, size);
+}
+
 void HuMemDCFlushAll()
 {
     HuMemDCFlush(2);
@@ -101,4 +121,47 @@ u32 HuMemHeapSizeGet(HeapID heap)
 void *HuMemHeapPtrGet(HeapID heap)
 {
     return HeapTbl[heap];
-}
\ No newline at end of file
+}
+
+HuMemStat *HuMemStatGet(HeapID heap)
+{
+    return HuMemHeapStatGet(HeapTbl[heap]);
+}
+
+void HuMemSnapshotGet(HuMemSnapshot *snap)
+{
+    s32 i;
+    for(i=0; i<HEAP_MAX; i++) {
+        HuMemHeapSnapshot(HeapTbl[i], &snap[i]);
+    }
+}
+
+void HuMemSnapshotDiff(HuMemSnapshot *prev, HuMemSnapshot *snap)
+{
+    s32 i;
+    s32 frag;
+    OSReport("HuMem>Heap Used----+Diff----+Peak----+FreeMax-+Frag+Alloc---+Fail\n");
+    for(i=0; i<HEAP_MAX; i++) {
+        if(snap[i].free_size) {
+            frag = ((snap[i].free_size-snap[i].free_max)*100)/snap[i].free_size;
+        } else {
+            frag = 0;
+        }
+        OSReport("HuMem>%4d %08x %8d %08x %08x %3d%% %8d %d\n", i, snap[i].used_size, snap[i].used_size-prev[i].used_size,
+            snap[i].peak_size, snap[i].free_max, frag, snap[i].alloc_count-prev[i].alloc_count,
+            snap[i].fail_count-prev[i].fail_count);
+    }
+}
+
+void HuMemPeakReset(void)
+{
+    s32 i;
+    for(i=0; i<HEAP_MAX; i++) {
+        HuMemHeapPeakReset(HeapTbl[i]);
+    }
+}
+
+void HuMemStatDump(HeapID heap)
+{
+    HuMemHeapStatDump(HeapTbl[heap]);
+}
@@ -1,21 +1,53 @@
 #include "game/memory.h"
 #include "dolphin/os.h"
 
-#define DATA_GET_BLOCK(ptr) ((struct memory_block *)(((char *)(ptr))-32))
-#define BLOCK_GET_DATA(block) (((char *)(block))+32)
+//Host builds have 8 byte pointers, which do not fit the console's 32 byte block header
+#ifdef TARGET_PC
+#define MEM_BLOCK_HEADER 64
+#else
+#define MEM_BLOCK_HEADER 32
+#endif
 
-#define MEM_ALLOC_SIZE(size) (((size)+63) & 0xFFFFFFE0)
+#define DATA_GET_BLOCK(ptr) ((struct memory_block *)(((char *)(ptr))-MEM_BLOCK_HEADER))
+#define BLOCK_GET_DATA(block) (((char *)(block))+MEM_BLOCK_HEADER)
+
+#define MEM_ALLOC_SIZE(size) (((size)+MEM_BLOCK_HEADER+31) & 0xFFFFFFE0)
+
+#define MEM_BIN_EXACT 32
+#define MEM_BIN_MAX 64
+#define MEM_HEAP_WORK_MAX HEAP_MAX
 
 struct memory_block {
     s32 size;
     u8 magic;
     u8 flag;
+    u8 heap;
     struct memory_block *prev;
     struct memory_block *next;
     u32 num;
     u32 retaddr;
+    struct memory_block *free_prev;
+    struct memory_block *free_next;
 };
 
+//Free blocks of a binned heap are kept in size class lists
+//Sizes up to 1KB get one class per 32 bytes, larger sizes one class per power of 2
+struct memory_bin {
+    u32 map[MEM_BIN_MAX/32];
+    struct memory_block *list[MEM_BIN_MAX];
+};
+
+//Heaps created with HuMemHeapInitBin or HuMemHeapInitStat
+//Their blocks store the index+1 of this table in heap, plain heaps store 0
+struct memory_heap {
+    BOOL bin_mode;
+    struct memory_bin bin;
+    HuMemStat stat;
+};
+
+static struct memory_heap HeapWork[MEM_HEAP_WORK_MAX];
+static s32 HeapWorkNum;
+
 static void *HuMemMemoryAlloc2(void *heap_ptr, s32 size, u32 num, u32 retaddr);
 
 void *HuMemHeapInit(void *ptr, s32 size)
@@ -24,6 +56,7 @@ void *HuMemHeapInit(void *ptr, s32 size)
     block->size = size;
     block->magic = 205;
     block->flag = 0;
+    block->heap = 0;
     block->prev = block;
     block->next = block;
     block->num = -256;
@@ -31,6 +64,255 @@ void *HuMemHeapInit(void *ptr, s32 size)
     return block;
 }
 
+static void HuMemStatClear(HuMemStat *stat)
+{
+    s32 i;
+    stat->used_size = stat->peak_size = 0;
+    stat->used_num = stat->peak_num = 0;
+    stat->alloc_count = stat->free_count = stat->fail_count = 0;
+    stat->other_num = stat->other_size = 0;
+    for(i=0; i<HUMEM_STAT_SIZE_MAX; i++) {
+        stat->size_hist[i] = 0;
+    }
+    for(i=0; i<HUMEM_STAT_CALL_MAX; i++) {
+        stat->call[i].retaddr = 0;
+        stat->call[i].num = 0;
+        stat->call[i].size = 0;
+    }
+}
+
+//Call sites are hashed by return address; entries stay in place once used
+static HuMemCallStat *HuMemStatCallGet(HuMemStat *stat, u32 retaddr)
+{
+    HuMemCallStat *call;
+    s32 idx = (retaddr >> 2) & (HUMEM_STAT_CALL_MAX-1);
+    s32 i;
+    for(i=0; i<HUMEM_STAT_CALL_MAX; i++) {
+        call = &stat->call[idx];
+        if(call->retaddr == retaddr) {
+            return call;
+        }
+        if(call->retaddr == 0) {
+            call->retaddr = retaddr;
+            return call;
+        }
+        idx = (idx+1) & (HUMEM_STAT_CALL_MAX-1);
+    }
+    return NULL;
+}
+
+static void HuMemStatAlloc(HuMemStat *stat, struct memory_block *block)
+{
+    HuMemCallStat *call;
+    u32 units = block->size >> 6;
+    s32 i;
+    for(i=0; units && i<HUMEM_STAT_SIZE_MAX-1; i++) {
+        units >>= 1;
+    }
+    stat->size_hist[i]++;
+    stat->alloc_count++;
+    stat->used_num++;
+    stat->used_size += block->size;
+    if(stat->used_size > stat->peak_size) {
+        stat->peak_size = stat->used_size;
+    }
+    if(stat->used_num > stat->peak_num) {
+        stat->peak_num = stat->used_num;
+    }
+    if(call = HuMemStatCallGet(stat, block->retaddr)) {
+        call->num++;
+        call->size += block->size;
+    } else {
+        stat->other_num++;
+        stat->other_size += block->size;
+    }
+}
+
+static void HuMemStatFree(HuMemStat *stat, struct memory_block *block)
+{
+    HuMemCallStat *call;
+    stat->free_count++;
+    stat->used_num--;
+    stat->used_size -= block->size;
+    if(call = HuMemStatCallGet(stat, block->retaddr)) {
+        call->num--;
+        call->size -= block->size;
+    } else {
+        stat->other_num--;
+        stat->other_size -= block->size;
+    }
+}
+
+static inline s32 HuMemBinIndex(s32 size)
+{
+    u32 units = size >> 5;
+    s32 idx;
+    if(units <= MEM_BIN_EXACT) {
+        return units-1;
+    }
+    for(idx=MEM_BIN_EXACT; units >> 6; idx++) {
+        units >>= 1;
+    }
+    return idx;
+}
+
+static void HuMemBinInsert(struct memory_bin *bin, struct memory_block *block)
+{
+    s32 idx = HuMemBinIndex(block->size);
+    block->free_prev = NULL;
+    block->free_next = bin->list[idx];
+    if(bin->list[idx]) {
+        bin->list[idx]->free_prev = block;
+    }
+    bin->list[idx] = block;
+    bin->map[idx >> 5] |= 1 << (idx & 0x1F);
+}
+
+static void HuMemBinRemove(struct memory_bin *bin, struct memory_block *block)
+{
+    s32 idx;
+    if(block->free_next) {
+        block->free_next->free_prev = block->free_prev;
+    }
+    if(block->free_prev) {
+        block->free_prev->free_next = block->free_next;
+    } else {
+        idx = HuMemBinIndex(block->size);
+        bin->list[idx] = block->free_next;
+        if(!block->free_next) {
+            bin->map[idx >> 5] &= ~(1 << (idx & 0x1F));
+        }
+    }
+}
+
+static struct memory_block *HuMemBinFind(struct memory_bin *bin, s32 alloc_size)
+{
+    struct memory_block *block;
+    u32 map;
+    s32 idx = HuMemBinIndex(alloc_size);
+    s32 i;
+    if(idx >= MEM_BIN_EXACT) {
+        for(block = bin->list[idx]; block; block = block->free_next) {
+            if(block->size >= alloc_size) {
+                return block;
+            }
+        }
+        idx++;
+    } else if(bin->list[idx]) {
+        return bin->list[idx];
+    } else {
+        idx++;
+    }
+    for(i=idx >> 5; i<MEM_BIN_MAX/32; i++) {
+        map = bin->map[i];
+        if(i == idx >> 5) {
+            map &= ~0U << (idx & 0x1F);
+        }
+        if(map) {
+            for(idx=i*32; !(map & 0x1); idx++) {
+                map >>= 1;
+            }
+            return bin->list[idx];
+        }
+    }
+    return NULL;
+}
+
+static void *HuMemHeapWorkInit(void *ptr, s32 size, BOOL bin_mode)
+{
+    struct memory_block *block;
+    struct memory_heap *heap;
+    s32 i;
+    block = HuMemHeapInit(ptr, size);
+    if(HeapWorkNum >= MEM_HEAP_WORK_MAX) {
+        OSReport("HuMem>heap work max error %08x\n", ptr);
+        return block;
+    }
+    heap = &HeapWork[HeapWorkNum++];
+    heap->bin_mode = bin_mode;
+    for(i=0; i<MEM_BIN_MAX/32; i++) {
+        heap->bin.map[i] = 0;
+    }
+    for(i=0; i<MEM_BIN_MAX; i++) {
+        heap->bin.list[i] = NULL;
+    }
+    HuMemStatClear(&heap->stat);
+    block->heap = HeapWorkNum;
+    if(bin_mode) {
+        HuMemBinInsert(&heap->bin, block);
+    }
+    return block;
+}
+
+void *HuMemHeapInitBin(void *ptr, s32 size)
+{
+    return HuMemHeapWorkInit(ptr, size, TRUE);
+}
+
+void *HuMemHeapInitStat(void *ptr, s32 size)
+{
+    return HuMemHeapWorkInit(ptr, size, FALSE);
+}
+
+static void *HuMemBinAlloc(void *heap_ptr, s32 size, u32 num, u32 retaddr)
+{
+    s32 alloc_size = MEM_ALLOC_SIZE(size);
+    struct memory_block *block = heap_ptr;
+    struct memory_bin *bin = &HeapWork[block->heap-1].bin;
+    block = HuMemBinFind(bin, alloc_size);
+    if(block) {
+        HuMemBinRemove(bin, block);
+        if(block->size-alloc_size > 32u) {
+            struct memory_block *new_block = (struct memory_block *)((u8 *)block+alloc_size);
+            new_block->size = block->size-alloc_size;
+            new_block->magic = 205;
+            new_block->flag = 0;
+            new_block->heap = block->heap;
+            new_block->retaddr = retaddr;
+            block->next->prev = new_block;
+            new_block->next = block->next;
+            block->next = new_block;
+            new_block->prev = block;
+            block->size = alloc_size;
+            HuMemBinInsert(bin, new_block);
+        }
+        block->flag = 1;
+        block->magic = 165;
+        block->num = num;
+        block->retaddr = retaddr;
+        HuMemStatAlloc(&HeapWork[block->heap-1].stat, block);
+        return BLOCK_GET_DATA(block);
+    }
+    HeapWork[((struct memory_block *)heap_ptr)->heap-1].stat.fail_count++;
+    OSReport("HuMem>memory alloc error %08x(%08X): Call %08x\n", size, num, retaddr);
+    HuMemHeapDump(heap_ptr, -1);
+    return NULL;
+}
+
+static void HuMemBinFree(struct memory_block *block, u32 retaddr)
+{
+    struct memory_bin *bin = &HeapWork[block->heap-1].bin;
+    if(block->prev < block && !block->prev->flag) {
+        HuMemBinRemove(bin, block->prev);
+        block->flag  = 0;
+        block->magic = 205;
+        block->next->prev = block->prev;
+        block->prev->next = block->next;
+        block->prev->size += block->size;
+        block = block->prev;
+    }
+    if(block->next > block && !block->next->flag) {
+        HuMemBinRemove(bin, block->next);
+        block->next->next->prev = block;
+        block->size += block->next->size;
+        block->next = block->next->next;
+    }
+    block->flag = 0;
+    block->magic = 205;
+    block->retaddr = retaddr;
+    HuMemBinInsert(bin, block);
+}
+
 void *HuMemMemoryAllocNum(void *heap_ptr, s32 size, u32 num, u32 retaddr)
 {
     return HuMemMemoryAlloc2(heap_ptr, size, num, retaddr);
@@ -45,6 +327,9 @@ static void *HuMemMemoryAlloc2(void *heap_ptr, s32 size, u32 num, u32 retaddr)
 {
     s32 alloc_size = MEM_ALLOC_SIZE(size);
     struct memory_block *block = heap_ptr;
+    if(block->heap && HeapWork[block->heap-1].bin_mode) {
+        return HuMemBinAlloc(heap_ptr, size, num, retaddr);
+    }
     do {
         if(!block->flag && block->size >= alloc_size) {
             if(block->size-alloc_size > 32u) {
@@ -52,6 +337,7 @@ static void *HuMemMemoryAlloc2(void *heap_ptr, s32 size, u32 num, u32 retaddr)
                 new_block->size = block->size-alloc_size;
                 new_block->magic = 205;
                 new_block->flag = 0;
+                new_block->heap = block->heap;
                 new_block->retaddr = retaddr;
                 block->next->prev = new_block;
                 new_block->next = block->next;
@@ -63,10 +349,16 @@ static void *HuMemMemoryAlloc2(void *heap_ptr, s32 size, u32 num, u32 retaddr)
             block->magic = 165;
             block->num = num;
             block->retaddr = retaddr;
+            if(block->heap) {
+                HuMemStatAlloc(&HeapWork[block->heap-1].stat, block);
+            }
             return BLOCK_GET_DATA(block);
         }
         block = block->next;
     } while(block != heap_ptr);
+    if(block->heap) {
+        HeapWork[block->heap-1].stat.fail_count++;
+    }
     OSReport("HuMem>memory alloc error %08x(%08X): Call %08x\n", size, num, retaddr);
     HuMemHeapDump(heap_ptr, -1);
     return NULL;
@@ -101,6 +393,13 @@ void HuMemMemoryFree(void *ptr, u32 retaddr)
         OSReport("HuMem>memory free error. %08x( call %08x)\n", ptr, retaddr);
         return;
     }
+    if(block->heap) {
+        HuMemStatFree(&HeapWork[block->heap-1].stat, block);
+        if(HeapWork[block->heap-1].bin_mode) {
+            HuMemBinFree(block, retaddr);
+            return;
+        }
+    }
     if(block->prev < block && !block->prev->flag) {
         block->flag  = 0;
         block->magic = 205;
@@ -196,8 +495,83 @@ s32 HuMemMemorySizeGet(void *ptr)
     }
     block = DATA_GET_BLOCK(ptr);
     if(block->flag == 1 && block->magic == 165) {
-        return block->size-32;
+        return block->size-MEM_BLOCK_HEADER;
     } else {
         return 0;
     }
 }
+
+HuMemStat *HuMemHeapStatGet(void *heap_ptr)
+{
+    struct memory_block *block = heap_ptr;
+    if(!block->heap) {
+        return NULL;
+    }
+    return &HeapWork[block->heap-1].stat;
+}
+
+void HuMemHeapSnapshot(void *heap_ptr, HuMemSnapshot *snap)
+{
+    struct memory_block *block = heap_ptr;
+    HuMemStat *stat = HuMemHeapStatGet(heap_ptr);
+    snap->free_size = snap->free_max = snap->free_num = 0;
+    do {
+        if(!block->flag) {
+            snap->free_size += block->size;
+            snap->free_num++;
+            if(block->size > snap->free_max) {
+                snap->free_max = block->size;
+            }
+        }
+        block = block->next;
+    } while(block != heap_ptr);
+    if(stat) {
+        snap->used_size = stat->used_size;
+        snap->peak_size = stat->peak_size;
+        snap->used_num = stat->used_num;
+        snap->peak_num = stat->peak_num;
+        snap->alloc_count = stat->alloc_count;
+        snap->free_count = stat->free_count;
+        snap->fail_count = stat->fail_count;
+    } else {
+        snap->used_size = snap->peak_size = HuMemUsedMemorySizeGet(heap_ptr);
+        snap->used_num = snap->peak_num = HuMemUsedMemoryBlockGet(heap_ptr);
+        snap->alloc_count = snap->free_count = snap->fail_count = 0;
+    }
+}
+
+void HuMemHeapPeakReset(void *heap_ptr)
+{
+    HuMemStat *stat = HuMemHeapStatGet(heap_ptr);
+    if(stat) {
+        stat->peak_size = stat->used_size;
+        stat->peak_num = stat->used_num;
+    }
+}
+
+void HuMemHeapStatDump(void *heap_ptr)
+{
+    HuMemStat *stat = HuMemHeapStatGet(heap_ptr);
+    s32 i;
+    if(!stat) {
+        return;
+    }
+    OSReport("======== HuMem heap stat %08x ========\n", heap_ptr);
+    OSReport("USED:%08x(%d) PEAK:%08x(%d) ALLOC:%d FREE:%d FAIL:%d\n", stat->used_size, stat->used_num,
+        stat->peak_size, stat->peak_num, stat->alloc_count, stat->free_count, stat->fail_count);
+    for(i=0; i<HUMEM_STAT_SIZE_MAX; i++) {
+        if(stat->size_hist[i]) {
+            OSReport("SIZE<%08x %d\n", 64 << i, stat->size_hist[i]);
+        }
+    }
+    OSReport("Call----+Num-----+Size----\n");
+    for(i=0; i<HUMEM_STAT_CALL_MAX; i++) {
+        if(stat->call[i].num) {
+            OSReport("%08x %08x %08x\n", stat->call[i].retaddr, stat->call[i].num, stat->call[i].size);
+        }
+    }
+    if(stat->other_num) {
+        OSReport("OTHER    %08x %08x\n", stat->other_num, stat->other_size);
+    }
+    OSReport("======== HuMem heap stat %08x end =====\n", heap_ptr);
+}
@@ -1,13 +1,56 @@
 #include "game/object.h"
 #include "game/dvd.h"
 #include "game/memory.h"
+#include "game/armem.h"
+#include "string.h"
+
+#define OM_DLL_PREFETCH_MAX 4
+#define OM_DLL_RESIDENT_MAX 8
+#define OM_DLL_RESIDENT_MRAM_SIZE 0x100000
+#define OM_DLL_RESIDENT_ARAM_SIZE 0x100000
+#define OM_DLL_RESIDENT_RESERVE_DIV 8
+
+#define OM_DLL_RESIDENT_MRAM 0
+#define OM_DLL_RESIDENT_ARAM 1
 
 typedef s32 (*DLLProlog)(void);
 typedef void (*DLLEpilog)(void);
 
+typedef struct om_dll_prefetch {
+	s16 overlay;
+	s16 req;
+} omDllPrefetch;
+
+//A module that has exited can stay linked in main memory, and a copy of its unlinked image can stay in ARAM
+typedef struct om_dll_resident {
+	s16 overlay;
+	u32 time;
+	omDllData *dll;
+	u32 mram_size;
+	u32 amemptr;
+	u32 amem_size;
+} omDllResident;
+
+typedef struct om_dll_stat {
+	u16 link_num;
+	u16 mram_num;
+	u16 aram_num;
+	u32 link_time;
+	u32 link_max;
+	u32 size;
+} omDllStat;
+
 omDllData *omDLLinfoTbl[OM_DLL_MAX];
 
 static FileListEntry *omDLLFileList;
+static omDllPrefetch omDLLPrefetchData[OM_DLL_PREFETCH_MAX];
+static omDllResident omDLLResidentData[OM_DLL_RESIDENT_MAX];
+static omDllStat omDLLStatData[OVL_COUNT];
+static u32 omDLLResidentTime;
+static u32 omDLLResidentMax[2] = { OM_DLL_RESIDENT_MRAM_SIZE, OM_DLL_RESIDENT_ARAM_SIZE };
+static u32 omDLLResidentSize[2];
+
+static BOOL omDLLResidentReclaim(void);
 
 void omDLLDBGOut(void)
 {
@@ -21,9 +64,347 @@ void omDLLInit(FileListEntry *ovl_list)
 	for(i=0; i<OM_DLL_MAX; i++) {
 		omDLLinfoTbl[i] = NULL;
 	}
+	for(i=0; i<OM_DLL_PREFETCH_MAX; i++) {
+		omDLLPrefetchData[i].overlay = -1;
+	}
+	for(i=0; i<OM_DLL_RESIDENT_MAX; i++) {
+		omDLLResidentData[i].overlay = -1;
+	}
+	for(i=0; i<OVL_COUNT; i++) {
+		memset(&omDLLStatData[i], 0, sizeof(omDllStat));
+	}
+	omDLLResidentSize[OM_DLL_RESIDENT_MRAM] = omDLLResidentSize[OM_DLL_RESIDENT_ARAM] = 0;
+	HuARReclaimSet(omDLLResidentReclaim);
 	omDLLFileList = ovl_list;
 }
 
+static omDllResident *omDLLResidentGet(s16 overlay)
+{
+	s32 i;
+	for(i=0; i<OM_DLL_RESIDENT_MAX; i++) {
+		if(omDLLResidentData[i].overlay == overlay) {
+			return &omDLLResidentData[i];
+		}
+	}
+	return NULL;
+}
+
+static void omDLLResidentRelease(omDllResident *resident, s32 type)
+{
+	omDllData *dll;
+	if(type == OM_DLL_RESIDENT_MRAM && resident->dll) {
+		dll = resident->dll;
+		OSReport("objdll>Release resident DLL:%s\n", dll->name);
+		if(OSUnlink(&dll->module->info) != TRUE) {
+			OSReport("objdll>+++++++++++++++++ DLL Unlink Failed\n");
+		}
+		HuMemDirectFree(dll->data);
+		HuMemDirectFree(dll->bss);
+		HuMemDirectFree(dll->module);
+		HuMemDirectFree(dll);
+		resident->dll = NULL;
+		omDLLResidentSize[OM_DLL_RESIDENT_MRAM] -= resident->mram_size;
+	}
+	if(type == OM_DLL_RESIDENT_ARAM && resident->amemptr) {
+		HuARFree(resident->amemptr);
+		resident->amemptr = 0;
+		omDLLResidentSize[OM_DLL_RESIDENT_ARAM] -= resident->amem_size;
+	}
+	if(!resident->dll && !resident->amemptr) {
+		resident->overlay = -1;
+	}
+}
+
+//Drops the least recently used module of the given kind
+//Returns FALSE when there is none left
+static BOOL omDLLResidentEvict(s32 type)
+{
+	s32 i;
+	omDllResident *resident = NULL;
+	for(i=0; i<OM_DLL_RESIDENT_MAX; i++) {
+		if(omDLLResidentData[i].overlay < 0) {
+			continue;
+		}
+		if(type == OM_DLL_RESIDENT_MRAM ? !omDLLResidentData[i].dll : !omDLLResidentData[i].amemptr) {
+			continue;
+		}
+		if(!resident || (s32)(omDLLResidentData[i].time-resident->time) < 0) {
+			resident = &omDLLResidentData[i];
+		}
+	}
+	if(!resident) {
+		return FALSE;
+	}
+	omDLLResidentRelease(resident, type);
+	return TRUE;
+}
+
+//Any other ARAM user that runs short takes the space of the stashed images first
+static BOOL omDLLResidentReclaim(void)
+{
+	return omDLLResidentEvict(OM_DLL_RESIDENT_ARAM);
+}
+
+static omDllResident *omDLLResidentEntry(s16 overlay)
+{
+	s32 i;
+	omDllResident *resident = omDLLResidentGet(overlay);
+	if(!resident) {
+		for(i=0; i<OM_DLL_RESIDENT_MAX; i++) {
+			if(omDLLResidentData[i].overlay < 0) {
+				break;
+			}
+			if(!resident || (s32)(omDLLResidentData[i].time-resident->time) < 0) {
+				resident = &omDLLResidentData[i];
+			}
+		}
+		if(i < OM_DLL_RESIDENT_MAX) {
+			resident = &omDLLResidentData[i];
+		} else {
+			omDLLResidentRelease(resident, OM_DLL_RESIDENT_MRAM);
+			omDLLResidentRelease(resident, OM_DLL_RESIDENT_ARAM);
+		}
+		resident->overlay = overlay;
+		resident->dll = NULL;
+		resident->amemptr = 0;
+	}
+	resident->time = omDLLResidentTime++;
+	return resident;
+}
+
+//Resident modules give way whenever the system heap runs short
+//The largest free block is what the next overlay's big allocations need, so that is what is kept
+static BOOL omDLLResidentReserve(void)
+{
+	HuMemSnapshot snap;
+	do {
+		HuMemHeapSnapshot(HuMemHeapPtrGet(HEAP_SYSTEM), &snap);
+		if(snap.free_max >= HuMemHeapSizeGet(HEAP_SYSTEM)/OM_DLL_RESIDENT_RESERVE_DIV) {
+			return TRUE;
+		}
+	} while(omDLLResidentEvict(OM_DLL_RESIDENT_MRAM));
+	return FALSE;
+}
+
+//Relocations in the data sections only stay valid if they point into the main program or the module itself
+static BOOL omDLLResidentChk(OSModuleHeader *module)
+{
+	OSImportInfo *imp = (OSImportInfo *)module->impOffset;
+	u32 i;
+	for(i=0; i<module->impSize/sizeof(OSImportInfo); i++) {
+		if(imp[i].id != 0 && imp[i].id != module->info.id) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+//Copies the linked contents of every data section to or from buf
+//With buf NULL only returns the size needed
+static u32 omDLLDataCopy(OSModuleHeader *module, u8 *buf, BOOL restore)
+{
+	OSSectionInfo *section = OSGetSectionInfo(module);
+	u32 i;
+	u32 size = 0;
+	for(i=0; i<module->info.numSections; i++) {
+		if(i == module->bssSection || section[i].offset == 0 || (section[i].offset & OS_SECTIONINFO_EXEC)) {
+			continue;
+		}
+		if(buf) {
+			if(restore) {
+				memcpy((void *)section[i].offset, &buf[size], section[i].size);
+			} else {
+				memcpy(&buf[size], (void *)section[i].offset, section[i].size);
+			}
+		}
+		size += section[i].size;
+	}
+	return size;
+}
+
+//Keeps an exiting module linked instead of freeing it
+static BOOL omDLLResidentAdd(omDllData *dll)
+{
+	omDllResident *resident;
+	u32 size;
+	if(!dll->data) {
+		return FALSE;
+	}
+	size = HuMemMemorySizeGet(dll->module)+HuMemMemorySizeGet(dll->bss)+HuMemMemorySizeGet(dll->data);
+	if(size > omDLLResidentMax[OM_DLL_RESIDENT_MRAM]) {
+		return FALSE;
+	}
+	while(omDLLResidentSize[OM_DLL_RESIDENT_MRAM]+size > omDLLResidentMax[OM_DLL_RESIDENT_MRAM]
+		&& omDLLResidentEvict(OM_DLL_RESIDENT_MRAM));
+	if(!omDLLResidentReserve()) {
+		return FALSE;
+	}
+	resident = omDLLResidentEntry(dll->overlay);
+	resident->dll = dll;
+	resident->mram_size = size;
+	omDLLResidentSize[OM_DLL_RESIDENT_MRAM] += size;
+	OSReport("objdll>Resident DLL:%s(%x)\n", dll->name, size);
+	return TRUE;
+}
+
+//Keeps the unlinked image in ARAM so a later link skips the disc
+static void omDLLResidentStash(s16 overlay, OSModuleHeader *module)
+{
+	omDllResident *resident;
+	ARDMARange range;
+	u32 size;
+	u32 amemptr;
+	size = OSRoundUp32B(HuMemMemorySizeGet(module));
+	if(size > omDLLResidentMax[OM_DLL_RESIDENT_ARAM]) {
+		return;
+	}
+	while(omDLLResidentSize[OM_DLL_RESIDENT_ARAM]+size > omDLLResidentMax[OM_DLL_RESIDENT_ARAM]
+		&& omDLLResidentEvict(OM_DLL_RESIDENT_ARAM));
+	amemptr = HuARMalloc(size);
+	if(!amemptr) {
+		return;
+	}
+	range.amemptr = amemptr;
+	range.ofs = 0;
+	range.mram = module;
+	range.size = size;
+	HuARFenceWait(HuARDMAWrite(&range, 1, ARQ_PRIORITY_HIGH));
+	resident = omDLLResidentEntry(overlay);
+	resident->amemptr = amemptr;
+	resident->amem_size = size;
+	omDLLResidentSize[OM_DLL_RESIDENT_ARAM] += size;
+}
+
+static OSModuleHeader *omDLLResidentRead(omDllResident *resident)
+{
+	ARDMARange range;
+	OSModuleHeader *module = HuMemDirectMalloc(HEAP_SYSTEM, resident->amem_size);
+	if(!module) {
+		return NULL;
+	}
+	range.amemptr = resident->amemptr;
+	range.ofs = 0;
+	range.mram = module;
+	range.size = resident->amem_size;
+	HuARFenceWait(HuARDMARead(&range, 1, ARQ_PRIORITY_HIGH));
+	resident->time = omDLLResidentTime++;
+	return module;
+}
+
+//Sizes of 0 turn the main memory or ARAM pool off
+void omDLLResidentSet(u32 mram_size, u32 aram_size)
+{
+	omDLLResidentMax[OM_DLL_RESIDENT_MRAM] = mram_size;
+	omDLLResidentMax[OM_DLL_RESIDENT_ARAM] = aram_size;
+	while(omDLLResidentSize[OM_DLL_RESIDENT_MRAM] > mram_size && omDLLResidentEvict(OM_DLL_RESIDENT_MRAM));
+	while(omDLLResidentSize[OM_DLL_RESIDENT_ARAM] > aram_size && omDLLResidentEvict(OM_DLL_RESIDENT_ARAM));
+}
+
+void omDLLResidentFlush(void)
+{
+	while(omDLLResidentEvict(OM_DLL_RESIDENT_MRAM));
+	while(omDLLResidentEvict(OM_DLL_RESIDENT_ARAM));
+}
+
+void omDLLStatDump(void)
+{
+	s32 i;
+	omDllStat *stat;
+	OSReport("DLL STAT ======================\n");
+	OSReport("Name                 Link  Res ARAM    Last(us)     Max(us)     Size\n");
+	for(i=0; i<OVL_COUNT; i++) {
+		stat = &omDLLStatData[i];
+		if(stat->link_num+stat->mram_num == 0) {
+			continue;
+		}
+		OSReport("%-20s %4d %4d %4d %11d %11d %8x\n", omDLLFileList[i].name, stat->link_num, stat->mram_num, stat->aram_num,
+			OSTicksToMicroseconds(stat->link_time), OSTicksToMicroseconds(stat->link_max), stat->size);
+	}
+	OSReport("Resident MRAM %x/%x ARAM %x/%x\n", omDLLResidentSize[OM_DLL_RESIDENT_MRAM], omDLLResidentMax[OM_DLL_RESIDENT_MRAM],
+		omDLLResidentSize[OM_DLL_RESIDENT_ARAM], omDLLResidentMax[OM_DLL_RESIDENT_ARAM]);
+	OSReport("================================\n");
+}
+
+//Starts reading a module in the background so omDLLLink finds it already loaded
+//It is read into HEAP_DVD while the current overlay still holds the system heap, and moved over when linked
+//Returns FALSE when there is no room for it yet
+BOOL omDLLPrefetch(s16 overlay)
+{
+	s32 i;
+	s32 entrynum;
+	omDllPrefetch *prefetch = NULL;
+	for(i=0; i<OM_DLL_PREFETCH_MAX; i++) {
+		if(omDLLPrefetchData[i].overlay == overlay) {
+			return TRUE;
+		}
+		if(omDLLPrefetchData[i].overlay < 0 && !prefetch) {
+			prefetch = &omDLLPrefetchData[i];
+		}
+	}
+	if(omDLLSearch(overlay) >= 0 || omDLLResidentGet(overlay)) {
+		return TRUE;
+	}
+	if(!prefetch) {
+		return FALSE;
+	}
+	entrynum = DVDConvertPathToEntrynum(omDLLFileList[overlay].name);
+	if(entrynum < 0) {
+		return TRUE;
+	}
+	prefetch->req = HuDvdReqFastRead(entrynum, HEAP_DVD, DVD_PRIO_PREFETCH, NULL);
+	if(prefetch->req < 0) {
+		return FALSE;
+	}
+	OSReport("objdll>Prefetch DLL:%s\n", omDLLFileList[overlay].name);
+	prefetch->overlay = overlay;
+	return TRUE;
+}
+
+//By now the previous overlay is gone, so the copy lands where a plain load would have put it
+static OSModuleHeader *omDLLPrefetchGet(s16 overlay)
+{
+	s32 i;
+	void *buf;
+	OSModuleHeader *module;
+	for(i=0; i<OM_DLL_PREFETCH_MAX; i++) {
+		if(omDLLPrefetchData[i].overlay == overlay) {
+			omDLLPrefetchData[i].overlay = -1;
+			HuDvdReqPrioSet(omDLLPrefetchData[i].req, DVD_PRIO_WAIT);
+			buf = HuDvdReqWait(omDLLPrefetchData[i].req);
+			if(!buf) {
+				return NULL;
+			}
+			module = HuMemDirectMalloc(HEAP_SYSTEM, HuMemMemorySizeGet(buf));
+			if(module) {
+				memcpy(module, buf, HuMemMemorySizeGet(buf));
+			}
+			HuDvdDataClose(buf);
+			return module;
+		}
+	}
+	return NULL;
+}
+
+//Frees the modules that were prefetched but never linked
+//Returns how many are still being read
+s32 omDLLPrefetchClose(void)
+{
+	s32 i;
+	s32 num = 0;
+	for(i=0; i<OM_DLL_PREFETCH_MAX; i++) {
+		if(omDLLPrefetchData[i].overlay < 0) {
+			continue;
+		}
+		if(!HuDvdReqCheck(omDLLPrefetchData[i].req)) {
+			num++;
+			continue;
+		}
+		HuDvdDataClose(HuDvdReqWait(omDLLPrefetchData[i].req));
+		omDLLPrefetchData[i].overlay = -1;
+	}
+	return num;
+}
+
 s32 omDLLStart(s16 overlay, s16 flag)
 {
 	s32 dllno;
@@ -90,16 +471,68 @@ void omDLLEnd(s16 dllno, s16 flag)
 omDllData *omDLLLink(omDllData **dll_ptr, s16 overlay, s16 flag)
 {
 	omDllData *dll;
+	omDllResident *resident;
+	omDllStat *stat = &omDLLStatData[overlay];
 	FileListEntry *dllFile = &omDLLFileList[overlay];
+	OSTick tick = OSGetTick();
 	OSReport("objdll>Link DLL:%s\n", dllFile->name);
-	dll = HuMemDirectMalloc(HEAP_SYSTEM, sizeof(omDllData));
-	*dll_ptr = dll;
-	dll->name = dllFile->name;
-	dll->module = HuDvdDataReadDirect(dllFile->name, HEAP_SYSTEM);
-	dll->bss = HuMemDirectMalloc(HEAP_SYSTEM, dll->module->bssSize);
-	if(OSLink(&dll->module->info, dll->bss) != TRUE) {
-		OSReport("objdll>++++++++++++++++ DLL Link Failed\n");
+	omOvlManifestDLLAdd(overlay);
+	resident = omDLLResidentGet(overlay);
+	if(resident && resident->dll) {
+		//Still linked, so only the data sections and bss go back to how they were
+		dll = resident->dll;
+		*dll_ptr = dll;
+		resident->dll = NULL;
+		resident->time = omDLLResidentTime++;
+		omDLLResidentSize[OM_DLL_RESIDENT_MRAM] -= resident->mram_size;
+		if(!resident->amemptr) {
+			resident->overlay = -1;
+		}
+		omDLLDataCopy(dll->module, dll->data, TRUE);
+		memset(dll->bss, 0, dll->module->bssSize);
+		HuMemDCFlushAll();
+		stat->mram_num++;
+	} else {
+		omDLLResidentReserve();
+		dll = HuMemDirectMalloc(HEAP_SYSTEM, sizeof(omDllData));
+		*dll_ptr = dll;
+		dll->name = dllFile->name;
+		dll->overlay = overlay;
+		dll->data = NULL;
+		dll->module = omDLLPrefetchGet(overlay);
+		if(!dll->module && resident && resident->amemptr) {
+			dll->module = omDLLResidentRead(resident);
+			if(dll->module) {
+				stat->aram_num++;
+			}
+		}
+		if(!dll->module) {
+			dll->module = HuDvdDataReadDirect(dllFile->name, HEAP_SYSTEM);
+		}
+		if(!resident || !resident->amemptr) {
+			omDLLResidentStash(overlay, dll->module);
+		}
+		dll->bss = HuMemDirectMalloc(HEAP_SYSTEM, dll->module->bssSize);
+		if(OSLink(&dll->module->info, dll->bss) != TRUE) {
+			OSReport("objdll>++++++++++++++++ DLL Link Failed\n");
+		}
+		if(omDLLResidentMax[OM_DLL_RESIDENT_MRAM] && omDLLResidentChk(dll->module)) {
+			dll->data = HuMemDirectMalloc(HEAP_SYSTEM, omDLLDataCopy(dll->module, NULL, FALSE));
+			if(dll->data) {
+				omDLLDataCopy(dll->module, dll->data, FALSE);
+			}
+		}
+		stat->link_num++;
+		stat->size = HuMemMemorySizeGet(dll->module)+HuMemMemorySizeGet(dll->bss);
+		if(dll->data) {
+			stat->size += HuMemMemorySizeGet(dll->data);
+		}
 	}
+	stat->link_time = OSGetTick()-tick;
+	if(stat->link_time > stat->link_max) {
+		stat->link_max = stat->link_time;
+	}
+	OSReport("objdll>Link time %s %dus\n", dllFile->name, OSTicksToMicroseconds(stat->link_time));
 	omDLLInfoDump(&dll->module->info);
 	omDLLHeaderDump(dll->module);
 	OSReport("objdll>LinkOK %08x %08x\n", dll->module, dll->bss);
@@ -119,9 +552,15 @@ void omDLLUnlink(omDllData *dll_ptr, s16 flag)
 		((DLLEpilog)dll_ptr->module->epilog)();
 		OSReport("objdll>Unlink DLL epilog finish\n");
 	}
+	if(flag == 1 && omDLLResidentAdd(dll_ptr)) {
+		return;
+	}
 	if(OSUnlink(&dll_ptr->module->info) != TRUE) {
 		OSReport("objdll>+++++++++++++++++ DLL Unlink Failed\n");
 	}
+	if(dll_ptr->data) {
+		HuMemDirectFree(dll_ptr->data);
+	}
 	HuMemDirectFree(dll_ptr->bss);
 	HuMemDirectFree(dll_ptr->module);
 	HuMemDirectFree(dll_ptr);
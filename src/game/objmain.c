@@ -1,16 +1,33 @@
+#include "game/armem.h"
 #include "game/audio.h"
 #include "game/chrman.h"
+#include "game/data.h"
 #include "game/esprite.h"
 #include "game/hsfdraw.h"
 #include "game/hsfman.h"
 #include "game/printfunc.h"
 #include "game/object.h"
 #include "game/pad.h"
+#include "game/perf.h"
 #include "game/flag.h"
+#include "game/wipe.h"
 
 #define OM_OVL_HIS_MAX 16
 #define OM_MAX_GROUPS 10
 
+#define OM_OVL_MANIFEST_MAX 32
+#define OM_OVL_MANIFEST_DLL_MAX 4
+#define OM_OVL_MANIFEST_FRAME 300
+#define OM_OVL_MANIFEST_DLL 0x8000
+#define OM_OVL_MANIFEST_ARAM 0x4000
+#define OM_OVL_MANIFEST_ID(entry) ((entry) & 0x3FFF)
+#define OM_OVL_MANIFEST_END 0xFFFF
+
+#define OM_OVL_PREFETCH_NONE 0
+#define OM_OVL_PREFETCH_READ 1
+#define OM_OVL_PREFETCH_DONE 2
+#define OM_OVL_PREFETCH_PREDICT 1
+
 typedef struct om_obj_group {
     u16 next_idx;
     u16 max_objs;
@@ -30,6 +47,19 @@ typedef struct om_obj_man {
     omObjGroup *group;
 } omObjMan;
 
+//What an overlay loaded in its first frames, and the overlay that followed it
+//next_cnt counts how many times in a row the same overlay followed
+//Manifests from the compiled table are only a first guess until rec is set by a real visit
+typedef struct om_ovl_manifest {
+    s16 next;
+    u8 next_cnt;
+    u8 num;
+    u8 rec;
+    u16 entry[OM_OVL_MANIFEST_MAX];
+} omOvlManifest;
+
+extern u32 GlobalCounter;
+
 omObjData *omDBGSysKeyObj;
 Process *omwatchproc;
 OverlayID omnextovl;
@@ -45,16 +75,47 @@ s16 omSysExitReq;
 s16 omdispinfo;
 
 static omOvlHisData omovlhis[OM_OVL_HIS_MAX];
+static HuMemSnapshot omOvlMemSnap[HEAP_MAX];
+static BOOL omOvlMemCheckF;
+
+//Each line is overlay, next overlay, entry count and the entries, as printed by omOvlManifestDump
+//tools/ovl_manifest.py seeds it from the directories each overlay's source refers to
+static u16 omOvlManifestData[] = {
+    #include "ovl_manifest_table.h"
+    OM_OVL_MANIFEST_END
+};
+
+static omOvlManifest omOvlManifestTbl[OVL_COUNT];
+static BOOL omOvlManifestRecF;
+static OverlayID omOvlManifestRecOvl = OVL_INVALID;
+static u32 omOvlManifestRecTime;
+static s16 omOvlManifestRecDir[OM_OVL_MANIFEST_MAX];
+static s16 omOvlManifestRecDLL[OM_OVL_MANIFEST_DLL_MAX];
+static s32 omOvlManifestRecDLLNum;
+static OverlayID omOvlPrefetchOvl = OVL_INVALID;
+static OverlayID omOvlPrefetchSrc = OVL_INVALID;
+static s32 omOvlPrefetchIdx;
+static u8 omOvlPrefetchStat[OM_OVL_MANIFEST_MAX];
+static BOOL omOvlPrefetchCloseF;
+static BOOL omOvlPrefetchWipeF;
+static u32 omOvlPrefetchFence;
+static OverlayID omOvlPrefetchFenceOvl = OVL_INVALID;
+static s32 omOvlPrefetchFenceIdx;
+static s32 omOvlPrefetchFenceDir;
 
 u8 omSysPauseEnableFlag = TRUE;
 OverlayID omprevovl = OVL_INVALID;
 
 static void omWatchOverlayProc(void);
 static void omInsertObj(Process *objman_process, omObjData *object);
+static void omOvlManifestInit(void);
+static void omOvlManifestStart(OverlayID overlay);
+static void omOvlManifestEnd(void);
 
 void omMasterInit(s32 prio, FileListEntry *ovl_list, s32 ovl_count, OverlayID start_ovl)
 {
     omDLLInit(ovl_list);
+    omOvlManifestInit();
     omwatchproc = HuPrcCreate(omWatchOverlayProc, prio, 8192, 0);
     HuPrcSetStat(omwatchproc, 12);
     omcurovl = OVL_INVALID;
@@ -70,12 +131,15 @@ static void omWatchOverlayProc(void)
         if(omcurovl == OVL_INVALID) {
             if(omnextovl >= 0 && fadeStat == 0) {
                 HuPrcSleep(0);
+                HuPrcPoolFlush();
+                HuARCompact();
                 OSReport("++++++++++++++++++++ Start New OVL %d (EVT:%d STAT:0x%08x) ++++++++++++++++++\n", omnextovl, omnextovlevtno, omnextovlstat);
                 HuMemHeapDump(HuMemHeapPtrGet(HEAP_SYSTEM), -1);
                 HuMemHeapDump(HuMemHeapPtrGet(HEAP_DATA), -1);
                 HuMemHeapDump(HuMemHeapPtrGet(HEAP_DVD), -1);
                 OSReport("objman>Used Memory Size:%08x\n", HuMemUsedMallocSizeGet(HEAP_SYSTEM));
                 OSReport("objman>Used Memory Cnt:%d\n", HuMemUsedMallocBlockGet(HEAP_SYSTEM));
+                omOvlManifestStart(omnextovl);
                 OSReport("objman>Init esp\n");
                 espInit();
                 OSReport("objman>Call objectsetup\n");
@@ -119,15 +183,45 @@ void omOvlCallEx(OverlayID overlay, s16 arg2, s32 event, s32 stat)
     omOvlGotoEx(overlay, arg2, event, stat);
 }
 
+//Reports each heap after the previous overlay has been freed, only while turned on with omOvlMemCheckSet
+//Used size that grows across transitions is memory the overlay leaked
+static void omOvlMemCheck(OverlayID overlay)
+{
+    HuMemSnapshot snap[HEAP_MAX];
+    s32 i;
+    if(!omOvlMemCheckF) {
+        return;
+    }
+    HuMemSnapshotGet(snap);
+    OSReport("objman>Ovl Memory %d->%d\n", omprevovl, overlay);
+    HuMemSnapshotDiff(omOvlMemSnap, snap);
+    for(i=0; i<HEAP_MAX; i++) {
+        omOvlMemSnap[i] = snap[i];
+    }
+    HuMemPeakReset();
+}
+
+//The first report after turning it on compares against the heaps as they are now
+void omOvlMemCheckSet(BOOL check)
+{
+    if(check && !omOvlMemCheckF) {
+        HuMemSnapshotGet(omOvlMemSnap);
+        HuMemPeakReset();
+    }
+    omOvlMemCheckF = check;
+}
+
 void omOvlGotoEx(OverlayID overlay, s16 arg2, s32 event, s32 stat)
 {
     omprevovl = omcurovl;
     if(omcurovl >= 0) {
         omOvlKill(arg2);
+        omOvlMemCheck(overlay);
     }
     omnextovl = overlay;
     omnextovlevtno = event;
     omnextovlstat = stat;
+    omOvlPrefetch(overlay);
 }
 
 void omOvlReturnEx(s16 level, s16 arg2)
@@ -143,12 +237,15 @@ void omOvlReturnEx(s16 level, s16 arg2)
 
 void omOvlKill(s16 arg)
 {
+    omOvlManifestEnd();
     CharModelKill(-1);
     MGSeqKillAll();
     Hu3DAllKill();
     HuWinAllKill();
     HuSprClose();
     HuPrcChildKill(omwatchproc);
+    //Loads the killed processes were sleeping on have to land before their buffers are freed
+    HuDvdReqWaitAll();
     HuMemDirectFreeNum(HEAP_SYSTEM, MEMORY_DEFAULT_NUM);
     HuDataDirCloseNum(MEMORY_DEFAULT_NUM);
     HuMemDirectFreeNum(HEAP_DVD, MEMORY_DEFAULT_NUM);
@@ -162,6 +259,251 @@ void omOvlKill(s16 arg)
     omDBGSysKeyObj = NULL;
 }
 
+static void omOvlManifestInit(void)
+{
+    omOvlManifest *manifest;
+    u16 *data;
+    s32 i;
+    for(i=0; i<OVL_COUNT; i++) {
+        omOvlManifestTbl[i].next = OVL_INVALID;
+        omOvlManifestTbl[i].next_cnt = 0;
+        omOvlManifestTbl[i].num = 0;
+        omOvlManifestTbl[i].rec = FALSE;
+    }
+    for(data=omOvlManifestData; *data != OM_OVL_MANIFEST_END; data += data[2]+3) {
+        if(data[0] >= OVL_COUNT || data[2] > OM_OVL_MANIFEST_MAX) {
+            OSReport("objman>Ovl Manifest Error(%d)\n", data[0]);
+            break;
+        }
+        manifest = &omOvlManifestTbl[data[0]];
+        manifest->next = (s16)data[1];
+        manifest->next_cnt = OM_OVL_PREFETCH_PREDICT;
+        manifest->num = data[2];
+        for(i=0; i<manifest->num; i++) {
+            manifest->entry[i] = data[i+3];
+        }
+    }
+}
+
+static void omOvlManifestPrint(OverlayID overlay)
+{
+    omOvlManifest *manifest = &omOvlManifestTbl[overlay];
+    s32 i;
+    OSReport("%d, 0x%04X, %d,", overlay, (u16)manifest->next, manifest->num);
+    for(i=0; i<manifest->num; i++) {
+        OSReport(" 0x%04X,", manifest->entry[i]);
+    }
+    OSReport("\n");
+}
+
+//Records the modules and directories an overlay loads in its first OM_OVL_MANIFEST_FRAME frames
+static void omOvlManifestStart(OverlayID overlay)
+{
+    omOvlManifest *prev;
+    if(omOvlPrefetchOvl != overlay) {
+        omOvlPrefetchStop();
+    }
+    if(omprevovl >= 0) {
+        prev = &omOvlManifestTbl[omprevovl];
+        if(prev->next == overlay) {
+            if(prev->next_cnt < 255) {
+                prev->next_cnt++;
+            }
+        } else {
+            prev->next = overlay;
+            prev->next_cnt = 0;
+        }
+    }
+    omOvlManifestRecOvl = overlay;
+    omOvlManifestRecTime = GlobalCounter;
+    omOvlManifestRecDLLNum = 0;
+    HuDataDirLogStart(omOvlManifestRecDir, OM_OVL_MANIFEST_MAX);
+}
+
+//A manifest is learned the first time an overlay runs, or every time while recording is on
+//Directories that ended up in ARAM are marked so the prefetcher moves them there too
+static void omOvlManifestEnd(void)
+{
+    omOvlManifest *manifest;
+    s32 dir_num;
+    s32 i;
+    u16 entry;
+    if(omOvlManifestRecOvl == OVL_INVALID) {
+        return;
+    }
+    dir_num = HuDataDirLogEnd();
+    manifest = &omOvlManifestTbl[omOvlManifestRecOvl];
+    if(omOvlManifestRecF || !manifest->rec) {
+        manifest->rec = TRUE;
+        manifest->num = 0;
+        for(i=0; i<omOvlManifestRecDLLNum; i++) {
+            manifest->entry[manifest->num++] = OM_OVL_MANIFEST_DLL|omOvlManifestRecDLL[i];
+        }
+        for(i=0; i<dir_num && manifest->num < OM_OVL_MANIFEST_MAX; i++) {
+            entry = omOvlManifestRecDir[i];
+            if(HuARDirCheck(entry << 16)) {
+                entry |= OM_OVL_MANIFEST_ARAM;
+            }
+            manifest->entry[manifest->num++] = entry;
+        }
+        if(omOvlManifestRecF) {
+            omOvlManifestPrint(omOvlManifestRecOvl);
+        }
+    }
+    //Whatever the overlay did not use by now was prefetched for nothing
+    if(omOvlPrefetchOvl == omOvlManifestRecOvl) {
+        omOvlPrefetchStop();
+    }
+    omOvlManifestRecOvl = OVL_INVALID;
+}
+
+void omOvlManifestDLLAdd(s16 overlay)
+{
+    if(omOvlManifestRecOvl == OVL_INVALID || omOvlManifestRecDLLNum >= OM_OVL_MANIFEST_DLL_MAX) {
+        return;
+    }
+    omOvlManifestRecDLL[omOvlManifestRecDLLNum++] = overlay;
+}
+
+void omOvlManifestRecSet(BOOL rec)
+{
+    omOvlManifestRecF = rec;
+}
+
+void omOvlManifestDump(void)
+{
+    s32 i;
+    OSReport("objman>Ovl Manifest\n");
+    for(i=0; i<OVL_COUNT; i++) {
+        if(omOvlManifestTbl[i].num) {
+            omOvlManifestPrint(i);
+        }
+    }
+}
+
+//Starts loading what the overlay is known to need while the current scene is still running
+//Reads queue behind everything else and stop short of filling the heaps
+void omOvlPrefetch(OverlayID overlay)
+{
+    s32 i;
+    if(overlay == omOvlPrefetchOvl) {
+        return;
+    }
+    omOvlPrefetchStop();
+    if(overlay < 0 || overlay >= OVL_COUNT || omOvlManifestTbl[overlay].num == 0) {
+        return;
+    }
+    OSReport("objman>Prefetch Ovl %d\n", overlay);
+    omOvlPrefetchOvl = overlay;
+    omOvlPrefetchSrc = omcurovl;
+    omOvlPrefetchIdx = 0;
+    for(i=0; i<OM_OVL_MANIFEST_MAX; i++) {
+        omOvlPrefetchStat[i] = OM_OVL_PREFETCH_NONE;
+    }
+}
+
+//The prefetched data nobody claimed is freed by omOvlPrefetchExec
+void omOvlPrefetchStop(void)
+{
+    if(omOvlPrefetchOvl == OVL_INVALID) {
+        return;
+    }
+    omOvlPrefetchOvl = OVL_INVALID;
+    omOvlPrefetchCloseF = TRUE;
+}
+
+//Polls the directory being copied to ARAM, and closes the main memory copy once it has landed
+//Returns FALSE while the copy is still in flight
+static BOOL omOvlPrefetchFenceChk(void)
+{
+    if(!HuARFenceCheck(omOvlPrefetchFence)) {
+        return FALSE;
+    }
+    //The overlay may have started reading it meanwhile, then the main memory copy is its own
+    if(HuARDirCheck(omOvlPrefetchFenceDir) && HuDataDirPrefetchDone(omOvlPrefetchFenceDir)) {
+        HuDataDirClose(omOvlPrefetchFenceDir);
+    }
+    if(omOvlPrefetchFenceOvl == omOvlPrefetchOvl) {
+        omOvlPrefetchStat[omOvlPrefetchFenceIdx] = OM_OVL_PREFETCH_DONE;
+    }
+    omOvlPrefetchFenceOvl = OVL_INVALID;
+    return TRUE;
+}
+
+void omOvlPrefetchExec(void)
+{
+    omOvlManifest *manifest;
+    BOOL wipe_out;
+    s32 data_num;
+    s32 i;
+    u16 entry;
+    if(omOvlManifestRecOvl != OVL_INVALID && GlobalCounter-omOvlManifestRecTime >= OM_OVL_MANIFEST_FRAME) {
+        omOvlManifestEnd();
+    }
+    //A scene fading out is guessed to go where it went the last times
+    //Fading back in without a new overlay means it stayed
+    wipe_out = wipeData.stat && wipeData.mode == WIPE_MODE_OUT;
+    if(wipe_out && !omOvlPrefetchWipeF && omcurovl >= 0 && omnextovl < 0) {
+        manifest = &omOvlManifestTbl[omcurovl];
+        if(manifest->next >= 0 && manifest->next_cnt >= OM_OVL_PREFETCH_PREDICT) {
+            omOvlPrefetch(manifest->next);
+        }
+    } else if(wipeData.stat && wipeData.mode == WIPE_MODE_IN && omnextovl < 0
+        && omOvlPrefetchSrc == omcurovl && omOvlPrefetchOvl != omcurovl) {
+        omOvlPrefetchStop();
+    }
+    omOvlPrefetchWipeF = wipe_out;
+    if(omOvlPrefetchFenceOvl != OVL_INVALID && !omOvlPrefetchFenceChk()) {
+        return;
+    }
+    if(omOvlPrefetchCloseF) {
+        if(HuDataDirPrefetchClose() || omDLLPrefetchClose()) {
+            return;
+        }
+        omOvlPrefetchCloseF = FALSE;
+    }
+    if(omOvlPrefetchOvl == OVL_INVALID) {
+        return;
+    }
+    manifest = &omOvlManifestTbl[omOvlPrefetchOvl];
+    //Half the DVD queue is left to the loads of the running scene
+    while(omOvlPrefetchIdx < manifest->num && HuDvdReqFreeGet() > DVD_REQ_MAX/2) {
+        entry = manifest->entry[omOvlPrefetchIdx];
+        if(entry & OM_OVL_MANIFEST_DLL) {
+            if(!omDLLPrefetch(OM_OVL_MANIFEST_ID(entry))) {
+                break;
+            }
+        } else {
+            data_num = OM_OVL_MANIFEST_ID(entry) << 16;
+            if(HuDataReadChk(data_num) < 0 && !HuARDirCheck(data_num) && HuDataDirPrefetch(data_num) < 0) {
+                break;
+            }
+        }
+        omOvlPrefetchStat[omOvlPrefetchIdx++] = OM_OVL_PREFETCH_READ;
+    }
+    //ARAM is only filled once the overlay is certain to start, one directory at a time
+    if(omOvlPrefetchOvl != omnextovl && omOvlPrefetchOvl != omcurovl) {
+        return;
+    }
+    for(i=0; i<omOvlPrefetchIdx; i++) {
+        entry = manifest->entry[i];
+        if(!(entry & OM_OVL_MANIFEST_ARAM) || omOvlPrefetchStat[i] != OM_OVL_PREFETCH_READ) {
+            continue;
+        }
+        data_num = OM_OVL_MANIFEST_ID(entry) << 16;
+        if(HuDataDirPrefetchDone(data_num)) {
+            omOvlPrefetchFence = HuAR_MRAMtoARAMList(&data_num, 1, ARQ_PRIORITY_LOW);
+            omOvlPrefetchFenceOvl = omOvlPrefetchOvl;
+            omOvlPrefetchFenceIdx = i;
+            omOvlPrefetchFenceDir = data_num;
+            break;
+        }
+        if(HuDataReadChk(data_num) >= 0 || HuARDirCheck(data_num)) {
+            omOvlPrefetchStat[i] = OM_OVL_PREFETCH_DONE;
+        }
+    }
+}
+
 void omOvlHisChg(s32 level, OverlayID overlay, s32 event, s32 stat)
 {
     omOvlHisData *history;
@@ -495,7 +837,9 @@ void omMain(void)
             obj_index = object->prev;
             if((object->stat & (OM_STAT_DELETED|OM_STAT_DISABLED)) == 0) {
                 if(object->func != NULL && (object->stat & (0x40|0x8|OM_STAT_PAUSED)) == 0) {
+                    s32 trace = HuPerfTraceBegin((u32)object->func, PERF_TRACE_OBJECT);
                     object->func(object);
+                    HuPerfTraceEnd(trace);
                 }
                 if(omcurovl == -1 || objman->obj_last == -1) {
                     break;
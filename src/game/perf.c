@@ -13,7 +13,16 @@ typedef struct {
     /* 0x52 */ char unk52[6];
 } UnknownPerfStruct; // Size 0x58
 
+#define PERF_TRACE_DEPTH_MAX 8
+
+typedef struct {
+    u32 id;
+    u32 type;
+    u32 start;
+} PerfTraceOpen;
+
 static void DSCallbackFunc(u16 arg0);
+static void HuPerfTraceFrame(void);
 
 static OSStopwatch Ssw;
 static UnknownPerfStruct perf[10];
@@ -42,6 +51,18 @@ static u32 total_copy_clks;
 static s16 tokenEndF;
 static u8 metf;
 
+static PerfTraceOpen traceOpen[PERF_TRACE_DEPTH_MAX];
+static s32 traceDepth;
+static PerfTraceEvent traceEvent[PERF_TRACE_EVENT_MAX];
+static u32 traceEventCnt;
+static PerfTraceFrame traceFrame[PERF_TRACE_FRAME_MAX];
+static u32 traceFrameCnt;
+static u32 traceFrameStart;
+static u32 traceFrameEvent;
+static PerfTraceStat traceStat[PERF_TRACE_STAT_MAX];
+static u16 traceStatIdx[PERF_TRACE_STAT_MAX];
+static s32 traceStatNum;
+
 void HuPerfInit(void) {
     s32 i;
 
@@ -52,6 +73,12 @@ void HuPerfInit(void) {
     HuPerfCreate("DRAW", 0xFF, 0, 0, 0xFF);
     GXSetDrawSyncCallback(DSCallbackFunc);
     total_copy_clks = 0;
+    traceDepth = 0;
+    traceEventCnt = 0;
+    traceFrameCnt = 0;
+    traceFrameStart = OSGetTick();
+    traceFrameEvent = 0;
+    HuPerfTraceStatReset();
 }
 
 s32 HuPerfCreate(char *arg0, u8 arg1, u8 arg2, u8 arg3, u8 arg4) {
@@ -77,6 +104,7 @@ s32 HuPerfCreate(char *arg0, u8 arg1, u8 arg2, u8 arg3, u8 arg4) {
 }
 
 void HuPerfZero(void) {
+    HuPerfTraceFrame();
     OSStopStopwatch(&Ssw);
     OSResetStopwatch(&Ssw);
     OSStartStopwatch(&Ssw);
@@ -134,3 +162,162 @@ static void DSCallbackFunc(u16 arg0) {
             break;
     }
 }
+
+static PerfTraceStat *HuPerfTraceStatFind(u32 id, BOOL create) {
+    PerfTraceStat *stat;
+    s32 i;
+    s32 j;
+
+    i = (id >> 2) & (PERF_TRACE_STAT_MAX - 1);
+    for (j = 0; j < PERF_TRACE_STAT_MAX; j++) {
+        stat = &traceStat[i];
+        if (stat->id == id) {
+            return stat;
+        }
+        if (stat->id == 0) {
+            if (!create) {
+                return NULL;
+            }
+            stat->id = id;
+            traceStatIdx[traceStatNum++] = i;
+            return stat;
+        }
+        i = (i + 1) & (PERF_TRACE_STAT_MAX - 1);
+    }
+    return NULL;
+}
+
+// Opens a timed span for a process resume or object callback and returns the depth to close it at
+s32 HuPerfTraceBegin(u32 id, s32 type) {
+    PerfTraceOpen *open;
+    s32 depth = traceDepth;
+
+    if (depth < PERF_TRACE_DEPTH_MAX) {
+        open = &traceOpen[depth];
+        open->id = id;
+        open->type = type;
+        open->start = OSGetTick();
+    }
+    traceDepth++;
+    return depth;
+}
+
+// Closes every span above depth, so spans left open by a process that slept are cut where it yielded
+void HuPerfTraceEnd(s32 depth) {
+    PerfTraceOpen *open;
+    PerfTraceEvent *event;
+    PerfTraceStat *stat;
+    u32 tick = OSGetTick();
+    u32 len;
+
+    while (traceDepth > depth) {
+        traceDepth--;
+        if (traceDepth >= PERF_TRACE_DEPTH_MAX) {
+            continue;
+        }
+        open = &traceOpen[traceDepth];
+        len = tick - open->start;
+        event = &traceEvent[traceEventCnt % PERF_TRACE_EVENT_MAX];
+        event->id = open->id;
+        event->start = open->start;
+        event->len = len;
+        event->type = open->type;
+        event->depth = traceDepth;
+        traceEventCnt++;
+        stat = HuPerfTraceStatFind(open->id, TRUE);
+        if (stat) {
+            stat->type = open->type;
+            stat->num++;
+            stat->total += len;
+            stat->frame_len += len;
+        }
+    }
+}
+
+static void HuPerfTraceFrame(void) {
+    PerfTraceFrame *frame;
+    PerfTraceStat *stat;
+    u32 tick = OSGetTick();
+    s32 i;
+
+    frame = &traceFrame[traceFrameCnt % PERF_TRACE_FRAME_MAX];
+    frame->start = traceFrameStart;
+    frame->len = tick - traceFrameStart;
+    frame->event_ofs = traceFrameEvent;
+    frame->event_num = traceEventCnt - traceFrameEvent;
+    traceFrameCnt++;
+    traceFrameStart = tick;
+    traceFrameEvent = traceEventCnt;
+    for (i = 0; i < traceStatNum; i++) {
+        stat = &traceStat[traceStatIdx[i]];
+        if (stat->frame_len > stat->frame_max) {
+            stat->frame_max = stat->frame_len;
+        }
+        stat->frame_len = 0;
+    }
+}
+
+PerfTraceStat *HuPerfTraceStatGet(u32 id) {
+    return HuPerfTraceStatFind(id, FALSE);
+}
+
+void HuPerfTraceStatReset(void) {
+    s32 i;
+
+    for (i = 0; i < PERF_TRACE_STAT_MAX; i++) {
+        traceStat[i].id = 0;
+        traceStat[i].num = 0;
+        traceStat[i].total = 0;
+        traceStat[i].frame_len = 0;
+        traceStat[i].frame_max = 0;
+    }
+    traceStatNum = 0;
+}
+
+void HuPerfTraceStatDump(void) {
+    PerfTraceStat *stat;
+    s32 i;
+
+    OSReport("perf> func     type   num   total(us) max/frame(us)\n");
+    for (i = 0; i < traceStatNum; i++) {
+        stat = &traceStat[traceStatIdx[i]];
+        OSReport("perf> %08x %s %6d %10d %8d\n", stat->id, (stat->type == PERF_TRACE_PROCESS) ? "prc" : "obj", stat->num,
+            (u32)OSTicksToMicroseconds(stat->total), OSTicksToMicroseconds(stat->frame_max));
+    }
+}
+
+// Writes the frames still held in the ring as Chrome trace JSON, one event per line
+void HuPerfTraceDump(void) {
+    PerfTraceFrame *frame;
+    PerfTraceEvent *event;
+    u32 frame_no;
+    u32 base;
+    u32 i;
+
+    frame_no = (traceFrameCnt > PERF_TRACE_FRAME_MAX) ? traceFrameCnt - PERF_TRACE_FRAME_MAX : 0;
+    for (; frame_no < traceFrameCnt; frame_no++) {
+        frame = &traceFrame[frame_no % PERF_TRACE_FRAME_MAX];
+        if (traceEventCnt - frame->event_ofs <= PERF_TRACE_EVENT_MAX) {
+            break;
+        }
+    }
+    if (frame_no == traceFrameCnt) {
+        OSReport("{\"traceEvents\":[]}\n");
+        return;
+    }
+    base = traceFrame[frame_no % PERF_TRACE_FRAME_MAX].start;
+    OSReport("{\"traceEvents\":[\n");
+    for (; frame_no < traceFrameCnt; frame_no++) {
+        frame = &traceFrame[frame_no % PERF_TRACE_FRAME_MAX];
+        OSReport("{\"name\":\"frame %d\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%u,\"dur\":%u},\n", frame_no,
+            OSTicksToMicroseconds(frame->start - base), OSTicksToMicroseconds(frame->len));
+        for (i = 0; i < frame->event_num; i++) {
+            event = &traceEvent[(frame->event_ofs + i) % PERF_TRACE_EVENT_MAX];
+            OSReport("{\"name\":\"%s %08x\",\"ph\":\"X\",\"pid\":0,\"tid\":1,\"ts\":%u,\"dur\":%u},\n",
+                (event->type == PERF_TRACE_PROCESS) ? "prc" : "obj", event->id,
+                OSTicksToMicroseconds(event->start - base), OSTicksToMicroseconds(event->len));
+        }
+    }
+    OSReport("{\"name\":\"end\",\"ph\":\"i\",\"pid\":0,\"tid\":0,\"ts\":%u}]}\n",
+        OSTicksToMicroseconds(traceFrameStart - base));
+}
@@ -1,6 +1,8 @@
 #include "game/process.h"
 #include "game/memory.h"
+#include "game/perf.h"
 #include "dolphin/os.h"
+#include "string.h"
 
 #define FAKE_RETADDR 0xA5A5A5A5
 
@@ -9,26 +11,415 @@
 #define EXEC_CHILDWATCH 2
 #define EXEC_KILLED 3
 
+#define SCHED_RUN 0
+#define SCHED_WAIT 1
+#define SCHED_PARK 2
+
+#define PROCESS_BUCKET_MAX 256
+#define PROCESS_BUCKET_HASH 64
+#define PROCESS_GROUP_MAX 256
+#define PROCESS_GROUP(prio) ((prio) >> 8)
+#define PROCESS_WHEEL_MAX 64
+
+#define PROCESS_POOL_MAX 3
+#define PROCESS_POOL_SLAB 4
+#define PROCESS_POOL_SLAB_MAX 16
+#define PROCESS_POOL_SLOT_MAX 64
+#define PROCESS_STACK_FILL 0xCD
+
+#define PROCESS_PAUSED(process) ((process)->stat & (PROCESS_STAT_PAUSE|PROCESS_STAT_UPAUSE))
+
+//All processes with the same priority, which are contiguous in the process list
+typedef struct process_bucket {
+    u16 prio;
+    u16 num;
+    Process *head;
+    Process *tail;
+    Process *run_head;
+    Process *run_tail;
+    struct process_bucket *hash_next;
+    struct process_bucket *next;
+    struct process_bucket *prev;
+} ProcessBucket;
+
+//Slots for the common stack sizes, carved from slabs of HEAP_SYSTEM and reused instead of freed
+//Slabs with no live process go back to HEAP_SYSTEM on overlay change through HuPrcPoolFlush
+typedef struct process_pool {
+    u32 stack_size;
+    s32 slab_max;
+    s32 slab_num;
+    u8 *slab[PROCESS_POOL_SLAB_MAX];
+    s32 used_num;
+    s32 peak_num;
+    s32 free_num;
+    void *free[PROCESS_POOL_SLOT_MAX];
+} ProcessPool;
+
 static jmp_buf processjmpbuf;
 static Process *processtop;
 static Process *processcur;
 static u16 processcnt;
 u32 procfunc;
 
+//processruntop lists the processes HuPrcCall visits, in process list order
+//Timed sleepers wait in processwheel and sleepers that can only be killed are parked in neither
+static Process *processruntop;
+static Process *processwheel[PROCESS_WHEEL_MAX];
+static s32 processtick;
+static s32 processticklast;
+static s32 processwheeltick;
+static u32 processseq;
+static s32 processtrace = -1;
+
+static ProcessBucket processbucket[PROCESS_BUCKET_MAX];
+static ProcessBucket *processbucketfree;
+static ProcessBucket *processbuckethash[PROCESS_BUCKET_HASH];
+static ProcessBucket *processgrouptop[PROCESS_GROUP_MAX];
+static ProcessBucket *processgroupbottom[PROCESS_GROUP_MAX];
+static u32 processgroupmap[PROCESS_GROUP_MAX/32];
+
+static ProcessPool processpool[PROCESS_POOL_MAX] = {
+    { 2048, 16 },
+    { 4096, 8 },
+    { 8192, 4 }
+};
+static s32 processpoolmiss;
+static ProcessStackStat processstackstat[PROCESS_STACK_STAT_MAX];
+static s32 processstackstatnum;
+
 void HuPrcInit(void)
 {
+    s32 i;
     processcnt = 0;
     processtop = NULL;
+    processruntop = NULL;
+    processtick = processticklast = processwheeltick = 0;
+    processseq = 0;
+    for(i=0; i<PROCESS_WHEEL_MAX; i++) {
+        processwheel[i] = NULL;
+    }
+    processbucketfree = NULL;
+    for(i=PROCESS_BUCKET_MAX-1; i>=0; i--) {
+        processbucket[i].next = processbucketfree;
+        processbucketfree = &processbucket[i];
+    }
+    for(i=0; i<PROCESS_BUCKET_HASH; i++) {
+        processbuckethash[i] = NULL;
+    }
+    for(i=0; i<PROCESS_GROUP_MAX; i++) {
+        processgrouptop[i] = processgroupbottom[i] = NULL;
+    }
+    for(i=0; i<PROCESS_GROUP_MAX/32; i++) {
+        processgroupmap[i] = 0;
+    }
+    for(i=0; i<PROCESS_POOL_MAX; i++) {
+        processpool[i].slab_num = 0;
+        processpool[i].used_num = processpool[i].peak_num = 0;
+        processpool[i].free_num = 0;
+    }
+    processpoolmiss = 0;
+    processstackstatnum = 0;
+}
+
+static s32 PoolSlotSize(ProcessPool *pool)
+{
+    return HuMemMemoryAllocSizeGet(sizeof(Process))
+            +HuMemMemoryAllocSizeGet(pool->stack_size)
+            +HuMemMemoryAllocSizeGet(0);
 }
 
-static void LinkProcess(Process** root, Process* process) {
-    Process* src_process = *root;
+static void *PoolAlloc(u32 stack_size, s32 extra_size, s16 *pool_no)
+{
+    ProcessPool *pool;
+    u8 *slab;
+    s32 slot_size;
+    s32 i;
+    *pool_no = -1;
+    if(extra_size != 0) {
+        return NULL;
+    }
+    for(i=0; i<PROCESS_POOL_MAX; i++) {
+        if(processpool[i].stack_size == stack_size) {
+            break;
+        }
+    }
+    if(i == PROCESS_POOL_MAX) {
+        return NULL;
+    }
+    pool = &processpool[i];
+    if(!pool->free_num) {
+        if(pool->slab_num >= pool->slab_max) {
+            processpoolmiss++;
+            return NULL;
+        }
+        slot_size = PoolSlotSize(pool);
+        if(!(slab = HuMemDirectMalloc(HEAP_SYSTEM, slot_size*PROCESS_POOL_SLAB))) {
+            return NULL;
+        }
+        pool->slab[pool->slab_num++] = slab;
+        for(i=PROCESS_POOL_SLAB-1; i>=0; i--) {
+            pool->free[pool->free_num++] = &slab[i*slot_size];
+        }
+    }
+    slab = pool->free[--pool->free_num];
+    if(++pool->used_num > pool->peak_num) {
+        pool->peak_num = pool->used_num;
+    }
+    *pool_no = pool-&processpool[0];
+    return slab;
+}
+
+//HuPrcCall still reads the process after this, so a freed slot is left untouched
+static void HeapFreeProcess(Process *process)
+{
+    ProcessPool *pool;
+    if(process->pool < 0) {
+        HuMemDirectFree(process->heap);
+        return;
+    }
+    pool = &processpool[process->pool];
+    pool->free[pool->free_num++] = process->heap;
+    pool->used_num--;
+}
+
+static s32 PoolSlabFreeNum(ProcessPool *pool, u8 *slab, s32 slot_size)
+{
+    s32 num = 0;
+    s32 i;
+    for(i=0; i<pool->free_num; i++) {
+        if((u8 *)pool->free[i] >= slab && (u8 *)pool->free[i] < slab+(slot_size*PROCESS_POOL_SLAB)) {
+            num++;
+        }
+    }
+    return num;
+}
+
+//Frees every slab whose slots are all free, so the pools do not pin HEAP_SYSTEM across overlays
+//Must not run inside HuPrcCall's reaping of a finished process, which still reads its slot
+void HuPrcPoolFlush(void)
+{
+    ProcessPool *pool;
+    u8 *slab;
+    s32 slot_size;
+    s32 i;
+    s32 j;
+    s32 k;
+    for(i=0; i<PROCESS_POOL_MAX; i++) {
+        pool = &processpool[i];
+        slot_size = PoolSlotSize(pool);
+        for(j=0; j<pool->slab_num;) {
+            slab = pool->slab[j];
+            if(PoolSlabFreeNum(pool, slab, slot_size) != PROCESS_POOL_SLAB) {
+                j++;
+                continue;
+            }
+            for(k=0; k<pool->free_num;) {
+                if((u8 *)pool->free[k] >= slab && (u8 *)pool->free[k] < slab+(slot_size*PROCESS_POOL_SLAB)) {
+                    pool->free[k] = pool->free[--pool->free_num];
+                } else {
+                    k++;
+                }
+            }
+            HuMemDirectFree(slab);
+            pool->slab[j] = pool->slab[--pool->slab_num];
+        }
+    }
+}
 
-    if (src_process && (src_process->prio >= process->prio)) {
-        while (src_process->next && src_process->next->prio >= process->prio) {
-            src_process = src_process->next;
+u32 HuPrcStackUsedGet(Process *process)
+{
+    u8 *stack = (u8 *)(process->base_sp+8-process->stack_size);
+    u32 i;
+    for(i=0; i<process->stack_size && stack[i] == PROCESS_STACK_FILL; i++);
+    return process->stack_size-i;
+}
+
+static void StackStatProcess(Process *process)
+{
+    ProcessStackStat *stat;
+    u32 used;
+    s32 i;
+    for(i=0; i<processstackstatnum; i++) {
+        if(processstackstat[i].func == process->func && processstackstat[i].stack_size == process->stack_size) {
+            break;
+        }
+    }
+    if(i == processstackstatnum) {
+        if(processstackstatnum >= PROCESS_STACK_STAT_MAX) {
+            return;
+        }
+        stat = &processstackstat[processstackstatnum++];
+        stat->func = process->func;
+        stat->stack_size = process->stack_size;
+        stat->used_max = 0;
+        stat->num = 0;
+    } else {
+        stat = &processstackstat[i];
+    }
+    used = HuPrcStackUsedGet(process);
+    if(used > stat->used_max) {
+        stat->used_max = used;
+    }
+    stat->num++;
+}
+
+ProcessStackStat *HuPrcStackStatGet(s32 *num)
+{
+    *num = processstackstatnum;
+    return processstackstat;
+}
+
+void HuPrcStackStatDump(void)
+{
+    ProcessStackStat *stat;
+    s32 i;
+    OSReport("process> stack use\n");
+    for(i=0; i<processstackstatnum; i++) {
+        stat = &processstackstat[i];
+        OSReport("  %08x size %6d max %6d (%3d%%) num %d\n", stat->func, stat->stack_size, stat->used_max,
+            (stat->used_max*100)/stat->stack_size, stat->num);
+    }
+    OSReport("process> pool\n");
+    for(i=0; i<PROCESS_POOL_MAX; i++) {
+        OSReport("  stack %5d slot %d/%d peak %d\n", processpool[i].stack_size, processpool[i].used_num,
+            processpool[i].slab_num*PROCESS_POOL_SLAB, processpool[i].peak_num);
+    }
+    OSReport("  miss %d\n", processpoolmiss);
+}
+
+static ProcessBucket *BucketFind(u16 prio)
+{
+    ProcessBucket *bucket;
+    for(bucket = processbuckethash[prio & (PROCESS_BUCKET_HASH-1)]; bucket; bucket = bucket->hash_next) {
+        if(bucket->prio == prio) {
+            break;
+        }
+    }
+    return bucket;
+}
+
+//Lowest priority bucket above prio, found through the group bitmap
+static ProcessBucket *BucketFindAbove(u16 prio)
+{
+    ProcessBucket *bucket;
+    ProcessBucket *above;
+    s32 group = PROCESS_GROUP(prio);
+    s32 i;
+    u32 map;
+    above = NULL;
+    for(bucket = processgrouptop[group]; bucket && PROCESS_GROUP(bucket->prio) == group; bucket = bucket->next) {
+        if(bucket->prio <= prio) {
+            break;
+        }
+        above = bucket;
+    }
+    if(above) {
+        return above;
+    }
+    for(i=(group+1) >> 5; i<PROCESS_GROUP_MAX/32; i++) {
+        map = processgroupmap[i];
+        if(i == (group+1) >> 5) {
+            map &= ~0U << ((group+1) & 0x1F);
+        }
+        if(map) {
+            for(group=i*32; !(map & 0x1); group++) {
+                map >>= 1;
+            }
+            return processgroupbottom[group];
+        }
+    }
+    return NULL;
+}
+
+static ProcessBucket *BucketCreate(u16 prio)
+{
+    ProcessBucket *bucket = processbucketfree;
+    ProcessBucket *above;
+    s32 group = PROCESS_GROUP(prio);
+    if(bucket) {
+        processbucketfree = bucket->next;
+    } else if(!(bucket = HuMemDirectMalloc(HEAP_SYSTEM, sizeof(ProcessBucket)))) {
+        return NULL;
+    }
+    bucket->prio = prio;
+    bucket->num = 0;
+    bucket->head = bucket->tail = NULL;
+    bucket->run_head = bucket->run_tail = NULL;
+    bucket->hash_next = processbuckethash[prio & (PROCESS_BUCKET_HASH-1)];
+    processbuckethash[prio & (PROCESS_BUCKET_HASH-1)] = bucket;
+    above = BucketFindAbove(prio);
+    bucket->prev = above;
+    if(above) {
+        bucket->next = above->next;
+        above->next = bucket;
+    } else {
+        bucket->next = processtop ? BucketFind(processtop->prio) : NULL;
+    }
+    if(bucket->next) {
+        bucket->next->prev = bucket;
+    }
+    if(!processgrouptop[group]) {
+        processgrouptop[group] = processgroupbottom[group] = bucket;
+        processgroupmap[group >> 5] |= 1 << (group & 0x1F);
+    } else if(prio > processgrouptop[group]->prio) {
+        processgrouptop[group] = bucket;
+    } else if(prio < processgroupbottom[group]->prio) {
+        processgroupbottom[group] = bucket;
+    }
+    return bucket;
+}
+
+static void BucketKill(ProcessBucket *bucket)
+{
+    ProcessBucket **hash;
+    s32 group = PROCESS_GROUP(bucket->prio);
+    for(hash = &processbuckethash[bucket->prio & (PROCESS_BUCKET_HASH-1)]; *hash; hash = &(*hash)->hash_next) {
+        if(*hash == bucket) {
+            *hash = bucket->hash_next;
+            break;
+        }
+    }
+    if(processgrouptop[group] == bucket) {
+        if(processgroupbottom[group] == bucket) {
+            processgrouptop[group] = processgroupbottom[group] = NULL;
+            processgroupmap[group >> 5] &= ~(1 << (group & 0x1F));
+        } else {
+            processgrouptop[group] = bucket->next;
         }
+    } else if(processgroupbottom[group] == bucket) {
+        processgroupbottom[group] = bucket->prev;
+    }
+    if(bucket->prev) {
+        bucket->prev->next = bucket->next;
+    }
+    if(bucket->next) {
+        bucket->next->prev = bucket->prev;
+    }
+    if(bucket >= &processbucket[0] && bucket < &processbucket[PROCESS_BUCKET_MAX]) {
+        bucket->next = processbucketfree;
+        processbucketfree = bucket;
+    } else {
+        HuMemDirectFree(bucket);
+    }
+}
 
+//Equal priorities run in creation order, after every process of higher priority
+static BOOL LinkProcess(Process** root, Process* process) {
+    ProcessBucket *bucket;
+    Process *src_process;
+    if(!(bucket = BucketFind(process->prio))) {
+        if(!(bucket = BucketCreate(process->prio))) {
+            return FALSE;
+        }
+    }
+    if(bucket->tail) {
+        src_process = bucket->tail;
+    } else if(bucket->prev) {
+        src_process = bucket->prev->tail;
+    } else {
+        src_process = NULL;
+    }
+    if(src_process) {
         process->next = src_process->next;
         process->prev = src_process;
         src_process->next = process;
@@ -38,13 +429,28 @@ static void LinkProcess(Process** root, Process* process) {
     } else {
         process->next = (*root);
         process->prev = NULL;
-        *root = process;
-        if (src_process) {
-            src_process->prev = process;
+        if(*root) {
+            (*root)->prev = process;
         }
+        *root = process;
     }
+    if(!bucket->head) {
+        bucket->head = process;
+    }
+    bucket->tail = process;
+    bucket->num++;
+    return TRUE;
 }
+
 static void UnlinkProcess(Process **root, Process *process) {
+    ProcessBucket *bucket = BucketFind(process->prio);
+    if(--bucket->num == 0) {
+        BucketKill(bucket);
+    } else if(bucket->head == process) {
+        bucket->head = process->next;
+    } else if(bucket->tail == process) {
+        bucket->tail = process->prev;
+    }
     if (process->next) {
         process->next->prev = process->prev;
     }
@@ -55,35 +461,224 @@ static void UnlinkProcess(Process **root, Process *process) {
     }
 }
 
+//Inserts after the nearest visited process before it in the process list
+//Only the visited processes of the same priority and the buckets above are walked
+static void RunLinkProcess(Process *process)
+{
+    ProcessBucket *bucket = BucketFind(process->prio);
+    ProcessBucket *above;
+    Process *src_process;
+    for(src_process = bucket->run_tail; src_process && src_process->seq > process->seq; src_process = src_process->run_prev) {
+        if(src_process == bucket->run_head) {
+            src_process = NULL;
+            break;
+        }
+    }
+    if(!src_process) {
+        for(above = bucket->prev; above && !above->run_tail; above = above->prev);
+        if(above) {
+            src_process = above->run_tail;
+        }
+    }
+    if(!bucket->run_head || process->seq < bucket->run_head->seq) {
+        bucket->run_head = process;
+    }
+    if(!bucket->run_tail || process->seq > bucket->run_tail->seq) {
+        bucket->run_tail = process;
+    }
+    process->run_prev = src_process;
+    if(src_process) {
+        process->run_next = src_process->run_next;
+        src_process->run_next = process;
+    } else {
+        process->run_next = processruntop;
+        processruntop = process;
+    }
+    if(process->run_next) {
+        process->run_next->run_prev = process;
+    }
+    process->sched = SCHED_RUN;
+}
+
+//run_next is left intact so HuPrcCall can step past a process that just went to sleep
+static void RunUnlinkProcess(Process *process, u16 sched)
+{
+    ProcessBucket *bucket = BucketFind(process->prio);
+    if(bucket->run_head == process) {
+        if(bucket->run_tail == process) {
+            bucket->run_head = bucket->run_tail = NULL;
+        } else {
+            bucket->run_head = process->run_next;
+        }
+    } else if(bucket->run_tail == process) {
+        bucket->run_tail = process->run_prev;
+    }
+    if(process->run_next) {
+        process->run_next->run_prev = process->run_prev;
+    }
+    if(process->run_prev) {
+        process->run_prev->run_next = process->run_next;
+    } else {
+        processruntop = process->run_next;
+    }
+    process->sched = sched;
+}
+
+static void WaitLinkProcess(Process *process)
+{
+    Process **slot;
+    s32 tick = process->wake_tick;
+    if(tick <= processwheeltick) {
+        tick = processwheeltick+1;
+    }
+    slot = &processwheel[tick & (PROCESS_WHEEL_MAX-1)];
+    process->wait_prev = NULL;
+    process->wait_next = *slot;
+    if(*slot) {
+        (*slot)->wait_prev = process;
+    }
+    *slot = process;
+    process->sched = SCHED_WAIT;
+}
+
+static void WaitUnlinkProcess(Process *process)
+{
+    s32 i;
+    if(process->wait_next) {
+        process->wait_next->wait_prev = process->wait_prev;
+    }
+    if(process->wait_prev) {
+        process->wait_prev->wait_next = process->wait_next;
+    } else {
+        for(i=0; i<PROCESS_WHEEL_MAX; i++) {
+            if(processwheel[i] == process) {
+                processwheel[i] = process->wait_next;
+                break;
+            }
+        }
+    }
+    process->sched = SCHED_PARK;
+}
+
+//Whether HuPrcCall has already passed process in the current frame
+static BOOL VisitedProcess(Process *process)
+{
+    if(!processcur) {
+        return TRUE;
+    }
+    if(process->prio != processcur->prio) {
+        return process->prio > processcur->prio;
+    }
+    return process->seq <= processcur->seq;
+}
+
+//A sleeper counts down in every frame in which it is not paused when HuPrcCall passes it
+static s32 SleepBaseTick(Process *process)
+{
+    if(VisitedProcess(process)) {
+        return processtick;
+    } else {
+        return processtick-processticklast;
+    }
+}
+
+static void WaitWakeProcess(Process *process)
+{
+    WaitUnlinkProcess(process);
+    process->sleep_time = 0;
+    process->exec = EXEC_NORMAL;
+    RunLinkProcess(process);
+}
+
+static void WaitExecProcess(void)
+{
+    Process *process;
+    Process *next;
+    s32 i;
+    for(i=0; processwheeltick < processtick && i < PROCESS_WHEEL_MAX; i++) {
+        processwheeltick++;
+        for(process = processwheel[processwheeltick & (PROCESS_WHEEL_MAX-1)]; process; process = next) {
+            next = process->wait_next;
+            if(process->wake_tick <= processtick) {
+                WaitWakeProcess(process);
+            }
+        }
+    }
+    processwheeltick = processtick;
+}
+
+static void PauseChgProcess(Process *process, u16 stat)
+{
+    s32 base;
+    if(process->exec != EXEC_SLEEP || !((stat ^ process->stat) & (PROCESS_STAT_PAUSE|PROCESS_STAT_UPAUSE))) {
+        return;
+    }
+    if(!PROCESS_PAUSED(process)) {
+        if(process->sched == SCHED_WAIT) {
+            base = SleepBaseTick(process);
+            WaitUnlinkProcess(process);
+            process->sleep_time = process->wake_tick-base;
+            if(process->sleep_time <= 0) {
+                process->sleep_time = 0;
+                process->exec = EXEC_NORMAL;
+            }
+            RunLinkProcess(process);
+        }
+    } else if(!(stat & (PROCESS_STAT_PAUSE|PROCESS_STAT_UPAUSE)) && process->sched == SCHED_RUN && process != processcur) {
+        if(process->sleep_time > 0) {
+            process->wake_tick = SleepBaseTick(process)+process->sleep_time;
+            RunUnlinkProcess(process, SCHED_WAIT);
+            WaitLinkProcess(process);
+        } else {
+            RunUnlinkProcess(process, SCHED_PARK);
+        }
+    }
+}
+
 Process *HuPrcCreate(void (*func)(void), u16 prio, u32 stack_size, s32 extra_size)
 {
     Process *process;
     s32 alloc_size;
     void *heap;
+    s16 pool_no;
+    void *stack;
     if(stack_size == 0) {
         stack_size = 2048;
     }
     alloc_size = HuMemMemoryAllocSizeGet(sizeof(Process))
                     +HuMemMemoryAllocSizeGet(stack_size)
                     +HuMemMemoryAllocSizeGet(extra_size);
-    if(!(heap = HuMemDirectMalloc(HEAP_SYSTEM, alloc_size))) {
-        OSReport("process> malloc error size %d\n", alloc_size);
-        return NULL;
+    if(!(heap = PoolAlloc(stack_size, extra_size, &pool_no))) {
+        if(!(heap = HuMemDirectMalloc(HEAP_SYSTEM, alloc_size))) {
+            OSReport("process> malloc error size %d\n", alloc_size);
+            return NULL;
+        }
     }
     HuMemHeapInit(heap, alloc_size);
     process = HuMemMemoryAlloc(heap, sizeof(Process), FAKE_RETADDR);
     process->heap = heap;
+    process->pool = pool_no;
+    process->stack_size = stack_size;
+    process->func = func;
     process->exec = EXEC_NORMAL;
     process->stat = 0;
     process->prio = prio;
     process->sleep_time = 0;
-    process->base_sp = ((u32)HuMemMemoryAlloc(heap, stack_size, FAKE_RETADDR))+stack_size-8;
+    stack = HuMemMemoryAlloc(heap, stack_size, FAKE_RETADDR);
+    memset(stack, PROCESS_STACK_FILL, stack_size);
+    process->base_sp = ((u32)stack)+stack_size-8;
     gcsetjmp(&process->jump);
     process->jump.lr = (u32)func;
     process->jump.sp = process->base_sp;
     process->dtor = NULL;
     process->user_data = NULL;
-    LinkProcess(&processtop, process);
+    process->seq = processseq++;
+    if(!LinkProcess(&processtop, process)) {
+        OSReport("process> malloc error size %d\n", sizeof(ProcessBucket));
+        HeapFreeProcess(process);
+        return NULL;
+    }
+    RunLinkProcess(process);
     process->child = NULL;
     process->parent = NULL;
     processcnt++;
@@ -145,6 +740,9 @@ static s32 SetKillStatusProcess(Process *process)
     if(process->exec != EXEC_KILLED) {
         HuPrcWakeup(process);
         process->exec = EXEC_KILLED;
+        if(process->sched != SCHED_RUN) {
+            RunLinkProcess(process);
+        }
         return 0;
     } else {
         return -1;
@@ -161,6 +759,12 @@ s32 HuPrcKill(Process *process)
     return SetKillStatusProcess(process);
 }
 
+BOOL HuPrcKillChk(Process *process)
+{
+    return process->exec == EXEC_KILLED;
+}
+
+//The children are detached as well, ending one later must not touch a parent that may be gone
 void HuPrcChildKill(Process *process)
 {
     Process *child = process->child;
@@ -169,6 +773,7 @@ void HuPrcChildKill(Process *process)
             HuPrcChildKill(child);
         }
         SetKillStatusProcess(child);
+        child->parent = NULL;
         child = child->next_child;
     }
     process->child = NULL;
@@ -179,6 +784,8 @@ static void gcTerminateProcess(Process *process)
     if(process->dtor) {
         process->dtor();
     }
+    StackStatProcess(process);
+    RunUnlinkProcess(process, SCHED_PARK);
     UnlinkProcess(&processtop, process);
     processcnt--;
     gclongjmp(&processjmpbuf, 2);
@@ -198,6 +805,15 @@ void HuPrcSleep(s32 time)
     if(time != 0 && process->exec != EXEC_KILLED) {
         process->exec = EXEC_SLEEP;
         process->sleep_time = time;
+        if(!PROCESS_PAUSED(process)) {
+            if(time > 0) {
+                process->wake_tick = processtick+time;
+                RunUnlinkProcess(process, SCHED_WAIT);
+                WaitLinkProcess(process);
+            } else {
+                RunUnlinkProcess(process, SCHED_PARK);
+            }
+        }
     }
     if(!gcsetjmp(&process->jump)) {
         gclongjmp(&processjmpbuf, 1);
@@ -211,6 +827,14 @@ void HuPrcVSleep()
 
 void HuPrcWakeup(Process *process)
 {
+    if(process->sched == SCHED_WAIT) {
+        //Sleepers that ran out earlier this frame only leave the wheel at the end of it
+        if(process->wake_tick <= processtick && VisitedProcess(process)) {
+            WaitWakeProcess(process);
+        } else {
+            WaitUnlinkProcess(process);
+        }
+    }
     process->sleep_time = 0;
 }
 
@@ -229,23 +853,30 @@ void HuPrcCall(s32 tick)
 {
     Process *process;
     s32 ret;
-    processcur = processtop;
+    processtick += tick;
+    processticklast = tick;
+    processcur = processruntop;
     ret = gcsetjmp(&processjmpbuf);
     while(1) {
+        if(processtrace >= 0) {
+            HuPerfTraceEnd(processtrace);
+            processtrace = -1;
+        }
         switch(ret) {
             case 2:
-                HuMemDirectFree(processcur->heap);
+                HeapFreeProcess(processcur);
             case 1:
                 if(((u8 *)(processcur->heap))[4] != 165) {
                     printf("stack overlap error.(process pointer %x)\n", processcur);
                     while(1);
                 } else {
-                    processcur = processcur->next;
+                    processcur = processcur->run_next;
                 }
                 break;
         }
         process = processcur;
         if(!process) {
+            WaitExecProcess();
             return;
         }
         procfunc = process->jump.lr;
@@ -275,8 +906,12 @@ void HuPrcCall(s32 tick)
                 break;
                 
             case EXEC_KILLED:
-                process->jump.lr = (u32)HuPrcEnd;
+                //A process holding off its kill is let back in, it ends itself once it is done
+                if(!(process->stat & PROCESS_STAT_KILL_HOLD)) {
+                    process->jump.lr = (u32)HuPrcEnd;
+                }
             case EXEC_NORMAL:
+                processtrace = HuPerfTraceBegin((u32)process->func, PERF_TRACE_PROCESS);
                 gclongjmp(&process->jump, 1);
                 break;
         }
@@ -296,11 +931,13 @@ void HuPrcMemFree(void *ptr)
 
 void HuPrcSetStat(Process *process, u16 value)
 {
+    PauseChgProcess(process, process->stat|value);
     process->stat |= value;
 }
 
 void HuPrcResetStat(Process *process, u16 value)
 {
+    PauseChgProcess(process, process->stat & ~value);
     process->stat &= ~value;
 }
 
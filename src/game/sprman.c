@@ -3,11 +3,17 @@
 #include "game/init.h"
 
 #include "dolphin/mtx.h"
+#include "string.h"
 
 #define SPRITE_DIRTY_ATTR 0x1
 #define SPRITE_DIRTY_XFORM 0x2
 #define SPRITE_DIRTY_COLOR 0x4
 
+#define SPRITE_GRP_DIRTY_MTX 0x1
+
+//Below this many entries the list insert is cheaper than the two sort passes
+#define HUSPR_ORDER_SORT_MIN 16
+
 typedef struct sprite_order {
     u16 group;
     u16 sprite;
@@ -18,11 +24,19 @@ typedef struct sprite_order {
 HuSprite HuSprData[HUSPR_MAX];
 HuSprGrp HuSprGrpData[HUSPR_GRP_MAX];
 static SpriteOrder HuSprOrder[HUSPR_MAX*2];
+static u16 HuSprOrderIdx[2][HUSPR_MAX*2];
+static u32 HuSprGrpActive[HUSPR_GRP_MAX/32];
+//Kept out of HuSprGrp so its layout stays what the RELs were built against
+static u8 HuSprGrpDirtyFlag[HUSPR_GRP_MAX];
+static float HuSprGrpTrans[HUSPR_GRP_MAX][2];
 
 static s16 HuSprOrderNum;
 static s16 HuSprOrderNo;
+static BOOL HuSprOrderNegF;
 static BOOL HuSprPauseF;
 
+static void HuSprOrderAdd(s16 group, s16 sprite);
+static void HuSprOrderSort(void);
 static void HuSprOrderEntry(s16 group, s16 sprite);
 
 
@@ -37,6 +51,7 @@ void HuSprInit(void)
     for(group = HuSprGrpData, i=0; i<HUSPR_GRP_MAX; i++, group++) {
         group->capacity = 0;
     }
+    memset(HuSprGrpActive, 0, sizeof(HuSprGrpActive));
     sprite = &HuSprData[0];
     sprite->prio = 0;
     sprite->data = (void *)1;
@@ -75,31 +90,118 @@ void HuSprExec(s16 draw_no)
 void HuSprBegin(void)
 {
     Mtx temp, rot;
-    s16 i, j;
+    s16 i, j, word;
+    u32 bits;
     Vec axis = {0, 0, 1};
     HuSprGrp *group;
-    group = HuSprGrpData;
     HuSprOrderNum = 1;
+    HuSprOrderNegF = FALSE;
     HuSprOrder[0].next = 0;
     HuSprOrder[0].prio = -1;
-    for(i=0; i<HUSPR_GRP_MAX; i++, group++) {
-        if(group->capacity != 0) {
-            MTXTrans(temp, group->center_x*group->scale_x, group->center_y*group->scale_y, 0.0f);
-            MTXRotAxisDeg(rot, &axis, group->z_rot);
-            MTXConcat(rot, temp, group->mtx);
-            MTXScale(temp, group->scale_x, group->scale_y, 1.0f);
-            MTXConcat(group->mtx, temp, group->mtx);
-            mtxTransCat(group->mtx, group->x, group->y, 0);
+    for(word=0; word<HUSPR_GRP_MAX/32; word++) {
+        //Groups are visited in index order since that decides ties in the sort
+        for(bits = HuSprGrpActive[word], i = word*32; bits != 0; bits <<= 1, i++) {
+            if(!(bits & 0x80000000)) {
+                continue;
+            }
+            group = &HuSprGrpData[i];
+            if(group->capacity == 0) {
+                continue;
+            }
+            //Only center, rotation and scale need the full rebuild
+            //Position is added to the stored translation every frame as some code writes it directly
+            if(HuSprGrpDirtyFlag[i] & SPRITE_GRP_DIRTY_MTX) {
+                MTXTrans(temp, group->center_x*group->scale_x, group->center_y*group->scale_y, 0.0f);
+                MTXRotAxisDeg(rot, &axis, group->z_rot);
+                MTXConcat(rot, temp, group->mtx);
+                MTXScale(temp, group->scale_x, group->scale_y, 1.0f);
+                MTXConcat(group->mtx, temp, group->mtx);
+                HuSprGrpTrans[i][0] = group->mtx[0][3];
+                HuSprGrpTrans[i][1] = group->mtx[1][3];
+                HuSprGrpDirtyFlag[i] &= ~SPRITE_GRP_DIRTY_MTX;
+            }
+            group->mtx[0][3] = HuSprGrpTrans[i][0]+group->x;
+            group->mtx[1][3] = HuSprGrpTrans[i][1]+group->y;
             for(j=0; j<group->capacity; j++) {
                 if(group->members[j] != -1) {
-                    HuSprOrderEntry(i, group->members[j]);
+                    HuSprOrderAdd(i, group->members[j]);
                 }
             }
         }
     }
+    HuSprOrderSort();
     HuSprOrderNo = 0;
 }
 
+static void HuSprOrderAdd(s16 group, s16 sprite)
+{
+    SpriteOrder *order = &HuSprOrder[HuSprOrderNum];
+    s16 prio = HuSprData[sprite].prio;
+    if(HuSprOrderNum >= HUSPR_MAX*2) {
+        OSReport("Order Max Over!\n");
+        return;
+    }
+    if(prio < 0) {
+        HuSprOrderNegF = TRUE;
+    }
+    order->prio = prio;
+    order->group = group;
+    order->sprite = sprite;
+    HuSprOrderNum++;
+}
+
+//Links the gathered entries by descending priority, equal priorities keeping gather order
+//This is a stable radix sort on the inverted priority, one pass per byte
+static void HuSprOrderSort(void)
+{
+    s16 count[256];
+    u16 *src, *dst, *swap;
+    s16 i, num, shift, ofs, temp;
+    num = HuSprOrderNum-1;
+    if(num == 0) {
+        return;
+    }
+    //The list insert compares the stored unsigned priority against the signed one
+    //Negative priorities do not form a plain ordering there, so those frames replay it
+    if(num < HUSPR_ORDER_SORT_MIN || HuSprOrderNegF) {
+        HuSprOrderNum = 1;
+        for(i=1; i<=num; i++) {
+            HuSprOrderEntry(HuSprOrder[i].group, HuSprOrder[i].sprite);
+        }
+        return;
+    }
+    src = HuSprOrderIdx[0];
+    dst = HuSprOrderIdx[1];
+    for(i=0; i<num; i++) {
+        src[i] = i+1;
+    }
+    for(shift=0; shift<16; shift += 8) {
+        memset(count, 0, sizeof(count));
+        for(i=0; i<num; i++) {
+            count[((u16)~HuSprOrder[src[i]].prio >> shift) & 0xFF]++;
+        }
+        if(count[((u16)~HuSprOrder[src[0]].prio >> shift) & 0xFF] == num) {
+            continue;
+        }
+        for(ofs=0, i=0; i<256; i++) {
+            temp = count[i];
+            count[i] = ofs;
+            ofs += temp;
+        }
+        for(i=0; i<num; i++) {
+            dst[count[((u16)~HuSprOrder[src[i]].prio >> shift) & 0xFF]++] = src[i];
+        }
+        swap = src;
+        src = dst;
+        dst = swap;
+    }
+    HuSprOrder[0].next = src[0];
+    for(i=0; i<num-1; i++) {
+        HuSprOrder[src[i]].next = src[i+1];
+    }
+    HuSprOrder[src[num-1]].next = 0;
+}
+
 static void HuSprOrderEntry(s16 group, s16 sprite)
 {
     SpriteOrder *order = &HuSprOrder[HuSprOrderNum];
@@ -308,8 +410,10 @@ s16 HuSprGrpCreate(s16 capacity)
         group->members[j] = HUSPR_NONE;
     }
     group->capacity = capacity;
+    HuSprGrpActive[i >> 5] |= 0x80000000 >> (i & 0x1F);
     group->x = group->y = group->z_rot = group->center_x = group->center_y = 0.0f;
     group->scale_x = group->scale_y = 1.0f;
+    HuSprGrpDirtyFlag[i] = SPRITE_GRP_DIRTY_MTX;
     return i;
 }
 
@@ -371,6 +475,7 @@ void HuSprGrpKill(s16 group)
         }
     }
     group_ptr->capacity = 0;
+    HuSprGrpActive[group >> 5] &= ~(0x80000000 >> (group & 0x1F));
     HuMemDirectFree(group_ptr->members);
 }
 
@@ -510,6 +615,7 @@ void HuSprGrpCenterSet(s16 group, float x, float y)
     s16 i;
     group_ptr->center_x = x;
     group_ptr->center_y = y;
+    HuSprGrpDirtyFlag[group] |= SPRITE_GRP_DIRTY_MTX;
     for(i=0; i<group_ptr->capacity; i++) {
         if(group_ptr->members[i] != HUSPR_NONE) {
             HuSprData[group_ptr->members[i]].dirty_flag |= SPRITE_DIRTY_XFORM;
@@ -522,6 +628,7 @@ void HuSprGrpZRotSet(s16 group, float z_rot)
     HuSprGrp *group_ptr = &HuSprGrpData[group];
     s16 i;
     group_ptr->z_rot = z_rot;
+    HuSprGrpDirtyFlag[group] |= SPRITE_GRP_DIRTY_MTX;
     for(i=0; i<group_ptr->capacity; i++) {
         if(group_ptr->members[i] != HUSPR_NONE) {
             HuSprData[group_ptr->members[i]].dirty_flag |= SPRITE_DIRTY_XFORM;
@@ -535,6 +642,7 @@ void HuSprGrpScaleSet(s16 group, float x, float y)
     s16 i;
     group_ptr->scale_x = x;
     group_ptr->scale_y = y;
+    HuSprGrpDirtyFlag[group] |= SPRITE_GRP_DIRTY_MTX;
     for(i=0; i<group_ptr->capacity; i++) {
         if(group_ptr->members[i] != HUSPR_NONE) {
             HuSprData[group_ptr->members[i]].dirty_flag |= SPRITE_DIRTY_XFORM;
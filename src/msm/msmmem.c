@@ -1,12 +1,25 @@
 #include "msm/msmmem.h"
+#include "stdint.h"
 
+#define MSM_MEM_BIN_MAX 32
+
+// Host builds have 8 byte pointers, which do not fit the console's 0x20 byte block header
+#ifdef TARGET_PC
+#define MSM_MEM_BLOCK_HEADER 0x40
+#else
+#define MSM_MEM_BLOCK_HEADER 0x20
+#endif
+
+// freeSize is the size taken by the block itself, size is the free space behind it
 typedef struct MSMBlock_s {
     struct MSMBlock_s* prev;
     struct MSMBlock_s* next;
     u32 freeSize;
     u32 size;
     void* ptr;
-    char pad[12];
+    struct MSMBlock_s* binPrev;
+    struct MSMBlock_s* binNext;
+    char pad[4];
 } MSMBLOCK;
 
 typedef struct MSMMem_s {
@@ -14,23 +27,150 @@ typedef struct MSMMem_s {
     u32 size;
     MSMBLOCK *head;
     MSMBLOCK first;
+    s32 mode;
+    u32 useSize;
+    u32 peakSize;
+    u32 binMask;
+    MSMBLOCK *bin[MSM_MEM_BIN_MAX];
 } MSM_MEM;
 
 static MSM_MEM mem;
 
+// Blocks with free space behind them are kept in bins by the highest bit of that size
+static inline s32 msmMemBinNo(u32 size) {
+    s32 no;
+
+    for (no = MSM_MEM_BIN_MAX - 1; no > 0; no--) {
+        if (size & (1 << no)) {
+            break;
+        }
+    }
+    return no;
+}
+
+static void msmMemBinAdd(MSMBLOCK* block) {
+    s32 no;
+
+    if (mem.mode != MSM_MEM_BESTFIT || block->size == 0) {
+        return;
+    }
+    no = msmMemBinNo(block->size);
+    block->binPrev = NULL;
+    block->binNext = mem.bin[no];
+    if (mem.bin[no]) {
+        mem.bin[no]->binPrev = block;
+    }
+    mem.bin[no] = block;
+    mem.binMask |= 1 << no;
+}
+
+static void msmMemBinDel(MSMBLOCK* block) {
+    s32 no;
+
+    if (mem.mode != MSM_MEM_BESTFIT || block->size == 0) {
+        return;
+    }
+    no = msmMemBinNo(block->size);
+    if (block->binPrev) {
+        block->binPrev->binNext = block->binNext;
+    } else {
+        mem.bin[no] = block->binNext;
+        if (mem.bin[no] == NULL) {
+            mem.binMask &= ~(1 << no);
+        }
+    }
+    if (block->binNext) {
+        block->binNext->binPrev = block->binPrev;
+    }
+}
+
+// Smallest free space that holds allocSize, looking no further than the first bin with a fit
+static MSMBLOCK* msmMemBinSearch(u32 allocSize) {
+    MSMBLOCK* block;
+    MSMBLOCK* best;
+    u32 mask;
+    s32 no;
+
+    no = msmMemBinNo(allocSize);
+    best = NULL;
+    for (block = mem.bin[no]; block; block = block->binNext) {
+        if (block->size >= allocSize && (best == NULL || block->size < best->size)) {
+            best = block;
+        }
+    }
+    if (best) {
+        return best;
+    }
+    mask = (no + 1 < MSM_MEM_BIN_MAX) ? (mem.binMask & ~((2 << no) - 1)) : 0;
+    if (mask == 0) {
+        return NULL;
+    }
+    for (no++; !(mask & (1 << no)); no++) {
+    }
+    best = mem.bin[no];
+    for (block = best->binNext; block; block = block->binNext) {
+        if (block->size < best->size) {
+            best = block;
+        }
+    }
+    return best;
+}
+
+static void msmMemBinBuild(void) {
+    MSMBLOCK* block;
+    s32 i;
+
+    for (i = 0; i < MSM_MEM_BIN_MAX; i++) {
+        mem.bin[i] = NULL;
+    }
+    mem.binMask = 0;
+    if (mem.ptr == NULL) {
+        return;
+    }
+    for (block = &mem.first; block; block = block->next) {
+        msmMemBinAdd(block);
+    }
+}
+
+void msmMemSetMode(s32 mode) {
+    mem.mode = mode;
+    msmMemBinBuild();
+}
+
+void msmMemGetStat(MSM_MEMSTAT* stat) {
+    MSMBLOCK* block;
+
+    stat->totalSize = mem.size;
+    stat->useSize = mem.useSize;
+    stat->peakSize = mem.peakSize;
+    stat->freeSize = 0;
+    stat->largestFree = 0;
+    stat->freeNum = 0;
+    if (mem.ptr != NULL) {
+        for (block = &mem.first; block; block = block->next) {
+            if (block->size == 0) {
+                continue;
+            }
+            stat->freeSize += block->size;
+            stat->freeNum++;
+            if (stat->largestFree < block->size) {
+                stat->largestFree = block->size;
+            }
+        }
+    }
+    stat->fragRatio = (stat->freeSize != 0) ? 1.0f - (float)stat->largestFree / stat->freeSize : 0.0f;
+}
+
 void msmMemFree(void* ptr) {
     MSMBLOCK* block;
     MSMBLOCK* blockPrev;
     MSMBLOCK* blockNext;
     MSMBLOCK* blockHead;
-    MSMBLOCK* base;
-    
-    base = ptr;
 
-    block = &base[-1];
+    block = (MSMBLOCK*)((u8*)ptr - MSM_MEM_BLOCK_HEADER);
     blockPrev = block->prev;
     blockNext = block->next;
-    if (mem.ptr > block || ((u32)mem.ptr + (u32)mem.size) <= (u32)block) {
+    if ((u8*)mem.ptr > (u8*)block || ((u8*)mem.ptr + mem.size) <= (u8*)block) {
         return;
     }
 
@@ -38,7 +178,11 @@ void msmMemFree(void* ptr) {
         return;
     }
     
+    mem.useSize -= block->freeSize;
+    msmMemBinDel(blockPrev);
+    msmMemBinDel(block);
     blockPrev->size += block->freeSize + block->size;
+    msmMemBinAdd(blockPrev);
     blockPrev->next = blockNext;
     blockHead = mem.head;
     if ((blockHead == block) || (blockHead->size < blockPrev->size)) {
@@ -60,12 +204,17 @@ void* msmMemAlloc(u32 size) {
     MSMBLOCK* blockPrev;
     MSMBLOCK* blockNext;
 
-    allocSize = size + 0x20;
+    allocSize = size + MSM_MEM_BLOCK_HEADER;
     alignOfs = allocSize & 0x1F;
     if (alignOfs) {
         allocSize += 0x20 - alignOfs;
     }
-    if (mem.head->size >= allocSize) {
+    if (mem.mode == MSM_MEM_BESTFIT) {
+        blockPrev = msmMemBinSearch(allocSize);
+        if (!blockPrev) {
+            return NULL;
+        }
+    } else if (mem.head->size >= allocSize) {
         blockPrev = mem.head;
     } else {
         blockPrev = &mem.first;
@@ -81,27 +230,33 @@ void* msmMemAlloc(u32 size) {
     
     freeSize = blockPrev->freeSize;
     if (freeSize != 0) {
-        freeSize -= 0x20;
+        freeSize -= MSM_MEM_BLOCK_HEADER;
     }
-    block = (void*)((u32)blockPrev->ptr + (freeSize));
+    block = (void*)((u8*)blockPrev->ptr + (freeSize));
     blockNext = blockPrev->next;
-    if ((mem.ptr > block) || ((void*)((u32)mem.ptr + (u32)mem.size) <= block)) {
+    if (((u8*)mem.ptr > (u8*)block) || (((u8*)mem.ptr + mem.size) <= (u8*)block)) {
         return NULL;
     }
+    msmMemBinDel(blockPrev);
     block->freeSize = allocSize;
     block->size = blockPrev->size - allocSize;
-    block->ptr = (block + 1);
+    block->ptr = (void*)((u8*)block + MSM_MEM_BLOCK_HEADER);
     block->prev = blockPrev;
     block->next = blockNext;
     mem.head = block;
     blockPrev->size = 0;
     blockPrev->next = block;
+    msmMemBinAdd(block);
     if (blockNext) {
         blockNext->prev = block;
         if (mem.head->size < blockNext->size) {
             mem.head = blockNext;
         }
     }
+    mem.useSize += allocSize;
+    if (mem.peakSize < mem.useSize) {
+        mem.peakSize = mem.useSize;
+    }
     return block->ptr;
 }
 
@@ -109,7 +264,7 @@ void msmMemInit(void* ptr, u32 size) {
     MSMBLOCK* block;
     s32 ofs;
 
-    ofs = (s32)ptr & 0x1F;
+    ofs = (uintptr_t)ptr & 0x1F;
     switch (ofs) {
         default:
             ofs = 0x20 - ofs;
@@ -119,9 +274,8 @@ void msmMemInit(void* ptr, u32 size) {
             break;
     }
     
-    mem.ptr = (void*)((s32)ptr + ofs);
-    ofs = (s32)ptr + size;
-    mem.size = ((ofs - (s32)mem.ptr) & ~0x1F);
+    mem.ptr = (void*)((u8*)ptr + ofs);
+    mem.size = ((size - ofs) & ~0x1F);
     block = &mem.first;
     block->freeSize = 0;
     block->size = mem.size;
@@ -129,4 +283,7 @@ void msmMemInit(void* ptr, u32 size) {
     block->prev = NULL;
     block->next = NULL;
     mem.head = &mem.first;
+    mem.useSize = 0;
+    mem.peakSize = 0;
+    msmMemBinBuild();
 }
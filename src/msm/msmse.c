@@ -3,6 +3,9 @@
 #include "msm/msmmem.h"
 
 #define SE_PLAYER_EMIT (1 << 0)
+#define SE_PLAYER_NOINDEX (1 << 1)
+
+#define SE_NO_TBL_SIZE 1024
 
 typedef struct SePlayer_s {
     SND_VOICEID vid;
@@ -50,6 +53,8 @@ static struct {
     float sndDist;
     u16 groupId;
     u16 listenerF;
+    s32 noIndexNum;
+    s8 noTbl[SE_NO_TBL_SIZE];
 } se;
 
 static void msmSeFade(SE_PLAYER *player) {
@@ -134,17 +139,64 @@ static void msmSePauseSub(SE_PLAYER* player, BOOL pause, s32 speed) {
     }
 }
 
+// seNo is handed out in sequence and doubles as the generation of its player slot,
+// so its low bits index noTbl and a slot holding a different no means the handle is stale.
+// A live seNo only misses the table when a newer one with the same low bits took its entry.
 static SE_PLAYER* msmSeSearchEntry(s32 seNo) {
     SE_PLAYER *player;
+    SE_PLAYER *result;
     s32 i;
+    s32 num;
 
-    for (i = 0; i < se.sfx; i++) {
+    i = se.noTbl[seNo & (SE_NO_TBL_SIZE - 1)];
+    if (i >= 0) {
         player = &se.player[i];
-        if (player->status != MSM_SE_DONE && player->no == seNo) {
-            return player;
+        if (player->no == seNo) {
+            return (player->status != MSM_SE_DONE) ? player : NULL;
         }
     }
-    return NULL;
+    if (se.noIndexNum == 0) {
+        return NULL;
+    }
+    result = NULL;
+    for (i = num = 0; i < se.sfx; i++) {
+        player = &se.player[i];
+        if (player->status != MSM_SE_DONE && (player->flag & SE_PLAYER_NOINDEX)) {
+            if (player->no == seNo) {
+                result = player;
+            }
+            num++;
+        }
+    }
+    se.noIndexNum = num;
+    return result;
+}
+
+static void msmSeEntryNo(SE_PLAYER* player, s32 slot) {
+    SE_PLAYER* old;
+    s32 idx;
+
+    idx = player->no & (SE_NO_TBL_SIZE - 1);
+    if (se.noTbl[idx] >= 0) {
+        old = &se.player[se.noTbl[idx]];
+        if (old != player && old->status != MSM_SE_DONE && (old->no & (SE_NO_TBL_SIZE - 1)) == idx) {
+            old->flag |= SE_PLAYER_NOINDEX;
+            se.noIndexNum++;
+        }
+    }
+    se.noTbl[idx] = slot;
+}
+
+static void msmSeUpdatePos(SE_PLAYER* player, Vec* pos) {
+    player->busyF = TRUE;
+    player->emiDir.x = pos->x - player->emiPos.x;
+    player->emiDir.y = pos->y - player->emiPos.y;
+    player->emiDir.z = pos->z - player->emiPos.z;
+    player->emiPos.x = pos->x;
+    player->emiPos.y = pos->y;
+    player->emiPos.z = pos->z;
+    sndUpdateEmitter(&player->emitter, &player->emiPos, &player->emiDir, player->vol * player->baseVol * player->fadeVol * player->pauseVol / (127*127*127), NULL);
+    player->busyF = FALSE;
 }
 
 void msmSePeriodicProc(void) {
@@ -364,15 +416,7 @@ s32 msmSeSetParam(int seNo, MSM_SEPARAM* param) {
     } else if (player->emitterF == TRUE) {
         player->vid = sndEmitterVoiceID(&player->emitter);
         if (param->flag & MSM_SEPARAM_POS) {
-            player->busyF = TRUE;
-            player->emiDir.x = param->pos.x - player->emiPos.x;
-            player->emiDir.y = param->pos.y - player->emiPos.y;
-            player->emiDir.z = param->pos.z - player->emiPos.z;
-            player->emiPos.x = param->pos.x;
-            player->emiPos.y = param->pos.y;
-            player->emiPos.z = param->pos.z;
-            sndUpdateEmitter(&player->emitter, &player->emiPos, &player->emiDir, player->vol * player->baseVol * player->fadeVol * player->pauseVol / (127*127*127), NULL);
-            player->busyF = FALSE;
+            msmSeUpdatePos(player, &param->pos);
         }
     }
     if (param->flag & MSM_SEPARAM_AUXVOLA) {
@@ -389,6 +433,23 @@ s32 msmSeSetParam(int seNo, MSM_SEPARAM* param) {
     return 0;
 }
 
+s32 msmSeSetPosList(int* seNo, Vec* pos, s32 num) {
+    SE_PLAYER* player;
+    s32 i;
+    s32 updateNum;
+
+    for (i = updateNum = 0; i < num; i++) {
+        player = msmSeSearchEntry(seNo[i]);
+        if (player == NULL || !(player->flag & SE_PLAYER_EMIT) || player->emitterF != TRUE) {
+            continue;
+        }
+        player->vid = sndEmitterVoiceID(&player->emitter);
+        msmSeUpdatePos(player, &pos[i]);
+        updateNum++;
+    }
+    return updateNum;
+}
+
 void msmSePauseAll(BOOL pause, s32 speed) {
     s32 i;
     SE_PLAYER* player;
@@ -540,6 +601,7 @@ int msmSePlay(int seId, MSM_SEPARAM* param) {
     player->pauseVol = 127;
     player->fadeVol = 127;
     player->emitterF = 0;
+    player->flag &= ~SE_PLAYER_NOINDEX;
     if (msmSeUpdateBaseParam(player, param)) {
         player->emiPos.x = param->pos.x;
         player->emiPos.y = param->pos.y;
@@ -604,6 +666,7 @@ int msmSePlay(int seId, MSM_SEPARAM* param) {
     player->busyF = 1;
     player->seId = seId;
     player->no = se.no++;
+    msmSeEntryNo(player, i);
     player->status = 2;
     player->busyF = 0;
     return player->no;
@@ -617,6 +680,8 @@ s32 msmSeInit(MSM_SYS* arg0, DVDFileInfo* arg1) {
     se.baseGrpNumPlay = 0;
     se.numPlay = 0;
     se.listenerF = 0;
+    se.noIndexNum = 0;
+    memset(se.noTbl, -1, sizeof(se.noTbl));
     if (arg0->info->seMax == 0) {
         return 0;
     }
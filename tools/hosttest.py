@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+
+###
+# Builds and runs the host tests in tools/hosttest.
+#
+# Usage:
+#   python3 tools/hosttest.py [-v] [test ...]
+#
+# Each test is one C file that includes the game source it covers and stands
+# in for the SDK and game calls that source makes. They are built with the
+# host compiler and TARGET_PC, so nothing from the console build is needed.
+# With no test named, all of them are run.
+###
+
+from argparse import ArgumentParser
+import os
+import subprocess
+import sys
+import tempfile
+from typing import List
+
+script_dir = os.path.dirname(os.path.realpath(__file__))
+root_dir = os.path.abspath(os.path.join(script_dir, ".."))
+test_dir = os.path.join(script_dir, "hosttest")
+
+
+def host_include_dirs(cc: str) -> List[str]:
+    # The repo's own libc headers would shadow the host ones, so the host
+    # search path is passed explicitly ahead of them
+    result = subprocess.run(
+        [cc, "-E", "-Wp,-v", "-x", "c", os.devnull],
+        capture_output=True,
+        text=True,
+        check=True,
+    )
+    dirs = []
+    listing = False
+    for line in result.stderr.splitlines():
+        if line.startswith("#include <...>"):
+            listing = True
+        elif line.startswith("End of search list"):
+            break
+        elif listing:
+            dirs.append(line.strip())
+    return dirs
+
+
+def build(cc: str, version: int, name: str, out: str) -> bool:
+    cmd = [cc, "-std=gnu99", "-O1", "-g", "-no-pie", "-nostdinc"]
+    # The game keeps pointers in u32 for the console's ARAM, module and
+    # jump buffer interfaces, which holds here because host.h puts the game's
+    # memory below 4GB; pointer arithmetic has to go through pointers
+    cmd += ["-Wno-pointer-to-int-cast", "-Wno-int-to-pointer-cast"]
+    cmd += ["-DTARGET_PC", "-DNON_MATCHING", "-DVERSION=%d" % version, "-D__declspec(x)="]
+    cmd += ["-I" + test_dir, "-I" + os.path.join(test_dir, "include")]
+    cmd += ["-I" + dir for dir in host_include_dirs(cc)]
+    cmd += ["-I" + os.path.join(root_dir, "include"), "-I" + os.path.join(root_dir, "src")]
+    cmd += ["-o", out, os.path.join(test_dir, name + ".c"), "-lm"]
+    return subprocess.run(cmd).returncode == 0
+
+
+def main() -> None:
+    parser = ArgumentParser(description="Build and run the host tests")
+    parser.add_argument("tests", nargs="*", help="tests to run (default: all)")
+    parser.add_argument("--cc", default="cc", help="host C compiler")
+    parser.add_argument("--version", type=int, default=0, help="game version to build")
+    parser.add_argument("-v", "--verbose", action="store_true", help="show the game's OSReport output")
+    args = parser.parse_args()
+
+    tests = args.tests or sorted(
+        name[:-2] for name in os.listdir(test_dir) if name.endswith(".c")
+    )
+    env = dict(os.environ)
+    if args.verbose:
+        env["HOST_VERBOSE"] = "1"
+    failed = []
+    with tempfile.TemporaryDirectory() as out_dir:
+        for name in tests:
+            out = os.path.join(out_dir, name)
+            if not build(args.cc, args.version, name, out):
+                print("%s: build failed" % name)
+                failed.append(name)
+                continue
+            if subprocess.run([out], env=env).returncode != 0:
+                failed.append(name)
+    if failed:
+        print("Failed: %s" % " ".join(failed))
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,426 @@
+//ARAM allocator in armem.c, run on a byte array standing in for ARAM
+//Mixed allocations and frees are churned through it with compaction between rounds, checking contents,
+//directory lookups and the block list, then the failures are compared with the list allocator it replaced
+
+#include "host.h"
+#include "game/armem.c"
+
+#define HOST_ARAM_SIZE 0x1000000
+#define HOST_ROUND_NUM 3000
+#define HOST_COMPACT_STEP 50
+#define HOST_LIVE_MAX 1024
+
+typedef struct host_live {
+    u32 handle;
+    u32 size;
+    u16 dir;
+} HostLive;
+
+static u8 HostARAM[HOST_ARAM_SIZE];
+static u8 *HostMemPtr;
+static s32 HostMemNum;
+static HostLive HostLiveData[HOST_LIVE_MAX];
+static s32 HostLiveNum;
+static s32 HostReclaimNum;
+static u32 HostSeed = 12345;
+
+u32 DirDataSize;
+
+BOOL ARCheckInit(void) { return TRUE; }
+u32 ARInit(u32 *stack_index_addr, u32 num_entries) { return 0; }
+void ARQInit(void) {}
+void DCInvalidateRange(void *addr, u32 nBytes) {}
+void DCFlushRangeNoSync(void *addr, u32 nBytes) {}
+void PPCSync(void) {}
+void HuDataDirClose(s32 data_id) {}
+DataReadStat *HuDataDirRead(s32 data_id) { return NULL; }
+DataReadStat *HuDataDirSet(void *dir_ptr, s32 data_id) { return NULL; }
+DataReadStat *HuDataGetStatus(void *dir_ptr) { return NULL; }
+void *HuDataGetDirPtr(s32 data_id) { return NULL; }
+s32 HuDataReadChk(s32 data_id) { return -1; }
+s32 HuMemMemorySizeGet(void *ptr) { return 0; }
+void HuDecodeStreamBegin(DecodeStream *stream, void *dst, u32 size, s32 decode_type) {}
+BOOL HuDecodeStreamFeed(DecodeStream *stream, void *src, u32 len) { return TRUE; }
+void HuDecodeStreamEnd(DecodeStream *stream) {}
+
+u32 ARGetSize(void)
+{
+    return HOST_ARAM_SIZE;
+}
+
+//Transfers land at once, so every fence is complete by the time it is checked
+void ARQPostRequest(ARQRequest *task, u32 owner, u32 type, u32 priority, u32 source, u32 dest, u32 length, ARQCallback callback)
+{
+    if(type == ARQ_TYPE_MRAM_TO_ARAM) {
+        memcpy(&HostARAM[dest], (void *)(uintptr_t)source, length);
+    } else {
+        memcpy((void *)(uintptr_t)dest, &HostARAM[source], length);
+    }
+    callback((u32)(uintptr_t)task);
+}
+
+void *HuMemDirectMalloc(HeapID heap, s32 size)
+{
+    void *ptr;
+    if(!HostMemPtr) {
+        HostMemPtr = HostMemAlloc(0x8000000);
+    }
+    ptr = HostMemPtr;
+    HostMemPtr += OSRoundUp32B(size);
+    HostMemNum++;
+    return ptr;
+}
+
+void *HuMemDirectMallocNum(HeapID heap, s32 size, u32 num)
+{
+    return HuMemDirectMalloc(heap, size);
+}
+
+void HuMemDirectFree(void *ptr)
+{
+    if(ptr) {
+        HostMemNum--;
+    }
+}
+
+static u32 HostRand(void)
+{
+    HostSeed = HostSeed*1103515245+12345;
+    return HostSeed >> 8;
+}
+
+//Old list allocator, kept to count the failures it had
+static ARMemBlock RefARInfo[64];
+
+static void RefARInit(void)
+{
+    s16 i;
+    for(i=0; i<64; i++) {
+        RefARInfo[i].amemptr = 0;
+    }
+    RefARInfo[0].amemptr = ARBase;
+    RefARInfo[0].size = ARSize;
+    RefARInfo[0].flag = 0;
+    RefARInfo[0].next = &RefARInfo[1];
+    RefARInfo[1].amemptr = -1;
+    RefARInfo[1].size = 0;
+    RefARInfo[1].flag = 1;
+    RefARInfo[1].next = NULL;
+}
+
+static u32 RefARMalloc(u32 size)
+{
+    ARMemBlock *curr, *next;
+    s16 i;
+    curr = RefARInfo;
+    while(curr->next) {
+        if(curr->flag == 0 && curr->size >= size) {
+            break;
+        }
+        curr = curr->next;
+    }
+    if(!curr->next) {
+        return 0;
+    }
+    curr->flag = 1;
+    if(curr->size != size || curr == RefARInfo) {
+        next = &RefARInfo[1];
+        for(i=0; i<63; i++, next++) {
+            if(!next->amemptr) {
+                break;
+            }
+        }
+        if(i == 63) {
+            return 0;
+        }
+        next->next = curr->next;
+        curr->next = next;
+        next->size = curr->size-size;
+        next->amemptr = curr->amemptr+size;
+        curr->size = size;
+        next->flag = 0;
+    }
+    return curr->amemptr;
+}
+
+static void RefARFree(u32 amemptr)
+{
+    ARMemBlock *prev, *next, *curr;
+    curr = prev = RefARInfo;
+    while(curr->next) {
+        if(curr->amemptr == amemptr) {
+            break;
+        }
+        prev = curr;
+        curr = curr->next;
+    }
+    if(curr->flag == 0 || (!curr->next && curr->amemptr != amemptr)) {
+        return;
+    }
+    next = curr->next;
+    if(next->next && next->flag == 0) {
+        curr->size += next->size;
+        curr->next = next->next;
+        next->amemptr = 0;
+    }
+    if(prev != curr && prev->next && prev->flag == 0) {
+        prev->size += curr->size;
+        prev->next = curr->next;
+        curr->amemptr = 0;
+    }
+    curr->flag = 0;
+}
+
+static u32 HostSizeGet(void)
+{
+    u32 size = (HostRand()%4 == 0) ? 0x80000+HostRand()%0x180000 : 0x4000+HostRand()%0x3C000;
+    return OSRoundUp32B(size);
+}
+
+//Blocks tile ARAM above ARBase in order, free neighbours are merged, and every free block is in the bin for its size
+static BOOL HostARChk(void)
+{
+    ARMemBlock *block;
+    ARMemBlock *prev = NULL;
+    u32 addr = ARBase;
+    u32 free_size = 0;
+    s32 free_num = 0;
+    s32 bin_num = 0;
+    s32 i;
+    for(block = ARFirst; block; prev = block, block = block->next) {
+        if(block->prev != prev || block->amemptr != addr || block->size == 0) {
+            return FALSE;
+        }
+        if(block->flag == 0) {
+            if(prev && prev->flag == 0) {
+                return FALSE;
+            }
+            free_size += block->size;
+            free_num++;
+        } else if(block->dir != AR_DIR_NONE && HuARDirGet(block->dir << 16) != block) {
+            return FALSE;
+        }
+        addr += block->size;
+    }
+    if(addr != ARBase+ARSize || free_size != ARFreeSize) {
+        return FALSE;
+    }
+    for(i=0; i<AR_BIN_MAX; i++) {
+        if(!ARBin[i] != !(ARBinMask & (1 << i))) {
+            return FALSE;
+        }
+        for(block = ARBin[i]; block; block = block->link_next) {
+            if(block->flag != 0 || HuARBinNo(block->size) != i) {
+                return FALSE;
+            }
+            bin_num++;
+        }
+    }
+    return bin_num == free_num;
+}
+
+static s32 HostARFreeNum(void)
+{
+    ARMemBlock *block;
+    s32 num = 0;
+    for(block = ARFirst; block; block = block->next) {
+        if(block->flag == 0) {
+            num++;
+        }
+    }
+    return num;
+}
+
+static u8 HostLiveByte(HostLive *live, u32 ofs)
+{
+    return live->dir*31+(ofs >> 5);
+}
+
+static BOOL HostLiveChk(HostLive *live)
+{
+    ARMemBlock *block = HuARInfoGet(live->handle);
+    u32 ofs;
+    if(!block || block->size != live->size || HuARDirCheck(live->dir << 16) != live->handle) {
+        return FALSE;
+    }
+    for(ofs=0; ofs<live->size; ofs += 32) {
+        if(HostARAM[block->amemptr+ofs] != HostLiveByte(live, ofs)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+//Returns the number of allocations that failed while enough ARAM was free in total
+static s32 HostChurn(BOOL ref)
+{
+    HostLive *live;
+    ARMemBlock *block;
+    u32 size, handle, used;
+    s32 round, i, num, frag_num;
+    u16 dir = 0;
+    HostSeed = 12345;
+    HostLiveNum = 0;
+    used = 0;
+    frag_num = 0;
+    for(round=0; round<HOST_ROUND_NUM; round++) {
+        for(i=0; i<HostLiveNum;) {
+            if(HostRand()%100 < 45) {
+                live = &HostLiveData[i];
+                if(ref) {
+                    RefARFree(live->handle);
+                } else {
+                    HOST_CHECK(HostLiveChk(live));
+                    HuARFree(live->handle);
+                    HOST_CHECK(HuARInfoGet(live->handle) == NULL);
+                    HOST_CHECK(HuARDirCheck(live->dir << 16) == 0);
+                }
+                used -= live->size;
+                *live = HostLiveData[--HostLiveNum];
+            } else {
+                i++;
+            }
+        }
+        for(num=1+HostRand()%12; num; num--) {
+            size = HostSizeGet();
+            handle = (ref) ? RefARMalloc(size) : HuARMalloc(size);
+            if(!handle) {
+                if(ARSize-used >= size) {
+                    frag_num++;
+                }
+                continue;
+            }
+            live = &HostLiveData[HostLiveNum++];
+            live->handle = handle;
+            live->size = size;
+            live->dir = dir++ & 0x7FFF;
+            used += size;
+            if(ref) {
+                continue;
+            }
+            block = HuARInfoGet(handle);
+            HuARDirSet(block, live->dir);
+            for(i=0; i<size; i += 32) {
+                HostARAM[block->amemptr+i] = HostLiveByte(live, i);
+            }
+        }
+        if(ref) {
+            continue;
+        }
+        HOST_CHECK(ARFreeSize == ARSize-used);
+        if(round%HOST_COMPACT_STEP == HOST_COMPACT_STEP-1) {
+            HuARCompact();
+            HOST_CHECK(HostARFreeNum() <= 1);
+        }
+        HOST_CHECK(HostARChk());
+        for(i=0; i<HostLiveNum; i++) {
+            HOST_CHECK(HostLiveChk(&HostLiveData[i]));
+        }
+    }
+    for(i=0; i<HostLiveNum; i++) {
+        if(ref) {
+            RefARFree(HostLiveData[i].handle);
+        } else {
+            HuARFree(HostLiveData[i].handle);
+        }
+    }
+    return frag_num;
+}
+
+static void HostChurnTest(void)
+{
+    s32 ref_num, num;
+    RefARInit();
+    ref_num = HostChurn(TRUE);
+    num = HostChurn(FALSE);
+    //Everything merged back into one free block
+    HOST_CHECK(HostARChk());
+    HOST_CHECK(ARFirst->flag == 0 && !ARFirst->next && ARFreeSize == ARSize);
+    HOST_CHECK(num < ref_num);
+    printf("armem %d rounds: failed with enough ARAM free, list %d, bins %d\n", HOST_ROUND_NUM, ref_num, num);
+}
+
+//Descriptors beyond the static 64 come from HEAP_SYSTEM and are given back by the next HuARInit
+static void HostPoolTest(void)
+{
+    static u32 handle[300];
+    s32 mem_num = HostMemNum;
+    s32 i;
+    for(i=0; i<300; i++) {
+        handle[i] = HuARMalloc(0x100);
+        HOST_CHECK(handle[i] != 0);
+    }
+    HOST_CHECK(HostMemNum > mem_num);
+    HOST_CHECK(HostARChk());
+    for(i=0; i<300; i += 2) {
+        HuARFree(handle[i]);
+    }
+    HOST_CHECK(HostARChk());
+    HOST_CHECK(HuARInfoGet(handle[0]) == NULL && HuARInfoGet(handle[1]) != NULL);
+    HuARInit();
+    HOST_CHECK(HostMemNum == mem_num);
+    HOST_CHECK(HostARChk() && ARFreeSize == ARSize);
+}
+
+//The smallest hole that fits is used, and a freed handle stays dead when its descriptor is reused
+static void HostFitTest(void)
+{
+    u32 handle[4];
+    u32 addr;
+    u32 old;
+    handle[0] = HuARMalloc(0x3000);
+    handle[1] = HuARMalloc(0x100);
+    handle[2] = HuARMalloc(0x2800);
+    handle[3] = HuARMalloc(0x100);
+    addr = HuARInfoGet(handle[2])->amemptr;
+    HuARFree(handle[2]);
+    HuARFree(handle[0]);
+    handle[0] = HuARMalloc(0x2000);
+    HOST_CHECK(HuARInfoGet(handle[0])->amemptr == addr);
+    HOST_CHECK(HostARChk());
+    HuARInit();
+    old = HuARMalloc(0x100);
+    HuARFree(old);
+    handle[0] = HuARMalloc(0x100);
+    HOST_CHECK(handle[0] != old && HuARInfoGet(old) == NULL);
+    HuARInit();
+}
+
+//Gives back the oldest block, which on a full ARAM is the lowest one
+static BOOL HostReclaim(void)
+{
+    if(HostReclaimNum == HostLiveNum) {
+        return FALSE;
+    }
+    HuARFree(HostLiveData[HostReclaimNum++].handle);
+    return TRUE;
+}
+
+//A full ARAM gives space back through the reclaim function before an allocation fails
+static void HostReclaimTest(void)
+{
+    u32 handle;
+    HostLiveNum = 0;
+    while((handle = HuARMalloc(0x100000)) != 0) {
+        HostLiveData[HostLiveNum++].handle = handle;
+    }
+    HOST_CHECK(HostLiveNum == ARSize/0x100000);
+    HuARReclaimSet(HostReclaim);
+    //One freed block is too small, the second merges with it
+    handle = HuARMalloc(0x180000);
+    HOST_CHECK(handle != 0 && HostReclaimNum == 2);
+    HuARFree(handle);
+    HOST_CHECK(HuARMalloc(ARSize+32) == 0 && HostReclaimNum == HostLiveNum);
+    HuARReclaimSet(NULL);
+    HOST_CHECK(HostARChk() && ARFreeSize == ARSize);
+}
+
+int main(void)
+{
+    HuARInit();
+    HostChurnTest();
+    HostPoolTest();
+    HostFitTest();
+    HostReclaimTest();
+    return HostEnd("armem");
+}
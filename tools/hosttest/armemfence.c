@@ -0,0 +1,466 @@
+//ARAM transfer batches and fences in armem.c, run against a model of ARQ driven by a timer signal
+//Each tick moves one 4KB chunk, high priority requests first, and calls back from the signal as the ARQ
+//interrupt would; the signal is held off while the game has interrupts disabled
+
+#include "host.h"
+#include <signal.h>
+#include <sys/time.h>
+#include "game/armem.c"
+#include "game/decode.c"
+
+#define HOST_ARAM_SIZE 0x1000000
+#define HOST_CHUNK 0x1000
+#define HOST_TICK_US 20
+#define HOST_QUE_MAX 64
+#define HOST_DIR_MAX 256
+
+typedef struct host_mem_block {
+    HeapID heap;
+    s32 size;
+    u32 pad[6];
+} HostMemBlock;
+
+typedef struct host_arq {
+    ARQRequest *task;
+    u32 type;
+    u32 src;
+    u32 dst;
+    u32 len;
+    u32 ofs;
+    ARQCallback callback;
+} HostARQ;
+
+static u8 HostARAM[HOST_ARAM_SIZE];
+static u8 *HostMemPtr;
+static HostARQ HostQue[2][HOST_QUE_MAX];
+static volatile s32 HostQueHead[2];
+static volatile s32 HostQueTail[2];
+
+static void *HostDirPtr[HOST_DIR_MAX];
+static s32 HostDirSetNum[HOST_DIR_MAX];
+static s32 HostDirSetIrqNum;
+static DataReadStat HostDirStat;
+
+u32 DirDataSize;
+
+BOOL ARCheckInit(void) { return TRUE; }
+u32 ARInit(u32 *stack_index_addr, u32 num_entries) { return 0; }
+void ARQInit(void) {}
+void DCInvalidateRange(void *addr, u32 nBytes) {}
+void DCFlushRangeNoSync(void *addr, u32 nBytes) {}
+void DCFlushRange(void *addr, u32 nBytes) {}
+void PPCSync(void) {}
+void HuDataDirClose(s32 data_id) {}
+DataReadStat *HuDataDirRead(s32 data_id) { return NULL; }
+
+u32 ARGetSize(void)
+{
+    return HOST_ARAM_SIZE;
+}
+
+void *HuMemDirectMalloc(HeapID heap, s32 size)
+{
+    HostMemBlock *block;
+    if(!HostMemPtr) {
+        HostMemPtr = HostMemAlloc(0x2000000);
+    }
+    size = OSRoundUp32B(size);
+    block = (HostMemBlock *)HostMemPtr;
+    HostMemPtr += sizeof(HostMemBlock)+size;
+    block->heap = heap;
+    block->size = size;
+    return block+1;
+}
+
+void *HuMemDirectMallocNum(HeapID heap, s32 size, u32 num)
+{
+    return HuMemDirectMalloc(heap, size);
+}
+
+void HuMemDirectFree(void *ptr) {}
+
+s32 HuMemMemorySizeGet(void *ptr)
+{
+    return ((HostMemBlock *)ptr-1)->size;
+}
+
+s32 HuDataReadChk(s32 data_id)
+{
+    return HostDirPtr[data_id >> 16] ? 0 : -1;
+}
+
+void *HuDataGetDirPtr(s32 data_id)
+{
+    return HostDirPtr[data_id >> 16];
+}
+
+DataReadStat *HuDataGetStatus(void *dir_ptr)
+{
+    s32 i;
+    for(i=0; i<HOST_DIR_MAX; i++) {
+        if(HostDirPtr[i] == dir_ptr) {
+            HostDirStat.dir_id = i;
+            HostDirStat.dir = dir_ptr;
+            return &HostDirStat;
+        }
+    }
+    return NULL;
+}
+
+//Registration takes data slots, which must never happen inside the ARQ interrupt
+DataReadStat *HuDataDirSet(void *dir_ptr, s32 data_id)
+{
+    if(HostIrqLevel) {
+        HostDirSetIrqNum++;
+    }
+    HostDirPtr[data_id >> 16] = dir_ptr;
+    HostDirSetNum[data_id >> 16]++;
+    return NULL;
+}
+
+void ARQPostRequest(ARQRequest *task, u32 owner, u32 type, u32 priority, u32 source, u32 dest, u32 length, ARQCallback callback)
+{
+    HostARQ *arq;
+    BOOL enabled = OSDisableInterrupts();
+    HOST_CHECK(HostQueTail[priority]-HostQueHead[priority] < HOST_QUE_MAX);
+    arq = &HostQue[priority][HostQueTail[priority]%HOST_QUE_MAX];
+    arq->task = task;
+    arq->type = type;
+    arq->src = source;
+    arq->dst = dest;
+    arq->len = length;
+    arq->ofs = 0;
+    arq->callback = callback;
+    HostQueTail[priority]++;
+    OSRestoreInterrupts(enabled);
+}
+
+//A tick that lands while the game has interrupts disabled is lost, the next one comes soon after
+static void HostARQTick(int sig)
+{
+    HostARQ *arq;
+    u32 prio, len;
+    if(HostIrqLevel) {
+        return;
+    }
+    if(HostQueHead[ARQ_PRIORITY_HIGH] != HostQueTail[ARQ_PRIORITY_HIGH]) {
+        prio = ARQ_PRIORITY_HIGH;
+    } else if(HostQueHead[ARQ_PRIORITY_LOW] != HostQueTail[ARQ_PRIORITY_LOW]) {
+        prio = ARQ_PRIORITY_LOW;
+    } else {
+        return;
+    }
+    HostIrqLevel++;
+    arq = &HostQue[prio][HostQueHead[prio]%HOST_QUE_MAX];
+    len = arq->len-arq->ofs;
+    if(len > HOST_CHUNK) {
+        len = HOST_CHUNK;
+    }
+    if(arq->type == ARQ_TYPE_MRAM_TO_ARAM) {
+        memcpy(&HostARAM[arq->dst+arq->ofs], (u8 *)(uintptr_t)arq->src+arq->ofs, len);
+    } else {
+        memcpy((u8 *)(uintptr_t)arq->dst+arq->ofs, &HostARAM[arq->src+arq->ofs], len);
+    }
+    arq->ofs += len;
+    if(arq->ofs == arq->len) {
+        HostQueHead[prio]++;
+        arq->callback((u32)(uintptr_t)arq->task);
+    }
+    HostIrqLevel--;
+}
+
+static void HostARQStart(void)
+{
+    struct sigaction action;
+    struct itimerval timer;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = HostARQTick;
+    sigaction(SIGALRM, &action, NULL);
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = HOST_TICK_US;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+static void HostARQStop(void)
+{
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+static u8 HostDirByte(s32 dir, u32 ofs)
+{
+    return dir*31+(ofs >> 5);
+}
+
+//Puts a directory in ARAM only, as if an earlier overlay had pushed it
+static void HostDirMake(s32 dir, u32 size)
+{
+    ARMemBlock *block = HuARInfoGet(HuARMalloc(size));
+    u32 i;
+    HuARDirSet(block, dir);
+    for(i=0; i<size; i++) {
+        HostARAM[block->amemptr+i] = HostDirByte(dir, i);
+    }
+    HostDirPtr[dir] = NULL;
+    HostDirSetNum[dir] = 0;
+}
+
+static BOOL HostDirChk(s32 dir, u32 size)
+{
+    u8 *ptr = HostDirPtr[dir];
+    u32 i;
+    if(!ptr) {
+        return FALSE;
+    }
+    for(i=0; i<size; i++) {
+        if(ptr[i] != HostDirByte(dir, i)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+//A small high priority pull is not held up by a large low priority batch posted first
+static void HostPrioTest(void)
+{
+    s32 big[8];
+    s32 small = 20 << 16;
+    u32 big_fence, small_fence;
+    s32 i;
+    for(i=0; i<8; i++) {
+        HostDirMake(1+i, 0x80000);
+        big[i] = (1+i) << 16;
+    }
+    HostDirMake(20, 0x8000);
+    big_fence = HuAR_ARAMtoMRAMList(big, 8, 0, ARQ_PRIORITY_LOW);
+    small_fence = HuAR_ARAMtoMRAMList(&small, 1, 0, ARQ_PRIORITY_HIGH);
+    HuARFenceWait(small_fence);
+    HOST_CHECK(!HuARFenceCheck(big_fence));
+    HOST_CHECK(HostDirChk(20, 0x8000) && HostDirSetNum[20] == 1);
+    HuARFenceWait(big_fence);
+    for(i=0; i<8; i++) {
+        HOST_CHECK(HostDirChk(1+i, 0x80000) && HostDirSetNum[1+i] == 1);
+    }
+    //Everything asked for is already in main memory, so nothing is queued
+    HOST_CHECK(HuARFenceCheck(HuAR_ARAMtoMRAMList(big, 8, 0, ARQ_PRIORITY_LOW)));
+    HOST_CHECK(HuARDMACheck() == 0);
+}
+
+//A batch larger than the request pool waits for slots to come back instead of reusing busy ones
+static void HostSlotTest(void)
+{
+    s32 dirs[40];
+    s32 i;
+    for(i=0; i<40; i++) {
+        HostDirMake(100+i, 0x4000);
+        dirs[i] = (100+i) << 16;
+    }
+    HuARFenceWait(HuAR_ARAMtoMRAMList(dirs, 40, 0, ARQ_PRIORITY_LOW));
+    for(i=0; i<40; i++) {
+        HOST_CHECK(HostDirChk(100+i, 0x4000) && HostDirSetNum[100+i] == 1);
+    }
+}
+
+//A directory already being pulled is waited for rather than pulled twice
+static void HostDupTest(void)
+{
+    s32 dir = 200 << 16;
+    HostDirMake(200, 0x40000);
+    HuAR_ARAMtoMRAM(HuARDirCheck(dir));
+    HuARFenceWait(HuAR_ARAMtoMRAMList(&dir, 1, 0, ARQ_PRIORITY_HIGH));
+    HOST_CHECK(HostDirChk(200, 0x40000));
+    while(HuARDMACheck());
+    HOST_CHECK(HostDirSetNum[200] == 1);
+}
+
+//Directories in main memory go up to ARAM as one batch
+static void HostPushTest(void)
+{
+    s32 dirs[3];
+    ARMemBlock *block;
+    u8 *ptr;
+    s32 i;
+    u32 j;
+    for(i=0; i<3; i++) {
+        dirs[i] = (210+i) << 16;
+        ptr = HuMemDirectMalloc(HEAP_DATA, 0x6000);
+        for(j=0; j<0x6000; j++) {
+            ptr[j] = HostDirByte(210+i, j);
+        }
+        HostDirPtr[210+i] = ptr;
+    }
+    HuARFenceWait(HuAR_MRAMtoARAMList(dirs, 3, ARQ_PRIORITY_LOW));
+    for(i=0; i<3; i++) {
+        block = HuARDirGet(dirs[i]);
+        HOST_CHECK(block && memcmp(&HostARAM[block->amemptr], HostDirPtr[210+i], 0x6000) == 0);
+    }
+}
+
+static void HostRangeTest(void)
+{
+    static u8 ATTRIBUTE_ALIGN(32) src[0x2000];
+    static u8 ATTRIBUTE_ALIGN(32) dst[0x2000];
+    ARDMARange range;
+    u32 handle = HuARMalloc(0x4000);
+    s32 i;
+    for(i=0; i<0x2000; i++) {
+        src[i] = i*7;
+    }
+    range.amemptr = handle;
+    range.ofs = 0x1000;
+    range.mram = src;
+    range.size = 0x2000;
+    HuARFenceWait(HuARDMAWrite(&range, 1, ARQ_PRIORITY_LOW));
+    range.mram = dst;
+    HuARFenceWait(HuARDMARead(&range, 1, ARQ_PRIORITY_HIGH));
+    HOST_CHECK(memcmp(src, dst, 0x2000) == 0);
+    //A range past the end of its block is refused and its fence has nothing to wait for
+    range.ofs = 0x3000;
+    HOST_CHECK(HuARFenceCheck(HuARDMARead(&range, 1, ARQ_PRIORITY_LOW)));
+    HuARFree(handle);
+}
+
+//Recycled fences read as complete, however many times their slot has been reused
+static void HostFenceTest(void)
+{
+    u8 *buf = HuMemDirectMalloc(HEAP_DVD, 0x4000);
+    u32 base = HuARMalloc(0x4000);
+    u32 fence;
+    u32 old;
+    s32 i;
+    HOST_CHECK(HuARFenceCheck(0) && HuARFenceCheck(0x11) && HuARFenceCheck(0xFF));
+    old = HuARDMAPost(ARQ_TYPE_MRAM_TO_ARAM, ARQ_PRIORITY_LOW, (u32)(uintptr_t)buf, HuARInfoGet(base)->amemptr, 32);
+    HuARFenceWait(old);
+    //Checked while the transfer that may have taken its slot is still in flight
+    for(i=0; i<AR_FENCE_MAX*300; i++) {
+        fence = HuARDMAPost(ARQ_TYPE_MRAM_TO_ARAM, ARQ_PRIORITY_LOW, (u32)(uintptr_t)buf, HuARInfoGet(base)->amemptr, 0x4000);
+        HOST_CHECK(HuARFenceCheck(old));
+        HuARFenceWait(fence);
+    }
+    HuARFree(base);
+}
+
+//Pulls that landed but were never reaped keep their fences counted; with every fence taken
+//that way, opening another one reaps them instead of waiting on them forever
+static void HostReapTest(void)
+{
+    s32 dirs[AR_FENCE_MAX+1];
+    s32 busy_num;
+    s32 i;
+    while(HuARDMACheck());
+    for(i=0; i<AR_FENCE_MAX+1; i++) {
+        HostDirMake(230+i, 0x1000);
+        dirs[i] = (230+i) << 16;
+    }
+    //Held off so none of them lands, and so none is reaped, until all are posted
+    HostIrqLevel++;
+    for(i=0; i<AR_FENCE_MAX; i++) {
+        HuAR_ARAMtoMRAMList(&dirs[i], 1, 0, ARQ_PRIORITY_LOW);
+    }
+    HostIrqLevel--;
+    while(HostQueHead[ARQ_PRIORITY_LOW] != HostQueTail[ARQ_PRIORITY_LOW]);
+    for(busy_num=0, i=0; i<AR_FENCE_MAX; i++) {
+        if(ARFenceTbl[i].cnt) {
+            busy_num++;
+        }
+    }
+    HOST_CHECK(busy_num == AR_FENCE_MAX);
+    HuARFenceWait(HuAR_ARAMtoMRAMList(&dirs[AR_FENCE_MAX], 1, 0, ARQ_PRIORITY_LOW));
+    for(i=0; i<AR_FENCE_MAX+1; i++) {
+        HOST_CHECK(HostDirChk(230+i, 0x1000) && HostDirSetNum[230+i] == 1);
+    }
+}
+
+static u8 HostFileByte(s32 file, u32 ofs)
+{
+    return (ofs/100)%3 ? file*7+ofs : file+ofs/100;
+}
+
+//Runs of a repeated byte and literal stretches, as the pattern above is made of
+static u32 HostRleMake(u8 *dst, s32 file, u32 size)
+{
+    u8 *ptr = dst;
+    u32 ofs, len, i;
+    for(ofs=0; ofs<size; ofs += len) {
+        len = 100-ofs%100;
+        if(len > size-ofs) {
+            len = size-ofs;
+        }
+        if((ofs/100)%3) {
+            len = (len > 60) ? 60 : len;
+            *ptr++ = 128+len;
+            for(i=0; i<len; i++) {
+                *ptr++ = HostFileByte(file, ofs+i);
+            }
+        } else {
+            *ptr++ = len;
+            *ptr++ = HostFileByte(file, ofs);
+        }
+    }
+    return ptr-dst;
+}
+
+//Files read straight out of ARAM are pulled and decoded a chunk at a time; sizes around the chunk
+//size and a file starting off a 32 byte boundary cover where one chunk ends and the next begins
+static void HostFileReadTest(void)
+{
+    static u32 raw_size[] = { 0x40, 0x9000, AR_STREAM_CHUNK-0x30, 0x20000, 0x300 };
+    static u8 dir[0x40000];
+    s32 *dir_hdr = (s32 *)dir;
+    s32 file_num = sizeof(raw_size)/sizeof(raw_size[0]);
+    ARMemBlock *block;
+    u8 *buf;
+    u32 ofs;
+    u32 i;
+    s32 file;
+    dir_hdr[0] = file_num;
+    ofs = OSRoundUp32B((file_num+1)*4)+0x14;
+    for(file=0; file<file_num; file++) {
+        dir_hdr[file+1] = ofs;
+        ((s32 *)&dir[ofs])[0] = raw_size[file];
+        if(file == 1) {
+            ((s32 *)&dir[ofs])[1] = DATA_DECODE_NONE;
+            for(i=0; i<raw_size[file]; i++) {
+                dir[ofs+8+i] = HostFileByte(file, i);
+            }
+            ofs += 8+raw_size[file]+3;
+        } else {
+            ((s32 *)&dir[ofs])[1] = DATA_DECODE_RLE;
+            ofs += 8+HostRleMake(&dir[ofs+8], file, raw_size[file])+1;
+        }
+    }
+    block = HuARInfoGet(HuARMalloc(OSRoundUp32B(ofs)));
+    HuARDirSet(block, 250);
+    memcpy(&HostARAM[block->amemptr], dir, ofs);
+    for(file=0; file<file_num; file++) {
+        buf = HuAR_ARAMtoMRAMFileRead((250 << 16)|file, 0, HEAP_DATA);
+        HOST_CHECK(buf != NULL);
+        for(i=0; i<raw_size[file]; i++) {
+            if(buf[i] != HostFileByte(file, i)) {
+                break;
+            }
+        }
+        HOST_CHECK(i == raw_size[file]);
+    }
+}
+
+int main(void)
+{
+    HuARInit();
+    HostARQStart();
+    HostPrioTest();
+    HostSlotTest();
+    HostDupTest();
+    HostPushTest();
+    HostRangeTest();
+    HostFenceTest();
+    HostReapTest();
+    HostFileReadTest();
+    while(HuARDMACheck());
+    HostARQStop();
+    HOST_CHECK(HostDirSetIrqNum == 0);
+    HOST_CHECK(arqCnt == 0 && HostIrqLevel == 0);
+    return HostEnd("armemfence");
+}
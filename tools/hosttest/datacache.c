@@ -0,0 +1,543 @@
+//Directory cache in data.c, on top of the real dvd.c and a stand-in drive that serves generated directories
+//Fills the cache past its slot count and checks that eviction never takes a directory a caller can
+//still be holding, whether by pointer, by async status or in the middle of a batch read
+//Blocking reads from a process sleep, are shared with other processes asking meanwhile, and survive a kill
+
+#include "host.h"
+//data.h declares HuDataDirReadNum though data.c keeps it static, which gcc refuses
+#define HuDataDirReadNum HostDataDirReadNumDecl
+#include "game/data.h"
+#undef HuDataDirReadNum
+#include "game/dvd.c"
+#include "game/data.c"
+
+#define HOST_DIR_FILES 4
+#define HOST_FILE_SIZE 0x100
+#define HOST_DIR_SIZE (4+HOST_DIR_FILES*4+HOST_DIR_FILES*(8+HOST_FILE_SIZE))
+#define HOST_ENTRY_MAX 256
+
+typedef struct host_mem_block {
+    HeapID heap;
+    s32 size;
+    BOOL freed;
+    u32 pad[5];
+} HostMemBlock;
+
+typedef struct host_cmd {
+    DVDFileInfo *file;
+    u8 *buf;
+    u32 len;
+    u32 ofs;
+    DVDCallback callback;
+} HostCmd;
+
+static u8 *HostMemPtr;
+static s32 HostMemNum;
+static s32 HostEntryNum;
+
+static HostCmd HostCmdQueue[DVD_REQ_MAX];
+static s32 HostCmdNum;
+static s32 HostReadNum[HOST_ENTRY_MAX];
+static s32 HostOpenNum;
+
+static Process HostPrc;
+static Process *HostPrcCur;
+static BOOL HostPrcKilled;
+static s32 HostPrcSleepNum;
+static s32 HostPrcKillSleep;
+//Runs as another process on the first frame the current one sleeps
+static void (*HostPrcOther)(void);
+static void *HostPrcEndJump[5];
+
+//Directories that armem.c would report as being in ARAM, and are registered when their fence is waited on
+static BOOL HostARAMDir[HOST_ENTRY_MAX];
+static s32 HostARAMList[HOST_ENTRY_MAX];
+static s32 HostARAMNum;
+
+void *HuMemDirectMalloc(HeapID heap, s32 size)
+{
+    HostMemBlock *block;
+    if(!HostMemPtr) {
+        HostMemPtr = HostMemAlloc(0x4000000);
+    }
+    size = OSRoundUp32B(size);
+    block = (HostMemBlock *)HostMemPtr;
+    HostMemPtr += sizeof(HostMemBlock)+size;
+    block->heap = heap;
+    block->size = size;
+    block->freed = FALSE;
+    HostMemNum++;
+    return block+1;
+}
+
+void *HuMemDirectMallocNum(HeapID heap, s32 size, u32 num)
+{
+    return HuMemDirectMalloc(heap, size);
+}
+
+void HuMemDirectFree(void *ptr)
+{
+    HostMemBlock *block = (HostMemBlock *)ptr-1;
+    HOST_CHECK(!block->freed);
+    block->freed = TRUE;
+    HostMemNum--;
+}
+
+static BOOL HostMemLive(void *ptr)
+{
+    return ptr && !((HostMemBlock *)ptr-1)->freed;
+}
+
+void HuMemHeapSnapshot(void *heap_ptr, HuMemSnapshot *snap)
+{
+    memset(snap, 0, sizeof(HuMemSnapshot));
+    snap->free_size = snap->free_max = 0x1000000;
+}
+
+void *HuMemHeapPtrGet(HeapID heap) { return NULL; }
+u32 HuMemHeapSizeGet(HeapID heap) { return 0x1000000; }
+s32 HuMemUsedMallocSizeGet(HeapID heap) { return 0; }
+s32 HuMemMemorySizeGet(void *ptr) { return ((HostMemBlock *)ptr-1)->size; }
+void DCInvalidateRange(void *addr, u32 nBytes) {}
+void DCFlushRangeNoSync(void *addr, u32 nBytes) {}
+
+void HuDecodeData(void *src, void *dst, u32 size, s32 decode_type)
+{
+    memcpy(dst, src, size);
+}
+
+void HuDecodeStreamBegin(DecodeStream *stream, void *dst, u32 size, s32 decode_type) {}
+BOOL HuDecodeStreamFeed(DecodeStream *stream, void *src, u32 len) { return TRUE; }
+void HuDecodeStreamEnd(DecodeStream *stream) {}
+s32 DVDGetCommandBlockStatus(const DVDCommandBlock *block) { return 0; }
+
+void OSPanic(const char *file, int line, const char *msg, ...)
+{
+    printf("OSPanic %s:%d %s\n", file, line, msg);
+    exit(2);
+}
+
+s32 DVDConvertPathToEntrynum(char *path)
+{
+    return ++HostEntryNum;
+}
+
+static u8 HostFileByte(u32 entry, u32 file, u32 ofs)
+{
+    return (u8)(entry*31+file*7+ofs);
+}
+
+//A directory of HOST_DIR_FILES raw files, laid out the way GetFileInfo reads them
+static void HostDirMake(u8 *buf, u32 entry)
+{
+    u32 *word = (u32 *)buf;
+    u32 ofs = 4+HOST_DIR_FILES*4;
+    u32 i, j;
+    word[0] = HOST_DIR_FILES;
+    for(i=0; i<HOST_DIR_FILES; i++) {
+        word[1+i] = ofs;
+        ((u32 *)(buf+ofs))[0] = HOST_FILE_SIZE;
+        ((u32 *)(buf+ofs))[1] = DATA_DECODE_NONE;
+        for(j=0; j<HOST_FILE_SIZE; j++) {
+            buf[ofs+8+j] = HostFileByte(entry, i, j);
+        }
+        ofs += 8+HOST_FILE_SIZE;
+    }
+}
+
+static BOOL HostFileChk(void *buf, s32 data_num)
+{
+    u32 entry = DataDirStat[data_num >> 16].file_id;
+    u32 file = data_num & 0xFFFF;
+    u32 i;
+    if(!buf) {
+        return FALSE;
+    }
+    for(i=0; i<HOST_FILE_SIZE; i++) {
+        if(((u8 *)buf)[i] != HostFileByte(entry, file, i)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+//Every queued command lands at once, calling back as the DVD interrupt would
+static void HostDriveRun(void)
+{
+    static u8 dir[HOST_DIR_SIZE];
+    HostCmd cmd;
+    while(HostCmdNum) {
+        cmd = HostCmdQueue[0];
+        memmove(&HostCmdQueue[0], &HostCmdQueue[1], --HostCmdNum*sizeof(HostCmd));
+        HostDirMake(dir, cmd.file->startAddr);
+        memcpy(cmd.buf, dir+cmd.ofs, cmd.len);
+        HostIrqLevel++;
+        cmd.callback(cmd.len, cmd.file);
+        HostIrqLevel--;
+    }
+}
+
+BOOL DVDReadAsyncPrio(DVDFileInfo *fileInfo, void *addr, s32 length, s32 offset, DVDCallback callback, s32 prio)
+{
+    if(offset == 0) {
+        HostReadNum[fileInfo->startAddr]++;
+    }
+    HostCmdQueue[HostCmdNum].file = fileInfo;
+    HostCmdQueue[HostCmdNum].buf = addr;
+    HostCmdQueue[HostCmdNum].len = length;
+    HostCmdQueue[HostCmdNum].ofs = offset;
+    HostCmdQueue[HostCmdNum].callback = callback;
+    HostCmdNum++;
+    return TRUE;
+}
+
+BOOL DVDFastOpen(s32 entrynum, DVDFileInfo *fileInfo)
+{
+    HostOpenNum++;
+    fileInfo->startAddr = entrynum;
+    fileInfo->length = HOST_DIR_SIZE;
+    return TRUE;
+}
+
+BOOL DVDOpen(char *fileName, DVDFileInfo *fileInfo)
+{
+    s32 i;
+    for(i=0; DataDirStat[i].name; i++) {
+        if(DataDirStat[i].name == fileName) {
+            return DVDFastOpen(DataDirStat[i].file_id, fileInfo);
+        }
+    }
+    return FALSE;
+}
+
+BOOL DVDClose(DVDFileInfo *f)
+{
+    HostOpenNum--;
+    return TRUE;
+}
+
+//Outside a process a spinning wait lands the reads, from a process only a frame going by does
+s32 DVDGetDriveStatus()
+{
+    if(!HostPrcCur) {
+        HostDriveRun();
+    }
+    return DVD_STATE_END;
+}
+
+Process *HuPrcCurrentGet(void)
+{
+    return HostPrcCur;
+}
+
+BOOL HuPrcKillChk(Process *process)
+{
+    return HostPrcKilled;
+}
+
+void HuPrcSetStat(Process *process, u16 value)
+{
+    process->stat |= value;
+}
+
+void HuPrcResetStat(Process *process, u16 value)
+{
+    process->stat &= ~value;
+}
+
+void HuPrcEnd(void)
+{
+    __builtin_longjmp(HostPrcEndJump, 1);
+}
+
+//A killed process is not let back in unless it holds off its kill, as in HuPrcCall
+void HuPrcVSleep(void)
+{
+    void (*other)(void) = HostPrcOther;
+    HostPrcSleepNum++;
+    if(HostPrcSleepNum == HostPrcKillSleep) {
+        HostPrcKilled = TRUE;
+    }
+    if(other) {
+        HostPrcOther = NULL;
+        other();
+    }
+    if(HostPrcKilled && !(HostPrc.stat & PROCESS_STAT_KILL_HOLD)) {
+        HuPrcEnd();
+    }
+    HostDriveRun();
+}
+
+static void HostPrcReset(void)
+{
+    HostPrcCur = NULL;
+    HostPrcKilled = FALSE;
+    HostPrcSleepNum = 0;
+    HostPrcKillSleep = 0;
+    HostPrcOther = NULL;
+    HostPrc.stat = 0;
+}
+
+u32 HuARDirCheck(u32 dir)
+{
+    return HostARAMDir[dir >> 16] ? 0x10000 : 0;
+}
+
+u32 HuAR_ARAMtoMRAMList(s32 *dirs, s32 num, s32 mem_num, u32 prio)
+{
+    s32 i;
+    for(i=0; i<num; i++) {
+        HostARAMList[HostARAMNum++] = dirs[i];
+    }
+    return HostARAMNum ? 1 : 0;
+}
+
+//Lands the batch: each directory is registered through HuDataDirSet, as HuARQueReap does
+void HuARFenceWait(u32 fence)
+{
+    u8 *dir;
+    s32 i;
+    for(i=0; i<HostARAMNum; i++) {
+        dir = HuMemDirectMalloc(HEAP_DVD, HOST_DIR_SIZE);
+        HostDirMake(dir, DataDirStat[HostARAMList[i] >> 16].file_id);
+        HuDataDirSet(dir, HostARAMList[i]);
+    }
+    HostARAMNum = 0;
+}
+
+BOOL HuARFenceCheck(u32 fence)
+{
+    return TRUE;
+}
+
+static s32 HostSlotUsed(void)
+{
+    s32 i, num = 0;
+    for(i=0; i<DATA_MAX_READSTAT; i++) {
+        if(ReadDataStat[i].dir_id >= 0) {
+            num++;
+        }
+    }
+    return num;
+}
+
+//Reads that only copy files out leave their directories to the cache, which reuses the oldest ones
+static void HostEvictTest(void)
+{
+    void *buf;
+    s32 i;
+    for(i=0; i<DataDirMax; i++) {
+        buf = HuDataRead((i << 16)|(i%HOST_DIR_FILES));
+        HOST_CHECK(HostFileChk(buf, (i << 16)|(i%HOST_DIR_FILES)));
+        HuDataClose(buf);
+    }
+    HOST_CHECK(HostSlotUsed() == DATA_MAX_READSTAT);
+    HOST_CHECK(ReadDataCacheStat.evict == DataDirMax-DATA_MAX_READSTAT);
+    HOST_CHECK(HuDataReadChk(0) < 0 && HuDataReadChk((DataDirMax-1) << 16) >= 0);
+}
+
+//Pointers, directories and async statuses handed to a caller outlive any amount of churn
+static void HostHeldTest(void)
+{
+    DataReadStat *read_stat;
+    void *dir_ptr;
+    s32 status;
+    void *async_ptr;
+    void *buf;
+    s32 i, j;
+    dir_ptr = HuDataGetDirPtr((DataDirMax-1) << 16);
+    HOST_CHECK(dir_ptr != NULL);
+    read_stat = HuDataDirRead(1 << 16);
+    HOST_CHECK(read_stat && read_stat->dir);
+    status = HuDataDirReadAsync(2 << 16);
+    HOST_CHECK(status >= 0);
+    HuDataDirReadAsyncWait(2 << 16);
+    HOST_CHECK(HuDataGetAsyncStat(status));
+    async_ptr = ReadDataStat[status].dir;
+    for(j=0; j<4; j++) {
+        for(i=3; i<DataDirMax-1; i++) {
+            buf = HuDataRead(i << 16);
+            HOST_CHECK(HostFileChk(buf, i << 16));
+            HuDataClose(buf);
+        }
+    }
+    HOST_CHECK(HuDataGetDirPtr((DataDirMax-1) << 16) == dir_ptr && HostMemLive(dir_ptr));
+    HOST_CHECK(HuDataReadChk(1 << 16) == read_stat-ReadDataStat && HostMemLive(read_stat->dir));
+    HOST_CHECK(HuDataGetAsyncStat(status));
+    HOST_CHECK(ReadDataStat[status].dir_id == 2 && ReadDataStat[status].dir == async_ptr && HostMemLive(async_ptr));
+    //Closing lets them go
+    HuDataDirClose((DataDirMax-1) << 16);
+    HuDataDirClose(1 << 16);
+    HuDataDirClose(2 << 16);
+    HOST_CHECK(!HostMemLive(dir_ptr) && !HostMemLive(async_ptr));
+}
+
+//A batch read registers its DVD directories before the ARAM ones land, and registering those takes
+//slots of its own; with only four slots left to evict, the DVD directories must still not be read twice
+static void HostMultiTest(void)
+{
+    s32 ids[7];
+    s32 read_num[3];
+    void **bufs;
+    s32 i;
+    HostEntryNum = 0;
+    HuDataInit();
+    for(i=0; i<DATA_MAX_READSTAT; i++) {
+        HuDataClose(HuDataRead(i << 16));
+        if(i >= 4) {
+            HuDataGetDirPtr(i << 16);
+        }
+    }
+    for(i=0; i<3; i++) {
+        ids[i*2] = ((DATA_MAX_READSTAT+i) << 16)|i;
+        ids[i*2+1] = ((DATA_MAX_READSTAT+3+i) << 16)|i;
+        HostARAMDir[DATA_MAX_READSTAT+3+i] = TRUE;
+        read_num[i] = HostReadNum[DataDirStat[DATA_MAX_READSTAT+i].file_id];
+    }
+    ids[6] = -1;
+    bufs = HuDataReadMulti(ids);
+    HOST_CHECK(bufs != NULL);
+    for(i=0; i<6; i++) {
+        HOST_CHECK(HostFileChk(bufs[i], ids[i]));
+    }
+    for(i=0; i<3; i++) {
+        HOST_CHECK(HostReadNum[DataDirStat[DATA_MAX_READSTAT+i].file_id] == read_num[i]+1);
+        HostARAMDir[DATA_MAX_READSTAT+3+i] = FALSE;
+    }
+    for(i=0; i<DATA_MAX_READSTAT; i++) {
+        HOST_CHECK(ReadDataPin[i] == 0);
+    }
+    HuDataCloseMulti(bufs);
+    for(i=4; i<DATA_MAX_READSTAT; i++) {
+        HuDataDirClose(i << 16);
+    }
+}
+
+static void *HostOtherBuf;
+
+static void HostOtherRead(void)
+{
+    HostOtherBuf = HuDataRead((DATA_MAX_READSTAT+1) << 16);
+}
+
+//Lands everything in flight, then pushes every slot the cache can give up out of it
+static void HostEvictOther(void)
+{
+    Process *process = HostPrcCur;
+    s32 i;
+    HostPrcCur = NULL;
+    HostDriveRun();
+    for(i=0; i<DATA_MAX_READSTAT; i++) {
+        HuDataClose(HuDataRead(i << 16));
+    }
+    HostPrcCur = process;
+}
+
+//Blocking reads from a process sleep until they land, and a second process asking for the same
+//directory meanwhile shares the read instead of starting its own
+//One evicted again before the reader wakes up is read again
+static void HostSleepTest(void)
+{
+    s32 entry = DataDirStat[DATA_MAX_READSTAT].file_id;
+    s32 read_num = HostReadNum[entry];
+    s32 open_num = HostOpenNum;
+    void *buf;
+    HuDataDirClose(DATA_MAX_READSTAT << 16);
+    HuDataDirClose((DATA_MAX_READSTAT+1) << 16);
+    HostPrcReset();
+    HostPrcCur = &HostPrc;
+    buf = HuDataReadNum((DATA_MAX_READSTAT << 16)|1, MEMORY_DEFAULT_NUM);
+    HOST_CHECK(HostFileChk(buf, (DATA_MAX_READSTAT << 16)|1));
+    HOST_CHECK(HostPrcSleepNum == 1);
+    HOST_CHECK(HostReadNum[entry] == read_num+1);
+    HuDataClose(buf);
+
+    entry = DataDirStat[DATA_MAX_READSTAT+1].file_id;
+    read_num = HostReadNum[entry];
+    HostPrcSleepNum = 0;
+    HostOtherBuf = NULL;
+    HostPrcOther = HostOtherRead;
+    buf = HuDataRead((DATA_MAX_READSTAT+1) << 16);
+    HOST_CHECK(HostFileChk(buf, (DATA_MAX_READSTAT+1) << 16));
+    HOST_CHECK(HostFileChk(HostOtherBuf, (DATA_MAX_READSTAT+1) << 16));
+    HOST_CHECK(HostReadNum[entry] == read_num+1);
+    HOST_CHECK(HostOpenNum == open_num);
+    HuDataClose(buf);
+    HuDataClose(HostOtherBuf);
+    HuDataDirCloseNum(MEMORY_DEFAULT_NUM);
+
+    HuDataDirClose((DATA_MAX_READSTAT+4) << 16);
+    entry = DataDirStat[DATA_MAX_READSTAT+4].file_id;
+    read_num = HostReadNum[entry];
+    HostPrcSleepNum = 0;
+    HostPrcOther = HostEvictOther;
+    buf = HuDataRead((DATA_MAX_READSTAT+4) << 16);
+    HOST_CHECK(HostFileChk(buf, (DATA_MAX_READSTAT+4) << 16));
+    HOST_CHECK(HostReadNum[entry] == read_num+2);
+    HOST_CHECK(HostOpenNum == open_num);
+    HuDataClose(buf);
+    HostPrcReset();
+}
+
+//A process killed while its read is in flight just ends; the read still lands in its slot, whether
+//HuDvdReqWaitAll lands it as omOvlKill does or another reader comes along and waits for it
+static void HostKillTest(void)
+{
+    void *volatile buf = NULL;
+    s32 entry = DataDirStat[DATA_MAX_READSTAT+3].file_id;
+    s32 read_num = HostReadNum[entry];
+    s32 open_num = HostOpenNum;
+    s32 mem_num;
+    s32 status;
+    s32 i;
+    for(i=0; i<DATA_MAX_READSTAT+4; i++) {
+        HuDataDirClose(i << 16);
+    }
+    mem_num = HostMemNum;
+    HostPrcReset();
+    HostPrcCur = &HostPrc;
+    HostPrcKillSleep = 1;
+    if(!__builtin_setjmp(HostPrcEndJump)) {
+        buf = HuDataReadNum((DATA_MAX_READSTAT+2) << 16, 5);
+    }
+    HostPrcReset();
+    HOST_CHECK(buf == NULL);
+    status = HuDataReadAsyncChk((DATA_MAX_READSTAT+2) << 16);
+    HOST_CHECK(status >= 0 && ReadDataStat[status].status == 1);
+    HuDvdReqWaitAll();
+    HOST_CHECK(HostOpenNum == open_num);
+    HOST_CHECK(HuDataReadChk((DATA_MAX_READSTAT+2) << 16) == status);
+    HOST_CHECK(ReadDataStat[status].used && ReadDataStat[status].num == 5 && ReadDataPin[status] == 0);
+    HuDataDirCloseNum(5);
+    HOST_CHECK(HuDataReadChk((DATA_MAX_READSTAT+2) << 16) < 0);
+    HOST_CHECK(HostMemNum == mem_num);
+    HOST_CHECK(HuDvdReqFreeGet() == DVD_REQ_MAX);
+
+    HostPrcCur = &HostPrc;
+    HostPrcKillSleep = 1;
+    if(!__builtin_setjmp(HostPrcEndJump)) {
+        buf = HuDataReadNum((DATA_MAX_READSTAT+3) << 16, 5);
+    }
+    HostPrcReset();
+    HOST_CHECK(buf == NULL);
+    buf = HuDataRead((DATA_MAX_READSTAT+3) << 16);
+    HOST_CHECK(HostFileChk(buf, (DATA_MAX_READSTAT+3) << 16));
+    HOST_CHECK(HostReadNum[entry] == read_num+1);
+    HOST_CHECK(HostOpenNum == open_num);
+    HuDataClose(buf);
+    HuDataDirCloseNum(5);
+    HOST_CHECK(HostMemNum == mem_num);
+}
+
+int main(void)
+{
+    HuDataInit();
+    HOST_CHECK(DataDirMax >= DATA_MAX_READSTAT+6);
+    HostEvictTest();
+    HostHeldTest();
+    HostMultiTest();
+    HostSleepTest();
+    HostKillTest();
+    HOST_CHECK(HostIrqLevel == 0);
+    return HostEnd("datacache");
+}
@@ -0,0 +1,359 @@
+//Archive decoders in decode.c, checked against the byte at a time decoders they replaced
+//Every DATA_DECODE_* type is decoded whole and as a stream fed in random chunks,
+//then timed against the old decoders on 1MB of generated data
+
+#include "host.h"
+#include <time.h>
+#include "game/decode.c"
+
+#define HOST_OUT_PAD 4096
+#define HOST_OUT_MAX (0x100000+16)
+#define HOST_SRC_MAX (HOST_OUT_MAX*2)
+#define HOST_RANDOM_NUM 4000
+#define HOST_BENCH_SIZE 0x100000
+#define HOST_BENCH_NUM 20
+
+static u8 HostSrc[HOST_SRC_MAX];
+static u8 HostOutRef[HOST_OUT_PAD+HOST_OUT_MAX];
+static u8 HostOut[HOST_OUT_PAD+HOST_OUT_MAX];
+static DecodeStream HostStream;
+static u32 HostSeed = 1;
+static s32 HostLitPct;
+
+void DCFlushRange(void *addr, u32 nBytes) {}
+
+static u32 HostRand(void)
+{
+    HostSeed = HostSeed*1103515245+12345;
+    return (HostSeed >> 16) & 0x7FFF;
+}
+
+//Old decoders, kept as the reference output
+
+static void RefDecodeLz(u8 *src, u8 *dst, u32 size)
+{
+    u8 text[1024];
+    u16 flag = 0, pos = 958;
+    s32 i, j, copy_len;
+    memset(text, 0, sizeof(text));
+    while(size) {
+        flag >>= 1;
+        if(!(flag & 0x100)) {
+            flag = (*src++)|0xFF00;
+        }
+        if(flag & 0x1) {
+            text[pos++] = *dst++ = *src++;
+            pos &= 0x3FF;
+            size--;
+        } else {
+            i = *src++;
+            copy_len = *src++;
+            i |= ((copy_len & ~0x3F) << 2);
+            copy_len = (copy_len & 0x3F)+3;
+            for(j=0; j<copy_len; j++) {
+                text[pos++] = *dst++ = text[(i+j) & 0x3FF];
+                pos &= 0x3FF;
+            }
+            size -= j;
+        }
+    }
+}
+
+static void RefDecodeSlide(u8 *src, u8 *dst, u32 size, BOOL clip)
+{
+    u8 *base_dst = dst;
+    u8 *copy_src;
+    u32 num_bits = 0, flag = 0, dist, len;
+    src += 4;
+    while(size) {
+        if(num_bits == 0) {
+            flag = (src[0] << 24)|(src[1] << 16)|(src[2] << 8)|src[3];
+            src += 4;
+            num_bits = 32;
+        }
+        if(flag >> 31) {
+            *dst++ = *src++;
+            size--;
+        } else {
+            dist = (src[0] << 8)|src[1];
+            src += 2;
+            len = (dist >> 12) & 0xF;
+            copy_src = dst-(dist & 0xFFF);
+            if(len == 0) {
+                len = (*src++)+18;
+            } else {
+                len += 2;
+            }
+            size -= len;
+            for(; len; len--, copy_src++) {
+                *dst++ = (clip && copy_src-1 < base_dst) ? 0 : copy_src[-1];
+            }
+        }
+        flag <<= 1;
+        num_bits--;
+    }
+}
+
+static void RefDecodeRle(u8 *src, u8 *dst, u32 size)
+{
+    s32 i, len;
+    while(size) {
+        len = *src++;
+        if(len < 128) {
+            for(i=0; i<len; i++) {
+                *dst++ = *src;
+            }
+            src++;
+        } else {
+            len -= 128;
+            for(i=0; i<len; i++) {
+                *dst++ = *src++;
+            }
+        }
+        size -= len;
+    }
+}
+
+static void RefDecodeData(void *src, void *dst, u32 size, s32 decode_type)
+{
+    switch(decode_type) {
+        case DATA_DECODE_NONE:
+            memcpy(dst, src, size);
+            break;
+
+        case DATA_DECODE_LZ:
+            RefDecodeLz(src, dst, size);
+            break;
+
+        case DATA_DECODE_SLIDE:
+            RefDecodeSlide(src, dst, size, TRUE);
+            break;
+
+        case DATA_DECODE_FSLIDE_ALT:
+        case DATA_DECODE_FSLIDE:
+            RefDecodeSlide(src, dst, size, FALSE);
+            break;
+
+        case DATA_DECODE_RLE:
+            RefDecodeRle(src, dst, size);
+            break;
+    }
+}
+
+//Distances favour the short overlapping cases the copy engine treats specially
+static u32 HostDist(u32 max)
+{
+    u32 dist;
+    switch(HostRand()%4) {
+        case 0:
+            dist = HostRand()%4+1;
+            break;
+
+        case 1:
+            dist = HostRand()%64+1;
+            break;
+
+        default:
+            dist = ((HostRand() << 15)|HostRand())%max+1;
+            break;
+    }
+    return (dist > max) ? max : dist;
+}
+
+static u32 HostGenLz(u8 *p, u32 size)
+{
+    u8 *start = p;
+    u8 *flag_ptr;
+    u32 rem = size;
+    u32 len, ofs;
+    s32 bit;
+    while(rem) {
+        flag_ptr = p++;
+        *flag_ptr = 0;
+        for(bit=0; bit<8 && rem; bit++) {
+            if(rem < 3 || HostRand()%100 < HostLitPct) {
+                *flag_ptr |= 1 << bit;
+                *p++ = HostRand();
+                rem--;
+            } else {
+                len = HostRand()%64+3;
+                if(len > rem) {
+                    len = rem;
+                }
+                if(HostRand()%2) {
+                    ofs = (958+(size-rem)-HostDist(1023)) & 0x3FF;
+                } else {
+                    ofs = HostRand()%1024;
+                }
+                *p++ = ofs & 0xFF;
+                *p++ = ((ofs >> 2) & 0xC0)|(len-3);
+                rem -= len;
+            }
+        }
+    }
+    return p-start;
+}
+
+static u32 HostGenSlide(u8 *p, u32 size)
+{
+    u8 *start = p;
+    u8 *flag_ptr;
+    u32 rem = size;
+    u32 flag, len, dist;
+    s32 bit;
+    p += 4;
+    while(rem) {
+        flag_ptr = p;
+        p += 4;
+        flag = 0;
+        for(bit=31; bit>=0 && rem; bit--) {
+            if(rem < 3 || HostRand()%100 < HostLitPct) {
+                flag |= 1U << bit;
+                *p++ = HostRand();
+                rem--;
+                continue;
+            }
+            len = (HostRand()%2) ? HostRand()%16+3 : HostRand()%271+3;
+            if(len > rem) {
+                len = rem;
+            }
+            dist = HostDist(4096)-1;
+            if(len <= 17) {
+                *p++ = ((len-2) << 4)|(dist >> 8);
+                *p++ = dist & 0xFF;
+            } else {
+                *p++ = dist >> 8;
+                *p++ = dist & 0xFF;
+                *p++ = len-18;
+            }
+            rem -= len;
+        }
+        flag_ptr[0] = flag >> 24;
+        flag_ptr[1] = flag >> 16;
+        flag_ptr[2] = flag >> 8;
+        flag_ptr[3] = flag;
+    }
+    return p-start;
+}
+
+static u32 HostGenRle(u8 *p, u32 size)
+{
+    u8 *start = p;
+    u32 rem = size;
+    u32 len, i;
+    while(rem) {
+        len = HostRand()%127+1;
+        if(len > rem) {
+            len = rem;
+        }
+        if(HostRand()%2) {
+            *p++ = len;
+            *p++ = HostRand();
+        } else {
+            *p++ = len+128;
+            for(i=0; i<len; i++) {
+                *p++ = HostRand();
+            }
+        }
+        rem -= len;
+    }
+    return p-start;
+}
+
+//Fills HostSrc with a stream that decodes to size bytes and returns its length
+static u32 HostGen(s32 decode_type, u32 size)
+{
+    u32 i;
+    switch(decode_type) {
+        case DATA_DECODE_LZ:
+            return HostGenLz(HostSrc, size);
+
+        case DATA_DECODE_SLIDE:
+        case DATA_DECODE_FSLIDE_ALT:
+        case DATA_DECODE_FSLIDE:
+            return HostGenSlide(HostSrc, size);
+
+        case DATA_DECODE_RLE:
+            return HostGenRle(HostSrc, size);
+
+        default:
+            for(i=0; i<size; i++) {
+                HostSrc[i] = HostRand();
+            }
+            return size;
+    }
+}
+
+//Fslide reads behind the output, so the pad in front of it holds the same pattern for both decoders
+static void HostOutClear(u8 *out, u32 size)
+{
+    u32 i;
+    for(i=0; i<HOST_OUT_PAD+size+16; i++) {
+        out[i] = i*7;
+    }
+}
+
+static void HostRandomTest(void)
+{
+    s32 i, decode_type;
+    u32 size, src_len, ofs, len;
+    for(i=0; i<HOST_RANDOM_NUM; i++) {
+        decode_type = i%6;
+        size = HostRand()%((i < HOST_RANDOM_NUM-60) ? 5000 : 200000)+1;
+        HostLitPct = HostRand()%100;
+        src_len = HostGen(decode_type, size);
+        HostOutClear(HostOutRef, size);
+        RefDecodeData(HostSrc, &HostOutRef[HOST_OUT_PAD], size, decode_type);
+
+        HostOutClear(HostOut, size);
+        HuDecodeData(HostSrc, &HostOut[HOST_OUT_PAD], size, decode_type);
+        HOST_CHECK(memcmp(HostOut, HostOutRef, HOST_OUT_PAD+size+16) == 0);
+
+        HostOutClear(HostOut, size);
+        HuDecodeStreamBegin(&HostStream, &HostOut[HOST_OUT_PAD], size, decode_type);
+        for(ofs=0; ofs<src_len; ofs += len) {
+            len = (HostRand()%3 == 0) ? HostRand()%8+1 : HostRand()%3000+1;
+            if(len > src_len-ofs) {
+                len = src_len-ofs;
+            }
+            HuDecodeStreamFeed(&HostStream, &HostSrc[ofs], len);
+        }
+        HuDecodeStreamEnd(&HostStream);
+        HOST_CHECK(HostStream.decode.size == 0);
+        HOST_CHECK(memcmp(HostOut, HostOutRef, HOST_OUT_PAD+size+16) == 0);
+    }
+}
+
+static double HostBenchTime(void (*decode)(void *, void *, u32, s32), u8 *out, s32 decode_type)
+{
+    clock_t start;
+    s32 i;
+    start = clock();
+    for(i=0; i<HOST_BENCH_NUM; i++) {
+        decode(HostSrc, &out[HOST_OUT_PAD], HOST_BENCH_SIZE, decode_type);
+    }
+    return (double)(clock()-start)/CLOCKS_PER_SEC;
+}
+
+static void HostBench(void)
+{
+    static const char *names[] = { "none", "lz", "slide", "fslide_alt", "fslide", "rle" };
+    double mb = (double)HOST_BENCH_SIZE*HOST_BENCH_NUM/(1024*1024);
+    double ref_time, time;
+    s32 decode_type;
+    HostLitPct = 50;
+    for(decode_type=0; decode_type<6; decode_type++) {
+        HostGen(decode_type, HOST_BENCH_SIZE);
+        ref_time = HostBenchTime(RefDecodeData, HostOutRef, decode_type);
+        time = HostBenchTime(HuDecodeData, HostOut, decode_type);
+        HOST_CHECK(memcmp(&HostOut[HOST_OUT_PAD], &HostOutRef[HOST_OUT_PAD], HOST_BENCH_SIZE) == 0);
+        printf("decode %-10s old %8.1f MB/s  new %8.1f MB/s\n", names[decode_type], mb/ref_time, mb/time);
+    }
+}
+
+int main(void)
+{
+    HostRandomTest();
+    HostBench();
+    return HostEnd("decode");
+}
@@ -0,0 +1,317 @@
+//Resident overlay modules in objdll.c, with armem.c holding the ARAM copies
+//Fake modules are relocated by a stand-in OSLink, so a reused module shows whether its data and bss
+//were put back the way a fresh link leaves them
+
+#include "host.h"
+#include "game/objdll.c"
+#include "game/armem.c"
+
+#define HOST_ARAM_SIZE 0x900000
+#define HOST_OVL_IMPORT 3
+#define HOST_DATA_MAGIC 0x1234
+
+typedef struct host_mem_block {
+    HeapID heap;
+    s32 size;
+    u32 pad[6];
+} HostMemBlock;
+
+//Section 1 is text, 2 is data and 3 is bss
+typedef struct host_module {
+    OSModuleHeader header;
+    OSSectionInfo section[4];
+    OSImportInfo imp[2];
+    u8 text[32];
+    u32 data[16];
+} HostModule;
+
+static u8 HostARAM[HOST_ARAM_SIZE];
+static u8 *HostMemPtr;
+static s32 HostMemNum[HEAP_MAX];
+static u32 HostHeapFree = 0x400000;
+static s32 HostDvdReadNum;
+static s32 HostEpilogNum;
+static BOOL HostLinked[OVL_COUNT+1];
+static s32 HostLinkNum;
+
+static FileListEntry HostOvlList[OVL_COUNT+1];
+
+u32 DirDataSize;
+
+BOOL ARCheckInit(void) { return TRUE; }
+u32 ARInit(u32 *stack_index_addr, u32 num_entries) { return 0; }
+void ARQInit(void) {}
+void DCInvalidateRange(void *addr, u32 nBytes) {}
+void DCFlushRangeNoSync(void *addr, u32 nBytes) {}
+void PPCSync(void) {}
+void HuDataDirClose(s32 data_id) {}
+DataReadStat *HuDataDirRead(s32 data_id) { return NULL; }
+DataReadStat *HuDataDirSet(void *dir_ptr, s32 data_id) { return NULL; }
+DataReadStat *HuDataGetStatus(void *dir_ptr) { return NULL; }
+void *HuDataGetDirPtr(s32 data_id) { return NULL; }
+s32 HuDataReadChk(s32 data_id) { return -1; }
+void HuDecodeStreamBegin(DecodeStream *stream, void *dst, u32 size, s32 decode_type) {}
+BOOL HuDecodeStreamFeed(DecodeStream *stream, void *src, u32 len) { return TRUE; }
+void HuDecodeStreamEnd(DecodeStream *stream) {}
+void omOvlManifestDLLAdd(s16 overlay) {}
+void HuMemDCFlushAll(void) {}
+void *HuMemHeapPtrGet(HeapID heap) { return NULL; }
+s32 DVDConvertPathToEntrynum(char *path) { return -1; }
+s32 HuDvdReqFastRead(s32 entrynum, HeapID heap, s32 prio, DVDCallback cb) { return -1; }
+void HuDvdReqPrioSet(s32 req, s32 prio) {}
+void *HuDvdReqWait(s32 req) { return NULL; }
+BOOL HuDvdReqCheck(s32 req) { return TRUE; }
+void HuDvdDataClose(void *ptr) {}
+
+u32 ARGetSize(void)
+{
+    return HOST_ARAM_SIZE;
+}
+
+void ARQPostRequest(ARQRequest *task, u32 owner, u32 type, u32 priority, u32 source, u32 dest, u32 length, ARQCallback callback)
+{
+    if(type == ARQ_TYPE_MRAM_TO_ARAM) {
+        memcpy(&HostARAM[dest], (void *)(uintptr_t)source, length);
+    } else {
+        memcpy((void *)(uintptr_t)dest, &HostARAM[source], length);
+    }
+    callback((u32)(uintptr_t)task);
+}
+
+void *HuMemDirectMalloc(HeapID heap, s32 size)
+{
+    HostMemBlock *block;
+    if(!HostMemPtr) {
+        HostMemPtr = HostMemAlloc(0x1000000);
+    }
+    size = OSRoundUp32B(size);
+    block = (HostMemBlock *)HostMemPtr;
+    HostMemPtr += sizeof(HostMemBlock)+size;
+    block->heap = heap;
+    block->size = size;
+    HostMemNum[heap]++;
+    return block+1;
+}
+
+void *HuMemDirectMallocNum(HeapID heap, s32 size, u32 num)
+{
+    return HuMemDirectMalloc(heap, size);
+}
+
+void HuMemDirectFree(void *ptr)
+{
+    if(ptr) {
+        HostMemNum[((HostMemBlock *)ptr-1)->heap]--;
+    }
+}
+
+s32 HuMemMemorySizeGet(void *ptr)
+{
+    return ((HostMemBlock *)ptr-1)->size;
+}
+
+void HuMemHeapSnapshot(void *heap_ptr, HuMemSnapshot *snap)
+{
+    memset(snap, 0, sizeof(HuMemSnapshot));
+    snap->free_size = 0x400000;
+    snap->free_max = HostHeapFree;
+}
+
+u32 HuMemHeapSizeGet(HeapID heap)
+{
+    return 0x400000;
+}
+
+OSTick OSGetTick(void)
+{
+    static OSTick tick;
+    return tick += 1000;
+}
+
+static void HostEpilog(void)
+{
+    HostEpilogNum++;
+}
+
+//Overlay HOST_OVL_IMPORT also imports from another module, so it may not stay linked
+void *HuDvdDataReadDirect(char *path, HeapID heap)
+{
+    HostModule *module = HuMemDirectMalloc(heap, sizeof(HostModule));
+    s32 id = path[0]-'A'+1;
+    HostDvdReadNum++;
+    memset(module, 0, sizeof(HostModule));
+    module->header.info.id = id;
+    module->header.info.numSections = 4;
+    module->header.info.sectionInfoOffset = offsetof(HostModule, section);
+    module->header.bssSize = 32;
+    module->header.impOffset = offsetof(HostModule, imp);
+    module->header.impSize = sizeof(OSImportInfo);
+    if(id == HOST_OVL_IMPORT+1) {
+        module->imp[1].id = OVL_COUNT;
+        module->header.impSize += sizeof(OSImportInfo);
+    }
+    module->header.epilog = (u32)(uintptr_t)HostEpilog;
+    module->section[1].offset = offsetof(HostModule, text)|OS_SECTIONINFO_EXEC;
+    module->section[1].size = sizeof(module->text);
+    module->section[2].offset = offsetof(HostModule, data);
+    module->section[2].size = sizeof(module->data);
+    module->section[3].size = 32;
+    module->data[0] = HOST_DATA_MAGIC;
+    return module;
+}
+
+//Relocates the offsets and one pointer in the data section, as the real linker would
+BOOL OSLink(OSModuleInfo *info, void *bss)
+{
+    HostModule *module = (HostModule *)info;
+    u32 base = (u32)(uintptr_t)module;
+    s32 i;
+    HOST_CHECK(!HostLinked[info->id]);
+    HostLinked[info->id] = TRUE;
+    HostLinkNum++;
+    info->sectionInfoOffset += base;
+    module->header.impOffset += base;
+    for(i=1; i<3; i++) {
+        module->section[i].offset += base;
+    }
+    module->section[3].offset = (u32)(uintptr_t)bss;
+    module->header.bssSection = 3;
+    module->data[1] = base;
+    return TRUE;
+}
+
+BOOL OSUnlink(OSModuleInfo *info)
+{
+    HOST_CHECK(HostLinked[info->id]);
+    HostLinked[info->id] = FALSE;
+    HostLinkNum--;
+    return TRUE;
+}
+
+//Runs the overlay: it must find its module as freshly linked, and leaves data and bss dirty
+static BOOL HostRun(omDllData *dll)
+{
+    HostModule *module = (HostModule *)dll->module;
+    u32 *bss = dll->bss;
+    BOOL result = module->data[0] == HOST_DATA_MAGIC && module->data[1] == (u32)(uintptr_t)module && bss[0] == 0 && bss[7] == 0;
+    module->data[0] = 99;
+    bss[0] = 7;
+    bss[7] = 8;
+    return result;
+}
+
+static void HostVisit(s16 overlay)
+{
+    omDllData *dll;
+    omDLLLink(&dll, overlay, 0);
+    HOST_CHECK(HostRun(dll));
+    omDLLUnlink(dll, 1);
+}
+
+//Room for one module in main memory: overlays 0,1,0,2,0,1,2,0,1,0 only go to the disc once each
+static void HostPoolTest(void)
+{
+    static s16 seq[] = { 0, 1, 0, 2, 0, 1, 2, 0, 1, 0 };
+    s32 i;
+    omDLLResidentSet(0x200, 0x10000);
+    for(i=0; i<10; i++) {
+        HostVisit(seq[i]);
+    }
+    HOST_CHECK(HostDvdReadNum == 3);
+    HOST_CHECK(HostEpilogNum == 10);
+    HOST_CHECK(HostLinkNum == 1);
+    for(i=0; i<3; i++) {
+        HOST_CHECK(omDLLStatData[i].link_num+omDLLStatData[i].mram_num == (i == 0 ? 5 : i == 1 ? 3 : 2));
+        HOST_CHECK(omDLLStatData[i].link_num == 1+omDLLStatData[i].aram_num);
+    }
+    HOST_CHECK(omDLLResidentSize[OM_DLL_RESIDENT_MRAM] <= 0x200);
+    //With room for all three, only the first visits to 1 and 2 link again
+    omDLLResidentSet(0x1000, 0x10000);
+    for(i=0; i<10; i++) {
+        HostVisit(seq[i]);
+    }
+    HOST_CHECK(HostDvdReadNum == 3);
+    HOST_CHECK(omDLLStatData[0].mram_num+omDLLStatData[1].mram_num+omDLLStatData[2].mram_num == 8);
+    HOST_CHECK(HostLinkNum == 3);
+    omDLLStatDump();
+    omDLLResidentSet(0x200, 0x10000);
+}
+
+//A module with foreign imports is unlinked on exit, but still comes back from ARAM
+static void HostImportTest(void)
+{
+    s32 read_num = HostDvdReadNum;
+    HostVisit(HOST_OVL_IMPORT);
+    HostVisit(HOST_OVL_IMPORT);
+    HOST_CHECK(!HostLinked[HOST_OVL_IMPORT+1]);
+    HOST_CHECK(HostDvdReadNum == read_num+1);
+    HOST_CHECK(omDLLStatData[HOST_OVL_IMPORT].mram_num == 0 && omDLLStatData[HOST_OVL_IMPORT].aram_num == 1);
+}
+
+//With the system heap split, exiting modules are unlinked and the resident ones are dropped too,
+//even though the total free space would have been enough
+static void HostReserveTest(void)
+{
+    HOST_CHECK(HostLinkNum == 1);
+    HostHeapFree = 0x10000;
+    HostVisit(1);
+    HOST_CHECK(HostLinkNum == 0 && omDLLResidentSize[OM_DLL_RESIDENT_MRAM] == 0);
+    HostHeapFree = 0x400000;
+}
+
+//An ARAM allocation that does not fit takes the space of the stashed images, oldest first
+static void HostReclaimTest(void)
+{
+    u32 amemptr;
+    u32 size = omDLLResidentSize[OM_DLL_RESIDENT_ARAM];
+    HOST_CHECK(size != 0);
+    HOST_CHECK(omDLLResidentGet(0) && omDLLResidentGet(0)->amemptr);
+    amemptr = HuARMalloc(ARFreeSize+0x100);
+    HOST_CHECK(amemptr != 0);
+    HOST_CHECK(omDLLResidentSize[OM_DLL_RESIDENT_ARAM] < size);
+    HOST_CHECK(!omDLLResidentGet(0));
+    HuARFree(amemptr);
+    //Nothing left to give back, so the allocation fails as it did before
+    omDLLResidentFlush();
+    HOST_CHECK(HuARMalloc(ARFreeSize+0x100) == 0);
+}
+
+//Everything goes back, and with both pools off every link reads the disc as before
+static void HostFlushTest(void)
+{
+    s32 read_num;
+    s32 i;
+    HostVisit(0);
+    omDLLResidentFlush();
+    HOST_CHECK(HostLinkNum == 0);
+    HOST_CHECK(omDLLResidentSize[OM_DLL_RESIDENT_MRAM] == 0 && omDLLResidentSize[OM_DLL_RESIDENT_ARAM] == 0);
+    HOST_CHECK(ARFreeSize == ARSize);
+    HOST_CHECK(HostMemNum[HEAP_SYSTEM] == 0);
+    omDLLResidentSet(0, 0);
+    read_num = HostDvdReadNum;
+    for(i=0; i<4; i++) {
+        HostVisit(i%2);
+    }
+    HOST_CHECK(HostDvdReadNum == read_num+4);
+    HOST_CHECK(HostLinkNum == 0 && ARFreeSize == ARSize);
+    HOST_CHECK(HostMemNum[HEAP_SYSTEM] == 0);
+}
+
+int main(void)
+{
+    static char names[OVL_COUNT][4];
+    s32 i;
+    __OSBusClock = 162000000;
+    for(i=0; i<OVL_COUNT; i++) {
+        names[i][0] = 'A'+i%26;
+        HostOvlList[i].name = names[i];
+    }
+    HuARInit();
+    omDLLInit(HostOvlList);
+    HostPoolTest();
+    HostImportTest();
+    HostReserveTest();
+    HostReclaimTest();
+    HostFlushTest();
+    return HostEnd("dllresident");
+}
@@ -0,0 +1,353 @@
+//DVD read queue in dvd.c, run against a stand-in for DVDReadAsync that models one drive
+//Checks blocking loads jump the prefetch queue, sleep a frame at a time when called from a process,
+//and that a process killed during a load only ends once the read has landed
+
+#include "host.h"
+#include "game/dvd.c"
+
+#define HOST_FILE_MAX 8
+#define HOST_FRAME_US 16667
+//Roughly 3MB a second, plus a seek for every command
+#define HOST_READ_US(len) (100+(len)/3)
+
+#define HOST_FILE_BIG 1
+#define HOST_FILE_SMALL 2
+#define HOST_FILE_MID 3
+
+typedef struct host_mem_block {
+    HeapID heap;
+    s32 size;
+    u32 pad[6];
+} HostMemBlock;
+
+typedef struct host_cmd {
+    DVDFileInfo *file;
+    u8 *buf;
+    u32 len;
+    u32 ofs;
+    DVDCallback callback;
+} HostCmd;
+
+static u32 HostFileLen[HOST_FILE_MAX] = { 0, 0x200000, 0x10000, 0x80000 };
+
+static u8 *HostMemPtr;
+static s32 HostMemNum;
+
+static u32 HostTime;
+static HostCmd HostCmdQueue[DVD_REQ_MAX];
+static s32 HostCmdNum;
+static u32 HostCmdEnd;
+static u32 HostCmdStart;
+static s32 HostStatusNum;
+static s32 HostOpenNum;
+
+static Process HostPrc;
+static Process *HostPrcCur;
+static BOOL HostPrcKilled;
+static s32 HostPrcSleepNum;
+static s32 HostPrcKillSleep;
+static u16 HostPrcHoldStat;
+static s32 HostPrcEndNum;
+//jmp_buf is the game's own type here, so the compiler's builtins stand in for setjmp
+static void *HostPrcEndJump[5];
+
+u32 DirDataSize;
+
+void *HuMemDirectMalloc(HeapID heap, s32 size)
+{
+    HostMemBlock *block;
+    if(!HostMemPtr) {
+        HostMemPtr = HostMemAlloc(0x2000000);
+    }
+    size = OSRoundUp32B(size);
+    block = (HostMemBlock *)HostMemPtr;
+    HostMemPtr += sizeof(HostMemBlock)+size;
+    block->heap = heap;
+    block->size = size;
+    HostMemNum++;
+    return block+1;
+}
+
+void *HuMemDirectMallocNum(HeapID heap, s32 size, u32 num)
+{
+    return HuMemDirectMalloc(heap, size);
+}
+
+void HuMemDirectFree(void *ptr)
+{
+    if(ptr) {
+        HostMemNum--;
+    }
+}
+
+void HuMemHeapSnapshot(void *heap_ptr, HuMemSnapshot *snap)
+{
+    memset(snap, 0, sizeof(HuMemSnapshot));
+    snap->free_size = snap->free_max = 0x1000000;
+}
+
+void *HuMemHeapPtrGet(HeapID heap) { return NULL; }
+u32 HuMemHeapSizeGet(HeapID heap) { return 0x1000000; }
+s32 HuMemUsedMallocSizeGet(HeapID heap) { return 0; }
+void DCInvalidateRange(void *addr, u32 nBytes) {}
+void HuDataDirReadAsyncCallBack(s32 result, DVDFileInfo *fileInfo) {}
+
+void OSPanic(const char *file, int line, const char *msg, ...)
+{
+    printf("OSPanic %s:%d %s\n", file, line, msg);
+    exit(2);
+}
+
+static u8 HostFileByte(u32 entry, u32 ofs)
+{
+    return (u8)(entry*31+(ofs >> 8)+ofs);
+}
+
+static BOOL HostBufChk(void *buf, u32 entry)
+{
+    u32 i;
+    for(i=0; i<HostFileLen[entry]; i++) {
+        if(((u8 *)buf)[i] != HostFileByte(entry, i)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+//Finishes every command that is done by HostTime, calling back as the DVD interrupt would
+static void HostDriveRun(void)
+{
+    HostCmd cmd;
+    u32 i;
+    while(HostCmdNum && HostCmdEnd <= HostTime) {
+        //A read started from the callback goes out as soon as this one is done
+        HostCmdStart = HostCmdEnd;
+        cmd = HostCmdQueue[0];
+        memmove(&HostCmdQueue[0], &HostCmdQueue[1], --HostCmdNum*sizeof(HostCmd));
+        for(i=0; i<cmd.len; i++) {
+            cmd.buf[i] = HostFileByte(cmd.file->startAddr, cmd.ofs+i);
+        }
+        if(HostCmdNum) {
+            HostCmdEnd += HOST_READ_US(HostCmdQueue[0].len);
+        }
+        HostIrqLevel++;
+        cmd.callback(cmd.len, cmd.file);
+        HostIrqLevel--;
+    }
+    HostCmdStart = HostTime;
+}
+
+BOOL DVDReadAsyncPrio(DVDFileInfo *fileInfo, void *addr, s32 length, s32 offset, DVDCallback callback, s32 prio)
+{
+    if(!HostCmdNum) {
+        HostCmdEnd = HostCmdStart+HOST_READ_US(length);
+    }
+    HostCmdQueue[HostCmdNum].file = fileInfo;
+    HostCmdQueue[HostCmdNum].buf = addr;
+    HostCmdQueue[HostCmdNum].len = length;
+    HostCmdQueue[HostCmdNum].ofs = offset;
+    HostCmdQueue[HostCmdNum].callback = callback;
+    HostCmdNum++;
+    return TRUE;
+}
+
+BOOL DVDFastOpen(s32 entrynum, DVDFileInfo *fileInfo)
+{
+    HostOpenNum++;
+    fileInfo->startAddr = entrynum;
+    fileInfo->length = HostFileLen[entrynum];
+    return TRUE;
+}
+
+BOOL DVDOpen(char *fileName, DVDFileInfo *fileInfo)
+{
+    return DVDFastOpen(atoi(fileName), fileInfo);
+}
+
+BOOL DVDClose(DVDFileInfo *f)
+{
+    HostOpenNum--;
+    return TRUE;
+}
+
+//A spinning wait polls this, so each poll moves time on a little
+s32 DVDGetDriveStatus()
+{
+    HostStatusNum++;
+    HostTime += 10;
+    HostDriveRun();
+    return HostCmdNum ? DVD_STATE_BUSY : DVD_STATE_END;
+}
+
+Process *HuPrcCurrentGet(void)
+{
+    return HostPrcCur;
+}
+
+BOOL HuPrcKillChk(Process *process)
+{
+    return HostPrcKilled;
+}
+
+void HuPrcSetStat(Process *process, u16 value)
+{
+    process->stat |= value;
+}
+
+void HuPrcResetStat(Process *process, u16 value)
+{
+    process->stat &= ~value;
+}
+
+//The other processes get a frame, one of them may kill the one that is waiting
+void HuPrcVSleep(void)
+{
+    HostPrcSleepNum++;
+    HostPrcHoldStat |= HostPrc.stat;
+    if(HostPrcSleepNum == HostPrcKillSleep) {
+        HostPrcKilled = TRUE;
+    }
+    HostTime += HOST_FRAME_US;
+    HostDriveRun();
+}
+
+void HuPrcEnd(void)
+{
+    HostPrcEndNum++;
+    __builtin_longjmp(HostPrcEndJump, 1);
+}
+
+static void HostPrcReset(void)
+{
+    HostPrcCur = NULL;
+    HostPrcKilled = FALSE;
+    HostPrcSleepNum = 0;
+    HostPrcKillSleep = 0;
+    HostPrcHoldStat = 0;
+    HostPrc.stat = 0;
+}
+
+static void HostDriveIdle(void)
+{
+    while(HostCmdNum) {
+        DVDGetDriveStatus();
+    }
+}
+
+//A blocking load queued behind a large prefetch only waits out the chunk being read
+static void HostSpinTest(void)
+{
+    s32 prefetch;
+    void *buf;
+    u32 time;
+    HostPrcReset();
+    prefetch = HuDvdReqFastRead(HOST_FILE_BIG, HEAP_DVD, DVD_PRIO_PREFETCH, NULL);
+    HOST_CHECK(prefetch >= 0);
+    time = HostTime;
+    buf = HuDvdDataFastRead(HOST_FILE_SMALL);
+    HOST_CHECK(buf && HostBufChk(buf, HOST_FILE_SMALL));
+    HOST_CHECK(HostTime-time <= HOST_READ_US(DVD_REQ_CHUNK)+HOST_READ_US(HostFileLen[HOST_FILE_SMALL])+100);
+    HOST_CHECK(!HuDvdReqCheck(prefetch));
+    buf = HuDvdReqWait(prefetch);
+    HOST_CHECK(buf && HostBufChk(buf, HOST_FILE_BIG));
+    HOST_CHECK(HuDvdReqFreeGet() == DVD_REQ_MAX);
+}
+
+static void HostSleepTest(void)
+{
+    s32 prefetch;
+    s32 req;
+    s32 status_num;
+    void *buf;
+    HostPrcReset();
+    HostPrcCur = &HostPrc;
+    //Loads made through the blocking calls sleep instead of polling the drive
+    status_num = HostStatusNum;
+    buf = HuDvdDataRead("3");
+    HOST_CHECK(buf && HostBufChk(buf, HOST_FILE_MID));
+    HOST_CHECK(HostPrcSleepNum >= HOST_READ_US(HostFileLen[HOST_FILE_MID])/HOST_FRAME_US);
+    HOST_CHECK(HostStatusNum-status_num <= HostPrcSleepNum+1);
+    HOST_CHECK(HostPrcHoldStat & PROCESS_STAT_KILL_HOLD);
+    HOST_CHECK(!(HostPrc.stat & PROCESS_STAT_KILL_HOLD));
+    buf = HuDvdDataReadDirect("2", HEAP_SYSTEM);
+    HOST_CHECK(buf && HostBufChk(buf, HOST_FILE_SMALL));
+    buf = HuDvdDataFastReadNum(HOST_FILE_SMALL, MEMORY_DEFAULT_NUM);
+    HOST_CHECK(buf && HostBufChk(buf, HOST_FILE_SMALL));
+
+    //A prefetch that is waited on is raised before the process goes to sleep
+    prefetch = HuDvdReqFastRead(HOST_FILE_BIG, HEAP_DVD, DVD_PRIO_PREFETCH, NULL);
+    req = HuDvdReqFastRead(HOST_FILE_SMALL, HEAP_DVD, DVD_PRIO_PREFETCH, NULL);
+    HostPrcSleepNum = 0;
+    buf = HuDvdReqWait(req);
+    HOST_CHECK(buf && HostBufChk(buf, HOST_FILE_SMALL));
+    HOST_CHECK(HostPrcSleepNum*HOST_FRAME_US <= HOST_READ_US(DVD_REQ_CHUNK)+HOST_READ_US(HostFileLen[HOST_FILE_SMALL])+HOST_FRAME_US);
+    HOST_CHECK(!HuDvdReqCheck(prefetch));
+    HOST_CHECK(HuDvdReqWait(prefetch) != NULL);
+    HOST_CHECK(HuDvdReqFreeGet() == DVD_REQ_MAX);
+    HostPrcReset();
+}
+
+static void HostKillTest(void)
+{
+    void *volatile buf = NULL;
+    s32 mem_num;
+    s32 open_num = HostOpenNum;
+    HostPrcReset();
+    HostPrcCur = &HostPrc;
+    //Killed on the second frame of a load that takes about ten
+    HostPrcKillSleep = 2;
+    HostPrcEndNum = 0;
+    mem_num = HostMemNum;
+    if(!__builtin_setjmp(HostPrcEndJump)) {
+        buf = HuDvdDataRead("3");
+    }
+    HOST_CHECK(HostPrcEndNum == 1);
+    HOST_CHECK(buf == NULL);
+    HOST_CHECK(HostCmdNum == 0);
+    HOST_CHECK(HostPrcSleepNum >= HOST_READ_US(HostFileLen[HOST_FILE_MID])/HOST_FRAME_US);
+    HOST_CHECK(HuDvdReqFreeGet() == DVD_REQ_MAX);
+    HOST_CHECK(HostMemNum == mem_num+1);
+    HOST_CHECK(HostOpenNum == open_num);
+    HOST_CHECK(!(HostPrc.stat & PROCESS_STAT_KILL_HOLD));
+
+    //A process already on its way out, such as one running its destructor, does not sleep
+    HostPrcSleepNum = 0;
+    HostPrcEndNum = 0;
+    buf = HuDvdDataRead("2");
+    HOST_CHECK(buf && HostBufChk(buf, HOST_FILE_SMALL));
+    HOST_CHECK(HostPrcSleepNum == 0 && HostPrcEndNum == 0);
+    HostPrcReset();
+}
+
+//Reads marked as slept on are the ones omOvlKill waits out before freeing heaps
+static void HostWaitAllTest(void)
+{
+    DVDFileInfo file;
+    void *buf;
+    s32 req;
+    s32 prefetch;
+    HostPrcReset();
+    prefetch = HuDvdReqFastRead(HOST_FILE_BIG, HEAP_DVD, DVD_PRIO_PREFETCH, NULL);
+    DVDFastOpen(HOST_FILE_MID, &file);
+    buf = HuMemDirectMalloc(HEAP_DVD, file.length);
+    req = HuDvdReqPush(&file, buf, file.length, DVD_PRIO_WAIT, NULL, TRUE, FALSE);
+    DvdReqData[req].wait = TRUE;
+    HuDvdReqWaitAll();
+    HOST_CHECK(HuDvdReqCheck(req));
+    HOST_CHECK(HostBufChk(buf, HOST_FILE_MID));
+    HOST_CHECK(!HuDvdReqCheck(prefetch));
+    HOST_CHECK(HuDvdReqWait(req) == buf);
+    HuDvdDataClose(HuDvdReqWait(prefetch));
+    HOST_CHECK(HuDvdReqFreeGet() == DVD_REQ_MAX);
+    HostDriveIdle();
+}
+
+int main(void)
+{
+    HostSpinTest();
+    HostSleepTest();
+    HostKillTest();
+    HostWaitAllTest();
+    HOST_CHECK(HostIrqLevel == 0);
+    return HostEnd("dvdqueue");
+}
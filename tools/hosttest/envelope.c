@@ -0,0 +1,521 @@
+//Envelope skinning in EnvelopeExec.c, run through EnvelopeProc with the skin plan and with the cenv walk it replaced
+//Four generated characters are loaded with InitEnvelope and played through a motion; every frame's
+//positions and normals from both paths are compared, then each path is timed over the whole motion
+
+#include "host.h"
+#include <math.h>
+#include <time.h>
+#include "game/EnvelopeExec.c"
+
+#define HOST_CHAR_NUM 4
+#define HOST_JOINTS 44
+#define HOST_MESHES 3
+#define HOST_CENVS 24
+#define HOST_OBJECTS (HOST_JOINTS+HOST_MESHES)
+#define HOST_FRAMES 600
+#define HOST_TOLERANCE 1e-4
+
+typedef struct host_char {
+    HsfData hsf;
+    HsfMatrix matrix;
+    HsfObject object[HOST_OBJECTS];
+    HsfObject *children[HOST_OBJECTS];
+    HsfBuffer vertex[HOST_MESHES];
+    HsfBuffer normal[HOST_MESHES];
+    Vec *vtxRef[HOST_MESHES];
+    Vec *nrmRef[HOST_MESHES];
+} HostChar;
+
+static HostChar HostCharData[HOST_CHAR_NUM];
+static HsfTransform HostMotion[HOST_FRAMES][HOST_OBJECTS];
+static u8 *HostMemPtr;
+static u32 HostSeed = 1;
+
+//Matrix library stand-ins, plain C versions of the paired single routines
+
+void PSMTXIdentity(Mtx m)
+{
+    memset(m, 0, sizeof(Mtx));
+    m[0][0] = m[1][1] = m[2][2] = 1.0f;
+}
+
+void PSMTXCopy(const Mtx src, Mtx dst)
+{
+    memmove(dst, src, sizeof(Mtx));
+}
+
+void PSMTXConcat(const Mtx a, const Mtx b, Mtx ab)
+{
+    Mtx tmp;
+    s32 i, j;
+    for(i=0; i<3; i++) {
+        for(j=0; j<4; j++) {
+            tmp[i][j] = a[i][0]*b[0][j]+a[i][1]*b[1][j]+a[i][2]*b[2][j]+((j == 3) ? a[i][3] : 0.0f);
+        }
+    }
+    memcpy(ab, tmp, sizeof(Mtx));
+}
+
+u32 PSMTXInverse(const Mtx src, Mtx inv)
+{
+    Mtx m;
+    float det;
+    s32 i;
+    memcpy(m, src, sizeof(Mtx));
+    det = m[0][0]*(m[1][1]*m[2][2]-m[1][2]*m[2][1])
+        - m[0][1]*(m[1][0]*m[2][2]-m[1][2]*m[2][0])
+        + m[0][2]*(m[1][0]*m[2][1]-m[1][1]*m[2][0]);
+    if(det == 0.0f) {
+        return FALSE;
+    }
+    det = 1.0f/det;
+    inv[0][0] = (m[1][1]*m[2][2]-m[1][2]*m[2][1])*det;
+    inv[0][1] = (m[0][2]*m[2][1]-m[0][1]*m[2][2])*det;
+    inv[0][2] = (m[0][1]*m[1][2]-m[0][2]*m[1][1])*det;
+    inv[1][0] = (m[1][2]*m[2][0]-m[1][0]*m[2][2])*det;
+    inv[1][1] = (m[0][0]*m[2][2]-m[0][2]*m[2][0])*det;
+    inv[1][2] = (m[0][2]*m[1][0]-m[0][0]*m[1][2])*det;
+    inv[2][0] = (m[1][0]*m[2][1]-m[1][1]*m[2][0])*det;
+    inv[2][1] = (m[0][1]*m[2][0]-m[0][0]*m[2][1])*det;
+    inv[2][2] = (m[0][0]*m[1][1]-m[0][1]*m[1][0])*det;
+    for(i=0; i<3; i++) {
+        inv[i][3] = -(inv[i][0]*m[0][3]+inv[i][1]*m[1][3]+inv[i][2]*m[2][3]);
+    }
+    return TRUE;
+}
+
+u32 PSMTXInvXpose(const Mtx src, Mtx invX)
+{
+    Mtx inv;
+    s32 i, j;
+    if(!PSMTXInverse(src, inv)) {
+        return FALSE;
+    }
+    for(i=0; i<3; i++) {
+        for(j=0; j<3; j++) {
+            invX[i][j] = inv[j][i];
+        }
+        invX[i][3] = 0.0f;
+    }
+    return TRUE;
+}
+
+void PSMTXMultVec(const Mtx m, const Vec *src, Vec *dst)
+{
+    Vec tmp;
+    tmp.x = m[0][0]*src->x+m[0][1]*src->y+m[0][2]*src->z+m[0][3];
+    tmp.y = m[1][0]*src->x+m[1][1]*src->y+m[1][2]*src->z+m[1][3];
+    tmp.z = m[2][0]*src->x+m[2][1]*src->y+m[2][2]*src->z+m[2][3];
+    *dst = tmp;
+}
+
+void PSMTXMultVecArray(const Mtx m, const Vec *srcBase, Vec *dstBase, u32 count)
+{
+    u32 i;
+    for(i=0; i<count; i++) {
+        PSMTXMultVec(m, &srcBase[i], &dstBase[i]);
+    }
+}
+
+void PSMTXReorder(const Mtx src, ROMtx dest)
+{
+    s32 i, j;
+    for(i=0; i<3; i++) {
+        for(j=0; j<4; j++) {
+            dest[j][i] = src[i][j];
+        }
+    }
+}
+
+void PSMTXROMultVecArray(const ROMtx m, const Vec *srcBase, Vec *dstBase, u32 count)
+{
+    Vec tmp;
+    u32 i;
+    for(i=0; i<count; i++) {
+        tmp.x = m[0][0]*srcBase[i].x+m[1][0]*srcBase[i].y+m[2][0]*srcBase[i].z+m[3][0];
+        tmp.y = m[0][1]*srcBase[i].x+m[1][1]*srcBase[i].y+m[2][1]*srcBase[i].z+m[3][1];
+        tmp.z = m[0][2]*srcBase[i].x+m[1][2]*srcBase[i].y+m[2][2]*srcBase[i].z+m[3][2];
+        dstBase[i] = tmp;
+    }
+}
+
+void PSMTXTrans(Mtx m, f32 xT, f32 yT, f32 zT)
+{
+    PSMTXIdentity(m);
+    m[0][3] = xT;
+    m[1][3] = yT;
+    m[2][3] = zT;
+}
+
+void PSMTXScale(Mtx m, f32 xS, f32 yS, f32 zS)
+{
+    memset(m, 0, sizeof(Mtx));
+    m[0][0] = xS;
+    m[1][1] = yS;
+    m[2][2] = zS;
+}
+
+void PSMTXRotRad(Mtx m, char axis, f32 rad)
+{
+    float s = sinf(rad);
+    float c = cosf(rad);
+    s32 a = (axis == 'x') ? 1 : 0;
+    s32 b = (axis == 'z') ? 1 : 2;
+    PSMTXIdentity(m);
+    if(axis == 'y') {
+        m[0][0] = c;
+        m[0][2] = s;
+        m[2][0] = -s;
+        m[2][2] = c;
+        return;
+    }
+    m[a][a] = c;
+    m[a][b] = -s;
+    m[b][a] = s;
+    m[b][b] = c;
+}
+
+void PSVECAdd(const Vec *a, const Vec *b, Vec *ab)
+{
+    ab->x = a->x+b->x;
+    ab->y = a->y+b->y;
+    ab->z = a->z+b->z;
+}
+
+//Column lengths, negated for a mirrored matrix
+void Hu3DMtxScaleGet(Mtx arg0, Vec *arg1)
+{
+    float det = arg0[0][0]*(arg0[1][1]*arg0[2][2]-arg0[1][2]*arg0[2][1])
+        - arg0[0][1]*(arg0[1][0]*arg0[2][2]-arg0[1][2]*arg0[2][0])
+        + arg0[0][2]*(arg0[1][0]*arg0[2][1]-arg0[1][1]*arg0[2][0]);
+    arg1->x = sqrtf(arg0[0][0]*arg0[0][0]+arg0[1][0]*arg0[1][0]+arg0[2][0]*arg0[2][0]);
+    arg1->y = sqrtf(arg0[0][1]*arg0[0][1]+arg0[1][1]*arg0[1][1]+arg0[2][1]*arg0[2][1]);
+    arg1->z = sqrtf(arg0[0][2]*arg0[0][2]+arg0[1][2]*arg0[1][2]+arg0[2][2]*arg0[2][2]);
+    if(det < 0.0f) {
+        arg1->x = -arg1->x;
+        arg1->y = -arg1->y;
+        arg1->z = -arg1->z;
+    }
+}
+
+void DCStoreRangeNoSync(void *addr, u32 nBytes) {}
+s32 SearchObjectSkeleton(HsfData *data, s32 index) { return -1; }
+s32 SearchSkeletonName(HsfData *data, char *name) { return -1; }
+
+//Bump allocator; nothing is freed before the test ends
+void *HuMemDirectMallocNum(HeapID heap, s32 size, u32 num)
+{
+    void *ptr = HostMemPtr;
+    HostMemPtr += (size+31) & ~31;
+    return ptr;
+}
+
+void HuMemDirectFree(void *ptr) {}
+
+static u32 HostRand(u32 max)
+{
+    HostSeed = HostSeed*1103515245+12345;
+    return (HostSeed >> 8)%max;
+}
+
+static float HostRandF(float max)
+{
+    return HostRand(100000)/100000.0f*max;
+}
+
+static void *HostAlloc(u32 size)
+{
+    void *ptr = HuMemDirectMallocNum(HEAP_DATA, size, MEMORY_DEFAULT_NUM);
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+static void HostTransformMake(HsfTransform *transform, BOOL scale)
+{
+    transform->pos.x = HostRandF(40)-20;
+    transform->pos.y = HostRandF(40)-20;
+    transform->pos.z = HostRandF(40)-20;
+    transform->rot.x = HostRandF(360)-180;
+    transform->rot.y = HostRandF(360)-180;
+    transform->rot.z = HostRandF(360)-180;
+    transform->scale.x = transform->scale.y = transform->scale.z = 1.0f;
+    if(scale) {
+        transform->scale.x = 0.6f+HostRandF(0.8f);
+        transform->scale.y = 0.6f+HostRandF(0.8f);
+        transform->scale.z = 0.6f+HostRandF(0.8f);
+    }
+}
+
+//Fills a mesh's cenv list the way the converter lays it out: each cenv's vertices follow the last
+static void HostMeshMake(HsfObject *object, HsfBuffer *vertex, HsfBuffer *normal)
+{
+    HsfCenv *cenv;
+    HsfCenvSingle *single;
+    HsfCenvDual *dual;
+    HsfCenvDualWeight *dual_weight;
+    HsfCenvMulti *multi;
+    Vec *vtx, *nrm;
+    float total;
+    u32 vtx_num, nrm_num;
+    s32 i, j, k;
+    object->type = 2;
+    object->data.cenvCnt = HOST_CENVS;
+    object->data.cenv = HostAlloc(HOST_CENVS*sizeof(HsfCenv));
+    vtx_num = nrm_num = 0;
+    for(i=0; i<HOST_CENVS; i++) {
+        cenv = &object->data.cenv[i];
+        cenv->singleCount = 2+HostRand(3);
+        cenv->singleData = HostAlloc(cenv->singleCount*sizeof(HsfCenvSingle));
+        for(j=0; j<cenv->singleCount; j++) {
+            single = &cenv->singleData[j];
+            single->target = HostRand(HOST_JOINTS);
+            single->posCnt = single->normalCnt = 1+HostRand(14);
+            single->pos = vtx_num;
+            single->normal = nrm_num;
+            vtx_num += single->posCnt;
+            nrm_num += single->normalCnt;
+        }
+        cenv->dualCount = HostRand(3);
+        cenv->dualData = HostAlloc(cenv->dualCount*sizeof(HsfCenvDual));
+        for(j=0; j<cenv->dualCount; j++) {
+            dual = &cenv->dualData[j];
+            dual->target1 = HostRand(HOST_JOINTS);
+            dual->target2 = HostRand(HOST_JOINTS);
+            dual->weightCnt = 2+HostRand(5);
+            dual->weight = HostAlloc(dual->weightCnt*sizeof(HsfCenvDualWeight));
+            for(k=0; k<dual->weightCnt; k++) {
+                dual_weight = &dual->weight[k];
+                dual_weight->weight = HostRandF(1);
+                dual_weight->posCnt = 1+HostRand(8);
+                dual_weight->normalCnt = HostRand(4) ? dual_weight->posCnt : 0;
+                dual_weight->pos = vtx_num;
+                dual_weight->normal = nrm_num;
+                vtx_num += dual_weight->posCnt;
+                nrm_num += dual_weight->normalCnt;
+            }
+        }
+        cenv->multiCount = 4+HostRand(10);
+        cenv->multiData = HostAlloc(cenv->multiCount*sizeof(HsfCenvMulti));
+        for(j=0; j<cenv->multiCount; j++) {
+            multi = &cenv->multiData[j];
+            multi->weightCnt = 2+HostRand(3);
+            multi->posCnt = multi->normalCnt = 1;
+            multi->pos = vtx_num++;
+            multi->normal = nrm_num++;
+            multi->weight = HostAlloc(multi->weightCnt*sizeof(HsfCenvMultiWeight));
+            for(total=0.0f, k=0; k<multi->weightCnt; k++) {
+                multi->weight[k].target = HostRand(HOST_JOINTS);
+                multi->weight[k].value = 0.1f+HostRandF(1);
+                total += multi->weight[k].value;
+            }
+            for(k=0; k<multi->weightCnt; k++) {
+                multi->weight[k].value /= total;
+            }
+        }
+        cenv->vtxCount = vtx_num;
+        cenv->copyCount = HostRand(3) ? 0 : 1+HostRand(6);
+        vtx_num += cenv->copyCount;
+    }
+    vtx = HostAlloc(vtx_num*sizeof(Vec));
+    nrm = HostAlloc(nrm_num*sizeof(Vec));
+    for(i=0; i<vtx_num; i++) {
+        vtx[i].x = HostRandF(20)-10;
+        vtx[i].y = HostRandF(20)-10;
+        vtx[i].z = HostRandF(20)-10;
+    }
+    for(i=0; i<nrm_num; i++) {
+        nrm[i].x = HostRandF(2)-1;
+        nrm[i].y = HostRandF(2)-1;
+        nrm[i].z = HostRandF(2)-1;
+    }
+    object->data.file[0] = vtx;
+    object->data.file[1] = nrm;
+    vertex->count = vtx_num;
+    vertex->data = HostAlloc(vtx_num*sizeof(Vec));
+    normal->count = nrm_num;
+    normal->data = HostAlloc(nrm_num*sizeof(Vec));
+    object->data.vertex = vertex;
+    object->data.normal = normal;
+}
+
+//Joints form a binary tree under object 0, the meshes hang off the root
+static void HostCharMake(HostChar *chr)
+{
+    HsfData *hsf = &chr->hsf;
+    HsfObject *object;
+    HsfObject **children = chr->children;
+    s32 i, j;
+    hsf->object = chr->object;
+    hsf->objectCnt = HOST_OBJECTS;
+    hsf->root = &chr->object[0];
+    for(i=0; i<HOST_OBJECTS; i++) {
+        object = &chr->object[i];
+        object->name = "joint";
+        object->data.children = children;
+        if(i < HOST_JOINTS) {
+            object->type = 0;
+            for(j=i*2+1; j<=i*2+2 && j<HOST_JOINTS; j++) {
+                *children++ = &chr->object[j];
+            }
+            if(i == 0) {
+                for(j=HOST_JOINTS; j<HOST_OBJECTS; j++) {
+                    *children++ = &chr->object[j];
+                }
+            }
+        } else {
+            HostMeshMake(object, &chr->vertex[i-HOST_JOINTS], &chr->normal[i-HOST_JOINTS]);
+            chr->vtxRef[i-HOST_JOINTS] = HostAlloc(chr->vertex[i-HOST_JOINTS].count*sizeof(Vec));
+            chr->nrmRef[i-HOST_JOINTS] = HostAlloc(chr->normal[i-HOST_JOINTS].count*sizeof(Vec));
+        }
+        object->data.childrenCount = children-object->data.children;
+        HostTransformMake(&object->data.base, HostRand(4) == 0);
+    }
+    chr->matrix.base_idx = HOST_MESHES;
+    chr->matrix.count = HOST_OBJECTS;
+    chr->matrix.data = HostAlloc((HOST_MESHES+HOST_OBJECTS+HOST_OBJECTS*HOST_MESHES)*sizeof(Mtx));
+    hsf->matrix = &chr->matrix;
+    hsf->cenvCnt = HOST_MESHES*HOST_CENVS;
+    InitEnvelope(hsf);
+}
+
+static void HostPose(HostChar *chr, s32 frame)
+{
+    s32 i;
+    for(i=0; i<HOST_OBJECTS; i++) {
+        chr->object[i].data.curr = HostMotion[frame][i];
+    }
+}
+
+//Largest difference between the two paths, relative to the reference value
+static double HostError(Vec *ref, Vec *out, s32 num)
+{
+    double error = 0.0;
+    double diff;
+    float *a, *b;
+    s32 i;
+    for(i=0; i<num*3; i++) {
+        a = &ref->x+i;
+        b = &out->x+i;
+        diff = fabs(*a-*b)/(1.0+fabs(*a));
+        if(!(diff <= error)) {
+            error = diff;
+        }
+    }
+    return error;
+}
+
+static void HostCompareTest(void)
+{
+    HostChar *chr;
+    HsfSkin *skin;
+    double error = 0.0;
+    double diff;
+    s32 frame, i, j;
+    for(frame=0; frame<HOST_FRAMES; frame++) {
+        for(i=0; i<HOST_CHAR_NUM; i++) {
+            chr = &HostCharData[i];
+            HostPose(chr, frame);
+            skin = chr->hsf.skin;
+            chr->hsf.skin = NULL;
+            EnvelopeProc(&chr->hsf);
+            chr->hsf.skin = skin;
+            for(j=0; j<HOST_MESHES; j++) {
+                memcpy(chr->vtxRef[j], chr->vertex[j].data, chr->vertex[j].count*sizeof(Vec));
+                memcpy(chr->nrmRef[j], chr->normal[j].data, chr->normal[j].count*sizeof(Vec));
+                memset(chr->vertex[j].data, 0, chr->vertex[j].count*sizeof(Vec));
+                memset(chr->normal[j].data, 0, chr->normal[j].count*sizeof(Vec));
+            }
+            EnvelopeProc(&chr->hsf);
+            for(j=0; j<HOST_MESHES; j++) {
+                diff = HostError(chr->vtxRef[j], chr->vertex[j].data, chr->vertex[j].count);
+                error = (diff > error) ? diff : error;
+                diff = HostError(chr->nrmRef[j], chr->normal[j].data, chr->normal[j].count);
+                error = (diff > error) ? diff : error;
+            }
+        }
+    }
+    HOST_CHECK(error < HOST_TOLERANCE);
+    printf("envelope max relative error %.3g\n", error);
+}
+
+//A mesh with more targets than the palette holds, or a vertex with too many influences,
+//leaves the model on the cenv walk
+static void HostFallbackTest(void)
+{
+    HsfData *hsf = &HostCharData[0].hsf;
+    HsfCenv *cenv = HostCharData[0].object[HOST_JOINTS].data.cenv;
+    u32 target[HOST_CENVS][3];
+    s32 i;
+    //Three new targets per cenv is more than the palette holds whatever the mesh already uses
+    for(i=0; i<HOST_CENVS; i++) {
+        target[i][0] = cenv[i].singleData[0].target;
+        target[i][1] = cenv[i].singleData[1].target;
+        target[i][2] = cenv[i].multiData[0].weight[0].target;
+        cenv[i].singleData[0].target = HOST_OBJECTS+i*3;
+        cenv[i].singleData[1].target = HOST_OBJECTS+i*3+1;
+        cenv[i].multiData[0].weight[0].target = HOST_OBJECTS+i*3+2;
+    }
+    SkinBuild(hsf);
+    HOST_CHECK(hsf->skin == NULL);
+    for(i=0; i<HOST_CENVS; i++) {
+        cenv[i].singleData[0].target = target[i][0];
+        cenv[i].singleData[1].target = target[i][1];
+        cenv[i].multiData[0].weight[0].target = target[i][2];
+    }
+    cenv[0].multiData[0].weightCnt += SKIN_INFLUENCE_MAX;
+    SkinBuild(hsf);
+    HOST_CHECK(hsf->skin == NULL);
+    cenv[0].multiData[0].weightCnt -= SKIN_INFLUENCE_MAX;
+    SkinBuild(hsf);
+    HOST_CHECK(hsf->skin != NULL);
+}
+
+static double HostPlayTime(BOOL skin_on)
+{
+    HostChar *chr;
+    HsfSkin *skin[HOST_CHAR_NUM];
+    clock_t start;
+    s32 frame, i;
+    for(i=0; i<HOST_CHAR_NUM; i++) {
+        skin[i] = HostCharData[i].hsf.skin;
+        HostCharData[i].hsf.skin = skin_on ? skin[i] : NULL;
+    }
+    start = clock();
+    for(frame=0; frame<HOST_FRAMES; frame++) {
+        for(i=0; i<HOST_CHAR_NUM; i++) {
+            chr = &HostCharData[i];
+            HostPose(chr, frame);
+            EnvelopeProc(&chr->hsf);
+        }
+    }
+    start = clock()-start;
+    for(i=0; i<HOST_CHAR_NUM; i++) {
+        HostCharData[i].hsf.skin = skin[i];
+    }
+    return (double)start/CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+    s32 frame, i, j;
+    u32 vtx_num = 0;
+    HostMemPtr = HostMemAlloc(0x4000000);
+    for(i=0; i<HOST_CHAR_NUM; i++) {
+        HostCharMake(&HostCharData[i]);
+        HOST_CHECK(HostCharData[i].hsf.skin != NULL);
+        HOST_CHECK(HostCharData[i].hsf.jointOrderCnt == HOST_OBJECTS);
+        for(j=0; j<HOST_MESHES; j++) {
+            vtx_num += HostCharData[i].vertex[j].count;
+        }
+    }
+    for(frame=0; frame<HOST_FRAMES; frame++) {
+        for(i=0; i<HOST_OBJECTS; i++) {
+            HostTransformMake(&HostMotion[frame][i], HostRand(5) == 0);
+        }
+    }
+    HostCompareTest();
+    HostFallbackTest();
+    printf("envelope %d players x %d frames, %d vertices: cenv walk %.1fms, skin plan %.1fms\n",
+        HOST_CHAR_NUM, HOST_FRAMES, vtx_num, HostPlayTime(FALSE)*1000, HostPlayTime(TRUE)*1000);
+    return HostEnd("envelope");
+}
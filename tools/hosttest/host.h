@@ -0,0 +1,76 @@
+#ifndef _HOSTTEST_HOST_H
+#define _HOSTTEST_HOST_H
+
+//Included first by every host test, ahead of the game source the test covers
+//tools/hosttest.py builds with TARGET_PC, which keeps u32 and s32 at their console sizes
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+//object.h and sprite.h name these structs in a prototype before defining them, which gcc would scope to the prototype
+struct om_obj_data;
+struct hu_sprite;
+
+#include "dolphin.h"
+
+static s32 HostCheckNum;
+static s32 HostFailNum;
+static volatile s32 HostIrqLevel;
+
+#define HOST_CHECK(cond) HostCheck((cond) != 0, #cond, __FILE__, __LINE__)
+
+static void HostCheck(BOOL ok, const char *expr, const char *file, s32 line)
+{
+    HostCheckNum++;
+    if(!ok) {
+        HostFailNum++;
+        printf("%s:%d: check failed: %s\n", file, line, expr);
+    }
+}
+
+//Prints the result line and gives the exit code tools/hosttest.py looks at
+static int HostEnd(const char *name)
+{
+    printf("%s: %d checks, %d failed\n", name, HostCheckNum, HostFailNum);
+    return HostFailNum != 0;
+}
+
+//Memory for the game's heaps has to sit below 4GB, the game keeps pointers in u32
+static void *HostMemAlloc(u32 size)
+{
+    void *ptr = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_32BIT, -1, 0);
+    if(ptr == MAP_FAILED) {
+        printf("HostMemAlloc: no memory below 4GB for %x bytes\n", size);
+        exit(2);
+    }
+    return ptr;
+}
+
+//Set HOST_VERBOSE in the environment to see the game's own reports
+void OSReport(const char *msg, ...)
+{
+    va_list args;
+    if(!getenv("HOST_VERBOSE")) {
+        return;
+    }
+    va_start(args, msg);
+    vprintf(msg, args);
+    va_end(args);
+}
+
+//Tests that run callbacks as if from an interrupt raise HostIrqLevel around them
+BOOL OSDisableInterrupts(void)
+{
+    return HostIrqLevel++ == 0;
+}
+
+BOOL OSRestoreInterrupts(BOOL level)
+{
+    HostIrqLevel--;
+    return level;
+}
+
+#endif
@@ -0,0 +1,288 @@
+//Keyframe search in hsfmotion.c, checked against the linear scans it replaced
+//Random tracks are sampled by sweeps and random seeks, then every track of a generated
+//motion is evaluated over its whole length with both versions and timed
+
+#include "host.h"
+#include <time.h>
+#include "game/hsfmotion.c"
+
+#define HOST_RANDOM_NUM 3000
+#define HOST_SAMPLE_NUM 400
+#define HOST_BENCH_TRACKS 300
+#define HOST_BENCH_FRAMES 1800
+#define HOST_SEEK_NUM 200000
+
+static u32 HostSeed = 1;
+
+ModelData Hu3DData[0x200];
+CameraData Hu3DCamera[0x10];
+LightData Hu3DGlobalLight[0x8];
+float minimumVcountf;
+
+void ClusterAdjustObject(HsfData *model, HsfData *src_model) {}
+void ClusterMotionExec(ModelData *arg0) {}
+void ClusterProc(ModelData *arg0) {}
+void EnvelopeProc(HsfData *arg0) {}
+float GetClusterCurve(HsfTrack *arg0, float arg1) { return 0.0f; }
+float GetClusterWeightCurve(HsfTrack *arg0, float arg1) { return 0.0f; }
+void Hu3DGLightPosAimSetV(s16 light, Vec *pos, Vec *aim) {}
+HsfObject *Hu3DModelObjPtrGet(s16 model, char *name) { return NULL; }
+void *HuMemDirectMallocNum(HeapID heap, s32 size, u32 num) { return NULL; }
+void InitVtxParm(HsfData *arg0) {}
+void KillHSF(HsfData *data) {}
+HsfData *LoadHSF(void *data) { return NULL; }
+HsfConstData *ObjConstantMake(HsfObject *arg0, u32 arg1) { return NULL; }
+void PPCSync() {}
+void PSVECNormalize(const Vec *src, Vec *unit) {}
+void PSVECSubtract(const Vec *a, const Vec *b, Vec *a_b) {}
+s32 SearchObjectName(HsfData *data, char *name) { return -1; }
+char *SetName(u32 *str_ofs) { return NULL; }
+void ShapeProc(HsfData *arg0) {}
+
+static u32 HostRand(void)
+{
+    HostSeed = HostSeed*1103515245+12345;
+    return HostSeed >> 8;
+}
+
+static float HostRandF(float max)
+{
+    return (HostRand()%100000)/100000.0f*max;
+}
+
+static BOOL HostSame(float a, float b)
+{
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+//Old scans, kept as the reference output
+
+static float RefGetConstant(s32 num, float *keys, float time)
+{
+    s32 i;
+    if(time == 0.0f || num == 1) {
+        return keys[1];
+    }
+    for(i=0; i<num; i++, keys += 2) {
+        if(time < keys[0]) {
+            break;
+        }
+    }
+    return keys[-1];
+}
+
+static float RefGetLinear(s32 num, float keys[][2], float time)
+{
+    s32 i;
+    if(time == 0.0f || num == 1) {
+        return keys[0][1];
+    }
+    for(i=0; i<num; i++) {
+        if(time < keys[i][0]) {
+            return keys[i-1][1]+(time-keys[i-1][0])*((keys[i][1]-keys[i-1][1])/(keys[i][0]-keys[i-1][0]));
+        }
+    }
+    return keys[num-1][1];
+}
+
+static float RefGetBezier(s32 num, HsfTrack *track, float time)
+{
+    float (*keys)[4] = track->data;
+    float t, t2, t3;
+    s32 i;
+    if(time == 0.0f || num == 1) {
+        return keys[0][1];
+    }
+    for(i=0; i<num; i++) {
+        if(time < keys[i][0]) {
+            break;
+        }
+    }
+    if(i == num) {
+        return keys[num-1][1];
+    }
+    keys += i-1;
+    t = (time-keys[0][0])/(keys[1][0]-keys[0][0]);
+    t2 = t*t;
+    t3 = t*t2;
+    return keys[0][1]*(t*(2.0f*t2)-3.0f*t2+1.0f)
+        + keys[1][1]*(-(t*(2.0f*t2))+3.0f*t2)
+        + keys[0][2]*(t3-2.0f*t2+t)
+        + keys[1][3]*(t3-t2);
+}
+
+static HsfBitmap *RefGetBitMap(s32 num, UnknownHsfMotionStruct01 *keys, float time)
+{
+    s32 i;
+    if(time == 0.0f || num == 1) {
+        return keys->unk04;
+    }
+    for(i=0; i<num; i++, keys++) {
+        if(time < keys->unk00*60.0f) {
+            break;
+        }
+    }
+    return keys[-1].unk04;
+}
+
+static float RefGetCurve(HsfTrack *track, float time)
+{
+    switch(track->curveType) {
+        case 0:
+            return RefGetConstant(track->numKeyframes, track->data, time);
+
+        case 1:
+            return RefGetLinear(track->numKeyframes, track->data, time);
+
+        case 2:
+            return RefGetBezier(track->numKeyframes, track, time);
+
+        case 3:
+            bitMapPtr = RefGetBitMap(track->numKeyframes, track->data, time);
+            break;
+
+        case 4:
+            return track->value;
+    }
+    return 0.0f;
+}
+
+//Times only go up, with repeats and whole frames mixed in
+static float HostKeyTimeNext(float time)
+{
+    time += (HostRand()%5 == 0) ? 0.0f : HostRandF(4);
+    if(HostRand()%9 == 0) {
+        time = (s32)time+1.0f;
+    }
+    return time;
+}
+
+static void HostRandomTest(void)
+{
+    static u8 bitmap[600];
+    float *linear, *bezier;
+    UnknownHsfMotionStruct01 *bits;
+    HsfTrack track;
+    float time, end;
+    s32 i, j, num;
+    u8 *mem = HostMemAlloc(0x10000*4);
+    for(i=0; i<HOST_RANDOM_NUM; i++) {
+        num = 1+HostRand()%((i%7 == 0) ? 600 : 40);
+        //Times before the first key read the entry in front of the keys, as the old scans did
+        linear = (float *)mem+4;
+        bezier = linear+num*2+4;
+        bits = (UnknownHsfMotionStruct01 *)(bezier+num*4)+1;
+        linear[-1] = 123.0f;
+        bezier[-3] = 5.0f;
+        bits[-1].unk04 = (HsfBitmap *)&bitmap[599];
+        time = (HostRand()%3 == 0) ? 0.0f : HostRandF(3);
+        for(j=0; j<num; j++) {
+            time = HostKeyTimeNext(time);
+            linear[j*2] = bezier[j*4] = time;
+            linear[j*2+1] = HostRandF(10)-5;
+            bezier[j*4+1] = HostRandF(10);
+            bezier[j*4+2] = HostRandF(2);
+            bezier[j*4+3] = HostRandF(2);
+            bits[j].unk00 = time/60.0f;
+            bits[j].unk04 = (HsfBitmap *)&bitmap[j];
+        }
+        end = time;
+        memset(&track, 0, sizeof(track));
+        track.numKeyframes = num;
+        track.data = bezier;
+        for(j=0; j<HOST_SAMPLE_NUM; j++) {
+            if(j < HOST_SAMPLE_NUM/2) {
+                time = (j/(HOST_SAMPLE_NUM/2.0f))*(end+2)-1;
+            } else {
+                time = HostRandF(end+4)-2;
+            }
+            if(HostRand()%20 == 0) {
+                time = (s32)time;
+            }
+            if(HostRand()%30 == 0) {
+                time = linear[(HostRand()%num)*2];
+            }
+            HOST_CHECK(HostSame(GetConstant(num, linear, time), RefGetConstant(num, linear, time)));
+            HOST_CHECK(HostSame(GetLinear(num, (void *)linear, time), RefGetLinear(num, (void *)linear, time)));
+            HOST_CHECK(HostSame(GetBezier(num, &track, time), RefGetBezier(num, &track, time)));
+            HOST_CHECK(GetBitMap(num, bits, time) == RefGetBitMap(num, bits, time));
+        }
+    }
+}
+
+//One long motion: evenly spaced Bezier, linear and constant tracks of 16-1200 keys
+//Frame 0 is before the first key, so each key array has a zeroed key in front of it
+static HsfMotion *HostMotionMake(void)
+{
+    HsfMotion *motion = HostMemAlloc(sizeof(HsfMotion)+HOST_BENCH_TRACKS*sizeof(HsfTrack));
+    HsfTrack *track;
+    float *keys;
+    s32 i, j, num, stride;
+    motion->numTracks = HOST_BENCH_TRACKS;
+    motion->track = (HsfTrack *)(motion+1);
+    motion->len = HOST_BENCH_FRAMES;
+    for(i=0; i<HOST_BENCH_TRACKS; i++) {
+        track = &motion->track[i];
+        num = 16+HostRand()%1185;
+        track->curveType = (i%4 == 3) ? 0 : (i%2)+1;
+        stride = (track->curveType == 2) ? 4 : 2;
+        keys = (float *)HostMemAlloc((num+1)*stride*sizeof(float))+stride;
+        for(j=0; j<num; j++) {
+            keys[j*stride] = j*(HOST_BENCH_FRAMES/(float)num)+0.5f;
+            keys[j*stride+1] = HostRandF(1);
+            if(stride == 4) {
+                keys[j*stride+2] = keys[j*stride+3] = 0.0f;
+            }
+        }
+        track->numKeyframes = num;
+        track->data = keys;
+    }
+    return motion;
+}
+
+static double HostPlayTime(HsfMotion *motion, float (*curve)(HsfTrack *, float), float *sum)
+{
+    clock_t start = clock();
+    s32 frame, i;
+    *sum = 0.0f;
+    for(frame=0; frame<=motion->len; frame++) {
+        for(i=0; i<motion->numTracks; i++) {
+            *sum += curve(&motion->track[i], frame+0.25f);
+        }
+    }
+    return (double)(clock()-start)/CLOCKS_PER_SEC;
+}
+
+static double HostSeekTime(HsfMotion *motion, float (*curve)(HsfTrack *, float), float *sum)
+{
+    clock_t start = clock();
+    s32 i;
+    HostSeed = 9;
+    *sum = 0.0f;
+    for(i=0; i<HOST_SEEK_NUM; i++) {
+        *sum += curve(&motion->track[HostRand()%motion->numTracks], HostRandF(motion->len));
+    }
+    return (double)(clock()-start)/CLOCKS_PER_SEC;
+}
+
+static void HostBench(void)
+{
+    HsfMotion *motion = HostMotionMake();
+    double ref_time, time;
+    float ref_sum, sum;
+    ref_time = HostPlayTime(motion, RefGetCurve, &ref_sum);
+    time = HostPlayTime(motion, GetCurve, &sum);
+    HOST_CHECK(HostSame(sum, ref_sum));
+    printf("hsfmotion %d tracks x %d frames: old %.1fms new %.1fms\n", HOST_BENCH_TRACKS, HOST_BENCH_FRAMES, ref_time*1000, time*1000);
+    ref_time = HostSeekTime(motion, RefGetCurve, &ref_sum);
+    time = HostSeekTime(motion, GetCurve, &sum);
+    HOST_CHECK(HostSame(sum, ref_sum));
+    printf("hsfmotion %d random seeks: old %.1fms new %.1fms\n", HOST_SEEK_NUM, ref_time*1000, time*1000);
+}
+
+int main(void)
+{
+    HostRandomTest();
+    HostBench();
+    return HostEnd("hsfmotion");
+}
@@ -0,0 +1,28 @@
+#ifndef _DOLPHIN_OSFASTCAST
+#define _DOLPHIN_OSFASTCAST
+
+//Plain C versions of the paired single casts, found ahead of include/dolphin/os/OSFastCast.h by the host tests
+
+#define OS_GQR_F32 0x0000
+#define OS_GQR_U8 0x0004
+#define OS_GQR_U16 0x0005
+#define OS_GQR_S8 0x0006
+#define OS_GQR_S16 0x0007
+
+#define OS_FASTCAST_U8 2
+#define OS_FASTCAST_U16 3
+#define OS_FASTCAST_S8 4
+#define OS_FASTCAST_S16 5
+
+static inline void OSInitFastCast(void) {}
+
+static inline void OSf32tos16(f32 *f, s16 *out) { *out = (s16)*f; }
+static inline void OSf32tou8(f32 *f, u8 *out) { *out = (u8)*f; }
+static inline void OSf32tos8(f32 *f, s8 *out) { *out = (s8)*f; }
+static inline void OSf32tou16(f32 *f, u16 *out) { *out = (u16)*f; }
+static inline void OSs8tof32(const s8 *in, float *out) { *out = *in; }
+static inline void OSs16tof32(const s16 *in, float *out) { *out = *in; }
+static inline void OSu8tof32(const u8 *in, float *out) { *out = *in; }
+static inline void OSu16tof32(const u16 *in, float *out) { *out = *in; }
+
+#endif // _DOLPHIN_OSFASTCAST
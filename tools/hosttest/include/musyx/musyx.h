@@ -0,0 +1,18 @@
+#ifndef _MUSYX_MUSYX
+#define _MUSYX_MUSYX
+
+//The MusyX types the msm headers name, found ahead of the extern/musyx submodule by the host tests
+
+#include "dolphin/types.h"
+
+typedef u16 SND_FXID;
+typedef u16 SND_GROUPID;
+typedef u16 SND_SONGID;
+
+typedef enum {
+    SND_OUTPUTMODE_MONO = 0,
+    SND_OUTPUTMODE_STEREO,
+    SND_OUTPUTMODE_SURROUND
+} SND_OUTPUTMODE;
+
+#endif
@@ -0,0 +1,278 @@
+//HuMem heaps in memory.c, replaying one generated allocation trace through a first-fit and a binned heap
+//The trace mixes small and large allocations, frees and frees by tag; both heaps are walked
+//for consistency as it runs, then the replay is timed
+
+#include "host.h"
+#include <time.h>
+#include "game/memory.c"
+
+#define HOST_HEAP_SIZE 0x4000000
+#define HOST_SLOT_MAX 4000
+#define HOST_TAG_MAX 8
+#define HOST_TRACE_MAX 200000
+#define HOST_CHECK_STEP 4096
+
+#define HOST_OP_ALLOC 0
+#define HOST_OP_FREE 1
+#define HOST_OP_FREE_NUM 2
+
+typedef struct host_op {
+    u8 type;
+    u8 num;
+    u16 slot;
+    s32 size;
+} HostOp;
+
+static HostOp HostTrace[HOST_TRACE_MAX];
+static s32 HostTraceNum;
+static u8 *HostSlotPtr[HOST_SLOT_MAX];
+static s32 HostSlotSize[HOST_SLOT_MAX];
+static u32 HostSeed = 5;
+
+static u32 HostRand(void)
+{
+    HostSeed = HostSeed*1103515245+12345;
+    return (HostSeed >> 16) & 0x7FFF;
+}
+
+static u32 HostSlotRetAddr(s32 slot)
+{
+    return 0x80000000+(slot%100)*4;
+}
+
+//Scene-like churn: mostly small blocks, some large ones, and now and then every block of one tag goes at once
+static void HostTraceGen(void)
+{
+    static BOOL live[HOST_SLOT_MAX];
+    HostOp *op;
+    s32 i, slot, num;
+    HostTraceNum = 0;
+    for(i=0; i<HOST_TRACE_MAX; i++) {
+        op = &HostTrace[HostTraceNum++];
+        if(i%50000 == 49999) {
+            num = HostRand()%HOST_TAG_MAX;
+            op->type = HOST_OP_FREE_NUM;
+            op->num = num;
+            for(slot=num; slot<HOST_SLOT_MAX; slot += HOST_TAG_MAX) {
+                live[slot] = FALSE;
+            }
+            continue;
+        }
+        slot = HostRand()%HOST_SLOT_MAX;
+        op->slot = slot;
+        op->num = slot%HOST_TAG_MAX;
+        if(live[slot]) {
+            op->type = HOST_OP_FREE;
+            live[slot] = FALSE;
+        } else {
+            op->type = HOST_OP_ALLOC;
+            op->size = (HostRand()%8 == 0) ? HostRand()*2 : HostRand()%512;
+            live[slot] = TRUE;
+        }
+    }
+}
+
+static u8 HostSlotByte(s32 slot)
+{
+    return slot*13+1;
+}
+
+static BOOL HostSlotChk(s32 slot)
+{
+    u8 *ptr = HostSlotPtr[slot];
+    s32 i;
+    for(i=0; i<HostSlotSize[slot]; i++) {
+        if(ptr[i] != HostSlotByte(slot)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+//Walks the block list: links agree, sizes cover the heap, free neighbours were merged,
+//and in a binned heap every free block is on the list of its size class
+static BOOL HostHeapChk(struct memory_block *heap_ptr)
+{
+    struct memory_block *block = heap_ptr;
+    struct memory_heap *heap = &HeapWork[heap_ptr->heap-1];
+    struct memory_block *bin_block;
+    s32 size = 0;
+    s32 free_num = 0;
+    s32 bin_num = 0;
+    s32 i;
+    do {
+        if(block->next->prev != block || block->size < MEM_BLOCK_HEADER || (block->size & 0x1F)) {
+            return FALSE;
+        }
+        if(block->flag) {
+            if(block->magic != 165) {
+                return FALSE;
+            }
+        } else {
+            if(block->magic != 205) {
+                return FALSE;
+            }
+            if(block->next != heap_ptr && !block->next->flag) {
+                return FALSE;
+            }
+            free_num++;
+        }
+        if(block->next != heap_ptr && (u8 *)block+block->size != (u8 *)block->next) {
+            return FALSE;
+        }
+        size += block->size;
+        block = block->next;
+    } while(block != heap_ptr);
+    if(size != HOST_HEAP_SIZE) {
+        return FALSE;
+    }
+    if(!heap->bin_mode) {
+        return TRUE;
+    }
+    for(i=0; i<MEM_BIN_MAX; i++) {
+        if(!(heap->bin.map[i >> 5] & (1 << (i & 0x1F))) != !heap->bin.list[i]) {
+            return FALSE;
+        }
+        for(bin_block = heap->bin.list[i]; bin_block; bin_block = bin_block->free_next) {
+            if(bin_block->flag || HuMemBinIndex(bin_block->size) != i) {
+                return FALSE;
+            }
+            bin_num++;
+        }
+    }
+    return bin_num == free_num;
+}
+
+//Returns the number of allocations that failed
+static s32 HostReplay(void *heap_ptr, BOOL check)
+{
+    HostOp *op;
+    s32 i, slot, live_num, fail_num;
+    HuMemStat *stat = HuMemHeapStatGet(heap_ptr);
+    memset(HostSlotPtr, 0, sizeof(HostSlotPtr));
+    live_num = fail_num = 0;
+    for(i=0; i<HostTraceNum; i++) {
+        op = &HostTrace[i];
+        slot = op->slot;
+        switch(op->type) {
+            case HOST_OP_ALLOC:
+                HostSlotPtr[slot] = HuMemMemoryAllocNum(heap_ptr, op->size, op->num, HostSlotRetAddr(slot));
+                HostSlotSize[slot] = op->size;
+                if(!HostSlotPtr[slot]) {
+                    fail_num++;
+                    break;
+                }
+                live_num++;
+                if(check) {
+                    HOST_CHECK(HuMemMemorySizeGet(HostSlotPtr[slot]) >= op->size);
+                    memset(HostSlotPtr[slot], HostSlotByte(slot), op->size);
+                }
+                break;
+
+            case HOST_OP_FREE:
+                if(!HostSlotPtr[slot]) {
+                    break;
+                }
+                if(check) {
+                    HOST_CHECK(HostSlotChk(slot));
+                }
+                HuMemMemoryFree(HostSlotPtr[slot], HostSlotRetAddr(slot));
+                HostSlotPtr[slot] = NULL;
+                live_num--;
+                break;
+
+            case HOST_OP_FREE_NUM:
+                HuMemMemoryFreeNum(heap_ptr, op->num, 0);
+                for(slot=op->num; slot<HOST_SLOT_MAX; slot += HOST_TAG_MAX) {
+                    if(HostSlotPtr[slot]) {
+                        HostSlotPtr[slot] = NULL;
+                        live_num--;
+                    }
+                }
+                break;
+        }
+        if(check && i%HOST_CHECK_STEP == 0) {
+            HOST_CHECK(HostHeapChk(heap_ptr));
+            HOST_CHECK(HuMemUsedMemoryBlockGet(heap_ptr) == live_num);
+            HOST_CHECK(stat->used_num == live_num);
+            HOST_CHECK(stat->used_size == HuMemUsedMemorySizeGet(heap_ptr));
+        }
+    }
+    for(slot=0; slot<HOST_SLOT_MAX; slot++) {
+        if(HostSlotPtr[slot]) {
+            if(check) {
+                HOST_CHECK(HostSlotChk(slot));
+            }
+            HuMemMemoryFree(HostSlotPtr[slot], HostSlotRetAddr(slot));
+        }
+    }
+    return fail_num;
+}
+
+static void HostTraceTest(void *heap_ptr)
+{
+    HuMemStat *stat = HuMemHeapStatGet(heap_ptr);
+    s32 i;
+    HOST_CHECK(HostReplay(heap_ptr, TRUE) == 0);
+    HOST_CHECK(HostHeapChk(heap_ptr));
+    HOST_CHECK(HuMemUsedMemorySizeGet(heap_ptr) == 0);
+    HOST_CHECK(stat->used_num == 0 && stat->used_size == 0);
+    HOST_CHECK(stat->other_num == 0);
+    for(i=0; i<HUMEM_STAT_CALL_MAX; i++) {
+        HOST_CHECK(stat->call[i].num == 0 && stat->call[i].size == 0);
+    }
+    //Everything was merged back into the one block the heap started as
+    HOST_CHECK(((struct memory_block *)heap_ptr)->next == heap_ptr);
+    HuMemHeapDump(heap_ptr, -1);
+}
+
+//Tag frees leave blocks of other tags alone and both heap modes dump the same way
+static void HostFreeNumTest(void *heap_ptr)
+{
+    void *ptr[HOST_TAG_MAX*4];
+    s32 i;
+    for(i=0; i<HOST_TAG_MAX*4; i++) {
+        ptr[i] = HuMemMemoryAllocNum(heap_ptr, 100+i*40, i%HOST_TAG_MAX, 0x80001000);
+        HOST_CHECK(ptr[i] != NULL);
+    }
+    HuMemMemoryFreeNum(heap_ptr, 3, 0);
+    for(i=0; i<HOST_TAG_MAX*4; i++) {
+        if(i%HOST_TAG_MAX == 3) {
+            HOST_CHECK(HuMemMemorySizeGet(ptr[i]) == 0);
+        } else {
+            HOST_CHECK(HuMemMemorySizeGet(ptr[i]) >= 100+i*40);
+            HOST_CHECK(DATA_GET_BLOCK(ptr[i])->num == i%HOST_TAG_MAX);
+            HOST_CHECK(DATA_GET_BLOCK(ptr[i])->retaddr == 0x80001000);
+        }
+    }
+    HOST_CHECK(HuMemUsedMemoryBlockGet(heap_ptr) == HOST_TAG_MAX*4-4);
+    HOST_CHECK(HostHeapChk(heap_ptr));
+    for(i=0; i<HOST_TAG_MAX; i++) {
+        HuMemMemoryFreeNum(heap_ptr, i, 0);
+    }
+    HOST_CHECK(HuMemUsedMemorySizeGet(heap_ptr) == 0);
+    HOST_CHECK(HostHeapChk(heap_ptr));
+}
+
+static double HostBenchTime(void *heap_ptr)
+{
+    clock_t start = clock();
+    HOST_CHECK(HostReplay(heap_ptr, FALSE) == 0);
+    return (double)(clock()-start)/CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+    void *heap_ptr = HuMemHeapInitStat(HostMemAlloc(HOST_HEAP_SIZE), HOST_HEAP_SIZE);
+    void *bin_heap_ptr = HuMemHeapInitBin(HostMemAlloc(HOST_HEAP_SIZE), HOST_HEAP_SIZE);
+    double time, bin_time;
+    HostTraceGen();
+    HostFreeNumTest(heap_ptr);
+    HostFreeNumTest(bin_heap_ptr);
+    HostTraceTest(heap_ptr);
+    HostTraceTest(bin_heap_ptr);
+    time = HostBenchTime(heap_ptr);
+    bin_time = HostBenchTime(bin_heap_ptr);
+    printf("memory %d ops: first fit %.1fms, binned %.1fms\n", HostTraceNum, time*1000, bin_time*1000);
+    return HostEnd("memory");
+}
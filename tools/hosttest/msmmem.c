@@ -0,0 +1,310 @@
+//Sound pool in msmmem.c, replaying one generated scene trace in first-fit and best-fit mode
+//The block chain, the best-fit bins and msmMemGetStat are checked as it runs, and the
+//failed allocations and fragmentation of each mode are printed
+//The trace is generated: no trace recorded on hardware was available
+
+#include "host.h"
+#include <stdint.h>
+#include "msm/msmmem.c"
+
+#define HOST_TRACE_MAX 100000
+#define HOST_ID_MAX 100000
+#define HOST_SCENE_NUM 300
+#define HOST_LIVE_MAX 4096
+#define HOST_GROUP_MAX 16
+#define HOST_CHECK_STEP 64
+
+#define HOST_OP_ALLOC 0
+#define HOST_OP_FREE 1
+
+typedef struct host_op {
+    u8 type;
+    s32 id;
+    u32 size;
+} HostOp;
+
+static HostOp HostTrace[HOST_TRACE_MAX];
+static s32 HostTraceNum;
+static u8 *HostIdPtr[HOST_ID_MAX];
+static u32 HostIdSize[HOST_ID_MAX];
+static u32 HostSeed = 11;
+
+//msmmem.c keeps whole pointers, so unlike the game heaps its pool is not held below 4GB
+static u8 *HostPoolAlloc(u32 size)
+{
+    void *ptr = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if(ptr == MAP_FAILED) {
+        printf("HostPoolAlloc: no memory for %x bytes\n", size);
+        exit(2);
+    }
+    return ptr;
+}
+
+static u32 HostRand(void)
+{
+    HostSeed = HostSeed*1103515245+12345;
+    return (HostSeed >> 16) & 0x7FFF;
+}
+
+static void HostTraceAdd(u8 type, s32 id, u32 size)
+{
+    HostOp *op = &HostTrace[HostTraceNum++];
+    op->type = type;
+    op->id = id;
+    op->size = size;
+}
+
+//Resident data, then per scene a few sound groups and short lived voice and stream scratch
+//About one group in five stays loaded into the next scene
+static void HostTraceGen(void)
+{
+    static s32 live[HOST_LIVE_MAX];
+    s32 group[HOST_GROUP_MAX];
+    s32 keep[HOST_GROUP_MAX];
+    s32 id, live_num, group_num, keep_num;
+    s32 scene, i, j;
+    u32 size;
+    id = live_num = keep_num = 0;
+    HostTraceNum = 0;
+    for(i=0; i<12; i++) {
+        HostTraceAdd(HOST_OP_ALLOC, id++, 0x800+HostRand()%0x8000);
+    }
+    for(scene=0; scene<HOST_SCENE_NUM; scene++) {
+        group_num = 3+HostRand()%8;
+        for(i=0; i<group_num; i++) {
+            if(HostRand()%4 == 0) {
+                size = 0x20000+((HostRand() << 2)%0x30000);
+            } else {
+                size = 0x1000+HostRand()%0x10000;
+            }
+            HostTraceAdd(HOST_OP_ALLOC, id, size);
+            group[i] = id++;
+        }
+        for(i=0; i<200; i++) {
+            if(live_num < HOST_LIVE_MAX && HostRand()%2) {
+                HostTraceAdd(HOST_OP_ALLOC, id, 0x40+HostRand()%0x800);
+                live[live_num++] = id++;
+            } else if(live_num) {
+                j = HostRand()%live_num;
+                HostTraceAdd(HOST_OP_FREE, live[j], 0);
+                live[j] = live[--live_num];
+            }
+        }
+        for(i=0; i<keep_num; i++) {
+            HostTraceAdd(HOST_OP_FREE, keep[i], 0);
+        }
+        keep_num = 0;
+        for(i=0; i<group_num; i++) {
+            if(HostRand()%5) {
+                HostTraceAdd(HOST_OP_FREE, group[i], 0);
+            } else {
+                keep[keep_num++] = group[i];
+            }
+        }
+    }
+}
+
+static u8 HostIdByte(s32 id)
+{
+    return id*13+1;
+}
+
+static BOOL HostIdChk(s32 id)
+{
+    u8 *ptr = HostIdPtr[id];
+    u32 i;
+    for(i=0; i<HostIdSize[id]; i++) {
+        if(ptr[i] != HostIdByte(id)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+//Walks the chain: links agree, the blocks and the space behind them cover the pool,
+//and in best-fit mode every block with space behind it is in the bin for that space
+static BOOL HostPoolChk(void)
+{
+    MSMBLOCK *block;
+    u32 size = 0;
+    s32 free_num = 0;
+    s32 bin_num = 0;
+    s32 i;
+    for(block = &mem.first; block; block = block->next) {
+        if(block->next && block->next->prev != block) {
+            return FALSE;
+        }
+        if((block->freeSize & 0x1F) || (block->size & 0x1F)) {
+            return FALSE;
+        }
+        if(block->next && (u8 *)block->ptr+block->freeSize-((block->freeSize != 0) ? MSM_MEM_BLOCK_HEADER : 0)+block->size != (u8 *)block->next) {
+            return FALSE;
+        }
+        size += block->freeSize+block->size;
+        if(block->size) {
+            free_num++;
+        }
+    }
+    if(size != mem.size) {
+        return FALSE;
+    }
+    if(mem.mode != MSM_MEM_BESTFIT) {
+        return TRUE;
+    }
+    for(i=0; i<MSM_MEM_BIN_MAX; i++) {
+        if(!mem.bin[i] != !(mem.binMask & (1 << i))) {
+            return FALSE;
+        }
+        for(block = mem.bin[i]; block; block = block->binNext) {
+            if(block->size == 0 || msmMemBinNo(block->size) != i) {
+                return FALSE;
+            }
+            if(block->binNext && block->binNext->binPrev != block) {
+                return FALSE;
+            }
+            bin_num++;
+        }
+    }
+    return bin_num == free_num;
+}
+
+//The statistics agree with a walk of the chain
+static BOOL HostStatChk(MSM_MEMSTAT *stat)
+{
+    MSMBLOCK *block;
+    u32 free_size = 0;
+    u32 largest = 0;
+    u32 free_num = 0;
+    for(block = &mem.first; block; block = block->next) {
+        if(block->size) {
+            free_size += block->size;
+            free_num++;
+            if(largest < block->size) {
+                largest = block->size;
+            }
+        }
+    }
+    if(stat->totalSize != mem.size || stat->useSize+free_size != mem.size) {
+        return FALSE;
+    }
+    if(stat->freeSize != free_size || stat->largestFree != largest || stat->freeNum != free_num) {
+        return FALSE;
+    }
+    if(stat->peakSize < stat->useSize) {
+        return FALSE;
+    }
+    return stat->fragRatio >= 0.0f && stat->fragRatio <= 1.0f;
+}
+
+//Returns the number of allocations that failed
+static s32 HostReplay(s32 mode, u32 heap_size)
+{
+    static const char *names[] = { "first-fit", "best-fit" };
+    u8 *buf = HostPoolAlloc(heap_size+0x40);
+    MSM_MEMSTAT stat;
+    HostOp *op;
+    float frag_max = 0.0f;
+    s32 i, fail_num = 0;
+    u32 peak = 0;
+    memset(HostIdPtr, 0, sizeof(HostIdPtr));
+    mem.ptr = NULL;
+    msmMemSetMode(mode);
+    //Start off the 0x20 boundary, msmMemInit aligns the pool itself
+    msmMemInit(buf+4, heap_size);
+    HOST_CHECK(((uintptr_t)mem.ptr & 0x1F) == 0 && mem.size <= heap_size && mem.size+0x20 > heap_size-4);
+    for(i=0; i<HostTraceNum; i++) {
+        op = &HostTrace[i];
+        if(op->type == HOST_OP_ALLOC) {
+            HostIdPtr[op->id] = msmMemAlloc(op->size);
+            HostIdSize[op->id] = op->size;
+            if(HostIdPtr[op->id]) {
+                HOST_CHECK(((uintptr_t)HostIdPtr[op->id] & 0x1F) == 0);
+                memset(HostIdPtr[op->id], HostIdByte(op->id), op->size);
+            } else {
+                fail_num++;
+            }
+        } else if(HostIdPtr[op->id]) {
+            HOST_CHECK(HostIdChk(op->id));
+            msmMemFree(HostIdPtr[op->id]);
+            HostIdPtr[op->id] = NULL;
+        }
+        if(i%HOST_CHECK_STEP == 0) {
+            HOST_CHECK(HostPoolChk());
+            msmMemGetStat(&stat);
+            HOST_CHECK(HostStatChk(&stat));
+            if(peak < stat.useSize) {
+                peak = stat.useSize;
+            }
+            if(frag_max < stat.fragRatio) {
+                frag_max = stat.fragRatio;
+            }
+        }
+    }
+    HOST_CHECK(HostPoolChk());
+    msmMemGetStat(&stat);
+    HOST_CHECK(HostStatChk(&stat));
+    HOST_CHECK(stat.peakSize >= peak);
+    printf("msmmem %-9s pool %x: %d failed allocs, peak %x, largest free %x of %x in %d holes, frag %.3f (max %.3f)\n",
+        names[mode], heap_size, fail_num, stat.peakSize, stat.largestFree, stat.freeSize, stat.freeNum, stat.fragRatio, frag_max);
+    for(i=0; i<HOST_ID_MAX; i++) {
+        if(HostIdPtr[i]) {
+            HOST_CHECK(HostIdChk(i));
+            msmMemFree(HostIdPtr[i]);
+        }
+    }
+    //Everything merged back into the space behind the first block
+    msmMemGetStat(&stat);
+    HOST_CHECK(stat.useSize == 0 && stat.freeNum == 1 && stat.largestFree == mem.size);
+    HOST_CHECK(mem.first.next == NULL && HostPoolChk());
+    munmap(buf, heap_size+0x40);
+    return fail_num;
+}
+
+//Frees of pointers the pool did not hand out are ignored, and switching modes on a live pool rebuilds the bins
+static void HostModeTest(void)
+{
+    u8 *buf = HostPoolAlloc(0x10000);
+    static u8 other[0x100];
+    u8 *ptr[8];
+    MSM_MEMSTAT stat;
+    s32 i;
+    mem.ptr = NULL;
+    msmMemSetMode(MSM_MEM_FIRSTFIT);
+    msmMemInit(buf, 0x10000);
+    for(i=0; i<8; i++) {
+        ptr[i] = msmMemAlloc(0x100+i*0x180);
+        HOST_CHECK(ptr[i] != NULL);
+    }
+    for(i=0; i<8; i += 2) {
+        msmMemFree(ptr[i]);
+    }
+    msmMemFree(ptr[0]);
+    msmMemFree(other+0x80);
+    msmMemGetStat(&stat);
+    HOST_CHECK(HostStatChk(&stat) && stat.freeNum == 5);
+    msmMemSetMode(MSM_MEM_BESTFIT);
+    HOST_CHECK(HostPoolChk());
+    //The smallest hole that fits is the one ptr[2] left
+    ptr[0] = msmMemAlloc(0x3C0);
+    HOST_CHECK(ptr[0] == ptr[2]);
+    HOST_CHECK(msmMemAlloc(0x10000) == NULL);
+    HOST_CHECK(HostPoolChk());
+    msmMemSetMode(MSM_MEM_FIRSTFIT);
+    HOST_CHECK(mem.binMask == 0 && HostPoolChk());
+    munmap(buf, 0x10000);
+}
+
+int main(void)
+{
+    s32 fail_num, bin_fail_num;
+    HostTraceGen();
+    printf("msmmem trace: %d ops\n", HostTraceNum);
+    HostModeTest();
+    fail_num = HostReplay(MSM_MEM_FIRSTFIT, 0x13FC00);
+    bin_fail_num = HostReplay(MSM_MEM_BESTFIT, 0x13FC00);
+    HOST_CHECK(bin_fail_num <= fail_num);
+    fail_num = HostReplay(MSM_MEM_FIRSTFIT, 0x100000);
+    bin_fail_num = HostReplay(MSM_MEM_BESTFIT, 0x100000);
+    HOST_CHECK(bin_fail_num <= fail_num);
+    return HostEnd("msmmem");
+}
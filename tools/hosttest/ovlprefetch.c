@@ -0,0 +1,459 @@
+//Overlay prefetch in objmain.c and module prefetch in objdll.c
+//Checks the compiled manifest table loads, the ARAM copy is polled by fence instead of waited on,
+//seeded manifests are replaced by the first real visit, and a prefetched module ends up in HEAP_SYSTEM
+
+#include "host.h"
+#include "game/minigame_seq.h"
+#include "game/sprite.h"
+#include "game/window.h"
+#include "game/objmain.c"
+#include "game/objdll.c"
+
+#define HOST_OVL OVL_INST
+#define HOST_DIR_ARAM 3
+#define HOST_DIR_MRAM 4
+#define HOST_FENCE_FRAME 3
+
+typedef struct host_mem_block {
+    HeapID heap;
+    s32 size;
+    u32 pad[6];
+} HostMemBlock;
+
+typedef struct host_module {
+    OSModuleHeader header;
+    OSSectionInfo section[3];
+    u32 data[8];
+} HostModule;
+
+static u8 *HostMemPtr;
+static s32 HostMemNum[HEAP_MAX];
+
+static void *HostDvdReqBuf[DVD_REQ_MAX];
+static HeapID HostDvdReqHeap[DVD_REQ_MAX];
+static s32 HostDvdReqPrio[DVD_REQ_MAX];
+static s32 HostDvdReqNum;
+static s32 HostDvdReadNum;
+static s32 HostDvdCloseNum;
+
+static u32 HostDirARAM;
+static u32 HostDirRead;
+static u32 HostDirPrefetch;
+static u32 HostDirCloseMask;
+static s32 HostDirCloseNum;
+static s16 *HostDirLog;
+static s32 HostDirLogNum;
+
+static u32 HostFence;
+static s32 HostFenceFrame;
+static s32 HostFenceCheckNum;
+static s32 HostFencePostNum;
+static s32 HostLinkNum;
+
+static FileListEntry HostOvlList[OVL_COUNT+1];
+
+u32 GlobalCounter;
+u8 fadeStat;
+WipeState wipeData;
+
+void *HuMemDirectMalloc(HeapID heap, s32 size)
+{
+    HostMemBlock *block;
+    if(!HostMemPtr) {
+        HostMemPtr = HostMemAlloc(0x1000000);
+    }
+    size = OSRoundUp32B(size);
+    block = (HostMemBlock *)HostMemPtr;
+    HostMemPtr += sizeof(HostMemBlock)+size;
+    block->heap = heap;
+    block->size = size;
+    HostMemNum[heap]++;
+    return block+1;
+}
+
+void *HuMemDirectMallocNum(HeapID heap, s32 size, u32 num)
+{
+    return HuMemDirectMalloc(heap, size);
+}
+
+void HuMemDirectFree(void *ptr)
+{
+    if(ptr) {
+        HostMemNum[((HostMemBlock *)ptr-1)->heap]--;
+    }
+}
+
+s32 HuMemMemorySizeGet(void *ptr)
+{
+    return ((HostMemBlock *)ptr-1)->size;
+}
+
+static HeapID HostMemHeapGet(void *ptr)
+{
+    return ((HostMemBlock *)ptr-1)->heap;
+}
+
+void HuMemHeapSnapshot(void *heap_ptr, HuMemSnapshot *snap)
+{
+    memset(snap, 0, sizeof(HuMemSnapshot));
+    snap->free_size = snap->free_max = 0x400000;
+}
+
+u32 HuMemHeapSizeGet(HeapID heap)
+{
+    return 0x400000;
+}
+
+void *HuMemHeapPtrGet(HeapID heap) { return NULL; }
+void HuMemDirectFreeNum(HeapID heap, u32 num) {}
+void HuMemDCFlushAll() {}
+s32 HuMemUsedMallocSizeGet(HeapID heap) { return 0; }
+s32 HuMemUsedMallocBlockGet(HeapID heap) { return 0; }
+void HuMemSnapshotGet(HuMemSnapshot *snap) {}
+void HuMemSnapshotDiff(HuMemSnapshot *prev, HuMemSnapshot *snap) {}
+void HuMemPeakReset(void) {}
+void HuMemHeapDump(void *heap_ptr, s16 status) {}
+
+static HostModule *HostModuleMake(HeapID heap, s32 id)
+{
+    HostModule *module = HuMemDirectMalloc(heap, sizeof(HostModule));
+    memset(module, 0, sizeof(HostModule));
+    module->header.info.id = id;
+    module->header.info.numSections = 3;
+    module->header.info.sectionInfoOffset = offsetof(HostModule, section);
+    module->header.bssSize = 32;
+    module->data[0] = 0x1234;
+    module->data[1] = id;
+    return module;
+}
+
+BOOL OSLink(OSModuleInfo *info, void *bss)
+{
+    HostLinkNum++;
+    return TRUE;
+}
+
+BOOL OSUnlink(OSModuleInfo *info)
+{
+    HostLinkNum--;
+    return TRUE;
+}
+
+OSTick OSGetTick(void)
+{
+    return 0;
+}
+
+s32 DVDConvertPathToEntrynum(char *path)
+{
+    return path[0];
+}
+
+s32 HuDvdReqFastRead(s32 entrynum, HeapID heap, s32 prio, DVDCallback cb)
+{
+    s32 req = HostDvdReqNum++;
+    HostDvdReqBuf[req] = HostModuleMake(heap, entrynum);
+    HostDvdReqHeap[req] = heap;
+    HostDvdReqPrio[req] = prio;
+    return req;
+}
+
+void HuDvdReqPrioSet(s32 req, s32 prio)
+{
+    HostDvdReqPrio[req] = prio;
+}
+
+void *HuDvdReqWait(s32 req)
+{
+    return HostDvdReqBuf[req];
+}
+
+void HuDvdReqWaitAll(void) {}
+
+BOOL HuDvdReqCheck(s32 req)
+{
+    return TRUE;
+}
+
+s32 HuDvdReqFreeGet(void)
+{
+    return DVD_REQ_MAX;
+}
+
+void HuDvdDataClose(void *ptr)
+{
+    if(ptr) {
+        HostDvdCloseNum++;
+        HuMemDirectFree(ptr);
+    }
+}
+
+void *HuDvdDataReadDirect(char *path, HeapID heap)
+{
+    HostDvdReadNum++;
+    return HostModuleMake(heap, path[0]);
+}
+
+//Only the test's own directories are tracked
+static u32 HostDirBit(s32 data_num)
+{
+    return (data_num >> 16) < 32 ? 1 << (data_num >> 16) : 0;
+}
+
+s32 HuDataReadChk(s32 data_num)
+{
+    return (HostDirRead & HostDirBit(data_num)) ? 0 : -1;
+}
+
+s32 HuDataDirPrefetch(s32 data_num)
+{
+    HostDirPrefetch |= HostDirBit(data_num);
+    return 0;
+}
+
+BOOL HuDataDirPrefetchDone(s32 data_num)
+{
+    return (HostDirPrefetch & HostDirBit(data_num)) != 0;
+}
+
+void HuDataDirClose(s32 data_id)
+{
+    HostDirCloseNum++;
+    HostDirCloseMask |= HostDirBit(data_id);
+    HostDirPrefetch &= ~HostDirBit(data_id);
+}
+
+s32 HuDataDirPrefetchClose(void)
+{
+    HostDirPrefetch = 0;
+    return 0;
+}
+
+void HuDataDirLogStart(s16 *log, s32 max)
+{
+    HostDirLog = log;
+}
+
+s32 HuDataDirLogEnd(void)
+{
+    return HostDirLogNum;
+}
+
+void HuDataDirCloseNum(s32 num) {}
+
+//An ARAM copy is in flight for HOST_FENCE_FRAME polls
+u32 HuAR_MRAMtoARAMList(s32 *dirs, s32 num, u32 prio)
+{
+    HostFencePostNum++;
+    HostFenceFrame = HOST_FENCE_FRAME;
+    HostDirARAM |= HostDirBit(dirs[0]);
+    return ++HostFence;
+}
+
+BOOL HuARFenceCheck(u32 fence)
+{
+    HostFenceCheckNum++;
+    if(fence == HostFence && HostFenceFrame > 0) {
+        HostFenceFrame--;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+u32 HuARDirCheck(u32 dir)
+{
+    return (HostDirARAM & HostDirBit(dir)) != 0;
+}
+
+void HuARReclaimSet(ARReclaimFunc func) {}
+u32 HuARCompact(void) { return 0; }
+u32 HuARMalloc(u32 size) { return 0; }
+void HuARFree(u32 amemptr) {}
+u32 HuARDMARead(ARDMARange *range, s32 num, u32 prio) { return 0; }
+u32 HuARDMAWrite(ARDMARange *range, s32 num, u32 prio) { return 0; }
+void HuARFenceWait(u32 fence) {}
+
+void HuPrcSleep(s32 time) {}
+void HuPrcVSleep(void) {}
+void HuPrcChildWatch(void) {}
+void HuPrcChildKill(Process *process) {}
+void HuPrcPoolFlush(void) {}
+void HuPrcSetStat(Process *process, u16 value) {}
+void HuPrcAllUPause(s32 flag) {}
+Process *HuPrcCreate(void (*func)(void), u16 prio, u32 stack_size, s32 extra_size) { return NULL; }
+Process *HuPrcChildCreate(void (*func)(void), u16 prio, u32 stack_size, s32 extra_size, Process *parent) { return NULL; }
+Process *HuPrcCurrentGet(void) { return NULL; }
+s32 HuPerfTraceBegin(u32 id, s32 type) { return 0; }
+void HuPerfTraceEnd(s32 depth) {}
+void CharModelKill(s16 character) {}
+void MGSeqKillAll(void) {}
+void MGSeqPracticeInit(void) {}
+void Hu3DAllKill(void) {}
+void Hu3DModelPosSet(s16 index, float x, float y, float z) {}
+void Hu3DModelRotSet(s16 index, float x, float y, float z) {}
+void Hu3DModelScaleSet(s16 index, float x, float y, float z) {}
+void HuWinAllKill(void) {}
+void HuSprClose(void) {}
+void HuPadRumbleAllStop(void) {}
+void HuAudFXListnerKill(void) {}
+void HuAudVoiceInit(s16 ovl) {}
+void HuAudDllSndGrpSet(u16 ovl) {}
+void espInit(void) {}
+s32 _CheckFlag(u32 flag) { return 0; }
+void omSysPauseEnable(u8 flag) {}
+s16 print8(s16 x, s16 y, float scale, char *str, ...) { return 0; }
+s16 printWin(s16 x, s16 y, s16 w, s16 h, GXColor *color) { return 0; }
+int fontcolor;
+u32 totalPolyCnted;
+
+static void HostManifestTest(void)
+{
+    u16 *data;
+    s32 num = 0;
+    s32 i;
+    omOvlManifestInit();
+    for(data=omOvlManifestData; *data != OM_OVL_MANIFEST_END; data += data[2]+3) {
+        num++;
+        HOST_CHECK(data[0] < OVL_COUNT);
+        HOST_CHECK(data[2] > 0 && data[2] <= OM_OVL_MANIFEST_MAX);
+        HOST_CHECK(data[3] == (OM_OVL_MANIFEST_DLL|data[0]));
+        for(i=1; i<data[2]; i++) {
+            HOST_CHECK(data[i+3] & OM_OVL_MANIFEST_DLL || OM_OVL_MANIFEST_ID(data[i+3]) < DATADIR_ID_MAX);
+        }
+        HOST_CHECK((s16)data[1] == OVL_INVALID || data[1] < OVL_COUNT);
+        HOST_CHECK(omOvlManifestTbl[data[0]].num == data[2]);
+        HOST_CHECK(!omOvlManifestTbl[data[0]].rec);
+    }
+    //Every overlay is seeded, and the walk ends on the terminator rather than on a bad entry
+    HOST_CHECK(num == OVL_COUNT);
+    HOST_CHECK(data == &omOvlManifestData[sizeof(omOvlManifestData)/sizeof(u16)-1]);
+}
+
+static void HostFenceTest(void)
+{
+    omOvlManifest *manifest = &omOvlManifestTbl[HOST_OVL];
+    s32 frame;
+    s32 check_num;
+    manifest->num = 3;
+    manifest->entry[0] = OM_OVL_MANIFEST_DLL|HOST_OVL;
+    manifest->entry[1] = OM_OVL_MANIFEST_ARAM|HOST_DIR_ARAM;
+    manifest->entry[2] = HOST_DIR_MRAM;
+    omcurovl = OVL_INVALID;
+    omnextovl = HOST_OVL;
+    omOvlPrefetch(HOST_OVL);
+    omOvlPrefetchExec();
+    HOST_CHECK(HostDvdReqNum == 1 && HostDvdReqHeap[0] == HEAP_DVD && HostDvdReqPrio[0] == DVD_PRIO_PREFETCH);
+    HOST_CHECK(HostDirPrefetch == ((1 << HOST_DIR_ARAM)|(1 << HOST_DIR_MRAM)));
+    HOST_CHECK(HostFencePostNum == 1);
+    //While the copy is in flight each frame polls the fence once and moves on
+    for(frame=0; frame<HOST_FENCE_FRAME; frame++) {
+        check_num = HostFenceCheckNum;
+        omOvlPrefetchExec();
+        HOST_CHECK(HostFenceCheckNum == check_num+1);
+        HOST_CHECK(HostDirCloseNum == 0);
+        HOST_CHECK(omOvlPrefetchStat[1] == OM_OVL_PREFETCH_READ);
+    }
+    omOvlPrefetchExec();
+    HOST_CHECK(HostFencePostNum == 1);
+    HOST_CHECK(HostDirCloseMask == (1 << HOST_DIR_ARAM));
+    HOST_CHECK(omOvlPrefetchStat[1] == OM_OVL_PREFETCH_DONE);
+    HOST_CHECK(omOvlPrefetchStat[2] == OM_OVL_PREFETCH_READ);
+    HOST_CHECK(omOvlPrefetchFenceOvl == OVL_INVALID);
+
+    //A copy still in flight when the prefetch moves on lands, but is not credited to the new overlay
+    omOvlPrefetchStop();
+    HostDirARAM = 0;
+    HostDirCloseMask = 0;
+    HostDirPrefetch = 0;
+    omOvlPrefetch(HOST_OVL);
+    omOvlPrefetchExec();
+    HOST_CHECK(HostFencePostNum == 2);
+    omnextovl = OVL_BOOT;
+    omOvlPrefetch(OVL_BOOT);
+    for(frame=0; frame<=HOST_FENCE_FRAME; frame++) {
+        omOvlPrefetchExec();
+    }
+    HOST_CHECK(omOvlPrefetchFenceOvl == OVL_INVALID);
+    HOST_CHECK(omOvlPrefetchStat[0] == OM_OVL_PREFETCH_READ);
+    HOST_CHECK(omOvlPrefetchStat[1] == OM_OVL_PREFETCH_NONE);
+    //Modules prefetched for nothing are given back
+    omOvlPrefetchStop();
+    omOvlPrefetchExec();
+    HOST_CHECK(HostMemNum[HEAP_DVD] == 0);
+    omnextovl = OVL_INVALID;
+}
+
+static void HostModuleTest(void)
+{
+    omDllData *dll;
+    s32 mram_num = HostMemNum[HEAP_SYSTEM];
+    s32 dvd_num = HostMemNum[HEAP_DVD];
+    s32 read_num = HostDvdReadNum;
+    s32 req = HostDvdReqNum;
+    HOST_CHECK(omDLLPrefetch(OVL_E3SETUP));
+    HOST_CHECK(HostDvdReqNum == req+1 && HostDvdReqHeap[req] == HEAP_DVD);
+    HOST_CHECK(HostMemNum[HEAP_DVD] == dvd_num+1 && HostMemNum[HEAP_SYSTEM] == mram_num);
+    omDLLLink(&dll, OVL_E3SETUP, 0);
+    //Linked from a HEAP_SYSTEM copy, with the HEAP_DVD buffer given back and no disc read
+    HOST_CHECK(HostDvdReqPrio[req] == DVD_PRIO_WAIT);
+    HOST_CHECK(HostDvdReadNum == read_num);
+    HOST_CHECK(HostMemHeapGet(dll->module) == HEAP_SYSTEM);
+    HOST_CHECK(((HostModule *)dll->module)->data[0] == 0x1234);
+    HOST_CHECK(((HostModule *)dll->module)->data[1] == HostOvlList[OVL_E3SETUP].name[0]);
+    HOST_CHECK(HostMemNum[HEAP_DVD] == dvd_num);
+    HOST_CHECK(HostLinkNum == 1);
+    omDLLUnlink(dll, 0);
+    HOST_CHECK(HostLinkNum == 0);
+    HOST_CHECK(HostMemNum[HEAP_SYSTEM] == mram_num);
+    //Without a prefetch the module comes straight off the disc as before
+    omDLLLink(&dll, OVL_E3SETUP, 0);
+    HOST_CHECK(HostDvdReadNum == read_num+1);
+    omDLLUnlink(dll, 0);
+    HOST_CHECK(HostMemNum[HEAP_SYSTEM] == mram_num);
+}
+
+static void HostRecordTest(void)
+{
+    omOvlManifest *manifest = &omOvlManifestTbl[OVL_E3SETUP];
+    u8 seed_num = manifest->num;
+    HOST_CHECK(seed_num > 1 && !manifest->rec);
+    //The first visit replaces the seed even though it is not empty
+    omprevovl = OVL_INVALID;
+    omOvlManifestStart(OVL_E3SETUP);
+    omOvlManifestDLLAdd(OVL_E3SETUP);
+    HostDirLog[0] = HOST_DIR_MRAM;
+    HostDirLogNum = 1;
+    omOvlManifestEnd();
+    HOST_CHECK(manifest->rec);
+    HOST_CHECK(manifest->num == 2);
+    HOST_CHECK(manifest->entry[0] == (OM_OVL_MANIFEST_DLL|OVL_E3SETUP));
+    HOST_CHECK(manifest->entry[1] == HOST_DIR_MRAM);
+    //Later visits keep it unless recording is on
+    omOvlManifestStart(OVL_E3SETUP);
+    HostDirLogNum = 0;
+    omOvlManifestEnd();
+    HOST_CHECK(manifest->num == 2);
+    omOvlManifestRecSet(TRUE);
+    omOvlManifestStart(OVL_E3SETUP);
+    omOvlManifestEnd();
+    HOST_CHECK(manifest->num == 0);
+    omOvlManifestRecSet(FALSE);
+}
+
+int main(void)
+{
+    static char names[OVL_COUNT][4];
+    s32 i;
+    __OSBusClock = 162000000;
+    for(i=0; i<OVL_COUNT; i++) {
+        names[i][0] = 'A'+i%26;
+        HostOvlList[i].name = names[i];
+    }
+    omDLLInit(HostOvlList);
+    omDLLResidentSet(0, 0);
+    HostManifestTest();
+    HostFenceTest();
+    HostModuleTest();
+    HostRecordTest();
+    return HostEnd("ovlprefetch");
+}
@@ -0,0 +1,570 @@
+//Process scheduler in process.c, replayed against the linear scheduler it replaced
+//Generated scripts create, sleep, wake, pause, kill and end processes from inside and outside them;
+//both schedulers must run the same processes in the same order every frame, then both are timed
+//A process is not resumed where it left off: each time it is run the script just goes on from there
+
+#include "host.h"
+#include <stddef.h>
+#include <time.h>
+#include "game/process.h"
+
+static void *HostCallJump[5];
+static s32 HostCallRet;
+static void HostLongJmp(void *jump, s32 status);
+
+//HuPrcCall's own jump buffer is a real one, a process's is only ever resumed by running its script
+#define gcsetjmp(jump) ((void *)(jump) == (void *)&processjmpbuf ? (__builtin_setjmp(HostCallJump) ? HostCallRet : 0) : 0)
+#define gclongjmp(jump, status) HostLongJmp((jump), (status))
+
+#include "game/process.c"
+
+#define HOST_MEM_SIZE 0x10000000
+#define HOST_PRC_MAX 20000
+#define HOST_LIVE_MAX 60
+#define HOST_FRAME_MAX 3000
+#define HOST_SEED_MAX 200
+#define HOST_TRACE_MAX 200000
+#define HOST_BENCH_PRC 1000
+#define HOST_BENCH_FRAME 20000
+
+typedef struct host_sched {
+    void (*init)(void);
+    Process *(*create)(void (*func)(void), u16 prio, u32 stack_size, s32 extra_size);
+    Process *(*child_create)(void (*func)(void), u16 prio, u32 stack_size, s32 extra_size, Process *parent);
+    Process *(*current_get)(void);
+    s32 (*kill)(Process *process);
+    void (*end)(void);
+    void (*sleep)(s32 time);
+    void (*wakeup)(Process *process);
+    void (*child_watch)(void);
+    void (*dtor_set)(Process *process, void (*func)(void));
+    void (*set_stat)(Process *process, u16 value);
+    void (*reset_stat)(Process *process, u16 value);
+    void (*all_pause)(s32 flag);
+    void (*all_upause)(s32 flag);
+    void (*call)(s32 tick);
+} HostSched;
+
+static u8 *HostMemPtr;
+static HostSched *HostCur;
+static u32 HostSeed;
+static s32 HostFrame;
+static Process *HostPrc[HOST_PRC_MAX];
+static BOOL HostAlive[HOST_PRC_MAX];
+static s32 HostPrcNum;
+static s32 *HostTrace;
+static s32 HostTraceNum;
+static BOOL HostBench;
+
+void *HuMemDirectMalloc(HeapID heap, s32 size)
+{
+    void *ptr;
+    if(!HostMemPtr) {
+        HostMemPtr = HostMemAlloc(HOST_MEM_SIZE);
+    }
+    ptr = HostMemPtr;
+    HostMemPtr += OSRoundUp32B(size);
+    return ptr;
+}
+
+void HuMemDirectFree(void *ptr) {}
+void HuMemMemoryFree(void *ptr, u32 retaddr) {}
+s32 HuPerfTraceBegin(u32 func, s32 type) { return -1; }
+void HuPerfTraceEnd(s32 trace) {}
+
+s32 HuMemMemoryAllocSizeGet(s32 size)
+{
+    return OSRoundUp32B(size)+32;
+}
+
+//The first word past the magic byte HuPrcCall checks holds how much of the heap is used
+void *HuMemHeapInit(void *ptr, s32 size)
+{
+    ((u8 *)ptr)[4] = 165;
+    ((u32 *)ptr)[2] = 0;
+    return ptr;
+}
+
+void *HuMemMemoryAlloc(void *heap_ptr, s32 size, u32 retaddr)
+{
+    u8 *ptr = (u8 *)heap_ptr+((u32 *)heap_ptr)[2]+32;
+    ((u32 *)heap_ptr)[2] += HuMemMemoryAllocSizeGet(size);
+    return ptr;
+}
+
+//The linear scheduler process.c had before, down to the order of its list walks
+static Process *RefPrcTop;
+static Process *RefPrcCur;
+
+static void RefPrcInit(void)
+{
+    RefPrcTop = NULL;
+}
+
+static void RefLinkProcess(Process *process)
+{
+    Process *src_process = RefPrcTop;
+    if(src_process && src_process->prio >= process->prio) {
+        while(src_process->next && src_process->next->prio >= process->prio) {
+            src_process = src_process->next;
+        }
+        process->next = src_process->next;
+        process->prev = src_process;
+        src_process->next = process;
+        if(process->next) {
+            process->next->prev = process;
+        }
+    } else {
+        process->next = RefPrcTop;
+        process->prev = NULL;
+        RefPrcTop = process;
+        if(src_process) {
+            src_process->prev = process;
+        }
+    }
+}
+
+static void RefUnlinkProcess(Process *process)
+{
+    if(process->next) {
+        process->next->prev = process->prev;
+    }
+    if(process->prev) {
+        process->prev->next = process->next;
+    } else {
+        RefPrcTop = process->next;
+    }
+}
+
+static Process *RefPrcCreate(void (*func)(void), u16 prio, u32 stack_size, s32 extra_size)
+{
+    Process *process = HuMemDirectMalloc(HEAP_SYSTEM, sizeof(Process));
+    memset(process, 0, sizeof(Process));
+    process->exec = EXEC_NORMAL;
+    process->prio = prio;
+    process->jump.lr = (u32)(uintptr_t)func;
+    RefLinkProcess(process);
+    return process;
+}
+
+static Process *RefPrcChildCreate(void (*func)(void), u16 prio, u32 stack_size, s32 extra_size, Process *parent)
+{
+    Process *child = RefPrcCreate(func, prio, stack_size, extra_size);
+    HuPrcChildLink(parent, child);
+    return child;
+}
+
+static Process *RefPrcCurrentGet(void)
+{
+    return RefPrcCur;
+}
+
+static void RefPrcWakeup(Process *process)
+{
+    process->sleep_time = 0;
+}
+
+static s32 RefSetKillStatusProcess(Process *process)
+{
+    if(process->exec != EXEC_KILLED) {
+        RefPrcWakeup(process);
+        process->exec = EXEC_KILLED;
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+//Detaching the killed children went in alongside the new scheduler; before it a child that ended
+//afterwards still unlinked itself through a parent that had since ended, or had new children
+static void RefPrcChildKill(Process *process)
+{
+    Process *child = process->child;
+    while(child) {
+        if(child->child) {
+            RefPrcChildKill(child);
+        }
+        RefSetKillStatusProcess(child);
+        child->parent = NULL;
+        child = child->next_child;
+    }
+    process->child = NULL;
+}
+
+static s32 RefPrcKill(Process *process)
+{
+    RefPrcChildKill(process);
+    HuPrcChildUnlink(process);
+    return RefSetKillStatusProcess(process);
+}
+
+static void RefPrcEnd(void)
+{
+    Process *process = RefPrcCur;
+    RefPrcChildKill(process);
+    HuPrcChildUnlink(process);
+    if(process->dtor) {
+        process->dtor();
+    }
+    RefUnlinkProcess(process);
+    HostCallRet = 2;
+    __builtin_longjmp(HostCallJump, 1);
+}
+
+static void RefPrcYield(void)
+{
+    HostCallRet = 1;
+    __builtin_longjmp(HostCallJump, 1);
+}
+
+static void RefPrcSleep(s32 time)
+{
+    Process *process = RefPrcCur;
+    if(time != 0 && process->exec != EXEC_KILLED) {
+        process->exec = EXEC_SLEEP;
+        process->sleep_time = time;
+    }
+    RefPrcYield();
+}
+
+static void RefPrcChildWatch(void)
+{
+    Process *curr = RefPrcCur;
+    if(curr->child) {
+        curr->exec = EXEC_CHILDWATCH;
+        RefPrcYield();
+    }
+}
+
+static void RefPrcDestructorSet2(Process *process, void (*func)(void))
+{
+    process->dtor = func;
+}
+
+static void RefPrcSetStat(Process *process, u16 value)
+{
+    process->stat |= value;
+}
+
+static void RefPrcResetStat(Process *process, u16 value)
+{
+    process->stat &= ~value;
+}
+
+static void RefPrcAllPause(s32 flag)
+{
+    Process *process;
+    for(process = RefPrcTop; process; process = process->next) {
+        if(flag) {
+            if(!(process->stat & PROCESS_STAT_PAUSE_EN)) {
+                RefPrcSetStat(process, PROCESS_STAT_PAUSE);
+            }
+        } else if(process->stat & PROCESS_STAT_PAUSE) {
+            RefPrcResetStat(process, PROCESS_STAT_PAUSE);
+        }
+    }
+}
+
+static void RefPrcAllUPause(s32 flag)
+{
+    Process *process;
+    for(process = RefPrcTop; process; process = process->next) {
+        if(flag) {
+            if(!(process->stat & PROCESS_STAT_UPAUSE_EN)) {
+                RefPrcSetStat(process, PROCESS_STAT_UPAUSE);
+            }
+        } else if(process->stat & PROCESS_STAT_UPAUSE) {
+            RefPrcResetStat(process, PROCESS_STAT_UPAUSE);
+        }
+    }
+}
+
+static void HostRun(Process *process);
+
+static void RefPrcCall(s32 tick)
+{
+    Process *process;
+    s32 ret;
+    RefPrcCur = RefPrcTop;
+    ret = __builtin_setjmp(HostCallJump) ? HostCallRet : 0;
+    while(1) {
+        if(ret) {
+            RefPrcCur = RefPrcCur->next;
+        }
+        process = RefPrcCur;
+        if(!process) {
+            return;
+        }
+        if((process->stat & (PROCESS_STAT_PAUSE|PROCESS_STAT_UPAUSE)) && process->exec != EXEC_KILLED) {
+            ret = 1;
+            continue;
+        }
+        switch(process->exec) {
+            case EXEC_SLEEP:
+                if(process->sleep_time > 0) {
+                    process->sleep_time -= tick;
+                    if(process->sleep_time <= 0) {
+                        process->sleep_time = 0;
+                        process->exec = EXEC_NORMAL;
+                    }
+                }
+                ret = 1;
+                break;
+
+            case EXEC_CHILDWATCH:
+                if(process->child) {
+                    ret = 1;
+                } else {
+                    process->exec = EXEC_NORMAL;
+                    ret = 0;
+                }
+                break;
+
+            case EXEC_KILLED:
+                process->jump.lr = (u32)(uintptr_t)RefPrcEnd;
+            case EXEC_NORMAL:
+                HostRun(process);
+                break;
+        }
+    }
+}
+
+static HostSched HostRef = {
+    RefPrcInit, RefPrcCreate, RefPrcChildCreate, RefPrcCurrentGet, RefPrcKill, RefPrcEnd, RefPrcSleep,
+    RefPrcWakeup, RefPrcChildWatch, RefPrcDestructorSet2, RefPrcSetStat, RefPrcResetStat, RefPrcAllPause,
+    RefPrcAllUPause, RefPrcCall
+};
+
+static HostSched HostNew = {
+    HuPrcInit, HuPrcCreate, HuPrcChildCreate, HuPrcCurrentGet, HuPrcKill, HuPrcEnd, HuPrcSleep,
+    HuPrcWakeup, HuPrcChildWatch, HuPrcDestructorSet2, HuPrcSetStat, HuPrcResetStat, HuPrcAllPause,
+    HuPrcAllUPause, HuPrcCall
+};
+
+static void HostLongJmp(void *jump, s32 status)
+{
+    if(jump == &processjmpbuf) {
+        HostCallRet = status;
+        __builtin_longjmp(HostCallJump, 1);
+    }
+    HostRun((Process *)((u8 *)jump-offsetof(Process, jump)));
+}
+
+static u32 HostRand(void)
+{
+    HostSeed = HostSeed*1103515245+12345;
+    return (HostSeed >> 8) & 0xFFFFFF;
+}
+
+static void HostTraceAdd(s32 event)
+{
+    if(HostTraceNum < HOST_TRACE_MAX) {
+        HostTrace[HostTraceNum] = event;
+    }
+    HostTraceNum++;
+}
+
+static void HostPrcFunc(void) {}
+
+static void HostPrcDtor(void)
+{
+    HostAlive[(s32)(intptr_t)HostCur->current_get()->user_data] = FALSE;
+}
+
+static void HostPrcMake(Process *parent)
+{
+    static u16 prio_tbl[] = { 0x1000, 0x1000, 0x2000, 0x2001, 0x10, 0x3000, 0x1000, 0xFF00, 0x2000, 0x100, 0x101, 0x8000 };
+    u16 prio = prio_tbl[HostRand()%12];
+    Process *process;
+    if(HostPrcNum >= HOST_PRC_MAX) {
+        return;
+    }
+    if(parent) {
+        process = HostCur->child_create(HostPrcFunc, prio, 0, 0, parent);
+    } else {
+        process = HostCur->create(HostPrcFunc, prio, 0, 0);
+    }
+    process->user_data = (void *)(intptr_t)HostPrcNum;
+    HostCur->dtor_set(process, HostPrcDtor);
+    HostPrc[HostPrcNum] = process;
+    HostAlive[HostPrcNum] = TRUE;
+    HostPrcNum++;
+}
+
+static s32 HostLiveNum(void)
+{
+    s32 i, num = 0;
+    for(i=0; i<HostPrcNum; i++) {
+        num += HostAlive[i];
+    }
+    return num;
+}
+
+static Process *HostPrcPick(void)
+{
+    s32 i, num = HostLiveNum();
+    if(num == 0) {
+        return NULL;
+    }
+    num = HostRand()%num;
+    for(i=0; i<HostPrcNum; i++) {
+        if(HostAlive[i] && num-- == 0) {
+            return HostPrc[i];
+        }
+    }
+    return NULL;
+}
+
+//The script a process runs until it sleeps or ends; everything it does draws from the same generator
+static void HostRun(Process *process)
+{
+    s32 id = (s32)(intptr_t)process->user_data;
+    Process *other;
+    u32 action;
+    if(process->jump.lr == (u32)(uintptr_t)HostCur->end) {
+        HostTraceAdd(-2-id);
+        HostCur->end();
+    }
+    HostTraceAdd(id);
+    //Long sleepers that never wake up in the timed stretch, which the old scheduler still walked every frame
+    if(HostBench) {
+        HostCur->sleep(1000000);
+    }
+    while(1) {
+        action = HostRand()%100;
+        if(action < 25) {
+            HostCur->sleep(0);
+        } else if(action < 45) {
+            HostCur->sleep(HostRand()%8+1);
+        } else if(action < 47) {
+            HostCur->sleep(-1);
+        } else if(action < 52) {
+            if(HostLiveNum() < HOST_LIVE_MAX) {
+                HostPrcMake(HostRand()%2 ? process : NULL);
+            }
+        } else if(action < 56) {
+            if((other = HostPrcPick()) && other != process) {
+                HostCur->kill(other);
+            }
+        } else if(action < 63) {
+            if((other = HostPrcPick())) {
+                HostCur->set_stat(other, PROCESS_STAT_PAUSE);
+            }
+        } else if(action < 72) {
+            if((other = HostPrcPick())) {
+                HostCur->reset_stat(other, PROCESS_STAT_PAUSE);
+            }
+        } else if(action < 75) {
+            if((other = HostPrcPick())) {
+                HostCur->wakeup(other);
+            }
+        } else if(action < 77) {
+            HostCur->end();
+        } else if(action < 79) {
+            HostCur->child_watch();
+        } else if(action < 81) {
+            HostCur->all_pause(HostRand()%2);
+        } else if(action < 83) {
+            HostCur->all_upause(HostRand()%2);
+        } else if(action < 86) {
+            if((other = HostPrcPick())) {
+                HostCur->set_stat(other, PROCESS_STAT_UPAUSE);
+            }
+        } else if(action < 90) {
+            if((other = HostPrcPick())) {
+                HostCur->reset_stat(other, PROCESS_STAT_UPAUSE);
+            }
+        }
+    }
+}
+
+//Returns the number of trace events; the frame loop also changes processes from outside any of them
+static s32 HostReplay(HostSched *sched, u32 seed, s32 *trace)
+{
+    Process *other;
+    u32 action;
+    s32 i;
+    HostCur = sched;
+    HostSeed = seed;
+    HostTrace = trace;
+    HostTraceNum = 0;
+    HostPrcNum = 0;
+    sched->init();
+    for(i=0; i<10; i++) {
+        HostPrcMake(NULL);
+    }
+    for(HostFrame=0; HostFrame<HOST_FRAME_MAX; HostFrame++) {
+        HostTraceAdd(-1);
+        action = HostRand()%100;
+        if(action < 5) {
+            if((other = HostPrcPick())) {
+                sched->reset_stat(other, PROCESS_STAT_PAUSE|PROCESS_STAT_UPAUSE);
+            }
+        } else if(action < 8) {
+            if((other = HostPrcPick())) {
+                sched->set_stat(other, PROCESS_STAT_PAUSE);
+            }
+        } else if(action < 10) {
+            sched->all_pause(HostRand()%2);
+        } else if(action < 12) {
+            if((other = HostPrcPick())) {
+                sched->wakeup(other);
+            }
+        } else if(action < 14) {
+            if((other = HostPrcPick())) {
+                sched->kill(other);
+            }
+        }
+        if(HostLiveNum() < 5) {
+            HostPrcMake(NULL);
+        }
+        sched->call(HostRand()%10 ? 1 : 3);
+    }
+    return HostTraceNum;
+}
+
+static s32 HostRefTrace[HOST_TRACE_MAX];
+static s32 HostNewTrace[HOST_TRACE_MAX];
+
+static void HostReplayTest(void)
+{
+    s32 ref_num, num;
+    s32 run_num = 0;
+    u32 seed;
+    for(seed=1; seed<=HOST_SEED_MAX; seed++) {
+        ref_num = HostReplay(&HostRef, seed, HostRefTrace);
+        num = HostReplay(&HostNew, seed, HostNewTrace);
+        HOST_CHECK(num == ref_num && num <= HOST_TRACE_MAX);
+        HOST_CHECK(memcmp(HostRefTrace, HostNewTrace, num*sizeof(s32)) == 0);
+        run_num += num;
+    }
+    printf("process %d scripts: %d frames, %d trace events\n", HOST_SEED_MAX, HOST_SEED_MAX*HOST_FRAME_MAX, run_num);
+}
+
+static double HostBenchTime(HostSched *sched)
+{
+    clock_t start;
+    s32 i;
+    HostCur = sched;
+    HostTraceNum = 0;
+    sched->init();
+    for(i=0; i<HOST_BENCH_PRC; i++) {
+        sched->create(HostPrcFunc, 0x100*(i%64), 0, 0)->user_data = (void *)(intptr_t)i;
+    }
+    start = clock();
+    for(i=0; i<HOST_BENCH_FRAME; i++) {
+        sched->call(1);
+    }
+    return (double)(clock()-start)/CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+    double ref_time, time;
+    HostReplayTest();
+    HostBench = TRUE;
+    ref_time = HostBenchTime(&HostRef);
+    time = HostBenchTime(&HostNew);
+    printf("process %d sleepers x %d frames: old %.1fms new %.1fms\n", HOST_BENCH_PRC, HOST_BENCH_FRAME, ref_time*1000, time*1000);
+    return HostEnd("process");
+}
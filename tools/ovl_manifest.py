@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+
+###
+# Generates include/ovl_manifest_table.h, the overlay manifests objmain.c
+# starts with before any overlay has run.
+#
+# Usage:
+#   python3 tools/ovl_manifest.py [-o include/ovl_manifest_table.h]
+#
+# Each overlay gets its own REL plus the data directories its source names
+# directly. Directories only named in tables, and the per character
+# directories, depend on who is playing and are left to be learned at runtime.
+# The next overlay is filled in when the source only ever goes to one.
+###
+
+from argparse import ArgumentParser
+import os
+import re
+from typing import Dict, List, Optional, Tuple
+
+script_dir = os.path.dirname(os.path.realpath(__file__))
+root_dir = os.path.abspath(os.path.join(script_dir, ".."))
+
+# Must match OM_OVL_MANIFEST_MAX in src/game/objmain.c
+MANIFEST_MAX = 32
+
+CHARACTER_PREFIXES = (
+    "MARIO",
+    "LUIGI",
+    "PEACH",
+    "YOSHI",
+    "WARIO",
+    "DONKEY",
+    "DAISY",
+    "WALUIGI",
+)
+
+ovl_pattern = re.compile(r'OVL_DEFINE\((\w+),\s*"dll/(\w+)\.rel"\)')
+cond_pattern = re.compile(r"^#\s*(if|else|endif)\b(.*)$")
+dir_pattern = re.compile(r"\bDATADIR_(\w+)")
+aram_pattern = re.compile(r"\bHuAR_(?:DVDtoARAM|MRAMtoARAM)\(\s*DATADIR_(\w+)")
+goto_pattern = re.compile(r"\bomOvl(?:Call|Goto)Ex\(\s*(OVL_\w+)")
+comment_pattern = re.compile(r"//[^\n]*|/\*.*?\*/", re.S)
+table_pattern = re.compile(r"=\s*\{[^;]*\}\s*;", re.S)
+
+
+def read_overlays() -> List[Tuple[str, str, Optional[str]]]:
+    # Returns name, REL name and the preprocessor condition it is under, if any
+    overlays = []
+    cond: List[str] = []
+    path = os.path.join(root_dir, "include", "ovl_table.h")
+    with open(path, "r") as f:
+        for line in f:
+            match = cond_pattern.match(line.strip())
+            if match:
+                if match.group(1) == "if":
+                    cond.append(match.group(2).strip())
+                elif match.group(1) == "else":
+                    cond[-1] = "!(%s)" % cond[-1]
+                else:
+                    cond.pop()
+                continue
+            match = ovl_pattern.search(line)
+            if match:
+                overlays.append((match.group(1), match.group(2), cond[-1] if cond else None))
+    # Overlays defined on both sides of a condition need no guard
+    conds: Dict[str, set] = {}
+    for name, _, c in overlays:
+        conds.setdefault(name, set()).add(c)
+    result = []
+    seen = set()
+    for name, rel, c in overlays:
+        if name in seen:
+            continue
+        seen.add(name)
+        result.append((name, rel, c if len(conds[name]) == 1 else None))
+    return result
+
+
+def read_datadirs() -> set:
+    path = os.path.join(root_dir, "include", "datadir_table.h")
+    with open(path, "r") as f:
+        return set(re.findall(r"DATADIR_DEFINE\((\w+),", f.read()))
+
+
+def source_dir(rel: str) -> Optional[str]:
+    rel_dir = os.path.join(root_dir, "src", "REL")
+    for name in os.listdir(rel_dir):
+        if name.lower() == rel.lower() and os.path.isdir(os.path.join(rel_dir, name)):
+            return os.path.join(rel_dir, name)
+    return None
+
+
+def scan_source(path: str, datadirs: set) -> Tuple[List[str], set, set]:
+    dirs: List[str] = []
+    aram = set()
+    nexts = set()
+    files = sorted(f for f in os.listdir(path) if f.endswith(".c"))
+    # main.c holds the setup code, so its directories are loaded first
+    files.sort(key=lambda f: f != "main.c")
+    for name in files:
+        with open(os.path.join(path, name), "r", errors="replace") as f:
+            text = comment_pattern.sub("", f.read())
+        aram.update(aram_pattern.findall(text))
+        nexts.update(goto_pattern.findall(text))
+        text = table_pattern.sub("= 0;", text)
+        for dir in dir_pattern.findall(text):
+            if dir not in datadirs or dir in dirs or dir.startswith(CHARACTER_PREFIXES):
+                continue
+            dirs.append(dir)
+    return dirs, aram, nexts
+
+
+def main() -> None:
+    parser = ArgumentParser(description="Generate the overlay manifest seed table")
+    parser.add_argument(
+        "-o",
+        "--output",
+        default=os.path.join(root_dir, "include", "ovl_manifest_table.h"),
+        help="output file",
+    )
+    args = parser.parse_args()
+
+    datadirs = read_datadirs()
+    names = {name for name, _, _ in read_overlays()}
+    lines = [
+        "//Overlay manifests printed by omOvlManifestDump after a run with omOvlManifestRecSet(TRUE)",
+        "//Generated by tools/ovl_manifest.py, each entry is replaced by what the overlay really loads once it has run",
+    ]
+    for name, rel, cond in read_overlays():
+        entries = ["OM_OVL_MANIFEST_DLL|%s" % name]
+        next = "(u16)OVL_INVALID"
+        path = source_dir(rel)
+        if path:
+            dirs, aram, nexts = scan_source(path, datadirs)
+            for dir in dirs[: MANIFEST_MAX - 1]:
+                if dir in aram:
+                    entries.append("OM_OVL_MANIFEST_ARAM|DATADIR_ID_%s" % dir)
+                else:
+                    entries.append("DATADIR_ID_%s" % dir)
+            nexts &= names
+            if len(nexts) == 1:
+                next = nexts.pop()
+        if cond:
+            lines.append("#if %s" % cond)
+        lines.append("%s, %s, %d, %s," % (name, next, len(entries), ", ".join(entries)))
+        if cond:
+            lines.append("#endif")
+    with open(args.output, "w", newline="\n") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+if __name__ == "__main__":
+    main()